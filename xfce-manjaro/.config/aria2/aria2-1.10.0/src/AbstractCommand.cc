@@ -250,6 +250,15 @@ bool AbstractCommand::execute() {
 
         throw DL_RETRY_EX2(EX_TIME_OUT, downloadresultcode::TIME_OUT);
       }
+      // Nothing happens until an event arrives, so sleep until the
+      // timeout. The checks at the top of this function are delayed
+      // until then, except that DownloadEngine wakes this command up
+      // when its download finishes or halts. Asynchronous name
+      // resolution does not activate this command when c-ares times
+      // out, so keep waking up on each refresh while it is running.
+      if(!nameResolverCheck_) {
+        setWakeupTime(checkPoint_.getTime()+timeout_);
+      }
       e_->addCommand(this);
       return false;
     }
@@ -39,6 +39,8 @@
 #include <cerrno>
 #include <cstring>
 #include <cassert>
+#include <vector>
+#include <algorithm>
 
 #ifdef __MINGW32__
 # include <windows.h>
@@ -101,7 +103,8 @@ void AbstractDiskWriter::openExistingFile(uint64_t totalLength)
 
   if((fd_ = open(filename_.c_str(), flags, OPEN_MODE)) < 0) {
     throw DL_ABORT_EX
-      (StringFormat(EX_FILE_OPEN, filename_.c_str(), strerror(errno)).str());
+      (StringFormat(EX_FILE_OPEN, filename_.c_str(),
+                    util::safeStrerror(errno).c_str()).str());
   }
 }
 
@@ -112,16 +115,31 @@ void AbstractDiskWriter::createFile(int addFlags)
   if((fd_ = open(filename_.c_str(), O_CREAT|O_RDWR|O_TRUNC|O_BINARY|addFlags,
                 OPEN_MODE)) < 0) {
     throw DL_ABORT_EX(StringFormat(EX_FILE_OPEN,
-                                   filename_.c_str(), strerror(errno)).str());
+                                   filename_.c_str(),
+                                   util::safeStrerror(errno).c_str()).str());
   }  
 }
 
-ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data, size_t len)
+// If pwrite(2) and pread(2) are available, they are used so that
+// each chunk costs one system call and the file offset of fd_ is
+// never touched. Otherwise, seek() is called before write(2) and
+// read(2).
+ssize_t AbstractDiskWriter::writeDataInternal
+(const unsigned char* data, size_t len, off_t offset)
 {
+#ifndef HAVE_PWRITE
+  seek(offset);
+#endif // !HAVE_PWRITE
   ssize_t writtenLength = 0;
   while((size_t)writtenLength < len) {
     ssize_t ret = 0;
-    while((ret = write(fd_, data+writtenLength, len-writtenLength)) == -1 && errno == EINTR);
+#ifdef HAVE_PWRITE
+    while((ret = pwrite(fd_, data+writtenLength, len-writtenLength,
+                        offset+writtenLength)) == -1 && errno == EINTR);
+#else // !HAVE_PWRITE
+    while((ret = write(fd_, data+writtenLength, len-writtenLength)) == -1 &&
+          errno == EINTR);
+#endif // !HAVE_PWRITE
     if(ret == -1) {
       return -1;
     }
@@ -130,47 +148,140 @@ ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data, size_t
   return writtenLength;
 }
 
-ssize_t AbstractDiskWriter::readDataInternal(unsigned char* data, size_t len)
+ssize_t AbstractDiskWriter::readDataInternal
+(unsigned char* data, size_t len, off_t offset)
 {
   ssize_t ret = 0;
+#ifdef HAVE_PREAD
+  while((ret = pread(fd_, data, len, offset)) == -1 && errno == EINTR);
+#else // !HAVE_PREAD
+  seek(offset);
   while((ret = read(fd_, data, len)) == -1 && errno == EINTR);
+#endif // !HAVE_PREAD
   return ret;
 }
 
+ssize_t AbstractDiskWriter::writeDataVecInternal
+(const struct iovec* iov, int iovcnt, off_t offset)
+{
+  std::vector<struct iovec> vec(&iov[0], &iov[iovcnt]);
+  std::vector<struct iovec>::iterator first = vec.begin();
+  ssize_t writtenLength = 0;
+  while(first != vec.end()) {
+    if((*first).iov_len == 0) {
+      ++first;
+      continue;
+    }
+    ssize_t ret = 0;
+#ifdef HAVE_PWRITEV
+    int cnt = std::min(static_cast<int>(vec.end()-first), IOV_MAX);
+    while((ret = pwritev(fd_, &(*first), cnt, offset+writtenLength)) == -1 &&
+          errno == EINTR);
+#else // !HAVE_PWRITEV
+    ret = writeDataInternal
+      (reinterpret_cast<const unsigned char*>((*first).iov_base),
+       (*first).iov_len, offset+writtenLength);
+#endif // !HAVE_PWRITEV
+    if(ret == -1) {
+      return -1;
+    }
+    writtenLength += ret;
+    // Skip buffers written completely and adjust the partially
+    // written one.
+    for(size_t rem = ret; rem > 0;) {
+      if(rem >= (*first).iov_len) {
+        rem -= (*first).iov_len;
+        ++first;
+      } else {
+        (*first).iov_base = reinterpret_cast<char*>((*first).iov_base)+rem;
+        (*first).iov_len -= rem;
+        rem = 0;
+      }
+    }
+  }
+  return writtenLength;
+}
+
 void AbstractDiskWriter::seek(off_t offset)
 {
   if(a2lseek(fd_, offset, SEEK_SET) == (off_t)-1) {
     throw DL_ABORT_EX
-      (StringFormat(EX_FILE_SEEK, filename_.c_str(), strerror(errno)).str());
+      (StringFormat(EX_FILE_SEEK, filename_.c_str(),
+                    util::safeStrerror(errno).c_str()).str());
+  }
+}
+
+void AbstractDiskWriter::throwOnWriteError()
+{
+  // If errno is ENOSPC(not enough space in device), throw
+  // DownloadFailureException and abort download instantly.
+  if(errno == ENOSPC) {
+    throw DOWNLOAD_FAILURE_EXCEPTION
+      (StringFormat(EX_FILE_WRITE, filename_.c_str(),
+                    util::safeStrerror(errno).c_str()).str());
   }
+  throw DL_ABORT_EX(StringFormat(EX_FILE_WRITE,
+                                 filename_.c_str(),
+                                 util::safeStrerror(errno).c_str()).str());
 }
 
 void AbstractDiskWriter::writeData(const unsigned char* data, size_t len, off_t offset)
 {
-  seek(offset);
-  if(writeDataInternal(data, len) < 0) {
-    // If errno is ENOSPC(not enough space in device), throw
-    // DownloadFailureException and abort download instantly.
-    if(errno == ENOSPC) {
-      throw DOWNLOAD_FAILURE_EXCEPTION
-        (StringFormat(EX_FILE_WRITE, filename_.c_str(), strerror(errno)).str());
-    }
-    throw DL_ABORT_EX(StringFormat(EX_FILE_WRITE,
-                                   filename_.c_str(), strerror(errno)).str());
+  if(writeDataInternal(data, len, offset) < 0) {
+    throwOnWriteError();
   }
 }
 
 ssize_t AbstractDiskWriter::readData(unsigned char* data, size_t len, off_t offset)
 {
   ssize_t ret;
-  seek(offset);
-  if((ret = readDataInternal(data, len)) < 0) {
+  if((ret = readDataInternal(data, len, offset)) < 0) {
     throw DL_ABORT_EX(StringFormat(EX_FILE_READ,
-                                   filename_.c_str(), strerror(errno)).str());
+                                   filename_.c_str(),
+                                   util::safeStrerror(errno).c_str()).str());
   }
   return ret;
 }
 
+void AbstractDiskWriter::writeDataVec
+(const struct iovec* iov, int iovcnt, off_t offset)
+{
+  if(writeDataVecInternal(iov, iovcnt, offset) < 0) {
+    throwOnWriteError();
+  }
+}
+
+ssize_t AbstractDiskWriter::readDataVec
+(const struct iovec* iov, int iovcnt, off_t offset)
+{
+#ifdef HAVE_PREADV
+  ssize_t totalReadLength = 0;
+  for(int i = 0; i < iovcnt;) {
+    int cnt = std::min(iovcnt-i, IOV_MAX);
+    ssize_t ret = 0;
+    while((ret = preadv(fd_, &iov[i], cnt, offset+totalReadLength)) == -1 &&
+          errno == EINTR);
+    if(ret < 0) {
+      throw DL_ABORT_EX(StringFormat(EX_FILE_READ,
+                                     filename_.c_str(),
+                                     util::safeStrerror(errno).c_str()).str());
+    }
+    totalReadLength += ret;
+    size_t len = 0;
+    for(int j = i; j < i+cnt; ++j) {
+      len += iov[j].iov_len;
+    }
+    if(static_cast<size_t>(ret) < len) {
+      break;
+    }
+    i += cnt;
+  }
+  return totalReadLength;
+#else // !HAVE_PREADV
+  return DiskWriter::readDataVec(iov, iovcnt, offset);
+#endif // !HAVE_PREADV
+}
+
 void AbstractDiskWriter::truncate(uint64_t length)
 {
   if(fd_ == -1) {
@@ -188,7 +299,7 @@ void AbstractDiskWriter::truncate(uint64_t length)
 #else
   if(ftruncate(fd_, length) == -1) {
     throw DL_ABORT_EX(StringFormat("ftruncate failed. cause: %s",
-                                   strerror(errno)).str());
+                                   util::safeStrerror(errno).c_str()).str());
   }
 #endif
 }
@@ -205,13 +316,13 @@ void AbstractDiskWriter::allocate(off_t offset, uint64_t length)
   int r = fallocate(fd_, 0, offset, length);
   if(r == -1) {
     throw DL_ABORT_EX(StringFormat("fallocate failed. cause: %s",
-                                   strerror(errno)).str());
+                                   util::safeStrerror(errno).c_str()).str());
   }
 # elif HAVE_POSIX_FALLOCATE
   int r = posix_fallocate(fd_, offset, length);
   if(r != 0) {
     throw DL_ABORT_EX(StringFormat("posix_fallocate failed. cause: %s",
-                                   strerror(r)).str());
+                                   util::safeStrerror(r).c_str()).str());
   }
 # else
 #  error "no *_fallocate function available."
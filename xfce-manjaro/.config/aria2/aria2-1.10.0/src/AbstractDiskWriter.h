@@ -53,8 +53,14 @@ private:
 
   Logger* logger_;
 
-  ssize_t writeDataInternal(const unsigned char* data, size_t len);
-  ssize_t readDataInternal(unsigned char* data, size_t len);
+  ssize_t writeDataInternal(const unsigned char* data, size_t len,
+                            off_t offset);
+  ssize_t readDataInternal(unsigned char* data, size_t len, off_t offset);
+
+  ssize_t writeDataVecInternal(const struct iovec* iov, int iovcnt,
+                               off_t offset);
+
+  void throwOnWriteError();
 
   void seek(off_t offset);
 protected:
@@ -73,6 +79,10 @@ public:
 
   virtual ssize_t readData(unsigned char* data, size_t len, off_t offset);
 
+  virtual void writeDataVec(const struct iovec* iov, int iovcnt, off_t offset);
+
+  virtual ssize_t readDataVec(const struct iovec* iov, int iovcnt, off_t offset);
+
   virtual void truncate(uint64_t length);
 
   // File must be opened before calling this function.
@@ -89,6 +99,8 @@ public:
   virtual void enableReadOnly();
 
   virtual void disableReadOnly();
+
+  virtual int getFd() const { return fd_; }
 };
 
 } // namespace aria2
@@ -80,6 +80,29 @@ ssize_t AbstractSingleDiskAdaptor::readData
   return diskWriter_->readData(data, len, offset);
 }
 
+void AbstractSingleDiskAdaptor::writeDataVec
+(const struct iovec* iov, int iovcnt, off_t offset)
+{
+  diskWriter_->writeDataVec(iov, iovcnt, offset);
+}
+
+ssize_t AbstractSingleDiskAdaptor::readDataVec
+(const struct iovec* iov, int iovcnt, off_t offset)
+{
+  return diskWriter_->readDataVec(iov, iovcnt, offset);
+}
+
+size_t AbstractSingleDiskAdaptor::getFileRange
+(int& fd, off_t& fileOffset, off_t offset, size_t len)
+{
+  fd = diskWriter_->getFd();
+  if(fd == -1) {
+    return 0;
+  }
+  fileOffset = offset;
+  return len;
+}
+
 bool AbstractSingleDiskAdaptor::fileExists()
 {
   return File(getFilePath()).exists();
@@ -95,6 +118,11 @@ void AbstractSingleDiskAdaptor::truncate(uint64_t length)
   diskWriter_->truncate(length);
 }
 
+void AbstractSingleDiskAdaptor::allocate(off_t offset, uint64_t length)
+{
+  diskWriter_->allocate(offset, length);
+}
+
 SharedHandle<FileAllocationIterator>
 AbstractSingleDiskAdaptor::fileAllocationIterator()
 {
@@ -40,6 +40,7 @@
 #include <unistd.h>
 
 #include "SharedHandle.h"
+#include "a2io.h"
 
 namespace aria2 {
 
@@ -51,6 +52,37 @@ public:
 
   virtual ssize_t readData(unsigned char* data, size_t len, off_t offset) = 0;
 
+  // Writes iovcnt buffers pointed by iov to the contiguous region
+  // starting at offset, in the order they appear in iov. The default
+  // implementation calls writeData() for each buffer.
+  virtual void writeDataVec(const struct iovec* iov, int iovcnt, off_t offset)
+  {
+    for(int i = 0; i < iovcnt; ++i) {
+      writeData(reinterpret_cast<const unsigned char*>(iov[i].iov_base),
+                iov[i].iov_len, offset);
+      offset += iov[i].iov_len;
+    }
+  }
+
+  // Reads the contiguous region starting at offset into iovcnt
+  // buffers pointed by iov and returns the number of bytes read. The
+  // default implementation calls readData() for each buffer and stops
+  // at the first short read.
+  virtual ssize_t readDataVec(const struct iovec* iov, int iovcnt, off_t offset)
+  {
+    ssize_t totalReadLength = 0;
+    for(int i = 0; i < iovcnt; ++i) {
+      ssize_t r = readData(reinterpret_cast<unsigned char*>(iov[i].iov_base),
+                           iov[i].iov_len, offset);
+      totalReadLength += r;
+      if(static_cast<size_t>(r) < iov[i].iov_len) {
+        break;
+      }
+      offset += r;
+    }
+    return totalReadLength;
+  }
+
   // Truncates a file to given length. The default implementation does
   // nothing.
   virtual void truncate(uint64_t length) {}
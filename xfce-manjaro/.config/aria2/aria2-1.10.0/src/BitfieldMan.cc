@@ -148,30 +148,15 @@ bool BitfieldMan::hasMissingPiece
   if(bitfieldLength_ != length) {
     return false;
   }
-  bool retval = false;
-  for(size_t i = 0; i < bitfieldLength_; ++i) {
-    unsigned char temp = peerBitfield[i] & ~bitfield_[i];
-    if(filterEnabled_) {
-      temp &= filterBitfield_[i];
-    }
-    if(temp&0xff) {
-      retval = true;
-      break;
-    }
-  }
-  return retval;
+  return bitfield::computeBits
+    (0, peerBitfield, getEnabledFilterBitfield(), bitfield_, 0, blocks_);
 }
 
 bool BitfieldMan::getFirstMissingUnusedIndex(size_t& index) const
 {
-  if(filterEnabled_) {
-    return bitfield::getFirstMissingIndex
-      (index, ~array(bitfield_)&~array(useBitfield_)&array(filterBitfield_),
-       blocks_);
-  } else {
-    return bitfield::getFirstMissingIndex
-      (index, ~array(bitfield_)&~array(useBitfield_), blocks_);
-  }
+  return bitfield::findFirstBit
+    (index, getEnabledFilterBitfield(), 0, bitfield_, useBitfield_,
+     blocks_);
 }
 
 size_t BitfieldMan::getFirstNMissingUnusedIndex
@@ -190,12 +175,8 @@ size_t BitfieldMan::getFirstNMissingUnusedIndex
 
 bool BitfieldMan::getFirstMissingIndex(size_t& index) const
 {
-  if(filterEnabled_) {
-    return bitfield::getFirstMissingIndex
-      (index, ~array(bitfield_)&array(filterBitfield_), blocks_);
-  } else {
-    return bitfield::getFirstMissingIndex(index, ~array(bitfield_), blocks_);
-  }
+  return bitfield::findFirstBit
+    (index, getEnabledFilterBitfield(), 0, bitfield_, 0, blocks_);
 }
 
 template<typename Array>
@@ -299,30 +280,12 @@ bool BitfieldMan::getSparseMissingUnusedIndex
   }
 }
 
-template<typename Array>
-static bool copyBitfield(unsigned char* dst, const Array& src, size_t blocks)
-{
-  unsigned char bits = 0;
-  size_t len = (blocks+7)/8;
-  for(size_t i = 0; i < len-1; ++i) {
-    dst[i] = src[i];
-    bits |= dst[i];
-  }
-  dst[len-1] = src[len-1]&bitfield::lastByteMask(blocks);
-  bits |= dst[len-1];
-  return bits != 0;
-}
-
 bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield, size_t len)
   const
 {
   assert(len == bitfieldLength_);
-  if(filterEnabled_) {
-    return copyBitfield
-      (misbitfield, ~array(bitfield_)&array(filterBitfield_), blocks_);
-  } else {
-    return copyBitfield(misbitfield, ~array(bitfield_), blocks_);
-  }
+  return bitfield::computeBits
+    (misbitfield, getEnabledFilterBitfield(), 0, bitfield_, 0, blocks_);
 }
 
 bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield, size_t len,
@@ -333,16 +296,9 @@ bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield, size_t len,
   if(bitfieldLength_ != peerBitfieldLength) {
     return false;
   }
-  if(filterEnabled_) {
-    return copyBitfield
-      (misbitfield,
-       ~array(bitfield_)&array(peerBitfield)&array(filterBitfield_),
-       blocks_);
-  } else {
-    return copyBitfield
-      (misbitfield, ~array(bitfield_)&array(peerBitfield),
-       blocks_);
-  }
+  return bitfield::computeBits
+    (misbitfield, peerBitfield, getEnabledFilterBitfield(), bitfield_, 0,
+     blocks_);
 }
 
 bool BitfieldMan::getAllMissingUnusedIndexes(unsigned char* misbitfield,
@@ -354,18 +310,9 @@ bool BitfieldMan::getAllMissingUnusedIndexes(unsigned char* misbitfield,
   if(bitfieldLength_ != peerBitfieldLength) {
     return false;
   }
-  if(filterEnabled_) {
-    return copyBitfield
-      (misbitfield,
-       ~array(bitfield_)&~array(useBitfield_)&array(peerBitfield)&
-       array(filterBitfield_),
-       blocks_);
-  } else {
-    return copyBitfield
-      (misbitfield,
-       ~array(bitfield_)&~array(useBitfield_)&array(peerBitfield),
-       blocks_);
-  }
+  return bitfield::computeBits
+    (misbitfield, peerBitfield, getEnabledFilterBitfield(), bitfield_,
+     useBitfield_, blocks_);
 }
 
 size_t BitfieldMan::countMissingBlock() const {
@@ -373,22 +320,13 @@ size_t BitfieldMan::countMissingBlock() const {
 }
 
 size_t BitfieldMan::countMissingBlockNow() const {
-  if(filterEnabled_) {
-    array_ptr<unsigned char> temp(new unsigned char[bitfieldLength_]);
-    for(size_t i = 0; i < bitfieldLength_; ++i) {
-      temp[i] = bitfield_[i]&filterBitfield_[i];
-    }
-    size_t count =  bitfield::countSetBit(filterBitfield_, blocks_)-
-      bitfield::countSetBit(temp, blocks_);
-    return count;
-  } else {
-    return blocks_-bitfield::countSetBit(bitfield_, blocks_);
-  }
+  return bitfield::countBits
+    (getEnabledFilterBitfield(), 0, bitfield_, 0, blocks_);
 }
 
 size_t BitfieldMan::countFilteredBlockNow() const {
   if(filterEnabled_) {
-    return bitfield::countSetBit(filterBitfield_, blocks_);
+    return bitfield::countBits(filterBitfield_, 0, 0, 0, blocks_);
   } else {
     return 0;
   }
@@ -586,7 +524,8 @@ uint64_t BitfieldMan::getFilteredTotalLengthNow() const {
   if(!filterBitfield_) {
     return 0;
   }
-  size_t filteredBlocks = bitfield::countSetBit(filterBitfield_, blocks_);
+  size_t filteredBlocks =
+    bitfield::countBits(filterBitfield_, 0, 0, 0, blocks_);
   if(filteredBlocks == 0) {
     return 0;
   }
@@ -598,32 +537,20 @@ uint64_t BitfieldMan::getFilteredTotalLengthNow() const {
 }
 
 uint64_t BitfieldMan::getCompletedLength(bool useFilter) const {
-  unsigned char* temp;
-  if(useFilter) {
-    temp = new unsigned char[bitfieldLength_];
-    for(size_t i = 0; i < bitfieldLength_; ++i) {
-      temp[i] = bitfield_[i];
-      if(filterEnabled_) {
-        temp[i] &= filterBitfield_[i];
-      }
-    }
-  } else {
-    temp = bitfield_;
-  }
-  size_t completedBlocks = bitfield::countSetBit(temp, blocks_);
+  const unsigned char* filter = useFilter ? getEnabledFilterBitfield() : 0;
+  size_t completedBlocks =
+    bitfield::countBits(bitfield_, filter, 0, 0, blocks_);
   uint64_t completedLength = 0;
   if(completedBlocks == 0) {
     completedLength = 0;
   } else {
-    if(bitfield::test(temp, blocks_, blocks_-1)) {
+    if(bitfield::test(bitfield_, blocks_, blocks_-1) &&
+       (!filter || bitfield::test(filter, blocks_, blocks_-1))) {
       completedLength = ((uint64_t)completedBlocks-1)*blockLength_+getLastBlockLength();
     } else {
       completedLength = ((uint64_t)completedBlocks)*blockLength_;
     }
   }
-  if(useFilter) {
-    delete [] temp;
-  }
   return completedLength;
 }
 
@@ -72,6 +72,14 @@ private:
   // If filterBitfield_ is 0, allocate bitfieldLength_ bytes to it and
   // set 0 to all bytes.
   void ensureFilterBitfield();
+
+  // Returns filterBitfield_ if filter is enabled. Otherwise returns
+  // 0, which bitfield::computeBits() and friends treat as all bits
+  // set.
+  const unsigned char* getEnabledFilterBitfield() const
+  {
+    return filterEnabled_ ? filterBitfield_ : 0;
+  }
 public:
   // [startIndex, endIndex)
   class Range {
@@ -37,6 +37,8 @@
 #include <cstring>
 #include <cstdlib>
 #include <cassert>
+#include <vector>
+#include <algorithm>
 
 #include "bittorrent_helper.h"
 #include "util.h"
@@ -54,6 +56,7 @@
 #include "PeerConnection.h"
 #include "StringFormat.h"
 #include "DownloadContext.h"
+#include "BufferPool.h"
 
 namespace aria2 {
 
@@ -73,12 +76,12 @@ BtPieceMessage::BtPieceMessage
 
 BtPieceMessage::~BtPieceMessage()
 {
-  delete [] rawData_;
+  BufferPool::getInstance()->deallocate(rawData_);
 }
 
 void BtPieceMessage::setRawMessage(unsigned char* data)
 {
-  delete [] rawData_;
+  BufferPool::getInstance()->deallocate(rawData_);
   rawData_ = data;
   block_ = data+9;
 }
@@ -197,18 +200,45 @@ void BtPieceMessage::send()
 size_t BtPieceMessage::sendPieceData(off_t offset, size_t length) const
 {
   assert(length <= 16*1024);
-  unsigned char* buf = new unsigned char[length];
+  const SharedHandle<DiskAdaptor>& diskAdaptor =
+    getPieceStorage()->getDiskAdaptor();
+  // First, send the data directly from the file if possible. The
+  // block may span several files.
+  size_t sentLength = 0;
+  while(sentLength < length) {
+    int fd;
+    off_t fileOffset;
+    size_t len = diskAdaptor->getFileRange(fd, fileOffset, offset+sentLength,
+                                           length-sentLength);
+    if(len == 0) {
+      break;
+    }
+    ssize_t r = getPeerConnection()->sendFile(fd, fileOffset, len);
+    sentLength += r;
+    if(static_cast<size_t>(r) < len) {
+      break;
+    }
+  }
+  if(sentLength == length) {
+    return sentLength;
+  }
+  // Queue the rest of the data.
+  size_t rest = length-sentLength;
+  const SharedHandle<BufferPool>& pool = BufferPool::getInstance();
+  assert(rest <= pool->getBlockSize());
+  unsigned char* buf = pool->allocate();
   ssize_t r;
   try {
-    r = getPieceStorage()->getDiskAdaptor()->readData(buf, length, offset);
+    r = diskAdaptor->readData(buf, rest, offset+sentLength);
   } catch(RecoverableException& e) {
-    delete [] buf;
+    pool->deallocate(buf);
     throw;
   }
-  if(r == static_cast<ssize_t>(length)) {
-    getPeerConnection()->pushBytes(buf, length);
-    return getPeerConnection()->sendPendingData();
+  if(r == static_cast<ssize_t>(rest)) {
+    getPeerConnection()->pushPooledBytes(buf, rest);
+    return sentLength+getPeerConnection()->sendPendingData();
   } else {
+    pool->deallocate(buf);
     throw DL_ABORT_EX(EX_DATA_READ);
   }
 }
@@ -261,17 +291,23 @@ void BtPieceMessage::onWrongPiece(const SharedHandle<Piece>& piece)
 
 void BtPieceMessage::erasePieceOnDisk(const SharedHandle<Piece>& piece)
 {
-  size_t BUFSIZE = 4096;
+  const size_t BUFSIZE = 4096;
   unsigned char buf[BUFSIZE];
   memset(buf, 0, BUFSIZE);
-  off_t offset = (off_t)piece->getIndex()*downloadContext_->getPieceLength();
-  div_t res = div(piece->getLength(), BUFSIZE);
-  for(int i = 0; i < res.quot; ++i) {
-    getPieceStorage()->getDiskAdaptor()->writeData(buf, BUFSIZE, offset);
-    offset += BUFSIZE;
+  // All buffers point to the same zero-filled block so that the whole
+  // piece is cleared by one writeDataVec() call.
+  std::vector<struct iovec> iov;
+  for(size_t rem = piece->getLength(); rem > 0;) {
+    struct iovec v;
+    v.iov_base = buf;
+    v.iov_len = std::min(rem, BUFSIZE);
+    iov.push_back(v);
+    rem -= v.iov_len;
   }
-  if(res.rem > 0) {
-    getPieceStorage()->getDiskAdaptor()->writeData(buf, res.rem, offset);
+  if(!iov.empty()) {
+    off_t offset = (off_t)piece->getIndex()*downloadContext_->getPieceLength();
+    getPieceStorage()->getDiskAdaptor()->writeDataVec(&iov[0], iov.size(),
+                                                      offset);
   }
 }
 
@@ -88,6 +88,7 @@ public:
 
   // Stores raw message data. After this function call, this object
   // has ownership of data. Caller must not be free or alter data.
+  // data must be allocated by BufferPool::getInstance().
   // Member block is pointed to block starting position in data.
   void setRawMessage(unsigned char* data);
 
@@ -0,0 +1,97 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BufferPool.h"
+
+#include <algorithm>
+
+#include "a2functional.h"
+
+namespace aria2 {
+
+SharedHandle<BufferPool> BufferPool::instance_;
+
+const size_t BufferPool::BLOCK_SIZE;
+
+const size_t BufferPool::MAX_FREE_BLOCK;
+
+BufferPool::BufferPool(size_t blockSize, size_t maxFreeBlock):
+  blockSize_(blockSize),
+  maxFreeBlock_(maxFreeBlock),
+  numInUse_(0),
+  highWater_(0),
+  numMiss_(0) {}
+
+BufferPool::~BufferPool()
+{
+  std::for_each(freeBlocks_.begin(), freeBlocks_.end(), ArrayDeleter());
+}
+
+const SharedHandle<BufferPool>& BufferPool::getInstance()
+{
+  if(instance_.isNull()) {
+    instance_.reset(new BufferPool(BLOCK_SIZE, MAX_FREE_BLOCK));
+  }
+  return instance_;
+}
+
+unsigned char* BufferPool::allocate()
+{
+  unsigned char* block;
+  if(freeBlocks_.empty()) {
+    ++numMiss_;
+    block = new unsigned char[blockSize_];
+  } else {
+    block = freeBlocks_.back();
+    freeBlocks_.pop_back();
+  }
+  ++numInUse_;
+  highWater_ = std::max(highWater_, numInUse_);
+  return block;
+}
+
+void BufferPool::deallocate(unsigned char* block)
+{
+  if(!block) {
+    return;
+  }
+  --numInUse_;
+  if(freeBlocks_.size() < maxFreeBlock_) {
+    freeBlocks_.push_back(block);
+  } else {
+    delete [] block;
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,116 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_BUFFER_POOL_H_
+#define _D_BUFFER_POOL_H_
+
+#include "common.h"
+
+#include <vector>
+
+#include "SharedHandle.h"
+
+namespace aria2 {
+
+// Pool of fixed size memory blocks. Network buffers which hold a
+// BitTorrent block (16KiB) and its message header are allocated from
+// this pool, so that the hot paths do not call new[] and delete[] for
+// each message. Each block has exactly one owner at a time, which
+// returns it by deallocate().
+class BufferPool {
+private:
+  size_t blockSize_;
+
+  // The maximum number of blocks kept in freeBlocks_.
+  size_t maxFreeBlock_;
+
+  std::vector<unsigned char*> freeBlocks_;
+
+  size_t numInUse_;
+
+  size_t highWater_;
+
+  // The number of allocations which could not be served from
+  // freeBlocks_.
+  uint64_t numMiss_;
+
+  static SharedHandle<BufferPool> instance_;
+public:
+  BufferPool(size_t blockSize, size_t maxFreeBlock);
+
+  ~BufferPool();
+
+  // 16KiB block plus room for message header and padding.
+  static const size_t BLOCK_SIZE = 16*1024+256;
+
+  static const size_t MAX_FREE_BLOCK = 256;
+
+  // Returns the process-wide pool whose block size is BLOCK_SIZE.
+  static const SharedHandle<BufferPool>& getInstance();
+
+  // Returns a block of getBlockSize() bytes.
+  unsigned char* allocate();
+
+  // Returns block, which was allocated by allocate(), to this pool.
+  void deallocate(unsigned char* block);
+
+  size_t getBlockSize() const
+  {
+    return blockSize_;
+  }
+
+  size_t countInUse() const
+  {
+    return numInUse_;
+  }
+
+  size_t getHighWater() const
+  {
+    return highWater_;
+  }
+
+  uint64_t countMiss() const
+  {
+    return numMiss_;
+  }
+
+  size_t countFreeBlock() const
+  {
+    return freeBlocks_.size();
+  }
+};
+
+} // namespace aria2
+
+#endif // _D_BUFFER_POOL_H_
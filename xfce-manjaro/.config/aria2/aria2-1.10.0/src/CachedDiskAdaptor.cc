@@ -0,0 +1,283 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "CachedDiskAdaptor.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "DiskCache.h"
+#include "DiskCacheEntry.h"
+#include "FileEntry.h"
+#include "FileAllocationIterator.h"
+#include "Logger.h"
+#include "RecoverableException.h"
+#include "message.h"
+
+namespace aria2 {
+
+CachedDiskAdaptor::CachedDiskAdaptor
+(const SharedHandle<DiskAdaptor>& diskAdaptor,
+ const SharedHandle<DiskCache>& diskCache,
+ size_t pieceLength):
+  diskAdaptor_(diskAdaptor),
+  diskCache_(diskCache),
+  pieceLength_(pieceLength)
+{
+  setFileEntries(diskAdaptor->getFileEntries().begin(),
+                 diskAdaptor->getFileEntries().end());
+}
+
+CachedDiskAdaptor::~CachedDiskAdaptor()
+{
+  try {
+    flushCache();
+  } catch(RecoverableException& e) {
+    getLogger()->error(EX_EXCEPTION_CAUGHT, e);
+  }
+  // DiskCache must not refer to the entries after this object is
+  // gone, even if they could not be written.
+  for(std::map<size_t, SharedHandle<DiskCacheEntry> >::const_iterator i =
+        entries_.begin(), eoi = entries_.end(); i != eoi; ++i) {
+    diskCache_->remove((*i).second.get());
+  }
+}
+
+SharedHandle<DiskCacheEntry> CachedDiskAdaptor::getEntry(size_t index)
+{
+  std::map<size_t, SharedHandle<DiskCacheEntry> >::const_iterator i =
+    entries_.find(index);
+  if(i == entries_.end()) {
+    SharedHandle<DiskCacheEntry> entry
+      (new DiskCacheEntry(diskAdaptor_.get(), index));
+    entries_[index] = entry;
+    return entry;
+  } else {
+    return (*i).second;
+  }
+}
+
+void CachedDiskAdaptor::openFile()
+{
+  diskAdaptor_->openFile();
+}
+
+void CachedDiskAdaptor::closeFile()
+{
+  flushCache();
+  diskAdaptor_->closeFile();
+}
+
+void CachedDiskAdaptor::openExistingFile()
+{
+  diskAdaptor_->openExistingFile();
+}
+
+void CachedDiskAdaptor::initAndOpenFile()
+{
+  // Data cached for the old file is meaningless now.
+  for(std::map<size_t, SharedHandle<DiskCacheEntry> >::const_iterator i =
+        entries_.begin(), eoi = entries_.end(); i != eoi; ++i) {
+    diskCache_->remove((*i).second.get());
+  }
+  entries_.clear();
+  diskAdaptor_->initAndOpenFile();
+}
+
+void CachedDiskAdaptor::writeData
+(const unsigned char* data, size_t len, off_t offset)
+{
+  // Split data at piece boundaries so that each entry holds the data
+  // of exactly one piece.
+  while(len > 0) {
+    size_t index = offset/pieceLength_;
+    size_t wlen = std::min(static_cast<off_t>(len),
+                           static_cast<off_t>((index+1)*pieceLength_)-offset);
+    diskCache_->cacheData(getEntry(index).get(), data, wlen, offset);
+    data += wlen;
+    len -= wlen;
+    offset += wlen;
+  }
+}
+
+ssize_t CachedDiskAdaptor::readData
+(unsigned char* data, size_t len, off_t offset)
+{
+  if(len == 0) {
+    return 0;
+  }
+  size_t firstIndex = offset/pieceLength_;
+  size_t lastIndex = (offset+len-1)/pieceLength_;
+  bool covered = true;
+  for(size_t index = firstIndex; index <= lastIndex; ++index) {
+    std::map<size_t, SharedHandle<DiskCacheEntry> >::const_iterator i =
+      entries_.find(index);
+    off_t first = std::max(offset, static_cast<off_t>(index*pieceLength_));
+    off_t last = std::min(static_cast<off_t>(offset+len),
+                          static_cast<off_t>((index+1)*pieceLength_));
+    if(i == entries_.end() || !(*i).second->covers(first, last-first)) {
+      covered = false;
+      break;
+    }
+  }
+  ssize_t readLength;
+  if(covered) {
+    readLength = len;
+  } else {
+    readLength = diskAdaptor_->readData(data, len, offset);
+    // Data may be cached beyond the end of the file. The hole between
+    // them reads as zeros, just like after the data is written.
+    if(static_cast<size_t>(readLength) < len) {
+      memset(data+readLength, 0, len-readLength);
+    }
+  }
+  for(size_t index = firstIndex; index <= lastIndex; ++index) {
+    std::map<size_t, SharedHandle<DiskCacheEntry> >::const_iterator i =
+      entries_.find(index);
+    if(i == entries_.end()) {
+      continue;
+    }
+    off_t first = std::max(offset, static_cast<off_t>(index*pieceLength_));
+    off_t last = std::min(static_cast<off_t>(offset+len),
+                          static_cast<off_t>((index+1)*pieceLength_));
+    size_t copied = (*i).second->readData(data+(first-offset), last-first,
+                                           first);
+    if(copied > 0) {
+      readLength = std::max(readLength,
+                            static_cast<ssize_t>(first-offset+copied));
+    }
+  }
+  return readLength;
+}
+
+size_t CachedDiskAdaptor::getFileRange
+(int& fd, off_t& fileOffset, off_t offset, size_t len)
+{
+  if(len == 0) {
+    return 0;
+  }
+  size_t firstIndex = offset/pieceLength_;
+  size_t lastIndex = (offset+len-1)/pieceLength_;
+  if(entries_.lower_bound(firstIndex) != entries_.upper_bound(lastIndex)) {
+    return 0;
+  }
+  return diskAdaptor_->getFileRange(fd, fileOffset, offset, len);
+}
+
+bool CachedDiskAdaptor::fileExists()
+{
+  return diskAdaptor_->fileExists();
+}
+
+uint64_t CachedDiskAdaptor::size()
+{
+  flushCache();
+  return diskAdaptor_->size();
+}
+
+void CachedDiskAdaptor::truncate(uint64_t length)
+{
+  flushCache();
+  diskAdaptor_->truncate(length);
+}
+
+void CachedDiskAdaptor::allocate(off_t offset, uint64_t length)
+{
+  diskAdaptor_->allocate(offset, length);
+}
+
+SharedHandle<FileAllocationIterator>
+CachedDiskAdaptor::fileAllocationIterator()
+{
+  return diskAdaptor_->fileAllocationIterator();
+}
+
+void CachedDiskAdaptor::enableDirectIO()
+{
+  diskAdaptor_->enableDirectIO();
+}
+
+void CachedDiskAdaptor::disableDirectIO()
+{
+  diskAdaptor_->disableDirectIO();
+}
+
+void CachedDiskAdaptor::enableReadOnly()
+{
+  diskAdaptor_->enableReadOnly();
+}
+
+void CachedDiskAdaptor::disableReadOnly()
+{
+  diskAdaptor_->disableReadOnly();
+}
+
+bool CachedDiskAdaptor::isReadOnlyEnabled() const
+{
+  return diskAdaptor_->isReadOnlyEnabled();
+}
+
+void CachedDiskAdaptor::cutTrailingGarbage()
+{
+  flushCache();
+  diskAdaptor_->cutTrailingGarbage();
+}
+
+size_t CachedDiskAdaptor::utime(const Time& actime, const Time& modtime)
+{
+  flushCache();
+  return diskAdaptor_->utime(actime, modtime);
+}
+
+void CachedDiskAdaptor::flushCache()
+{
+  while(!entries_.empty()) {
+    std::map<size_t, SharedHandle<DiskCacheEntry> >::iterator i =
+      entries_.begin();
+    diskCache_->flush((*i).second.get());
+    entries_.erase(i);
+  }
+}
+
+void CachedDiskAdaptor::flushPiece(size_t index)
+{
+  std::map<size_t, SharedHandle<DiskCacheEntry> >::iterator i =
+    entries_.find(index);
+  if(i != entries_.end()) {
+    diskCache_->flush((*i).second.get());
+    entries_.erase(i);
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,131 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_CACHED_DISK_ADAPTOR_H_
+#define _D_CACHED_DISK_ADAPTOR_H_
+
+#include "DiskAdaptor.h"
+
+#include <map>
+
+namespace aria2 {
+
+class DiskCache;
+class DiskCacheEntry;
+
+// DiskAdaptor which buffers written data per piece in memory and
+// writes it to underlying DiskAdaptor when the piece is completed,
+// when the file is closed or when DiskCache runs out of its memory
+// budget. Reads are served from the cached data when possible.
+class CachedDiskAdaptor:public DiskAdaptor {
+private:
+  SharedHandle<DiskAdaptor> diskAdaptor_;
+
+  SharedHandle<DiskCache> diskCache_;
+
+  size_t pieceLength_;
+
+  std::map<size_t, SharedHandle<DiskCacheEntry> > entries_;
+
+  SharedHandle<DiskCacheEntry> getEntry(size_t index);
+public:
+  CachedDiskAdaptor(const SharedHandle<DiskAdaptor>& diskAdaptor,
+                    const SharedHandle<DiskCache>& diskCache,
+                    size_t pieceLength);
+
+  virtual ~CachedDiskAdaptor();
+
+  virtual void openFile();
+
+  virtual void closeFile();
+
+  virtual void openExistingFile();
+
+  virtual void initAndOpenFile();
+
+  virtual void writeData(const unsigned char* data, size_t len,
+                         off_t offset);
+
+  virtual ssize_t readData(unsigned char* data, size_t len, off_t offset);
+
+  // Returns 0 if any piece in the range has cached data, because the
+  // file does not have the latest data.
+  virtual size_t getFileRange
+  (int& fd, off_t& fileOffset, off_t offset, size_t len);
+
+  virtual bool fileExists();
+
+  virtual uint64_t size();
+
+  virtual void truncate(uint64_t length);
+
+  virtual void allocate(off_t offset, uint64_t length);
+
+  virtual SharedHandle<FileAllocationIterator> fileAllocationIterator();
+
+  virtual void enableDirectIO();
+
+  virtual void disableDirectIO();
+
+  virtual void enableReadOnly();
+
+  virtual void disableReadOnly();
+
+  virtual bool isReadOnlyEnabled() const;
+
+  virtual void cutTrailingGarbage();
+
+  virtual size_t utime(const Time& actime, const Time& modtime);
+
+  virtual void flushCache();
+
+  // Writes data cached for the piece at index to disk.
+  void flushPiece(size_t index);
+
+  const SharedHandle<DiskAdaptor>& getDiskAdaptor() const
+  {
+    return diskAdaptor_;
+  }
+
+  const SharedHandle<DiskCache>& getDiskCache() const
+  {
+    return diskCache_;
+  }
+};
+
+typedef SharedHandle<CachedDiskAdaptor> CachedDiskAdaptorHandle;
+
+} // namespace aria2
+
+#endif // _D_CACHED_DISK_ADAPTOR_H_
@@ -46,6 +46,10 @@
 #include "RequestGroupMan.h"
 #include "FileAllocationEntry.h"
 #include "ServerStatMan.h"
+#include "DiskIOJob.h"
+#ifdef ENABLE_DISK_IO_THREAD
+# include "DiskIOThreadPool.h"
+#endif // ENABLE_DISK_IO_THREAD
 
 namespace aria2 {
 
@@ -56,7 +60,52 @@ CheckIntegrityCommand::CheckIntegrityCommand
   entry_(entry)
 {}
 
-CheckIntegrityCommand::~CheckIntegrityCommand() {}
+CheckIntegrityCommand::~CheckIntegrityCommand()
+{
+#ifdef ENABLE_DISK_IO_THREAD
+  for(std::deque<SharedHandle<DiskIOJob> >::const_iterator i =
+        chunkJobs_.begin(), eoi = chunkJobs_.end(); i != eoi; ++i) {
+    (*i)->setCommand(0);
+  }
+#endif // ENABLE_DISK_IO_THREAD
+}
+
+bool CheckIntegrityCommand::validateChunk()
+{
+#ifdef ENABLE_DISK_IO_THREAD
+  const SharedHandle<DiskIOThreadPool>& pool =
+    getDownloadEngine()->getDiskIOThreadPool();
+  if(!pool.isNull() && entry_->concurrent()) {
+    for(std::deque<SharedHandle<DiskIOJob> >::iterator i = chunkJobs_.begin();
+        i != chunkJobs_.end();) {
+      if((*i)->completed()) {
+        entry_->finishChunkJob(*i);
+        i = chunkJobs_.erase(i);
+      } else {
+        ++i;
+      }
+    }
+    // Keep every thread busy while the next jobs are posted, but do not
+    // read far ahead of the hashing.
+    while(chunkJobs_.size() < pool->getNumThread()*2) {
+      SharedHandle<DiskIOJob> job = entry_->createChunkJob();
+      if(job.isNull()) {
+        break;
+      }
+      postDiskIOJob(job);
+      chunkJobs_.push_back(job);
+    }
+    if(chunkJobs_.empty()) {
+      return true;
+    }
+    setStatusInactive();
+    getDownloadEngine()->addCommand(this);
+    return false;
+  }
+#endif // ENABLE_DISK_IO_THREAD
+  return executeDiskIOJob
+    (createDiskIOJob(entry_, &CheckIntegrityEntry::validateChunk));
+}
 
 bool CheckIntegrityCommand::executeInternal()
 {
@@ -64,7 +113,9 @@ bool CheckIntegrityCommand::executeInternal()
     getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry();
     return true;
   }
-  entry_->validateChunk();
+  if(!entry_->finished() && !validateChunk()) {
+    return false;
+  }
   if(entry_->finished()) {
     getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry();
     // Enable control file saving here. See also
@@ -36,15 +36,28 @@
 #define _D_CHECK_INTEGRITY_COMMAND_H_
 
 #include "RealtimeCommand.h"
+
+#include <deque>
+
 #include "SharedHandle.h"
 
 namespace aria2 {
 
 class CheckIntegrityEntry;
+class DiskIOJob;
 
 class CheckIntegrityCommand : public RealtimeCommand {
 private:
   SharedHandle<CheckIntegrityEntry> entry_;
+#ifdef ENABLE_DISK_IO_THREAD
+  // The jobs created by CheckIntegrityEntry::createChunkJob() and not
+  // finished yet.
+  std::deque<SharedHandle<DiskIOJob> > chunkJobs_;
+#endif // ENABLE_DISK_IO_THREAD
+
+  // Validates chunks. Returns false if executeInternal() must return
+  // false and wait for disk I/O threads.
+  bool validateChunk();
 public:
   CheckIntegrityCommand(cuid_t cuid,
                         RequestGroup* requestGroup,
@@ -44,6 +44,7 @@
 #include "DownloadContext.h"
 #include "RequestGroupMan.h"
 #include "ServerStatMan.h"
+#include "DiskIOJob.h"
 
 namespace aria2 {
 
@@ -82,6 +83,21 @@ bool CheckIntegrityEntry::finished()
   return validator_->finished();
 }
 
+bool CheckIntegrityEntry::concurrent() const
+{
+  return validator_->concurrent();
+}
+
+SharedHandle<DiskIOJob> CheckIntegrityEntry::createChunkJob()
+{
+  return validator_->createChunkJob();
+}
+
+void CheckIntegrityEntry::finishChunkJob(const SharedHandle<DiskIOJob>& job)
+{
+  validator_->finishChunkJob(job);
+}
+
 void CheckIntegrityEntry::cutTrailingGarbage()
 {
   getRequestGroup()->getPieceStorage()->getDiskAdaptor()->cutTrailingGarbage();
@@ -98,7 +114,8 @@ void CheckIntegrityEntry::proceedFileAllocation
     entry->prepareForNextAction(commands, e);
   }
   // Disable directIO when fallocation() is going to be used.
-  if(getRequestGroup()->getOption()->get(PREF_FILE_ALLOCATION) == V_FALLOC) {
+  if(getRequestGroup()->getOption()->get(PREF_FILE_ALLOCATION) == V_FALLOC ||
+     getRequestGroup()->getOption()->get(PREF_FILE_ALLOCATION) == V_LAZY) {
     entry->disableDirectIO();
   }
 }
@@ -45,6 +45,7 @@ namespace aria2 {
 class IteratableValidator;
 class DownloadEngine;
 class FileAllocationEntry;
+class DiskIOJob;
 
 class CheckIntegrityEntry : public RequestGroupEntry,
                             public ProgressAwareEntry {
@@ -69,6 +70,13 @@ public:
 
   virtual bool finished();
 
+  // See IteratableValidator.
+  bool concurrent() const;
+
+  SharedHandle<DiskIOJob> createChunkJob();
+
+  void finishChunkJob(const SharedHandle<DiskIOJob>& job);
+
   virtual bool isValidationReady() = 0;
 
   virtual void initValidator() = 0;
@@ -42,6 +42,9 @@ namespace aria2 {
 
 class CheckIntegrityEntry;
 
+// Downloads are checked one at a time. With the disk I/O thread pool,
+// one check already keeps every worker thread busy, and checking two
+// files at once would only make their reads compete for the disk.
 typedef SequentialPicker<CheckIntegrityEntry> CheckIntegrityMan;
 
 } // namespace aria2
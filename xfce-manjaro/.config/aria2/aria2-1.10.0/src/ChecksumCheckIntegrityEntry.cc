@@ -37,6 +37,7 @@
 #include "DownloadContext.h"
 #include "FileEntry.h"
 #include "IteratableChecksumValidator.h"
+#include "DiskIOJob.h"
 #include "DownloadEngine.h"
 #include "PieceStorage.h"
 #include "RequestGroupMan.h"
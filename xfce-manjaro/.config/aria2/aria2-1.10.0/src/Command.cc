@@ -35,6 +35,7 @@
 #include "Command.h"
 #include "LogFactory.h"
 #include "Logger.h"
+#include "CommandScheduler.h"
 
 namespace aria2 {
 
@@ -44,7 +45,19 @@ Command::Command(cuid_t cuid):status_(STATUS_INACTIVE),
                               readEvent_(false),
                               writeEvent_(false),
                               errorEvent_(false),
-                              hupEvent_(false) {}
+                              hupEvent_(false),
+                              wakeupTime_(0),
+                              scheduler_(0),
+                              schedSlot_(-1),
+                              schedPrev_(0),
+                              schedNext_(0) {}
+
+Command::~Command()
+{
+  if(scheduler_) {
+    scheduler_->remove(this);
+  }
+}
 
 void Command::transitStatus()
 {
@@ -59,6 +72,19 @@ void Command::transitStatus()
 void Command::setStatus(STATUS status)
 {
   status_ = status;
+  if(scheduler_ && statusMatch(STATUS_ACTIVE)) {
+    scheduler_->activate(this);
+  }
+}
+
+void Command::setStatusActive()
+{
+  setStatus(STATUS_ACTIVE);
+}
+
+void Command::setStatusRealtime()
+{
+  setStatus(STATUS_REALTIME);
 }
 
 void Command::readEventReceived()
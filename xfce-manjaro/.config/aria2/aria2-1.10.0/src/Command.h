@@ -37,10 +37,12 @@
 
 #include "common.h"
 #include <stdint.h>
+#include <ctime>
 
 namespace aria2 {
 
 class Logger;
+class CommandScheduler;
 
 typedef int64_t cuid_t;
 
@@ -63,6 +65,19 @@ private:
   bool writeEvent_;
   bool errorEvent_;
   bool hupEvent_;
+
+  // The time, in seconds of global::wallclock, at which this command
+  // is executed if no event arrives. 0 means the next refresh of
+  // DownloadEngine.
+  time_t wakeupTime_;
+
+  // Links maintained by CommandScheduler.
+  friend class CommandScheduler;
+  CommandScheduler* scheduler_;
+  // Index of the list in CommandScheduler. -1 if not scheduled.
+  int schedSlot_;
+  Command* schedPrev_;
+  Command* schedNext_;
 protected:
   Logger* getLogger() const
   {
@@ -91,20 +106,29 @@ protected:
 public:
   Command(cuid_t cuid);
 
-  virtual ~Command() {}
+  virtual ~Command();
 
   virtual bool execute() = 0;
 
   cuid_t getCuid() const { return cuid_; }
 
-  void setStatusActive() { status_ = STATUS_ACTIVE; }
+  // Setting active or realtime status moves this command to the
+  // ready queue of CommandScheduler if it is waiting there.
+  void setStatusActive();
 
   void setStatusInactive() { status_ = STATUS_INACTIVE; }
 
-  void setStatusRealtime() { status_ = STATUS_REALTIME; }
+  void setStatusRealtime();
 
   void setStatus(STATUS status);
 
+  // Tells DownloadEngine not to execute this command until
+  // global::wallclock reaches time, unless an event arrives. This
+  // must be called before each DownloadEngine::addCommand(this).
+  void setWakeupTime(time_t time) { wakeupTime_ = time; }
+
+  time_t getWakeupTime() const { return wakeupTime_; }
+
   bool statusMatch(Command::STATUS statusFilter) const
   {
     return statusFilter <= status_;
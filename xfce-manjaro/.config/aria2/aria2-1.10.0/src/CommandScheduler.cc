@@ -0,0 +1,227 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "CommandScheduler.h"
+
+#include <cassert>
+
+#include "Command.h"
+
+namespace aria2 {
+
+CommandScheduler::CommandScheduler():now_(0), numCommands_(0), numWheel_(0)
+{
+  for(int i = 0; i < NUM_LISTS; ++i) {
+    lists_[i].head = lists_[i].tail = 0;
+    lists_[i].size = 0;
+  }
+}
+
+CommandScheduler::~CommandScheduler()
+{
+  for(int i = 0; i < NUM_LISTS; ++i) {
+    while(lists_[i].head) {
+      Command* command = lists_[i].head;
+      unlink(command);
+      command->scheduler_ = 0;
+    }
+  }
+}
+
+void CommandScheduler::pushBack(int slot, Command* command)
+{
+  CommandList& list = lists_[slot];
+  command->schedSlot_ = slot;
+  command->schedPrev_ = list.tail;
+  command->schedNext_ = 0;
+  if(list.tail) {
+    list.tail->schedNext_ = command;
+  } else {
+    list.head = command;
+  }
+  list.tail = command;
+  ++list.size;
+  if(slot >= WHEEL0_LIST) {
+    ++numWheel_;
+  }
+}
+
+void CommandScheduler::unlink(Command* command)
+{
+  int slot = command->schedSlot_;
+  CommandList& list = lists_[slot];
+  if(command->schedPrev_) {
+    command->schedPrev_->schedNext_ = command->schedNext_;
+  } else {
+    list.head = command->schedNext_;
+  }
+  if(command->schedNext_) {
+    command->schedNext_->schedPrev_ = command->schedPrev_;
+  } else {
+    list.tail = command->schedPrev_;
+  }
+  command->schedPrev_ = command->schedNext_ = 0;
+  command->schedSlot_ = -1;
+  --list.size;
+  if(slot >= WHEEL0_LIST) {
+    --numWheel_;
+  }
+}
+
+void CommandScheduler::moveAll(int dest, int src)
+{
+  while(lists_[src].head) {
+    Command* command = lists_[src].head;
+    unlink(command);
+    pushBack(dest, command);
+  }
+}
+
+void CommandScheduler::schedule(Command* command)
+{
+  time_t wakeupTime = command->wakeupTime_;
+  if(wakeupTime <= now_) {
+    pushBack(REFRESH_LIST, command);
+  } else if(wakeupTime-now_ < WHEEL_SIZE) {
+    pushBack(WHEEL0_LIST+(wakeupTime&WHEEL_MASK), command);
+  } else if(wakeupTime-now_ < WHEEL_SIZE*WHEEL_SIZE) {
+    pushBack(WHEEL1_LIST+((wakeupTime >> WHEEL_BITS)&WHEEL_MASK), command);
+  } else {
+    // Too far. Put it in the slot cascaded last, and it is scheduled
+    // again then.
+    pushBack(WHEEL1_LIST+(((now_ >> WHEEL_BITS)-1)&WHEEL_MASK), command);
+  }
+}
+
+void CommandScheduler::add(Command* command)
+{
+  assert(command->schedSlot_ == -1);
+  command->scheduler_ = this;
+  ++numCommands_;
+  if(command->statusMatch(Command::STATUS_ACTIVE)) {
+    pushBack(READY_LIST, command);
+  } else if(command->wakeupTime_ == 0) {
+    pushBack(REFRESH_LIST, command);
+  } else {
+    schedule(command);
+  }
+}
+
+void CommandScheduler::activate(Command* command)
+{
+  if(command->schedSlot_ != -1 && command->schedSlot_ != READY_LIST) {
+    unlink(command);
+    pushBack(READY_LIST, command);
+  }
+}
+
+void CommandScheduler::remove(Command* command)
+{
+  if(command->schedSlot_ != -1) {
+    unlink(command);
+    --numCommands_;
+  }
+  command->scheduler_ = 0;
+}
+
+void CommandScheduler::cascade(int slot)
+{
+  // Detach the slot first because some Commands may be scheduled to
+  // the same slot again.
+  CommandList temp = lists_[slot];
+  lists_[slot].head = lists_[slot].tail = 0;
+  lists_[slot].size = 0;
+  numWheel_ -= temp.size;
+  for(Command* command = temp.head; command;) {
+    Command* next = command->schedNext_;
+    schedule(command);
+    command = next;
+  }
+}
+
+void CommandScheduler::rebuild(time_t now)
+{
+  now_ = now;
+  for(int slot = WHEEL0_LIST; slot < NUM_LISTS; ++slot) {
+    cascade(slot);
+  }
+}
+
+void CommandScheduler::refresh(time_t now)
+{
+  if(numWheel_ == 0) {
+    now_ = now;
+  } else if(now < now_ || now-now_ >= WHEEL_SIZE*WHEEL_SIZE) {
+    // The clock jumped, or this is the first refresh.
+    rebuild(now);
+  } else {
+    while(now_ < now) {
+      ++now_;
+      if((now_&WHEEL_MASK) == 0) {
+        cascade(WHEEL1_LIST+((now_ >> WHEEL_BITS)&WHEEL_MASK));
+      }
+      moveAll(REFRESH_LIST, WHEEL0_LIST+(now_&WHEEL_MASK));
+    }
+  }
+  moveAll(READY_LIST, REFRESH_LIST);
+}
+
+void CommandScheduler::wakeAll()
+{
+  for(int slot = REFRESH_LIST; slot < NUM_LISTS; ++slot) {
+    moveAll(READY_LIST, slot);
+  }
+}
+
+Command* CommandScheduler::popReady()
+{
+  Command* command = lists_[READY_LIST].head;
+  if(command) {
+    unlink(command);
+    command->scheduler_ = 0;
+    command->wakeupTime_ = 0;
+    --numCommands_;
+  }
+  return command;
+}
+
+void CommandScheduler::deleteAll()
+{
+  wakeAll();
+  while(!empty()) {
+    delete popReady();
+  }
+}
+
+} // namespace aria2
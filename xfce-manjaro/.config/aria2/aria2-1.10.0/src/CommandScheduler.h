@@ -0,0 +1,153 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_COMMAND_SCHEDULER_H_
+#define _D_COMMAND_SCHEDULER_H_
+
+#include "common.h"
+
+#include <ctime>
+
+namespace aria2 {
+
+class Command;
+
+// Holds the Commands of DownloadEngine. Commands which have events
+// to process are kept in the ready queue, so that DownloadEngine does
+// not have to visit idle Commands in each iteration. The other
+// Commands wait for the next refresh of DownloadEngine, or for their
+// wakeup time (see Command::setWakeupTime()) in a 2 level
+// hierarchical timer wheel with 1 second resolution.
+//
+// The lists are intrusive: links are stored in Command, so that
+// moving a Command between lists is O(1).
+class CommandScheduler {
+private:
+  struct CommandList {
+    Command* head;
+    Command* tail;
+    size_t size;
+  };
+
+  static const int WHEEL_BITS = 6;
+  static const time_t WHEEL_SIZE = 1 << WHEEL_BITS;
+  static const time_t WHEEL_MASK = WHEEL_SIZE-1;
+
+  enum {
+    READY_LIST = 0,
+    REFRESH_LIST = 1,
+    WHEEL0_LIST = 2,
+    WHEEL1_LIST = WHEEL0_LIST+WHEEL_SIZE,
+    NUM_LISTS = WHEEL1_LIST+WHEEL_SIZE
+  };
+
+  CommandList lists_[NUM_LISTS];
+
+  // The last time refresh() was called.
+  time_t now_;
+
+  size_t numCommands_;
+
+  size_t numWheel_;
+
+  void pushBack(int slot, Command* command);
+
+  void unlink(Command* command);
+
+  void moveAll(int dest, int src);
+
+  void schedule(Command* command);
+
+  void cascade(int slot);
+
+  void rebuild(time_t now);
+
+  CommandScheduler(const CommandScheduler&);
+  CommandScheduler& operator=(const CommandScheduler&);
+public:
+  CommandScheduler();
+
+  // Commands still scheduled are not deleted. Call deleteAll() to
+  // delete them.
+  ~CommandScheduler();
+
+  // Adds command. Command whose status is active or realtime goes to
+  // the ready queue.
+  void add(Command* command);
+
+  // Moves command to the ready queue if it is waiting.
+  void activate(Command* command);
+
+  // Removes command from this object.
+  void remove(Command* command);
+
+  // Moves the Commands waiting for refresh and the Commands whose
+  // wakeup time has come by now to the ready queue.
+  void refresh(time_t now);
+
+  // Moves all Commands to the ready queue.
+  void wakeAll();
+
+  // Removes the first Command in the ready queue and returns it.
+  // Returns 0 if the ready queue is empty.
+  Command* popReady();
+
+  size_t countReady() const
+  {
+    return lists_[READY_LIST].size;
+  }
+
+  // Returns the number of Commands in the timer wheel.
+  size_t countWheel() const
+  {
+    return numWheel_;
+  }
+
+  size_t size() const
+  {
+    return numCommands_;
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  // Removes and deletes all Commands.
+  void deleteAll();
+};
+
+} // namespace aria2
+
+#endif // _D_COMMAND_SCHEDULER_H_
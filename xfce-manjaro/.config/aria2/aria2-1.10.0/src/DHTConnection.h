@@ -36,6 +36,9 @@
 #define _D_DHT_CONNECTION_H_
 
 #include "common.h"
+
+#include <sys/types.h>
+
 #include <string>
 
 namespace aria2 {
@@ -49,6 +52,15 @@ public:
 
   virtual ssize_t sendMessage(const unsigned char* data, size_t len,
                               const std::string& host, uint16_t port) = 0;
+
+  // Same as sendMessage() but the datagram may be held until
+  // flushMessages() is called, so that several datagrams are sent in
+  // one system call. Returns len if the datagram was queued or sent.
+  virtual ssize_t queueMessage(const unsigned char* data, size_t len,
+                               const std::string& host, uint16_t port) = 0;
+
+  // Sends the datagrams held by queueMessage().
+  virtual void flushMessages() = 0;
 };
 
 } // namespace aria2
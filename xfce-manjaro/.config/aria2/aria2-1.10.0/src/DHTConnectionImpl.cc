@@ -36,6 +36,7 @@
 
 #include <utility>
 #include <algorithm>
+#include <cstring>
 
 #include "LogFactory.h"
 #include "Logger.h"
@@ -43,10 +44,24 @@
 #include "util.h"
 #include "Socket.h"
 #include "SimpleRandomizer.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
+const size_t DHTConnectionImpl::BATCH_SIZE;
+
+const size_t DHTConnectionImpl::MAX_DATAGRAM_LENGTH;
+
 DHTConnectionImpl::DHTConnectionImpl():socket_(new SocketCore(SOCK_DGRAM)),
+                                       family_(AF_UNSPEC),
+                                       recvBegin_(0),
+                                       recvEnd_(0),
+                                       recvDrained_(false),
+                                       numQueued_(0),
+                                       numReceiveCall_(0),
+                                       numReceivedPacket_(0),
+                                       numSendCall_(0),
+                                       numSentPacket_(0),
                                        logger_(LogFactory::getInstance()) {}
 
 DHTConnectionImpl::~DHTConnectionImpl() {}
@@ -78,6 +93,7 @@ bool DHTConnectionImpl::bind(uint16_t& port)
     std::pair<std::string, uint16_t> svaddr;
     socket_->getAddrInfo(svaddr);
     port = svaddr.second;
+    family_ = svaddr.first.find(':') == std::string::npos ? AF_INET : AF_INET6;
     logger_->notice("DHT: listening to port %d", port);
     return true;
   } catch(RecoverableException& e) {
@@ -86,24 +102,173 @@ bool DHTConnectionImpl::bind(uint16_t& port)
   return false;
 }
 
+bool DHTConnectionImpl::fillReceiveBuffer()
+{
+#if defined HAVE_RECVMMSG && defined HAVE_SENDMMSG
+  // The previous call found the socket drained. Report no datagram
+  // once, so that the caller finishes this round without a system call
+  // which would only get EAGAIN.
+  if(recvDrained_) {
+    recvDrained_ = false;
+    return false;
+  }
+  if(recvBuf_.empty()) {
+    recvBuf_.resize(BATCH_SIZE*MAX_DATAGRAM_LENGTH);
+  }
+  struct mmsghdr msgs[BATCH_SIZE];
+  struct iovec iovs[BATCH_SIZE];
+  memset(msgs, 0, sizeof(msgs));
+  for(size_t i = 0; i < BATCH_SIZE; ++i) {
+    iovs[i].iov_base = &recvBuf_[i*MAX_DATAGRAM_LENGTH];
+    iovs[i].iov_len = MAX_DATAGRAM_LENGTH;
+    msgs[i].msg_hdr.msg_name = &recvAddrs_[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(recvAddrs_[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  ++numReceiveCall_;
+  int r = socket_->readDataFromBatch(msgs, BATCH_SIZE);
+  numReceivedPacket_ += r;
+  recvBegin_ = 0;
+  recvEnd_ = r;
+  recvDrained_ = 0 < r && static_cast<size_t>(r) < BATCH_SIZE;
+  for(int i = 0; i < r; ++i) {
+    recvAddrlens_[i] = msgs[i].msg_hdr.msg_namelen;
+    if(msgs[i].msg_hdr.msg_flags&MSG_TRUNC) {
+      recvLengths_[i] = MAX_DATAGRAM_LENGTH+1;
+    } else {
+      recvLengths_[i] = msgs[i].msg_len;
+    }
+  }
+  return r > 0;
+#else // !(HAVE_RECVMMSG && HAVE_SENDMMSG)
+  abort();
+#endif // !(HAVE_RECVMMSG && HAVE_SENDMMSG)
+}
+
 ssize_t DHTConnectionImpl::receiveMessage(unsigned char* data, size_t len,
                                           std::string& host, uint16_t& port)
 {
-  std::pair<std::string, uint16_t> remoteHost;
-  ssize_t length = socket_->readDataFrom(data, len, remoteHost);
-  if(length == 0) {
-    return length;
-  } else {
+  if(!socket_->supportsDatagramBatch()) {
+    std::pair<std::string, uint16_t> remoteHost;
+    ++numReceiveCall_;
+    ssize_t length = socket_->readDataFrom(data, len, remoteHost);
+    if(length == 0) {
+      return length;
+    } else {
+      ++numReceivedPacket_;
+      host = remoteHost.first;
+      port = remoteHost.second;
+      return length;
+    }
+  }
+  while(recvBegin_ != recvEnd_ || fillReceiveBuffer()) {
+    size_t i = recvBegin_++;
+    std::pair<std::string, uint16_t> remoteHost =
+      util::getNumericNameInfo
+      (reinterpret_cast<const struct sockaddr*>(&recvAddrs_[i]),
+       recvAddrlens_[i]);
+    if(recvLengths_[i] > MAX_DATAGRAM_LENGTH) {
+      logger_->info("Dropped DHT message longer than %lu bytes. From:%s:%u",
+                    static_cast<unsigned long>(MAX_DATAGRAM_LENGTH),
+                    remoteHost.first.c_str(), remoteHost.second);
+      continue;
+    }
+    size_t length = std::min(len, recvLengths_[i]);
+    memcpy(data, &recvBuf_[i*MAX_DATAGRAM_LENGTH], length);
     host = remoteHost.first;
     port = remoteHost.second;
     return length;
   }
+  return 0;
 }
 
 ssize_t DHTConnectionImpl::sendMessage(const unsigned char* data, size_t len,
                                        const std::string& host, uint16_t port)
 {
-  return socket_->writeData(data, len, host, port);
+  ++numSendCall_;
+  ssize_t r = socket_->writeData(data, len, host, port);
+  if(r > 0) {
+    ++numSentPacket_;
+  }
+  return r;
+}
+
+ssize_t DHTConnectionImpl::queueMessage(const unsigned char* data, size_t len,
+                                        const std::string& host, uint16_t port)
+{
+  if(!socket_->supportsDatagramBatch()) {
+    return sendMessage(data, len, host, port);
+  }
+  struct addrinfo* res;
+  int flags = AI_NUMERICHOST;
+  if(family_ == AF_INET6) {
+    flags |= AI_V4MAPPED;
+  }
+  if(callGetaddrinfo(&res, host.c_str(), util::uitos(port).c_str(), family_,
+                     SOCK_DGRAM, flags, 0)) {
+    // host is not a numeric address.
+    return sendMessage(data, len, host, port);
+  }
+  WSAAPI_AUTO_DELETE<struct addrinfo*> resDeleter(res, freeaddrinfo);
+  if(numQueued_ == sendQueue_.size()) {
+    sendQueue_.push_back(Datagram());
+  }
+  Datagram& d = sendQueue_[numQueued_++];
+  d.data.assign(reinterpret_cast<const char*>(data), len);
+  memcpy(&d.addr, res->ai_addr, res->ai_addrlen);
+  d.addrlen = res->ai_addrlen;
+  if(numQueued_ >= BATCH_SIZE) {
+    flushMessages();
+  }
+  return len;
+}
+
+void DHTConnectionImpl::flushMessages()
+{
+#if defined HAVE_RECVMMSG && defined HAVE_SENDMMSG
+  size_t sent = 0;
+  while(sent < numQueued_) {
+    size_t n = std::min(numQueued_-sent, BATCH_SIZE);
+    struct mmsghdr msgs[BATCH_SIZE];
+    struct iovec iovs[BATCH_SIZE];
+    memset(msgs, 0, sizeof(msgs));
+    for(size_t i = 0; i < n; ++i) {
+      Datagram& d = sendQueue_[sent+i];
+      iovs[i].iov_base = const_cast<char*>(d.data.data());
+      iovs[i].iov_len = d.data.size();
+      msgs[i].msg_hdr.msg_name = &d.addr;
+      msgs[i].msg_hdr.msg_namelen = d.addrlen;
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    ++numSendCall_;
+    int r;
+    try {
+      r = socket_->writeDataToBatch(msgs, n);
+    } catch(RecoverableException& e) {
+      // The first datagram cannot be sent. It is dropped and the query
+      // in it times out.
+      logger_->info("Failed to send DHT message.", e);
+      ++sent;
+      continue;
+    }
+    if(r == 0) {
+      break;
+    }
+    numSentPacket_ += r;
+    sent += r;
+  }
+  // Datagrams not sent because of EAGAIN are sent by the next call.
+  for(size_t i = sent; i < numQueued_; ++i) {
+    Datagram& src = sendQueue_[i];
+    Datagram& dst = sendQueue_[i-sent];
+    dst.data.swap(src.data);
+    dst.addr = src.addr;
+    dst.addrlen = src.addrlen;
+  }
+  numQueued_ -= sent;
+#endif // HAVE_RECVMMSG && HAVE_SENDMMSG
 }
 
 } // namespace aria2
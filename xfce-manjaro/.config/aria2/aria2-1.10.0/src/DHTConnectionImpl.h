@@ -36,8 +36,12 @@
 #define _D_DHT_CONNECTION_IMPL_H_
 
 #include "DHTConnection.h"
+
+#include <vector>
+
 #include "SharedHandle.h"
 #include "IntSequence.h"
+#include "a2netcompat.h"
 
 namespace aria2 {
 
@@ -45,10 +49,51 @@ class SocketCore;
 class Logger;
 
 class DHTConnectionImpl:public DHTConnection {
+public:
+  // The maximum number of datagrams received or sent in one system
+  // call.
+  static const size_t BATCH_SIZE = 32;
+
+  // Datagrams longer than this are dropped when they are received in
+  // batch. DHT messages fit in a single IP packet.
+  static const size_t MAX_DATAGRAM_LENGTH = 4096;
 private:
+  struct Datagram {
+    std::string data;
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+  };
+
   SharedHandle<SocketCore> socket_;
 
+  int family_;
+
+  // Slots for the datagrams received by one system call. Each slot is
+  // MAX_DATAGRAM_LENGTH bytes.
+  std::vector<unsigned char> recvBuf_;
+  struct sockaddr_storage recvAddrs_[BATCH_SIZE];
+  socklen_t recvAddrlens_[BATCH_SIZE];
+  size_t recvLengths_[BATCH_SIZE];
+  size_t recvBegin_;
+  size_t recvEnd_;
+
+  // True if the last system call returned fewer datagrams than
+  // BATCH_SIZE, which means the socket had no more to read.
+  bool recvDrained_;
+
+  // The first numQueued_ entries hold datagrams waiting for
+  // flushMessages(). The entries are reused to keep their buffers.
+  std::vector<Datagram> sendQueue_;
+  size_t numQueued_;
+
+  uint64_t numReceiveCall_;
+  uint64_t numReceivedPacket_;
+  uint64_t numSendCall_;
+  uint64_t numSentPacket_;
+
   Logger* logger_;
+
+  bool fillReceiveBuffer();
 public:
   DHTConnectionImpl();
 
@@ -77,6 +122,33 @@ public:
   virtual ssize_t sendMessage(const unsigned char* data, size_t len,
                               const std::string& host, uint16_t port);
 
+  virtual ssize_t queueMessage(const unsigned char* data, size_t len,
+                               const std::string& host, uint16_t port);
+
+  virtual void flushMessages();
+
+  // The number of system calls made to receive and send datagrams and
+  // the number of datagrams they transferred.
+  uint64_t getNumReceiveCall() const
+  {
+    return numReceiveCall_;
+  }
+
+  uint64_t getNumReceivedPacket() const
+  {
+    return numReceivedPacket_;
+  }
+
+  uint64_t getNumSendCall() const
+  {
+    return numSendCall_;
+  }
+
+  uint64_t getNumSentPacket() const
+  {
+    return numSentPacket_;
+  }
+
   const SharedHandle<SocketCore>& getSocket() const
   {
     return socket_;
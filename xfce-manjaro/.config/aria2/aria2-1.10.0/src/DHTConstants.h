@@ -60,6 +60,13 @@
 
 #define DHT_PEER_ANNOUNCE_CHECK_INTERVAL (5*60)
 
+// The maximum number of peers stored for one info hash. A get_peers
+// reply carries at most this number of peers.
+#define DHT_MAX_PEER_ANNOUNCE_PER_INFO_HASH 100
+
+// The maximum number of peers stored for all info hashes.
+#define DHT_MAX_PEER_ANNOUNCE 100000
+
 #define DHT_TOKEN_UPDATE_INTERVAL (10*60)
 
 #endif // _D_DHT_CONSTANTS_H_
@@ -43,6 +43,7 @@
 #include "DHTConstants.h"
 #include "StringFormat.h"
 #include "DHTNode.h"
+#include "DHTConnection.h"
 
 namespace aria2 {
 
@@ -114,6 +115,10 @@ void DHTMessageDispatcherImpl::sendMessages()
     }
   }
   messageQueue_.erase(messageQueue_.begin(), itr);
+  // Messages sent above are held by the connection to be sent together.
+  if(!connection_.isNull()) {
+    connection_->flushMessages();
+  }
   if(logger_->debug()) {
     logger_->debug("%lu dht messages remaining in the queue.",
                    static_cast<unsigned long>(messageQueue_.size()));
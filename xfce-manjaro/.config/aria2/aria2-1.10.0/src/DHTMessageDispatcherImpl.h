@@ -41,6 +41,7 @@
 namespace aria2 {
 
 class DHTMessageTracker;
+class DHTConnection;
 struct DHTMessageEntry;
 class Logger;
 
@@ -48,6 +49,8 @@ class DHTMessageDispatcherImpl:public DHTMessageDispatcher {
 private:
   SharedHandle<DHTMessageTracker> tracker_;
 
+  SharedHandle<DHTConnection> connection_;
+
   std::deque<SharedHandle<DHTMessageEntry> > messageQueue_;
 
   time_t timeout_;
@@ -75,6 +78,13 @@ public:
 
   virtual size_t countMessageInQueue() const;
 
+  // Sets the connection whose queued datagrams are flushed at the end
+  // of sendMessages().
+  void setConnection(const SharedHandle<DHTConnection>& connection)
+  {
+    connection_ = connection;
+  }
+
   void setTimeout(time_t timeout)
   {
     timeout_ = timeout;
@@ -35,6 +35,7 @@
 #include "DHTMessageTracker.h"
 
 #include <utility>
+#include <algorithm>
 
 #include "DHTMessage.h"
 #include "DHTMessageCallback.h"
@@ -52,14 +53,47 @@
 namespace aria2 {
 
 DHTMessageTracker::DHTMessageTracker():
-  logger_(LogFactory::getInstance()) {}
+  numTimeout_(0), logger_(LogFactory::getInstance()) {}
 
 DHTMessageTracker::~DHTMessageTracker() {}
 
 void DHTMessageTracker::addMessage(const SharedHandle<DHTMessage>& message, time_t timeout, const SharedHandle<DHTMessageCallback>& callback)
 {
   SharedHandle<DHTMessageTrackerEntry> e(new DHTMessageTrackerEntry(message, timeout, callback));
-  entries_.push_back(e);
+  TimeoutQueue::iterator i =
+    timeouts_.insert(std::make_pair(e->getDeadline(), e));
+  index_[e->getTransactionID()].push_back(i);
+}
+
+bool DHTMessageTracker::findEntry
+(TimeoutQueue::iterator& result, const std::string& transactionID,
+ const std::string& ipaddr, uint16_t port) const
+{
+  UnorderedMap<std::string, std::vector<TimeoutQueue::iterator> >::type::
+    const_iterator i = index_.find(transactionID);
+  if(i != index_.end()) {
+    for(std::vector<TimeoutQueue::iterator>::const_iterator j =
+          (*i).second.begin(), eoj = (*i).second.end(); j != eoj; ++j) {
+      if((**j).second->match(transactionID, ipaddr, port)) {
+        result = *j;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void DHTMessageTracker::removeEntry(TimeoutQueue::iterator i)
+{
+  UnorderedMap<std::string, std::vector<TimeoutQueue::iterator> >::type::
+    iterator itr = index_.find((*i).second->getTransactionID());
+  std::vector<TimeoutQueue::iterator>& v = (*itr).second;
+  if(v.size() == 1) {
+    index_.erase(itr);
+  } else {
+    v.erase(std::find(v.begin(), v.end(), i));
+  }
+  timeouts_.erase(i);
 }
 
 std::pair<SharedHandle<DHTResponseMessage>, SharedHandle<DHTMessageCallback> >
@@ -75,69 +109,64 @@ DHTMessageTracker::messageArrived
     logger_->debug("Searching tracker entry for TransactionID=%s, Remote=%s:%u",
                    util::toHex(tid->s()).c_str(), ipaddr.c_str(), port);
   }
-  for(std::deque<SharedHandle<DHTMessageTrackerEntry> >::iterator i =
-        entries_.begin(), eoi = entries_.end(); i != eoi; ++i) {
-    if((*i)->match(tid->s(), ipaddr, port)) {
-      SharedHandle<DHTMessageTrackerEntry> entry = *i;
-      entries_.erase(i);
-      if(logger_->debug()) {
-        logger_->debug("Tracker entry found.");
-      }
-      SharedHandle<DHTNode> targetNode = entry->getTargetNode();
-
-      SharedHandle<DHTResponseMessage> message =
-        factory_->createResponseMessage(entry->getMessageType(), dict,
-                                        targetNode->getIPAddress(),
-                                        targetNode->getPort());
-
-      int64_t rtt = entry->getElapsedMillis();
-      if(logger_->debug()) {
-        logger_->debug("RTT is %s", util::itos(rtt).c_str());
-      }
-      message->getRemoteNode()->updateRTT(rtt);
-      SharedHandle<DHTMessageCallback> callback = entry->getCallback();
-      return std::make_pair(message, callback);
+  TimeoutQueue::iterator i;
+  if(!findEntry(i, tid->s(), ipaddr, port)) {
+    if(logger_->debug()) {
+      logger_->debug("Tracker entry not found.");
     }
+    return std::pair<SharedHandle<DHTResponseMessage>,
+                     SharedHandle<DHTMessageCallback> >();
   }
+  SharedHandle<DHTMessageTrackerEntry> entry = (*i).second;
+  removeEntry(i);
+  if(logger_->debug()) {
+    logger_->debug("Tracker entry found.");
+  }
+  SharedHandle<DHTNode> targetNode = entry->getTargetNode();
+
+  SharedHandle<DHTResponseMessage> message =
+    factory_->createResponseMessage(entry->getMessageType(), dict,
+                                    targetNode->getIPAddress(),
+                                    targetNode->getPort());
+
+  int64_t rtt = entry->getElapsedMillis();
   if(logger_->debug()) {
-    logger_->debug("Tracker entry not found.");
+    logger_->debug("RTT is %s", util::itos(rtt).c_str());
   }
-  return std::pair<SharedHandle<DHTResponseMessage>,
-                   SharedHandle<DHTMessageCallback> >();
+  message->getRemoteNode()->updateRTT(rtt);
+  SharedHandle<DHTMessageCallback> callback = entry->getCallback();
+  return std::make_pair(message, callback);
 }
 
 void DHTMessageTracker::handleTimeout()
 {
-  for(std::deque<SharedHandle<DHTMessageTrackerEntry> >::iterator i =
-        entries_.begin(), eoi = entries_.end(); i != eoi;) {
-    if((*i)->isTimeout()) {
-      try {
-        SharedHandle<DHTMessageTrackerEntry> entry = *i;
-        i = entries_.erase(i);
-        eoi = entries_.end();
-        SharedHandle<DHTNode> node = entry->getTargetNode();
+  // Entries are removed before their callbacks run, so that callbacks
+  // can add new messages.
+  while(!timeouts_.empty() && (*timeouts_.begin()).second->isTimeout()) {
+    SharedHandle<DHTMessageTrackerEntry> entry = (*timeouts_.begin()).second;
+    removeEntry(timeouts_.begin());
+    ++numTimeout_;
+    try {
+      SharedHandle<DHTNode> node = entry->getTargetNode();
+      if(logger_->debug()) {
+        logger_->debug("Message timeout: To:%s:%u",
+                       node->getIPAddress().c_str(), node->getPort());
+      }
+      node->updateRTT(entry->getElapsedMillis());
+      node->timeout();
+      if(node->isBad()) {
         if(logger_->debug()) {
-          logger_->debug("Message timeout: To:%s:%u",
+          logger_->debug("Marked bad: %s:%u",
                          node->getIPAddress().c_str(), node->getPort());
         }
-        node->updateRTT(entry->getElapsedMillis());
-        node->timeout();
-        if(node->isBad()) {
-          if(logger_->debug()) {
-            logger_->debug("Marked bad: %s:%u",
-                           node->getIPAddress().c_str(), node->getPort());
-          }
-          routingTable_->dropNode(node);
-        }
-        SharedHandle<DHTMessageCallback> callback = entry->getCallback();
-        if(!callback.isNull()) {
-          callback->onTimeout(node);
-        }
-      } catch(RecoverableException& e) {
-        logger_->info("Exception thrown while handling timeouts.", e);
+        routingTable_->dropNode(node);
       }
-    } else {
-      ++i;
+      SharedHandle<DHTMessageCallback> callback = entry->getCallback();
+      if(!callback.isNull()) {
+        callback->onTimeout(node);
+      }
+    } catch(RecoverableException& e) {
+      logger_->info("Exception thrown while handling timeouts.", e);
     }
   }
 }
@@ -145,20 +174,19 @@ void DHTMessageTracker::handleTimeout()
 SharedHandle<DHTMessageTrackerEntry>
 DHTMessageTracker::getEntryFor(const SharedHandle<DHTMessage>& message) const
 {
-  for(std::deque<SharedHandle<DHTMessageTrackerEntry> >::const_iterator i =
-        entries_.begin(), eoi = entries_.end(); i != eoi; ++i) {
-    if((*i)->match(message->getTransactionID(),
-                   message->getRemoteNode()->getIPAddress(),
-                   message->getRemoteNode()->getPort())) {
-      return *i;
-    }
+  TimeoutQueue::iterator i;
+  if(findEntry(i, message->getTransactionID(),
+               message->getRemoteNode()->getIPAddress(),
+               message->getRemoteNode()->getPort())) {
+    return (*i).second;
+  } else {
+    return SharedHandle<DHTMessageTrackerEntry>();
   }
-  return SharedHandle<DHTMessageTrackerEntry>();
 }
 
 size_t DHTMessageTracker::countEntry() const
 {
-  return entries_.size();
+  return timeouts_.size();
 }
 
 void DHTMessageTracker::setRoutingTable
@@ -38,11 +38,15 @@
 #include "common.h"
 
 #include <utility>
-#include <deque>
+#include <map>
+#include <vector>
+#include <string>
 
 #include "SharedHandle.h"
 #include "a2time.h"
+#include "TimerA2.h"
 #include "ValueBase.h"
+#include "a2unordered_map.h"
 
 namespace aria2 {
 
@@ -56,13 +60,34 @@ class Logger;
 
 class DHTMessageTracker {
 private:
-  std::deque<SharedHandle<DHTMessageTrackerEntry> > entries_;
-  
+  typedef std::multimap<Timer, SharedHandle<DHTMessageTrackerEntry> >
+  TimeoutQueue;
+
+  // Outstanding entries ordered by deadline, so that handleTimeout()
+  // only looks at the entries which have timed out.
+  TimeoutQueue timeouts_;
+
+  // Maps transaction ID to the entries in timeouts_ which have it.
+  // Transaction IDs are short random strings, so a few entries sent to
+  // different nodes may share one.
+  UnorderedMap<std::string, std::vector<TimeoutQueue::iterator> >::type
+  index_;
+
+  uint64_t numTimeout_;
+
   SharedHandle<DHTRoutingTable> routingTable_;
 
   SharedHandle<DHTMessageFactory> factory_;
 
   Logger* logger_;
+
+  // Stores the entry matching transactionID, ipaddr and port in
+  // result and returns true. Returns false if there is no such entry.
+  bool findEntry
+  (TimeoutQueue::iterator& result, const std::string& transactionID,
+   const std::string& ipaddr, uint16_t port) const;
+
+  void removeEntry(TimeoutQueue::iterator i);
 public:
   DHTMessageTracker();
 
@@ -82,8 +107,15 @@ public:
   SharedHandle<DHTMessageTrackerEntry> getEntryFor
   (const SharedHandle<DHTMessage>& message) const;
 
+  // Returns the number of messages waiting for a reply.
   size_t countEntry() const;
 
+  // Returns the number of messages which have timed out so far.
+  uint64_t getNumTimeout() const
+  {
+    return numTimeout_;
+  }
+
   void setRoutingTable(const SharedHandle<DHTRoutingTable>& routingTable);
 
   void setMessageFactory(const SharedHandle<DHTMessageFactory>& factory);
@@ -58,6 +58,13 @@ bool DHTMessageTrackerEntry::isTimeout() const
   return dispatchedTime_.difference(global::wallclock) >= timeout_;
 }
 
+Timer DHTMessageTrackerEntry::getDeadline() const
+{
+  Timer deadline = dispatchedTime_;
+  deadline.advance(timeout_);
+  return deadline;
+}
+
 void DHTMessageTrackerEntry::extendTimeout()
 {}
 
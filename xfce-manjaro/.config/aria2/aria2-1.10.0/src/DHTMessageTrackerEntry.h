@@ -71,6 +71,9 @@ public:
 
   bool isTimeout() const;
 
+  // Returns the time when isTimeout() becomes true.
+  Timer getDeadline() const;
+
   void extendTimeout();
 
   bool match(const std::string& transactionID, const std::string& ipaddr, uint16_t port) const;
@@ -80,6 +83,11 @@ public:
     return targetNode_;
   }
 
+  const std::string& getTransactionID() const
+  {
+    return transactionID_;
+  }
+
   const std::string& getMessageType() const
   {
     return messageType_;
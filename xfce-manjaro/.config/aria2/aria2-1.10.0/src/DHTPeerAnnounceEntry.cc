@@ -82,10 +82,29 @@ public:
   }
 };
 
-void DHTPeerAnnounceEntry::removeStalePeerAddrEntry(time_t timeout)
+size_t DHTPeerAnnounceEntry::removeStalePeerAddrEntry(time_t timeout)
 {
+  size_t size = peerAddrEntries_.size();
   peerAddrEntries_.erase(std::remove_if(peerAddrEntries_.begin(), peerAddrEntries_.end(),
                                         FindStaleEntry(timeout)), peerAddrEntries_.end());
+  return size-peerAddrEntries_.size();
+}
+
+class UpdatedEarlier {
+public:
+  bool operator()(const PeerAddrEntry& lhs, const PeerAddrEntry& rhs) const
+  {
+    return lhs.getLastUpdated() < rhs.getLastUpdated();
+  }
+};
+
+void DHTPeerAnnounceEntry::removeOldestPeerAddrEntry()
+{
+  if(!peerAddrEntries_.empty()) {
+    peerAddrEntries_.erase(std::min_element(peerAddrEntries_.begin(),
+                                            peerAddrEntries_.end(),
+                                            UpdatedEarlier()));
+  }
 }
 
 bool DHTPeerAnnounceEntry::empty() const
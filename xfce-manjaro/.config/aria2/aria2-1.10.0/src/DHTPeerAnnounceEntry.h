@@ -71,8 +71,13 @@ public:
     return peerAddrEntries_;
   }
 
-  void removeStalePeerAddrEntry(time_t timeout);
-  
+  // Removes peer addr entries which are not updated in the past
+  // timeout seconds and returns the number of removed entries.
+  size_t removeStalePeerAddrEntry(time_t timeout);
+
+  // Removes the peer addr entry which is updated least recently.
+  void removeOldestPeerAddrEntry();
+
   bool empty() const;
 
   const Timer& getLastUpdated() const
@@ -46,41 +46,42 @@
 #include "LogFactory.h"
 #include "Logger.h"
 #include "util.h"
-#include "a2functional.h"
 #include "wallclock.h"
 
 namespace aria2 {
 
 DHTPeerAnnounceStorage::DHTPeerAnnounceStorage():
+  numPeerAddrEntry_(0),
+  maxPeerAddrEntry_(DHT_MAX_PEER_ANNOUNCE),
+  maxPeerAddrEntryPerInfoHash_(DHT_MAX_PEER_ANNOUNCE_PER_INFO_HASH),
   logger_(LogFactory::getInstance()) {}
 
 DHTPeerAnnounceStorage::~DHTPeerAnnounceStorage() {}
 
-class InfoHashLess
-{
-public:
-  bool operator()(const SharedHandle<DHTPeerAnnounceEntry>& lhs,
-                  const SharedHandle<DHTPeerAnnounceEntry>& rhs)
-  {
-    return memcmp(lhs->getInfoHash(), rhs->getInfoHash(), DHT_ID_LENGTH) < 0;
-  }
-};
-
-SharedHandle<DHTPeerAnnounceEntry>
+DHTPeerAnnounceStorage::EntryList::iterator
 DHTPeerAnnounceStorage::getPeerAnnounceEntry(const unsigned char* infoHash)
 {
-  SharedHandle<DHTPeerAnnounceEntry> entry(new DHTPeerAnnounceEntry(infoHash));
-
-  std::deque<SharedHandle<DHTPeerAnnounceEntry> >::iterator i = 
-    std::lower_bound(entries_.begin(), entries_.end(), entry, InfoHashLess());
-
-  if(i != entries_.end() &&
-     memcmp(infoHash, (*i)->getInfoHash(), DHT_ID_LENGTH) == 0) {
-    entry = *i;
+  std::string key(&infoHash[0], &infoHash[DHT_ID_LENGTH]);
+  UnorderedMap<std::string, EntryList::iterator>::type::iterator i =
+    index_.find(key);
+  if(i == index_.end()) {
+    SharedHandle<DHTPeerAnnounceEntry> entry
+      (new DHTPeerAnnounceEntry(infoHash));
+    EntryList::iterator e = entries_.insert(entries_.end(), entry);
+    index_[key] = e;
+    return e;
   } else {
-    entries_.insert(i, entry);
+    entries_.splice(entries_.end(), entries_, (*i).second);
+    return (*i).second;
   }
-  return entry;
+}
+
+void DHTPeerAnnounceStorage::removePeerAnnounceEntry(EntryList::iterator i)
+{
+  numPeerAddrEntry_ -= (*i)->countPeerAddrEntry();
+  const unsigned char* infoHash = (*i)->getInfoHash();
+  index_.erase(std::string(&infoHash[0], &infoHash[DHT_ID_LENGTH]));
+  entries_.erase(i);
 }
 
 void
@@ -92,38 +93,47 @@ DHTPeerAnnounceStorage::addPeerAnnounce(const unsigned char* infoHash,
                    ipaddr.c_str(), port,
                    util::toHex(infoHash, DHT_ID_LENGTH).c_str());
   }
-  getPeerAnnounceEntry(infoHash)->addPeerAddrEntry(PeerAddrEntry(ipaddr, port));
+  const SharedHandle<DHTPeerAnnounceEntry>& entry =
+    *getPeerAnnounceEntry(infoHash);
+  numPeerAddrEntry_ -=
+    entry->removeStalePeerAddrEntry(DHT_PEER_ANNOUNCE_PURGE_INTERVAL);
+  numPeerAddrEntry_ -= entry->countPeerAddrEntry();
+  entry->addPeerAddrEntry(PeerAddrEntry(ipaddr, port));
+  if(entry->countPeerAddrEntry() > maxPeerAddrEntryPerInfoHash_) {
+    entry->removeOldestPeerAddrEntry();
+  }
+  numPeerAddrEntry_ += entry->countPeerAddrEntry();
+  while(numPeerAddrEntry_ > maxPeerAddrEntry_) {
+    entries_.front()->removeOldestPeerAddrEntry();
+    --numPeerAddrEntry_;
+    if(entries_.front()->empty()) {
+      removePeerAnnounceEntry(entries_.begin());
+    }
+  }
 }
 
 bool DHTPeerAnnounceStorage::contains(const unsigned char* infoHash) const
 {
-  SharedHandle<DHTPeerAnnounceEntry> entry(new DHTPeerAnnounceEntry(infoHash));
-  return 
-    std::binary_search(entries_.begin(), entries_.end(), entry, InfoHashLess());
+  return index_.count(std::string(&infoHash[0], &infoHash[DHT_ID_LENGTH]));
 }
 
 void DHTPeerAnnounceStorage::getPeers(std::vector<SharedHandle<Peer> >& peers,
                                       const unsigned char* infoHash)
 {
-  SharedHandle<DHTPeerAnnounceEntry> entry(new DHTPeerAnnounceEntry(infoHash));
-
-  std::deque<SharedHandle<DHTPeerAnnounceEntry> >::iterator i = 
-    std::lower_bound(entries_.begin(), entries_.end(), entry, InfoHashLess());
-  if(i != entries_.end() &&
-     memcmp(infoHash, (*i)->getInfoHash(), DHT_ID_LENGTH) == 0 &&
-     !(*i)->empty()) {
-    (*i)->getPeers(peers);
+  UnorderedMap<std::string, EntryList::iterator>::type::iterator i =
+    index_.find(std::string(&infoHash[0], &infoHash[DHT_ID_LENGTH]));
+  if(i == index_.end()) {
+    return;
   }
-}
-
-class RemoveStalePeerAddrEntry
-{
-public:
-  void operator()(const SharedHandle<DHTPeerAnnounceEntry>& e)
-  {
-    e->removeStalePeerAddrEntry(DHT_PEER_ANNOUNCE_PURGE_INTERVAL);
+  const SharedHandle<DHTPeerAnnounceEntry>& entry = *(*i).second;
+  numPeerAddrEntry_ -=
+    entry->removeStalePeerAddrEntry(DHT_PEER_ANNOUNCE_PURGE_INTERVAL);
+  if(entry->empty()) {
+    removePeerAnnounceEntry((*i).second);
+  } else {
+    entry->getPeers(peers);
   }
-};
+}
 
 void DHTPeerAnnounceStorage::handleTimeout()
 {
@@ -131,13 +141,22 @@ void DHTPeerAnnounceStorage::handleTimeout()
     logger_->debug("Now purge peer announces(%lu entries) which are timed out.",
                    static_cast<unsigned long>(entries_.size()));
   }
-  std::for_each(entries_.begin(), entries_.end(), RemoveStalePeerAddrEntry());
-  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
-                                mem_fun_sh(&DHTPeerAnnounceEntry::empty)),
-                 entries_.end());
+  // The newest peer of an entry was added when the entry was announced
+  // last time. So if the first entry keeps a peer after purge, the
+  // following entries do too.
+  while(!entries_.empty()) {
+    numPeerAddrEntry_ -= entries_.front()->removeStalePeerAddrEntry
+      (DHT_PEER_ANNOUNCE_PURGE_INTERVAL);
+    if(entries_.front()->empty()) {
+      removePeerAnnounceEntry(entries_.begin());
+    } else {
+      break;
+    }
+  }
   if(logger_->debug()) {
-    logger_->debug("Currently %lu peer announce entries",
-                   static_cast<unsigned long>(entries_.size()));
+    logger_->debug("Currently %lu peer announce entries, %lu peers",
+                   static_cast<unsigned long>(entries_.size()),
+                   static_cast<unsigned long>(numPeerAddrEntry_));
   }
 }
 
@@ -146,8 +165,8 @@ void DHTPeerAnnounceStorage::announcePeer()
   if(logger_->debug()) {
     logger_->debug("Now announcing peer.");
   }
-  for(std::deque<SharedHandle<DHTPeerAnnounceEntry> >::iterator i =
-        entries_.begin(), eoi = entries_.end(); i != eoi; ++i) {
+  for(EntryList::iterator i = entries_.begin(), eoi = entries_.end();
+      i != eoi; ++i) {
     if((*i)->getLastUpdated().
        difference(global::wallclock) >= DHT_PEER_ANNOUNCE_INTERVAL) {
       (*i)->notifyUpdate();
@@ -37,10 +37,12 @@
 
 #include "common.h"
 
-#include <deque>
+#include <string>
+#include <list>
 #include <vector>
 
 #include "SharedHandle.h"
+#include "a2unordered_map.h"
 
 namespace aria2 {
 
@@ -52,9 +54,25 @@ class Logger;
 
 class DHTPeerAnnounceStorage {
 private:
-  std::deque<SharedHandle<DHTPeerAnnounceEntry> > entries_;
+  typedef std::list<SharedHandle<DHTPeerAnnounceEntry> > EntryList;
 
-  SharedHandle<DHTPeerAnnounceEntry> getPeerAnnounceEntry(const unsigned char* infoHash);
+  // Entries ordered by the time of the last announce. The least
+  // recently announced one comes first.
+  EntryList entries_;
+
+  // Maps info hash to the position in entries_.
+  UnorderedMap<std::string, EntryList::iterator>::type index_;
+
+  // The number of peers stored for all info hashes.
+  size_t numPeerAddrEntry_;
+
+  size_t maxPeerAddrEntry_;
+
+  size_t maxPeerAddrEntryPerInfoHash_;
+
+  EntryList::iterator getPeerAnnounceEntry(const unsigned char* infoHash);
+
+  void removePeerAnnounceEntry(EntryList::iterator i);
 
   SharedHandle<DHTTaskQueue> taskQueue_;
 
@@ -75,7 +93,9 @@ public:
                 const unsigned char* infoHash);
 
   // drop peer announce entry which is not updated in the past
-  // DHT_PEER_ANNOUNCE_PURGE_INTERVAL seconds.
+  // DHT_PEER_ANNOUNCE_PURGE_INTERVAL seconds. Only the timed out
+  // entries are visited. Stale peers of the other entries are removed
+  // when the entry is accessed.
   void handleTimeout();
 
   // announce peer in every DHT_PEER_ANNOUNCE_PURGE_INTERVAL.
@@ -86,6 +106,32 @@ public:
   void setTaskQueue(const SharedHandle<DHTTaskQueue>& taskQueue);
 
   void setTaskFactory(const SharedHandle<DHTTaskFactory>& taskFactory);
+
+  size_t countPeerAnnounceEntry() const
+  {
+    return entries_.size();
+  }
+
+  size_t countPeerAddrEntry() const
+  {
+    return numPeerAddrEntry_;
+  }
+
+  // If the number of peers stored for all info hashes exceeds
+  // maxPeerAddrEntry, the least recently announced peer of the least
+  // recently announced info hash is removed.
+  void setMaxPeerAddrEntry(size_t maxPeerAddrEntry)
+  {
+    maxPeerAddrEntry_ = maxPeerAddrEntry;
+  }
+
+  // If the number of peers stored for one info hash exceeds
+  // maxPeerAddrEntryPerInfoHash, the least recently announced peer of
+  // the info hash is removed.
+  void setMaxPeerAddrEntryPerInfoHash(size_t maxPeerAddrEntryPerInfoHash)
+  {
+    maxPeerAddrEntryPerInfoHash_ = maxPeerAddrEntryPerInfoHash;
+  }
 };
 
 } // namespace aria2
@@ -43,6 +43,8 @@
 #include "DHTMessageReceiver.h"
 #include "DHTMessageFactory.h"
 #include "DHTMessageCallback.h"
+#include "DHTMessageTracker.h"
+#include "DHTConnectionImpl.h"
 
 namespace aria2 {
 
@@ -60,6 +62,8 @@ void DHTRegistry::clearData()
   data_.messageDispatcher.reset();
   data_.messageReceiver.reset();
   data_.messageFactory.reset();
+  data_.messageTracker.reset();
+  data_.connection.reset();
 }
 
 } // namespace aria2
@@ -49,6 +49,8 @@ class DHTTokenTracker;
 class DHTMessageDispatcher;
 class DHTMessageReceiver;
 class DHTMessageFactory;
+class DHTMessageTracker;
+class DHTConnectionImpl;
 
 class DHTRegistry {
 private:
@@ -70,6 +72,10 @@ private:
     SharedHandle<DHTMessageReceiver> messageReceiver;
 
     SharedHandle<DHTMessageFactory> messageFactory;
+
+    SharedHandle<DHTMessageTracker> messageTracker;
+
+    SharedHandle<DHTConnectionImpl> connection;
   };
 
   static Data data_;
@@ -35,10 +35,10 @@
 #include "DHTRoutingTable.h"
 
 #include <cstring>
+#include <algorithm>
 
 #include "DHTNode.h"
 #include "DHTBucket.h"
-#include "BNode.h"
 #include "DHTTaskQueue.h"
 #include "DHTTaskFactory.h"
 #include "DHTTask.h"
@@ -50,16 +50,29 @@ namespace aria2 {
 
 DHTRoutingTable::DHTRoutingTable(const SharedHandle<DHTNode>& localNode):
   localNode_(localNode),
-  numBucket_(1),
   logger_(LogFactory::getInstance())
 {
   SharedHandle<DHTBucket> bucket(new DHTBucket(localNode_));
-  root_ = new BNode(bucket);
+  buckets_.push_back(bucket);
 }
 
-DHTRoutingTable::~DHTRoutingTable()
+DHTRoutingTable::~DHTRoutingTable() {}
+
+size_t DHTRoutingTable::getBucketIndex(const unsigned char* nodeID) const
 {
-  delete root_;
+  const unsigned char* localID = localNode_->getID();
+  size_t prefix = 0;
+  for(size_t i = 0; i < DHT_ID_LENGTH; ++i) {
+    unsigned char diff = nodeID[i]^localID[i];
+    if(diff) {
+      for(; !(diff&0x80); diff <<= 1) {
+        ++prefix;
+      }
+      break;
+    }
+    prefix += 8;
+  }
+  return std::min(prefix, buckets_.size()-1);
 }
 
 bool DHTRoutingTable::addNode(const SharedHandle<DHTNode>& node)
@@ -84,8 +97,7 @@ bool DHTRoutingTable::addNode(const SharedHandle<DHTNode>& node, bool good)
     }
     return false;
   }
-  BNode* bnode = BNode::findBNodeFor(root_, node->getID());
-  SharedHandle<DHTBucket> bucket = bnode->getBucket();
+  SharedHandle<DHTBucket> bucket = getBucketFor(node);
   while(1) {
     if(bucket->addNode(node)) {
       if(logger_->debug()) {
@@ -98,21 +110,16 @@ bool DHTRoutingTable::addNode(const SharedHandle<DHTNode>& node, bool good)
                        util::toHex(bucket->getMinID(), DHT_ID_LENGTH).c_str(),
                        util::toHex(bucket->getMaxID(), DHT_ID_LENGTH).c_str());
       }
+      // Only the last bucket contains the local node and may be
+      // split. The half which keeps the local node stays last.
       SharedHandle<DHTBucket> r = bucket->split();
-
-      bnode->setBucket(SharedHandle<DHTBucket>());
-      BNode* lbnode = new BNode(bucket);
-      BNode* rbnode = new BNode(r);
-      bnode->setLeft(lbnode);
-      bnode->setRight(rbnode);
-      ++numBucket_;
-
-      if(r->isInRange(node)) {
-        bucket = r;
-        bnode = rbnode;
+      if(r->isInRange(localNode_)) {
+        buckets_.push_back(r);
       } else {
-        bnode = lbnode;
+        buckets_.back() = r;
+        buckets_.push_back(bucket);
       }
+      bucket = getBucketFor(node);
     } else {
       if(good) {
         bucket->cacheNode(node);
@@ -126,16 +133,41 @@ bool DHTRoutingTable::addNode(const SharedHandle<DHTNode>& node, bool good)
   return false;
 }
 
+void DHTRoutingTable::appendGoodNodes
+(std::vector<SharedHandle<DHTNode> >& nodes, size_t index) const
+{
+  std::vector<SharedHandle<DHTNode> > goodNodes;
+  buckets_[index]->getGoodNodes(goodNodes);
+  size_t r = DHTBucket::K-nodes.size();
+  if(goodNodes.size() <= r) {
+    nodes.insert(nodes.end(), goodNodes.begin(), goodNodes.end());
+  } else {
+    nodes.insert(nodes.end(), goodNodes.begin(), goodNodes.begin()+r);
+  }
+}
+
 void DHTRoutingTable::getClosestKNodes
 (std::vector<SharedHandle<DHTNode> >& nodes,
  const unsigned char* key) const
 {
-  BNode::findClosestKNodes(nodes, root_, key);
+  // The nodes in the bucket for key are closest. Nodes in the buckets
+  // after it differ from key at the bit where key leaves the prefix of
+  // the local node, and nodes in the buckets before it differ at a
+  // more significant bit, the earlier the farther.
+  size_t index = getBucketIndex(key);
+  buckets_[index]->getGoodNodes(nodes);
+  for(size_t i = index+1; i < buckets_.size() && nodes.size() < DHTBucket::K;
+      ++i) {
+    appendGoodNodes(nodes, i);
+  }
+  for(size_t i = index; i > 0 && nodes.size() < DHTBucket::K; --i) {
+    appendGoodNodes(nodes, i-1);
+  }
 }
 
 size_t DHTRoutingTable::countBucket() const
 {
-  return numBucket_;
+  return buckets_.size();
 }
 
 void DHTRoutingTable::showBuckets() const
@@ -149,7 +181,7 @@ void DHTRoutingTable::showBuckets() const
 
 SharedHandle<DHTBucket> DHTRoutingTable::getBucketFor(const unsigned char* nodeID) const
 {
-  return BNode::findBucketFor(root_, nodeID);
+  return buckets_[getBucketIndex(nodeID)];
 }
 
 SharedHandle<DHTBucket> DHTRoutingTable::getBucketFor(const SharedHandle<DHTNode>& node) const
@@ -181,7 +213,7 @@ void DHTRoutingTable::moveBucketTail(const SharedHandle<DHTNode>& node)
 void DHTRoutingTable::getBuckets
 (std::vector<SharedHandle<DHTBucket> >& buckets) const
 {
-  BNode::enumerateBucket(buckets, root_);
+  buckets.insert(buckets.end(), buckets_.begin(), buckets_.end());
 }
 
 void DHTRoutingTable::setTaskQueue(const SharedHandle<DHTTaskQueue>& taskQueue)
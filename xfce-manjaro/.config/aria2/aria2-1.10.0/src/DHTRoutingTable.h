@@ -48,16 +48,18 @@ class DHTNode;
 class DHTBucket;
 class DHTTaskQueue;
 class DHTTaskFactory;
-class BNode;
 class Logger;
 
 class DHTRoutingTable {
 private:
   SharedHandle<DHTNode> localNode_;
 
-  BNode* root_;
-
-  size_t numBucket_;
+  // Only the bucket which contains the local node is ever split, so
+  // the buckets are laid out by the length of the ID prefix shared
+  // with the local node: buckets_[i] holds the nodes whose IDs share
+  // exactly i leading bits with it, and the last bucket holds the rest
+  // including the local node itself.
+  std::vector<SharedHandle<DHTBucket> > buckets_;
 
   SharedHandle<DHTTaskQueue> taskQueue_;
 
@@ -66,6 +68,12 @@ private:
   Logger* logger_;
 
   bool addNode(const SharedHandle<DHTNode>& node, bool good);
+
+  // Returns the index of the bucket for nodeID in buckets_.
+  size_t getBucketIndex(const unsigned char* nodeID) const;
+
+  void appendGoodNodes(std::vector<SharedHandle<DHTNode> >& nodes,
+                       size_t index) const;
 public:
   DHTRoutingTable(const SharedHandle<DHTNode>& localNode);
 
@@ -153,6 +153,7 @@ void DHTSetup::setup(std::vector<Command*>& commands, DownloadEngine* e)
     tracker->setMessageFactory(factory);
 
     dispatcher->setTimeout(messageTimeout);
+    dispatcher->setConnection(connection);
 
     receiver->setConnection(connection);
     receiver->setMessageFactory(factory);
@@ -188,6 +189,8 @@ void DHTSetup::setup(std::vector<Command*>& commands, DownloadEngine* e)
     DHTRegistry::getMutableData().messageDispatcher = dispatcher;
     DHTRegistry::getMutableData().messageReceiver = receiver;
     DHTRegistry::getMutableData().messageFactory = factory;
+    DHTRegistry::getMutableData().messageTracker = tracker;
+    DHTRegistry::getMutableData().connection = connection;
 
     // add deserialized nodes to routing table
     const std::vector<SharedHandle<DHTNode> >& desnodes =
@@ -216,38 +216,43 @@ DefaultBtAnnounce::processAnnounceResponse(const unsigned char* trackerResponse,
   if(logger_->debug()) {
     logger_->debug("Now processing tracker response.");
   }
-  SharedHandle<ValueBase> decodedValue =
-    bencode2::decode(trackerResponse, trackerResponseLength);
-  const Dict* dict = asDict(decodedValue);
-  if(!dict) {
+  bencode2::ViewDecoder decoder;
+  decoder.decode(trackerResponse, trackerResponseLength);
+  const bencode2::View* dict = decoder.getRoot();
+  if(!dict || dict->type != bencode2::View::DICT) {
     throw DL_ABORT_EX(MSG_NULL_TRACKER_RESPONSE);
   }
-  const String* failure = asString(dict->get(BtAnnounce::FAILURE_REASON));
+  const bencode2::View* failure =
+    decoder.get(dict, BtAnnounce::FAILURE_REASON, bencode2::View::STRING);
   if(failure) {
     throw DL_ABORT_EX
       (StringFormat(EX_TRACKER_FAILURE, failure->s().c_str()).str());
   }
-  const String* warn = asString(dict->get(BtAnnounce::WARNING_MESSAGE));
+  const bencode2::View* warn =
+    decoder.get(dict, BtAnnounce::WARNING_MESSAGE, bencode2::View::STRING);
   if(warn) {
     logger_->warn(MSG_TRACKER_WARNING_MESSAGE, warn->s().c_str());
   }
-  const String* tid = asString(dict->get(BtAnnounce::TRACKER_ID));
+  const bencode2::View* tid =
+    decoder.get(dict, BtAnnounce::TRACKER_ID, bencode2::View::STRING);
   if(tid) {
     trackerId_ = tid->s();
     if(logger_->debug()) {
       logger_->debug("Tracker ID:%s", trackerId_.c_str());
     }
   }
-  const Integer* ival = asInteger(dict->get(BtAnnounce::INTERVAL));
-  if(ival && ival->i() > 0) {
-    interval_ = ival->i();
+  const bencode2::View* ival =
+    decoder.get(dict, BtAnnounce::INTERVAL, bencode2::View::INTEGER);
+  if(ival && ival->i > 0) {
+    interval_ = ival->i;
     if(logger_->debug()) {
       logger_->debug("Interval:%d", interval_);
     }
   }
-  const Integer* mival = asInteger(dict->get(BtAnnounce::MIN_INTERVAL));
-  if(mival && mival->i() > 0) {
-    minInterval_ = mival->i();
+  const bencode2::View* mival =
+    decoder.get(dict, BtAnnounce::MIN_INTERVAL, bencode2::View::INTEGER);
+  if(mival && mival->i > 0) {
+    minInterval_ = mival->i;
     if(logger_->debug()) {
       logger_->debug("Min interval:%d", minInterval_);
     }
@@ -256,27 +261,29 @@ DefaultBtAnnounce::processAnnounceResponse(const unsigned char* trackerResponse,
     // Use interval as a minInterval if minInterval is not supplied.
     minInterval_ = interval_;
   }
-  const Integer* comp = asInteger(dict->get(BtAnnounce::COMPLETE));
+  const bencode2::View* comp =
+    decoder.get(dict, BtAnnounce::COMPLETE, bencode2::View::INTEGER);
   if(comp) {
-    complete_ = comp->i();
+    complete_ = comp->i;
     if(logger_->debug()) {
       logger_->debug("Complete:%d", complete_);
     }
   }
-  const Integer* incomp = asInteger(dict->get(BtAnnounce::INCOMPLETE));
+  const bencode2::View* incomp =
+    decoder.get(dict, BtAnnounce::INCOMPLETE, bencode2::View::INTEGER);
   if(incomp) {
-    incomplete_ = incomp->i();
+    incomplete_ = incomp->i;
     if(logger_->debug()) {
       logger_->debug("Incomplete:%d", incomplete_);
     }
   }
-  const SharedHandle<ValueBase>& peerData = dict->get(BtAnnounce::PEERS);
-  if(peerData.isNull()) {
+  const bencode2::View* peerData = decoder.get(dict, BtAnnounce::PEERS);
+  if(!peerData) {
     logger_->info(MSG_NO_PEER_LIST_RECEIVED);
   } else {
     if(!btRuntime_->isHalt() && btRuntime_->lessThanMinPeers()) {
       std::vector<SharedHandle<Peer> > peers;
-      bittorrent::extractPeer(peerData, std::back_inserter(peers));
+      bittorrent::extractPeer(decoder, peerData, std::back_inserter(peers));
       peerStorage_->addPeer(peers);
     }
   }
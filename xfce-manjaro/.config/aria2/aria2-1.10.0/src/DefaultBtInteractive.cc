@@ -316,6 +316,8 @@ size_t DefaultBtInteractive::receiveMessages() {
       }
       break;
     case BtPieceMessage::ID:
+      requestGroupMan_->updateOverallDownloadLength
+        (static_cast<BtPieceMessage*>(message.get())->getBlockLength());
       peerStorage_->updateTransferStatFor(peer_);
       // pass through
     case BtRequestMessage::ID:
@@ -475,9 +477,9 @@ void DefaultBtInteractive::addPeerExchangeMessage()
      difference(global::wallclock) >= UTPexExtensionMessage::DEFAULT_INTERVAL) {
     UTPexExtensionMessageHandle m
       (new UTPexExtensionMessage(peer_->getExtensionMessageID("ut_pex")));
-    const std::deque<SharedHandle<Peer> >& peers = peerStorage_->getPeers();
+    const std::list<SharedHandle<Peer> >& peers = peerStorage_->getPeers();
     {
-      for(std::deque<SharedHandle<Peer> >::const_iterator i =
+      for(std::list<SharedHandle<Peer> >::const_iterator i =
             peers.begin(), eoi = peers.end();
           i != eoi && !m->freshPeersAreFull(); ++i) {
         if(peer_->getIPAddress() != (*i)->getIPAddress()) {
@@ -486,7 +488,7 @@ void DefaultBtInteractive::addPeerExchangeMessage()
       }
     }
     {
-      for(std::deque<SharedHandle<Peer> >::const_reverse_iterator i =
+      for(std::list<SharedHandle<Peer> >::const_reverse_iterator i =
             peers.rbegin(), eoi = peers.rend();
           i != eoi && !m->droppedPeersAreFull();
           ++i) {
@@ -98,8 +98,11 @@ void DefaultBtMessageDispatcher::sendMessages() {
         continue;
       }
     }
+    uint64_t uploadLength = peer_->getSessionUploadLength();
     msg->send();
     if(msg->isUploading()) {
+      requestGroupMan_->updateOverallUploadLength
+        (peer_->getSessionUploadLength()-uploadLength);
       peerStorage_->updateTransferStatFor(peer_);
     }
     if(msg->isSendingInProgress()) {
@@ -37,6 +37,11 @@
 #include <cerrno>
 #include <cstring>
 #include <fstream>
+#include <algorithm>
+#include <map>
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif // HAVE_MMAP
 
 #include "PieceStorage.h"
 #include "Piece.h"
@@ -55,6 +60,8 @@
 #include "StringFormat.h"
 #include "array_fun.h"
 #include "DownloadContext.h"
+#include "DiskAdaptor.h"
+#include "sha1.h"
 #ifdef ENABLE_BITTORRENT
 # include "PeerStorage.h"
 # include "BtRuntime.h"
@@ -65,6 +72,13 @@ namespace aria2 {
 
 const std::string DefaultBtProgressInfoFile::V0000("0000");
 const std::string DefaultBtProgressInfoFile::V0001("0001");
+const std::string DefaultBtProgressInfoFile::V0002("0002");
+
+// The index of an unused in-flight piece record.
+static const uint32_t UNUSED_RECORD = UINT32_MAX;
+
+// The minimum number of in-flight piece records a control file has.
+static const size_t MIN_IN_FLIGHT_PIECE_RECORD = 16;
 
 static std::string createFilename
 (const SharedHandle<DownloadContext>& dctx, const std::string& suffix)
@@ -82,13 +96,32 @@ DefaultBtProgressInfoFile::DefaultBtProgressInfoFile
   pieceStorage_(pieceStorage),
   option_(option),
   logger_(LogFactory::getInstance()),
-  filename_(createFilename(dctx_, getSuffix()))
+  filename_(createFilename(dctx_, getSuffix())),
+  maxInFlightPiece_(0),
+  pieceBitfieldLength_(0),
+  headerLength_(0),
+  generation_(0)
+#ifdef HAVE_MMAP
+  ,
+  map_(0),
+  mapLength_(0),
+  mapDev_(0),
+  mapIno_(0)
+#endif // HAVE_MMAP
 {}
 
-DefaultBtProgressInfoFile::~DefaultBtProgressInfoFile() {}
+DefaultBtProgressInfoFile::~DefaultBtProgressInfoFile()
+{
+#ifdef HAVE_MMAP
+  closeMap();
+#endif // HAVE_MMAP
+}
 
 void DefaultBtProgressInfoFile::updateFilename()
 {
+#ifdef HAVE_MMAP
+  closeMap();
+#endif // HAVE_MMAP
   filename_ = createFilename(dctx_, getSuffix());
 }
 
@@ -101,106 +134,224 @@ bool DefaultBtProgressInfoFile::isTorrentDownload()
 #endif // !ENABLE_BITTORRENT
 }
 
-// Since version 0001, Integers are saved in binary form, network byte order.
-void DefaultBtProgressInfoFile::save()
+// Since version 0001, Integers are saved in binary form, network
+// byte order.
+//
+// Version 0002 has fixed offsets, so that save() can update the file
+// in place through a memory map:
+//
+// header:
+//   version: 16 bits, 0x0002
+//   extension: 32 bits, 0x00000001 if BitTorrent download
+//   infoHashLength: 32 bits
+//   infoHash: infoHashLength bytes
+//   pieceLength: 32 bits
+//   totalLength: 64 bits
+//   bitfieldLength: 32 bits
+//   maxInFlightPiece: 32 bits, the number of in-flight piece records
+//   pieceBitfieldLength: 32 bits, the bitfield length of a full piece
+// 2 snapshots:
+//   checksum: SHA-1 of the rest of the snapshot
+//   generation: 64 bits
+//   uploadLength: 64 bits
+//   bitfield: bitfieldLength bytes
+//   maxInFlightPiece in-flight piece records:
+//     index: 32 bits, 0xffffffff if the record is unused
+//     length: 32 bits
+//     bitfield: pieceBitfieldLength bytes
+//
+// save() writes the older snapshot, so the newer one stays intact
+// if the process dies in the middle. load() takes the snapshot which
+// has a valid checksum and the larger generation.
+
+// Writes only the 64 byte blocks of src which differ from dst, so
+// that unchanged pages of the memory map are not dirtied.
+static void writeChanged(unsigned char* dst, const void* src, size_t length)
 {
-  logger_->info(MSG_SAVING_SEGMENT_FILE, filename_.c_str());
-  std::string filenameTemp = filename_+"__temp";
-  {
-    std::ofstream o(filenameTemp.c_str(), std::ios::out|std::ios::binary);
-    if(!o) {
-      throw DL_ABORT_EX(StringFormat(EX_SEGMENT_FILE_WRITE,
-                                     filename_.c_str(), strerror(errno)).str());
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+  for(size_t i = 0; i < length; i += 64) {
+    size_t n = std::min(static_cast<size_t>(64), length-i);
+    if(memcmp(dst+i, p+i, n) != 0) {
+      memcpy(dst+i, p+i, n);
     }
+  }
+}
+
+static void put32(unsigned char* dst, uint32_t value)
+{
+  uint32_t valueNL = htonl(value);
+  writeChanged(dst, &valueNL, sizeof(valueNL));
+}
+
+static void put64(unsigned char* dst, uint64_t value)
+{
+  uint64_t valueNL = hton64(value);
+  writeChanged(dst, &valueNL, sizeof(valueNL));
+}
+
+static uint32_t get32(const unsigned char* src)
+{
+  uint32_t valueNL;
+  memcpy(&valueNL, src, sizeof(valueNL));
+  return ntohl(valueNL);
+}
+
+static uint64_t get64(const unsigned char* src)
+{
+  uint64_t valueNL;
+  memcpy(&valueNL, src, sizeof(valueNL));
+  return ntoh64(valueNL);
+}
+
+static void computeChecksum
+(unsigned char* md, const unsigned char* snapshot, size_t snapshotLength)
+{
+  sha1::Context ctx;
+  sha1::init(ctx);
+  sha1::update(ctx, snapshot+sha1::DIGEST_LENGTH,
+               snapshotLength-sha1::DIGEST_LENGTH);
+  sha1::final(ctx, md);
+}
+
+size_t DefaultBtProgressInfoFile::getSnapshotLength() const
+{
+  return sha1::DIGEST_LENGTH+8+8+pieceStorage_->getBitfieldLength()+
+    maxInFlightPiece_*(8+pieceBitfieldLength_);
+}
+
+void DefaultBtProgressInfoFile::writeHeader(unsigned char* dst)
+{
+  dst[0] = 0x00;
+  dst[1] = 0x02;
+  dst += 2;
+  if(isTorrentDownload()) {
 #ifdef ENABLE_BITTORRENT
-    bool torrentDownload = isTorrentDownload();
-#else // !ENABLE_BITTORRENT
-    bool torrentDownload = false;
-#endif // !ENABLE_BITTORRENT
+    put32(dst, 1);
+    dst += 4;
+    put32(dst, INFO_HASH_LENGTH);
+    dst += 4;
+    memcpy(dst, bittorrent::getInfoHash(dctx_), INFO_HASH_LENGTH);
+    dst += INFO_HASH_LENGTH;
+#endif // ENABLE_BITTORRENT
+  } else {
+    put32(dst, 0);
+    dst += 4;
+    put32(dst, 0);
+    dst += 4;
+  }
+  put32(dst, dctx_->getPieceLength());
+  dst += 4;
+  put64(dst, dctx_->getTotalLength());
+  dst += 8;
+  put32(dst, pieceStorage_->getBitfieldLength());
+  dst += 4;
+  put32(dst, maxInFlightPiece_);
+  dst += 4;
+  put32(dst, pieceBitfieldLength_);
+}
 
-    // file version: 16 bits
-    // values: '1'
-    char version[] = { 0x00, 0x01 };
-    o.write(version, sizeof(version));
-    // extension: 32 bits
-    // If this is BitTorrent download, then 0x00000001
-    // Otherwise, 0x00000000
-    char extension[4];
-    memset(extension, 0, sizeof(extension));
-    if(torrentDownload) {
-      extension[3] = 1;
-    }
-    o.write(reinterpret_cast<const char*>(&extension), sizeof(extension));
-    if(torrentDownload) {
+void DefaultBtProgressInfoFile::writeSnapshot
+(unsigned char* dst, uint64_t generation,
+ const std::vector<SharedHandle<Piece> >& inFlightPieces)
+{
+  unsigned char* p = dst+sha1::DIGEST_LENGTH;
+  put64(p, generation);
+  p += 8;
+  uint64_t uploadLength = 0;
 #ifdef ENABLE_BITTORRENT
-      // infoHashLength:
-      // length: 32 bits
-      const unsigned char* infoHash = bittorrent::getInfoHash(dctx_);
-      uint32_t infoHashLengthNL = htonl(INFO_HASH_LENGTH);
-      o.write(reinterpret_cast<const char*>(&infoHashLengthNL),
-              sizeof(infoHashLengthNL));
-      // infoHash:
-      o.write(reinterpret_cast<const char*>(infoHash), INFO_HASH_LENGTH);
+  if(isTorrentDownload()) {
+    uploadLength = peerStorage_->calculateStat().getAllTimeUploadLength();
+  }
 #endif // ENABLE_BITTORRENT
-    } else {
-      // infoHashLength:
-      // length: 32 bits
-      uint32_t infoHashLength = 0;
-      o.write(reinterpret_cast<const char*>(&infoHashLength),
-              sizeof(infoHashLength));
+  put64(p, uploadLength);
+  p += 8;
+  writeChanged(p, pieceStorage_->getBitfield(),
+               pieceStorage_->getBitfieldLength());
+  p += pieceStorage_->getBitfieldLength();
+  // A piece keeps the record it had in this snapshot, so that the
+  // records of other pieces are not moved.
+  const size_t recordLength = 8+pieceBitfieldLength_;
+  std::map<uint32_t, size_t> records;
+  for(size_t i = 0; i < maxInFlightPiece_; ++i) {
+    uint32_t index = get32(p+i*recordLength);
+    if(index != UNUSED_RECORD) {
+      records[index] = i;
     }
-    // pieceLength: 32 bits
-    uint32_t pieceLengthNL = htonl(dctx_->getPieceLength());
-    o.write(reinterpret_cast<const char*>(&pieceLengthNL),
-            sizeof(pieceLengthNL));
-    // totalLength: 64 bits
-    uint64_t totalLengthNL = hton64(dctx_->getTotalLength());
-    o.write(reinterpret_cast<const char*>(&totalLengthNL),
-            sizeof(totalLengthNL));
-    // uploadLength: 64 bits
-    uint64_t uploadLengthNL = 0;
-#ifdef ENABLE_BITTORRENT
-    if(torrentDownload) {
-      TransferStat stat = peerStorage_->calculateStat();
-      uploadLengthNL = hton64(stat.getAllTimeUploadLength());
+  }
+  std::vector<bool> used(maxInFlightPiece_);
+  std::vector<size_t> pos(inFlightPieces.size(), maxInFlightPiece_);
+  for(size_t i = 0; i < inFlightPieces.size(); ++i) {
+    std::map<uint32_t, size_t>::const_iterator itr =
+      records.find(inFlightPieces[i]->getIndex());
+    if(itr != records.end()) {
+      pos[i] = (*itr).second;
+      used[pos[i]] = true;
+    }
+  }
+  size_t freeRecord = 0;
+  for(size_t i = 0; i < inFlightPieces.size(); ++i) {
+    if(pos[i] == maxInFlightPiece_) {
+      while(used[freeRecord]) {
+        ++freeRecord;
+      }
+      pos[i] = freeRecord;
+      used[pos[i]] = true;
     }
+    const SharedHandle<Piece>& piece = inFlightPieces[i];
+    unsigned char* record = p+pos[i]*recordLength;
+    put32(record, piece->getIndex());
+    put32(record+4, piece->getLength());
+    writeChanged(record+8, piece->getBitfield(),
+                 std::min(piece->getBitfieldLength(), pieceBitfieldLength_));
+  }
+  for(size_t i = 0; i < maxInFlightPiece_; ++i) {
+    if(!used[i]) {
+      put32(p+i*recordLength, UNUSED_RECORD);
+    }
+  }
+  unsigned char md[sha1::DIGEST_LENGTH];
+  computeChecksum(md, dst, getSnapshotLength());
+  writeChanged(dst, md, sizeof(md));
+}
+
+// Writes the whole control file with room for twice as many
+// in-flight pieces as there are now. Both snapshots have the current
+// progress.
+void DefaultBtProgressInfoFile::writeFile
+(const std::vector<SharedHandle<Piece> >& inFlightPieces)
+{
+  maxInFlightPiece_ =
+    std::max(inFlightPieces.size(),
+             std::min(std::max(inFlightPieces.size()*2,
+                               MIN_IN_FLIGHT_PIECE_RECORD),
+                      dctx_->getNumPieces()));
+  pieceBitfieldLength_ = Piece(0, dctx_->getPieceLength()).getBitfieldLength();
+  headerLength_ = 2+4+4+4+8+4+4+4;
+#ifdef ENABLE_BITTORRENT
+  if(isTorrentDownload()) {
+    headerLength_ += INFO_HASH_LENGTH;
+  }
 #endif // ENABLE_BITTORRENT
-    o.write(reinterpret_cast<const char*>(&uploadLengthNL),
-            sizeof(uploadLengthNL));
-    // bitfieldLength: 32 bits
-    uint32_t bitfieldLengthNL = htonl(pieceStorage_->getBitfieldLength());
-    o.write(reinterpret_cast<const char*>(&bitfieldLengthNL),
-            sizeof(bitfieldLengthNL));
-    // bitfield
-    o.write(reinterpret_cast<const char*>(pieceStorage_->getBitfield()),
-            pieceStorage_->getBitfieldLength());
-    // the number of in-flight piece: 32 bits
-    // TODO implement this
-    uint32_t numInFlightPieceNL = htonl(pieceStorage_->countInFlightPiece());
-    o.write(reinterpret_cast<const char*>(&numInFlightPieceNL),
-            sizeof(numInFlightPieceNL));
-    std::vector<SharedHandle<Piece> > inFlightPieces;
-    inFlightPieces.reserve(pieceStorage_->countInFlightPiece());
-    pieceStorage_->getInFlightPieces(inFlightPieces);
-    for(std::vector<SharedHandle<Piece> >::const_iterator itr =
-          inFlightPieces.begin(), eoi = inFlightPieces.end();
-        itr != eoi; ++itr) {
-      uint32_t indexNL = htonl((*itr)->getIndex());
-      o.write(reinterpret_cast<const char*>(&indexNL), sizeof(indexNL));
-      uint32_t lengthNL = htonl((*itr)->getLength());
-      o.write(reinterpret_cast<const char*>(&lengthNL), sizeof(lengthNL));
-      uint32_t bitfieldLengthNL = htonl((*itr)->getBitfieldLength());
-      o.write(reinterpret_cast<const char*>(&bitfieldLengthNL),
-              sizeof(bitfieldLengthNL));
-      o.write(reinterpret_cast<const char*>((*itr)->getBitfield()),
-              (*itr)->getBitfieldLength());
+  size_t snapshotLength = getSnapshotLength();
+  std::vector<unsigned char> buf(headerLength_+snapshotLength*2);
+  writeHeader(&buf[0]);
+  generation_ = 1;
+  writeSnapshot(&buf[headerLength_], 0, inFlightPieces);
+  writeSnapshot(&buf[headerLength_+snapshotLength], 1, inFlightPieces);
+
+  std::string filenameTemp = filename_+"__temp";
+  {
+    std::ofstream o(filenameTemp.c_str(), std::ios::out|std::ios::binary);
+    if(!o) {
+      throw DL_ABORT_EX(StringFormat(EX_SEGMENT_FILE_WRITE,
+                                     filename_.c_str(), strerror(errno)).str());
     }
+    o.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
     o.flush();
     if(!o) {
       throw DL_ABORT_EX(StringFormat(EX_SEGMENT_FILE_WRITE,
                                      filename_.c_str(), strerror(errno)).str());
     }
-    logger_->info(MSG_SAVED_SEGMENT_FILE);
   }
   if(!File(filenameTemp).renameTo(filename_)) {
     throw DL_ABORT_EX(StringFormat(EX_SEGMENT_FILE_WRITE,
@@ -208,6 +359,90 @@ void DefaultBtProgressInfoFile::save()
   }
 }
 
+#ifdef HAVE_MMAP
+
+bool DefaultBtProgressInfoFile::openMap()
+{
+  int fd = open(filename_.c_str(), O_RDWR|O_BINARY);
+  if(fd == -1) {
+    return false;
+  }
+  a2_struct_stat st;
+  if(a2fstat(fd, &st) == -1) {
+    int errNum = errno;
+    close(fd);
+    errno = errNum;
+    return false;
+  }
+  mapLength_ = headerLength_+getSnapshotLength()*2;
+  void* addr = mmap(0, mapLength_, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the descriptor is closed.
+  int errNum = errno;
+  close(fd);
+  if(addr == MAP_FAILED) {
+    errno = errNum;
+    return false;
+  }
+  map_ = reinterpret_cast<unsigned char*>(addr);
+  mapDev_ = st.st_dev;
+  mapIno_ = st.st_ino;
+  return true;
+}
+
+void DefaultBtProgressInfoFile::closeMap()
+{
+  if(map_) {
+    munmap(map_, mapLength_);
+    map_ = 0;
+  }
+}
+
+#endif // HAVE_MMAP
+
+void DefaultBtProgressInfoFile::save()
+{
+  // In-flight pieces are recorded as partially downloaded, so their
+  // cached data must be on disk before the control file is written.
+  const SharedHandle<DiskAdaptor>& diskAdaptor =
+    pieceStorage_->getDiskAdaptor();
+  if(!diskAdaptor.isNull()) {
+    diskAdaptor->flushCache();
+  }
+  logger_->info(MSG_SAVING_SEGMENT_FILE, filename_.c_str());
+  std::vector<SharedHandle<Piece> > inFlightPieces;
+  inFlightPieces.reserve(pieceStorage_->countInFlightPiece());
+  pieceStorage_->getInFlightPieces(inFlightPieces);
+#ifdef HAVE_MMAP
+  if(map_) {
+    // The file is written again if the records are full or someone
+    // removed or replaced it.
+    a2_struct_stat st;
+    if(inFlightPieces.size() <= maxInFlightPiece_ &&
+       a2stat(filename_.c_str(), &st) == 0 &&
+       st.st_dev == mapDev_ && st.st_ino == mapIno_) {
+      ++generation_;
+      size_t snapshotLength = getSnapshotLength();
+      writeSnapshot(map_+headerLength_+(generation_%2)*snapshotLength,
+                    generation_, inFlightPieces);
+      // The dirty pages are written by the kernel. If the process
+      // dies before the snapshot is complete, its checksum fails.
+      msync(map_, mapLength_, MS_ASYNC);
+      logger_->info(MSG_SAVED_SEGMENT_FILE);
+      return;
+    }
+    closeMap();
+  }
+#endif // HAVE_MMAP
+  writeFile(inFlightPieces);
+#ifdef HAVE_MMAP
+  if(!openMap() && logger_->debug()) {
+    logger_->debug("Failed to map %s, cause: %s. It will be written again"
+                   " in whole.", filename_.c_str(), strerror(errno));
+  }
+#endif // HAVE_MMAP
+  logger_->info(MSG_SAVED_SEGMENT_FILE);
+}
+
 #define CHECK_STREAM(in, length)                                        \
   if(in.gcount() != length) {                                           \
     throw DL_ABORT_EX(StringFormat(EX_SEGMENT_FILE_READ,                \
@@ -218,9 +453,136 @@ void DefaultBtProgressInfoFile::save()
                                    filename_.c_str(), strerror(errno)).str()); \
   }
 
+void DefaultBtProgressInfoFile::setProgress
+(uint32_t pieceLength, uint64_t totalLength,
+ const unsigned char* bitfield, size_t bitfieldLength,
+ size_t numInFlightPiece,
+ const std::vector<SharedHandle<Piece> >& inFlightPieces)
+{
+  if(pieceLength == dctx_->getPieceLength()) {
+    pieceStorage_->setBitfield(bitfield, bitfieldLength);
+    pieceStorage_->addInFlightPiece(inFlightPieces);
+  } else {
+    BitfieldMan src(pieceLength, totalLength);
+    src.setBitfield(bitfield, bitfieldLength);
+    if((src.getCompletedLength() || numInFlightPiece) &&
+       !option_->getAsBool(PREF_ALLOW_PIECE_LENGTH_CHANGE)) {
+      throw DOWNLOAD_FAILURE_EXCEPTION
+        ("WARNING: Detected a change in piece length. You can proceed with"
+         " --allow-piece-length-change=true, but you may lose some download"
+         " progress.");
+    }
+    BitfieldMan dest(dctx_->getPieceLength(), totalLength);
+    util::convertBitfield(&dest, &src);
+    pieceStorage_->setBitfield(dest.getBitfield(), dest.getBitfieldLength());
+  }
+}
+
+// Reads the part of version 0002 after totalLength.
+void DefaultBtProgressInfoFile::loadSnapshot
+(std::istream& in, uint32_t pieceLength, uint64_t totalLength)
+{
+  unsigned char buf[12];
+  in.read(reinterpret_cast<char*>(buf), sizeof(buf));
+  CHECK_STREAM(in, sizeof(buf));
+  uint32_t bitfieldLength = get32(buf);
+  uint32_t maxInFlightPiece = get32(buf+4);
+  uint32_t pieceBitfieldLength = get32(buf+8);
+  uint32_t expectedBitfieldLength =
+    ((totalLength+pieceLength-1)/pieceLength+7)/8;
+  if(expectedBitfieldLength != bitfieldLength) {
+    throw DL_ABORT_EX
+      (StringFormat("bitfield length mismatch. expected: %d, actual: %d",
+                    expectedBitfieldLength,
+                    bitfieldLength).str());
+  }
+  if(maxInFlightPiece > (totalLength+pieceLength-1)/pieceLength) {
+    throw DL_ABORT_EX
+      (StringFormat("the number of in-flight piece records out of range: %u",
+                    maxInFlightPiece).str());
+  }
+  if(pieceBitfieldLength != Piece(0, pieceLength).getBitfieldLength()) {
+    throw DL_ABORT_EX
+      (StringFormat("piece bitfield length mismatch."
+                    " expected: %u actual: %u",
+                    Piece(0, pieceLength).getBitfieldLength(),
+                    pieceBitfieldLength).str());
+  }
+  const size_t recordLength = 8+pieceBitfieldLength;
+  const size_t snapshotLength = sha1::DIGEST_LENGTH+8+8+bitfieldLength+
+    maxInFlightPiece*recordLength;
+  std::vector<unsigned char> snapshots(snapshotLength*2);
+  in.read(reinterpret_cast<char*>(&snapshots[0]), snapshots.size());
+  CHECK_STREAM(in, static_cast<int>(snapshots.size()));
+  const unsigned char* snapshot = 0;
+  uint64_t generation = 0;
+  for(int i = 0; i < 2; ++i) {
+    const unsigned char* p = &snapshots[i*snapshotLength];
+    unsigned char md[sha1::DIGEST_LENGTH];
+    computeChecksum(md, p, snapshotLength);
+    if(memcmp(md, p, sizeof(md)) != 0) {
+      if(logger_->debug()) {
+        logger_->debug("The checksum of snapshot #%d is invalid.", i);
+      }
+      continue;
+    }
+    uint64_t g = get64(p+sha1::DIGEST_LENGTH);
+    if(!snapshot || generation < g) {
+      snapshot = p;
+      generation = g;
+    }
+  }
+  if(!snapshot) {
+    throw DL_ABORT_EX(StringFormat(EX_SEGMENT_FILE_READ, filename_.c_str(),
+                                   "No valid snapshot").str());
+  }
+  const unsigned char* p = snapshot+sha1::DIGEST_LENGTH+8;
+#ifdef ENABLE_BITTORRENT
+  if(isTorrentDownload()) {
+    btRuntime_->setUploadLengthAtStartup(get64(p));
+  }
+#endif // ENABLE_BITTORRENT
+  p += 8;
+  const unsigned char* bitfield = p;
+  p += bitfieldLength;
+  size_t numInFlightPiece = 0;
+  std::vector<SharedHandle<Piece> > inFlightPieces;
+  for(size_t i = 0; i < maxInFlightPiece; ++i, p += recordLength) {
+    uint32_t index = get32(p);
+    if(index == UNUSED_RECORD) {
+      continue;
+    }
+    ++numInFlightPiece;
+    if(pieceLength != dctx_->getPieceLength()) {
+      continue;
+    }
+    if(!(index < dctx_->getNumPieces())) {
+      throw DL_ABORT_EX
+        (StringFormat("piece index out of range: %u", index).str());
+    }
+    uint32_t length = get32(p+4);
+    if(!(length <= dctx_->getPieceLength())) {
+      throw DL_ABORT_EX
+        (StringFormat("piece length out of range: %u", length).str());
+    }
+    SharedHandle<Piece> piece(new Piece(index, length));
+    piece->setBitfield(p+8, piece->getBitfieldLength());
+
+#ifdef ENABLE_MESSAGE_DIGEST
+
+    piece->setHashAlgo(dctx_->getPieceHashAlgo());
+
+#endif // ENABLE_MESSAGE_DIGEST
+
+    inFlightPieces.push_back(piece);
+  }
+  setProgress(pieceLength, totalLength, bitfield, bitfieldLength,
+              numInFlightPiece, inFlightPieces);
+}
+
 // It is assumed that integers are saved as:
 // 1) host byte order if version == 0000
-// 2) network byte order if version == 0001
+// 2) network byte order if version >= 0001
 void DefaultBtProgressInfoFile::load() 
 {
   logger_->info(MSG_LOADING_SEGMENT_FILE, filename_.c_str());
@@ -238,6 +600,8 @@ void DefaultBtProgressInfoFile::load()
     version = 0;
   } else if(DefaultBtProgressInfoFile::V0001 == versionHex) {
     version = 1;
+  } else if(DefaultBtProgressInfoFile::V0002 == versionHex) {
+    version = 2;
   } else {
     throw DL_ABORT_EX
       (StringFormat("Unsupported ctrl file version: %s",
@@ -304,6 +668,11 @@ void DefaultBtProgressInfoFile::load()
                     util::itos(dctx_->getTotalLength()).c_str(),
                     util::itos(totalLength).c_str()).str());
   }
+  if(version >= 2) {
+    loadSnapshot(in, pieceLength, totalLength);
+    logger_->info(MSG_LOADED_SEGMENT_FILE);
+    return;
+  }
   uint64_t uploadLength;
   in.read(reinterpret_cast<char*>(&uploadLength), sizeof(uploadLength));
   CHECK_STREAM(in, sizeof(uploadLength));
@@ -335,19 +704,17 @@ void DefaultBtProgressInfoFile::load()
   in.read(reinterpret_cast<char*>
           (static_cast<unsigned char*>(savedBitfield)), bitfieldLength);
   CHECK_STREAM(in, static_cast<int>(bitfieldLength));
+  uint32_t numInFlightPiece;
+  in.read(reinterpret_cast<char*>(&numInFlightPiece),
+          sizeof(numInFlightPiece));
+  CHECK_STREAM(in, sizeof(numInFlightPiece));
+  if(version >= 1) {
+    numInFlightPiece = ntohl(numInFlightPiece);
+  }
+  std::vector<SharedHandle<Piece> > inFlightPieces;
   if(pieceLength == dctx_->getPieceLength()) {
-    pieceStorage_->setBitfield(savedBitfield, bitfieldLength);
-
-    uint32_t numInFlightPiece;
-    in.read(reinterpret_cast<char*>(&numInFlightPiece),
-            sizeof(numInFlightPiece));
-    CHECK_STREAM(in, sizeof(numInFlightPiece));
-    if(version >= 1) {
-      numInFlightPiece = ntohl(numInFlightPiece);
-    }
-    std::vector<SharedHandle<Piece> > inFlightPieces;
     inFlightPieces.reserve(numInFlightPiece);
-    while(numInFlightPiece--) {
+    for(uint32_t i = 0; i < numInFlightPiece; ++i) {
       uint32_t index;
       in.read(reinterpret_cast<char*>(&index), sizeof(index));
       CHECK_STREAM(in, sizeof(index));
@@ -397,33 +764,17 @@ void DefaultBtProgressInfoFile::load()
         
       inFlightPieces.push_back(piece);
     }
-    pieceStorage_->addInFlightPiece(inFlightPieces);
-  } else {
-    uint32_t numInFlightPiece;
-    in.read(reinterpret_cast<char*>(&numInFlightPiece),
-            sizeof(numInFlightPiece));
-    CHECK_STREAM(in, sizeof(numInFlightPiece));
-    if(version >= 1) {
-      numInFlightPiece = ntohl(numInFlightPiece);
-    }
-    BitfieldMan src(pieceLength, totalLength);
-    src.setBitfield(savedBitfield, bitfieldLength);
-    if((src.getCompletedLength() || numInFlightPiece) &&
-       !option_->getAsBool(PREF_ALLOW_PIECE_LENGTH_CHANGE)) {
-      throw DOWNLOAD_FAILURE_EXCEPTION
-        ("WARNING: Detected a change in piece length. You can proceed with"
-         " --allow-piece-length-change=true, but you may lose some download"
-         " progress.");
-    }
-    BitfieldMan dest(dctx_->getPieceLength(), totalLength);
-    util::convertBitfield(&dest, &src);
-    pieceStorage_->setBitfield(dest.getBitfield(), dest.getBitfieldLength());
   }
+  setProgress(pieceLength, totalLength, savedBitfield, bitfieldLength,
+              numInFlightPiece, inFlightPieces);
   logger_->info(MSG_LOADED_SEGMENT_FILE);
 }
 
 void DefaultBtProgressInfoFile::removeFile()
 {
+#ifdef HAVE_MMAP
+  closeMap();
+#endif // HAVE_MMAP
   if(exists()) {
     File f(filename_);
     f.remove();
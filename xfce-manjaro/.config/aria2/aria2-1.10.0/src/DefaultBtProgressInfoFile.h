@@ -37,6 +37,11 @@
 
 #include "BtProgressInfoFile.h"
 
+#include <sys/types.h>
+
+#include <vector>
+#include <iosfwd>
+
 namespace aria2 {
 
 class DownloadContext;
@@ -45,6 +50,7 @@ class PeerStorage;
 class BtRuntime;
 class Logger;
 class Option;
+class Piece;
 
 class DefaultBtProgressInfoFile : public BtProgressInfoFile {
 private:
@@ -58,10 +64,50 @@ private:
   Logger* logger_;
   std::string filename_;
 
+  // The layout of the control file last written by save(). See
+  // DefaultBtProgressInfoFile.cc for the format.
+  size_t maxInFlightPiece_;
+  size_t pieceBitfieldLength_;
+  size_t headerLength_;
+  // The generation of the latest snapshot.
+  uint64_t generation_;
+#ifdef HAVE_MMAP
+  // The control file mapped by save(), which updates snapshots in
+  // place. The file descriptor is closed right after mmap(). The
+  // device and inode numbers tell whether filename_ still refers to
+  // the mapped file.
+  unsigned char* map_;
+  size_t mapLength_;
+  dev_t mapDev_;
+  ino_t mapIno_;
+
+  bool openMap();
+
+  void closeMap();
+#endif // HAVE_MMAP
+
   bool isTorrentDownload();
 
+  size_t getSnapshotLength() const;
+
+  void writeHeader(unsigned char* dst);
+
+  void writeSnapshot(unsigned char* dst, uint64_t generation,
+                     const std::vector<SharedHandle<Piece> >& inFlightPieces);
+
+  void writeFile(const std::vector<SharedHandle<Piece> >& inFlightPieces);
+
+  void setProgress(uint32_t pieceLength, uint64_t totalLength,
+                   const unsigned char* bitfield, size_t bitfieldLength,
+                   size_t numInFlightPiece,
+                   const std::vector<SharedHandle<Piece> >& inFlightPieces);
+
+  void loadSnapshot(std::istream& in, uint32_t pieceLength,
+                    uint64_t totalLength);
+
   static const std::string V0000;
   static const std::string V0001;
+  static const std::string V0002;
 public:
   DefaultBtProgressInfoFile(const SharedHandle<DownloadContext>& btContext,
                             const SharedHandle<PieceStorage>& pieceStorage,
@@ -77,6 +77,7 @@ DefaultExtensionMessageFactory::createMessage(const unsigned char* data, size_t
     HandshakeExtensionMessageHandle m =
       HandshakeExtensionMessage::create(data, length);
     m->setPeer(peer_);
+    m->setPeerStorage(peerStorage_);
     m->setDownloadContext(dctx_);
     return m;
   } else {
@@ -97,25 +98,27 @@ DefaultExtensionMessageFactory::createMessage(const unsigned char* data, size_t
         throw DL_ABORT_EX(StringFormat(MSG_TOO_SMALL_PAYLOAD_SIZE,
                                        "ut_metadata", length).str());
       }
-      size_t end;
-      SharedHandle<ValueBase> decoded = bencode2::decode(data+1, length-1, end);
-      const Dict* dict = asDict(decoded);
-      if(!dict) {
+      bencode2::ViewDecoder decoder;
+      size_t end = decoder.decode(data+1, length-1);
+      const bencode2::View* dict = decoder.getRoot();
+      if(!dict || dict->type != bencode2::View::DICT) {
         throw DL_ABORT_EX("Bad ut_metadata: dictionary not found");
       }
-      const Integer* msgType = asInteger(dict->get("msg_type"));
+      const bencode2::View* msgType =
+        decoder.get(dict, "msg_type", bencode2::View::INTEGER);
       if(!msgType) {
         throw DL_ABORT_EX("Bad ut_metadata: msg_type not found");
       }
-      const Integer* index = asInteger(dict->get("piece"));
+      const bencode2::View* index =
+        decoder.get(dict, "piece", bencode2::View::INTEGER);
       if(!index) {
         throw DL_ABORT_EX("Bad ut_metadata: piece not found");
       }
-      switch(msgType->i()) {
+      switch(msgType->i) {
       case 0: {
         SharedHandle<UTMetadataRequestExtensionMessage> m
           (new UTMetadataRequestExtensionMessage(extensionMessageID));
-        m->setIndex(index->i());
+        m->setIndex(index->i);
         m->setDownloadContext(dctx_);
         m->setPeer(peer_);
         m->setBtMessageFactory(messageFactory_);
@@ -126,14 +129,15 @@ DefaultExtensionMessageFactory::createMessage(const unsigned char* data, size_t
         if(end == length) {
           throw DL_ABORT_EX("Bad ut_metadata data: data not found");
         }
-        const Integer* totalSize = asInteger(dict->get("total_size"));
+        const bencode2::View* totalSize =
+          decoder.get(dict, "total_size", bencode2::View::INTEGER);
         if(!totalSize) {
           throw DL_ABORT_EX("Bad ut_metadata data: total_size not found");
         }
         SharedHandle<UTMetadataDataExtensionMessage> m
           (new UTMetadataDataExtensionMessage(extensionMessageID));
-        m->setIndex(index->i());
-        m->setTotalSize(totalSize->i());
+        m->setIndex(index->i);
+        m->setTotalSize(totalSize->i);
         m->setData(std::string(&data[1+end], &data[length]));
         m->setUTMetadataRequestTracker(tracker_);
         m->setPieceStorage(dctx_->getOwnerRequestGroup()->getPieceStorage());
@@ -143,13 +147,13 @@ DefaultExtensionMessageFactory::createMessage(const unsigned char* data, size_t
       case 2: {
         SharedHandle<UTMetadataRejectExtensionMessage> m
           (new UTMetadataRejectExtensionMessage(extensionMessageID));
-        m->setIndex(index->i());
+        m->setIndex(index->i);
         // No need to inject tracker because peer will be disconnected.
         return m;
       }
       default:
         throw DL_ABORT_EX(StringFormat("Bad ut_metadata: unknown msg_type=%u",
-                                       msgType->i()).str());
+                                       msgType->i).str());
       }
     } else {
       throw DL_ABORT_EX
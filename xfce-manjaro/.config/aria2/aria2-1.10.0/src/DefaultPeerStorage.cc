@@ -45,6 +45,7 @@
 #include "BtLeecherStateChoke.h"
 #include "PieceStorage.h"
 #include "wallclock.h"
+#include "bittorrent_helper.h"
 
 namespace aria2 {
 
@@ -65,23 +66,51 @@ DefaultPeerStorage::~DefaultPeerStorage()
   delete leecherStateChoke_;
 }
 
-class FindIdenticalPeer {
-private:
-  SharedHandle<Peer> peer_;
-public:
-  FindIdenticalPeer(const SharedHandle<Peer>& peer):peer_(peer) {}
-
-  bool operator()(const SharedHandle<Peer>& peer) const {
-    return (peer_ == peer) ||
-      ((peer_->getIPAddress() == peer->getIPAddress()) &&
-       (peer_->getPort() == peer->getPort()));
+// Returns the key of peerIndex_ for ipaddr and port. IPv4 address is
+// packed into 6 bytes compact form. Other address is stored as is,
+// followed by port in network byte order. The first byte tells which
+// form is used, so that they never collide.
+static std::string makePeerKey(const std::string& ipaddr, uint16_t port)
+{
+  unsigned char compact[6];
+  std::string key;
+  if(bittorrent::createcompact(compact, ipaddr, port)) {
+    key += '4';
+    key.append(&compact[0], &compact[sizeof(compact)]);
+  } else {
+    key += '*';
+    key += ipaddr;
+    key += static_cast<char>(port >> 8);
+    key += static_cast<char>(port & 0xff);
   }
-};
+  return key;
+}
+
+static std::string makePeerKey(const SharedHandle<Peer>& peer)
+{
+  return makePeerKey(peer->getIPAddress(), peer->getPort());
+}
 
 bool DefaultPeerStorage::isPeerAlreadyAdded(const SharedHandle<Peer>& peer)
 {
-  return std::find_if(peers_.begin(), peers_.end(),
-                      FindIdenticalPeer(peer)) != peers_.end();
+  return peerIndex_.find(makePeerKey(peer)) != peerIndex_.end();
+}
+
+DefaultPeerStorage::PeerIndex::iterator
+DefaultPeerStorage::findPeer(const SharedHandle<Peer>& peer)
+{
+  PeerIndex::iterator itr = peerIndex_.find(makePeerKey(peer));
+  if(itr != peerIndex_.end() && *(*itr).second != peer) {
+    // Another Peer object with the same address and port.
+    return peerIndex_.end();
+  }
+  return itr;
+}
+
+void DefaultPeerStorage::erasePeer(PeerIndex::iterator itr)
+{
+  peers_.erase((*itr).second);
+  peerIndex_.erase(itr);
 }
 
 static size_t calculateMaxPeerListSize(const SharedHandle<BtRuntime>& btRuntime)
@@ -103,10 +132,11 @@ bool DefaultPeerStorage::addPeer(const SharedHandle<Peer>& peer) {
     return false;
   }
   size_t maxPeerListSize = calculateMaxPeerListSize(btRuntime_);
-  if(peers_.size() >= maxPeerListSize) {
-    deleteUnusedPeer(peers_.size()-maxPeerListSize+1);
+  if(countPeer() >= maxPeerListSize) {
+    deleteUnusedPeer(countPeer()-maxPeerListSize+1);
   }
   peers_.push_front(peer);
+  peerIndex_[makePeerKey(peer)] = peers_.begin();
   return true;
 }
 
@@ -124,7 +154,7 @@ void DefaultPeerStorage::addPeer(const std::vector<SharedHandle<Peer> >& peers)
   }  
 }
 
-const std::deque<SharedHandle<Peer> >& DefaultPeerStorage::getPeers()
+const std::list<SharedHandle<Peer> >& DefaultPeerStorage::getPeers()
 {
   return peers_;
 }
@@ -137,7 +167,7 @@ public:
 };
 
 SharedHandle<Peer> DefaultPeerStorage::getUnusedPeer() {
-  std::deque<SharedHandle<Peer> >::const_iterator itr =
+  std::list<SharedHandle<Peer> >::const_iterator itr =
     std::find_if(peers_.begin(), peers_.end(), FindFinePeer());
   if(itr == peers_.end()) {
     return SharedHandle<Peer>();
@@ -146,32 +176,18 @@ SharedHandle<Peer> DefaultPeerStorage::getUnusedPeer() {
   }
 }
 
-class FindPeer {
-private:
-  std::string ipaddr;
-  uint16_t port;
-public:
-  FindPeer(const std::string& ipaddr, uint16_t port):
-    ipaddr(ipaddr), port(port) {}
-
-  bool operator()(const SharedHandle<Peer>& peer) const {
-    return ipaddr == peer->getIPAddress() && port == peer->getPort();
-  }
-};
-
 SharedHandle<Peer> DefaultPeerStorage::getPeer(const std::string& ipaddr,
                                                uint16_t port) const {
-  std::deque<SharedHandle<Peer> >::const_iterator itr =
-    std::find_if(peers_.begin(), peers_.end(), FindPeer(ipaddr, port));
-  if(itr == peers_.end()) {
+  PeerIndex::const_iterator itr = peerIndex_.find(makePeerKey(ipaddr, port));
+  if(itr == peerIndex_.end()) {
     return SharedHandle<Peer>();
   } else {
-    return *itr;
+    return *(*itr).second;
   }
 }
 
 size_t DefaultPeerStorage::countPeer() const {
-  return peers_.size();
+  return peerIndex_.size();
 }
 
 bool DefaultPeerStorage::isPeerAvailable() {
@@ -271,18 +287,19 @@ TransferStat DefaultPeerStorage::getTransferStatFor
 }
 
 void DefaultPeerStorage::deleteUnusedPeer(size_t delSize) {
-  std::deque<SharedHandle<Peer> > temp;
-  for(std::deque<SharedHandle<Peer> >::const_reverse_iterator itr =
-        peers_.rbegin(), eoi = peers_.rend(); itr != eoi; ++itr) {
-    const SharedHandle<Peer>& p = *itr;
-    if(p->unused() && delSize > 0) {
+  // Old peers are at the back. Each peer visited is either erased or
+  // in use, so this takes O(delSize + the number of peers in use).
+  std::list<SharedHandle<Peer> >::iterator itr = peers_.end();
+  while(delSize > 0 && itr != peers_.begin()) {
+    --itr;
+    if((*itr)->unused()) {
+      SharedHandle<Peer> p = *itr;
+      peerIndex_.erase(makePeerKey(p));
+      itr = peers_.erase(itr);
       onErasingPeer(p);
-      delSize--;
-    } else {
-      temp.push_front(p);
+      --delSize;
     }
   }
-  peers_.swap(temp);
 }
 
 void DefaultPeerStorage::onErasingPeer(const SharedHandle<Peer>& peer) {}
@@ -305,21 +322,56 @@ void DefaultPeerStorage::onReturningPeer(const SharedHandle<Peer>& peer)
 
 void DefaultPeerStorage::returnPeer(const SharedHandle<Peer>& peer)
 {
-  std::deque<SharedHandle<Peer> >::iterator itr =
-    std::find(peers_.begin(), peers_.end(), peer);
-  if(itr == peers_.end()) {
+  PeerIndex::iterator itr = findPeer(peer);
+  if(itr == peerIndex_.end()) {
     if(logger_->debug()) {
       logger_->debug("Cannot find peer %s:%u in PeerStorage.",
                     peer->getIPAddress().c_str(), peer->getPort());
     }
   } else {
-    peers_.erase(itr);
+    erasePeer(itr);
 
     onReturningPeer(peer);
     onErasingPeer(peer);
   }
 }
 
+void DefaultPeerStorage::updatePeerPort
+(const SharedHandle<Peer>& peer, uint16_t port)
+{
+  if(peer->getPort() == port) {
+    return;
+  }
+  PeerIndex::iterator itr = findPeer(peer);
+  if(itr == peerIndex_.end()) {
+    peer->setPort(port);
+    return;
+  }
+  std::string newKey = makePeerKey(peer->getIPAddress(), port);
+  PeerIndex::iterator dup = peerIndex_.find(newKey);
+  if(dup != peerIndex_.end()) {
+    SharedHandle<Peer> dupPeer = *(*dup).second;
+    if(!dupPeer->unused()) {
+      // We are connected to the same peer twice. Keep the port the
+      // connection came from, so that both stay in PeerStorage.
+      if(logger_->debug()) {
+        logger_->debug("Not changing port of %s:%u to %u because it has"
+                       " been already added.",
+                       peer->getIPAddress().c_str(), peer->getPort(), port);
+      }
+      return;
+    }
+    // dupPeer is the peer we are now connected to, learned from
+    // tracker, PEX or DHT. Keep the connected one.
+    erasePeer(dup);
+    onErasingPeer(dupPeer);
+  }
+  std::list<SharedHandle<Peer> >::iterator pos = (*itr).second;
+  peerIndex_.erase(itr);
+  peer->setPort(port);
+  peerIndex_[newKey] = pos;
+}
+
 bool DefaultPeerStorage::chokeRoundIntervalElapsed()
 {
   const time_t CHOKE_ROUND_INTERVAL = 10;
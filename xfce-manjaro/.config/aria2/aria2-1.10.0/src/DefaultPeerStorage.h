@@ -37,9 +37,11 @@
 
 #include "PeerStorage.h"
 
+#include <string>
 #include <map>
 
 #include "TimerA2.h"
+#include "a2unordered_map.h"
 
 namespace aria2 {
 
@@ -53,7 +55,15 @@ class DefaultPeerStorage : public PeerStorage {
 private:
   SharedHandle<BtRuntime> btRuntime_;
   SharedHandle<PieceStorage> pieceStorage_;
-  std::deque<SharedHandle<Peer> > peers_;
+  std::list<SharedHandle<Peer> > peers_;
+  typedef UnorderedMap<std::string,
+                       std::list<SharedHandle<Peer> >::iterator>::type
+  PeerIndex;
+  // Index of peers_ keyed by the packed address and port of a
+  // peer. See makePeerKey(). Each peer in peers_ has exactly one
+  // entry, so peerIndex_.size() is the number of peers, which
+  // std::list::size() may have to count.
+  PeerIndex peerIndex_;
   Logger* logger_;
   uint64_t removedPeerSessionDownloadLength_;
   uint64_t removedPeerSessionUploadLength_;
@@ -68,6 +78,12 @@ private:
   TransferStat cachedTransferStat_;
 
   bool isPeerAlreadyAdded(const SharedHandle<Peer>& peer);
+
+  // Returns the entry of peerIndex_ for peer. If peer is not in
+  // peers_, returns peerIndex_.end().
+  PeerIndex::iterator findPeer(const SharedHandle<Peer>& peer);
+
+  void erasePeer(PeerIndex::iterator itr);
 public:
   DefaultPeerStorage();
 
@@ -83,7 +99,7 @@ public:
 
   virtual void addPeer(const std::vector<SharedHandle<Peer> >& peers);
 
-  virtual const std::deque<SharedHandle<Peer> >& getPeers();
+  virtual const std::list<SharedHandle<Peer> >& getPeers();
 
   virtual bool isPeerAvailable();
 
@@ -97,6 +113,8 @@ public:
 
   virtual void returnPeer(const SharedHandle<Peer>& peer);
 
+  virtual void updatePeerPort(const SharedHandle<Peer>& peer, uint16_t port);
+
   virtual bool chokeRoundIntervalElapsed();
 
   virtual void executeChoke();
@@ -45,6 +45,8 @@
 #include "prefs.h"
 #include "DirectDiskAdaptor.h"
 #include "MultiDiskAdaptor.h"
+#include "CachedDiskAdaptor.h"
+#include "DiskCache.h"
 #include "DiskWriter.h"
 #include "BitfieldMan.h"
 #include "message.h"
@@ -58,6 +60,7 @@
 #include "RarestPieceSelector.h"
 #include "array_fun.h"
 #include "PieceStatMan.h"
+#include "LazyFileAllocator.h"
 #include "wallclock.h"
 #ifdef ENABLE_BITTORRENT
 # include "bittorrent_helper.h"
@@ -117,6 +120,9 @@ SharedHandle<Piece> DefaultPieceStorage::checkOutPiece(size_t index)
   SharedHandle<Piece> piece = findUsedPiece(index);
   if(piece.isNull()) {
     piece.reset(new Piece(index, bitfieldMan_->getBlockLength(index)));
+    if(!lazyFileAllocator_.isNull()) {
+      lazyFileAllocator_->reserve(index);
+    }
 
 #ifdef ENABLE_MESSAGE_DIGEST
 
@@ -346,6 +352,9 @@ void DefaultPieceStorage::completePiece(const SharedHandle<Piece>& piece)
     return;
   }
   deleteUsedPiece(piece);
+  if(!cachedDiskAdaptor_.isNull()) {
+    cachedDiskAdaptor_->flushPiece(piece->getIndex());
+  }
   //   if(!isEndGame()) {
   //     reduceUsedPieces(100);
   //   }
@@ -526,6 +535,20 @@ void DefaultPieceStorage::initStorage()
   if(option_->get(PREF_FILE_ALLOCATION) == V_FALLOC) {
     diskAdaptor_->enableFallocate();
   }
+  if(!diskCache_.isNull() && diskCache_->getLimit() > 0) {
+    if(logger_->debug()) {
+      logger_->debug("Enabling disk cache");
+    }
+    cachedDiskAdaptor_.reset
+      (new CachedDiskAdaptor(diskAdaptor_, diskCache_,
+                             downloadContext_->getPieceLength()));
+    diskAdaptor_ = cachedDiskAdaptor_;
+  }
+  if(option_->get(PREF_FILE_ALLOCATION) == V_LAZY) {
+    lazyFileAllocator_.reset(new LazyFileAllocator(diskAdaptor_, bitfieldMan_));
+  } else {
+    lazyFileAllocator_.reset();
+  }
 }
 
 void DefaultPieceStorage::setBitfield(const unsigned char* bitfield,
@@ -673,6 +696,11 @@ void DefaultPieceStorage::setDiskWriterFactory
   diskWriterFactory_ = diskWriterFactory;
 }
 
+void DefaultPieceStorage::setDiskCache(const SharedHandle<DiskCache>& diskCache)
+{
+  diskCache_ = diskCache;
+}
+
 void DefaultPieceStorage::addPieceStats(const unsigned char* bitfield,
                                         size_t bitfieldLength)
 {
@@ -49,6 +49,9 @@ class DiskWriterFactory;
 class FileEntry;
 class PieceStatMan;
 class PieceSelector;
+class DiskCache;
+class CachedDiskAdaptor;
+class LazyFileAllocator;
 
 #define END_GAME_PIECE_NUM 20
 
@@ -76,6 +79,12 @@ private:
   BitfieldMan* bitfieldMan_;
   SharedHandle<DiskAdaptor> diskAdaptor_;
   SharedHandle<DiskWriterFactory> diskWriterFactory_;
+  SharedHandle<DiskCache> diskCache_;
+  // Same object as diskAdaptor_ if disk cache is enabled. Otherwise
+  // null.
+  SharedHandle<CachedDiskAdaptor> cachedDiskAdaptor_;
+  // Non-null if --file-allocation=lazy is given.
+  SharedHandle<LazyFileAllocator> lazyFileAllocator_;
   std::deque<SharedHandle<Piece> > usedPieces_;
 
   size_t endGamePieceNum_;
@@ -237,6 +246,10 @@ public:
   void setDiskWriterFactory
   (const SharedHandle<DiskWriterFactory>& diskWriterFactory);
 
+  // If diskCache is set before initStorage() is called, DiskAdaptor
+  // is wrapped with CachedDiskAdaptor which uses diskCache.
+  void setDiskCache(const SharedHandle<DiskCache>& diskCache);
+
   const SharedHandle<PieceStatMan>& getPieceStatMan() const
   {
     return pieceStatMan_;
@@ -251,6 +264,11 @@ public:
   {
     return pieceSelector_;
   }
+
+  const SharedHandle<LazyFileAllocator>& getLazyFileAllocator() const
+  {
+    return lazyFileAllocator_;
+  }
 };
 
 typedef SharedHandle<DefaultPieceStorage> DefaultPieceStorageHandle;
@@ -110,6 +110,22 @@ public:
   // successfully changed.
   virtual size_t utime(const Time& actime, const Time& modtime) = 0;
 
+  // Writes data buffered in memory to disk. The default
+  // implementation does nothing.
+  virtual void flushCache() {}
+
+  // Finds the file which holds the data at offset and stores its
+  // file descriptor in fd and the position of the data in the file
+  // in fileOffset. Returns the number of bytes, up to len, which can
+  // be read contiguously from fd. Returns 0 if the data cannot be
+  // read directly from a file descriptor. The default
+  // implementation returns 0.
+  virtual size_t getFileRange
+  (int& fd, off_t& fileOffset, off_t offset, size_t len)
+  {
+    return 0;
+  }
+
   void enableFallocate()
   {
     fallocate_ = true;
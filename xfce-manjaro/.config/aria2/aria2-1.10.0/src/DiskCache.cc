@@ -0,0 +1,105 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DiskCache.h"
+#include "DiskCacheEntry.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "RecoverableException.h"
+
+namespace aria2 {
+
+DiskCache::DiskCache(size_t limit):
+  limit_(limit),
+  size_(0),
+  clock_(0),
+  logger_(LogFactory::getInstance()) {}
+
+DiskCache::~DiskCache() {}
+
+void DiskCache::cacheData
+(DiskCacheEntry* entry, const unsigned char* data, size_t len, off_t offset)
+{
+  size_t oldSize = entry->getSize();
+  if(oldSize > 0) {
+    entries_.erase(std::make_pair(entry->getLastUpdate(), entry));
+  }
+  entry->cacheData(data, len, offset);
+  size_ += entry->getSize()-oldSize;
+  entry->setLastUpdate(++clock_);
+  entries_.insert(std::make_pair(entry->getLastUpdate(), entry));
+  evict();
+}
+
+void DiskCache::evict()
+{
+  while(size_ > limit_ && !entries_.empty()) {
+    DiskCacheEntry* entry = (*entries_.begin()).second;
+    if(logger_->debug()) {
+      logger_->debug("Disk cache is full. Writing back piece index=%lu,"
+                     " size=%lu",
+                     static_cast<unsigned long>(entry->getIndex()),
+                     static_cast<unsigned long>(entry->getSize()));
+    }
+    flush(entry);
+  }
+}
+
+void DiskCache::flush(DiskCacheEntry* entry)
+{
+  size_t oldSize = entry->getSize();
+  if(oldSize == 0) {
+    return;
+  }
+  entries_.erase(std::make_pair(entry->getLastUpdate(), entry));
+  try {
+    entry->flush();
+  } catch(RecoverableException& e) {
+    size_ -= oldSize-entry->getSize();
+    entries_.insert(std::make_pair(entry->getLastUpdate(), entry));
+    throw;
+  }
+  size_ -= oldSize;
+}
+
+void DiskCache::remove(DiskCacheEntry* entry)
+{
+  if(entry->getSize() > 0) {
+    entries_.erase(std::make_pair(entry->getLastUpdate(), entry));
+    size_ -= entry->getSize();
+    entry->clear();
+  }
+}
+
+} // namespace aria2
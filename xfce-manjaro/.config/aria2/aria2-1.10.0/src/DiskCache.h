@@ -0,0 +1,103 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_DISK_CACHE_H_
+#define _D_DISK_CACHE_H_
+
+#include "common.h"
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <cstddef>
+#include <set>
+#include <utility>
+
+namespace aria2 {
+
+class DiskCacheEntry;
+class Logger;
+
+// Process-wide memory budget for the data buffered by
+// CachedDiskAdaptor. When the total size of cached data exceeds the
+// limit, the least recently updated entries are written back to disk.
+class DiskCache {
+private:
+  size_t limit_;
+
+  size_t size_;
+
+  uint64_t clock_;
+
+  // Entries which hold data, ordered by last update.
+  std::set<std::pair<uint64_t, DiskCacheEntry*> > entries_;
+
+  Logger* logger_;
+
+  void evict();
+public:
+  DiskCache(size_t limit);
+
+  ~DiskCache();
+
+  // Stores data in entry and writes back least recently updated
+  // entries while the total size exceeds the limit.
+  void cacheData(DiskCacheEntry* entry,
+                 const unsigned char* data, size_t len, off_t offset);
+
+  // Writes data cached in entry to disk.
+  void flush(DiskCacheEntry* entry);
+
+  // Drops data cached in entry without writing it.
+  void remove(DiskCacheEntry* entry);
+
+  size_t getLimit() const
+  {
+    return limit_;
+  }
+
+  size_t getSize() const
+  {
+    return size_;
+  }
+
+  size_t countEntry() const
+  {
+    return entries_.size();
+  }
+};
+
+} // namespace aria2
+
+#endif // _D_DISK_CACHE_H_
@@ -0,0 +1,162 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DiskCacheEntry.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "DiskAdaptor.h"
+#include "FileEntry.h"
+
+namespace aria2 {
+
+DiskCacheEntry::DiskCacheEntry(DiskAdaptor* diskAdaptor, size_t index):
+  diskAdaptor_(diskAdaptor),
+  index_(index),
+  size_(0),
+  lastUpdate_(0) {}
+
+DiskCacheEntry::~DiskCacheEntry() {}
+
+static off_t cellEnd(const std::map<off_t, std::string>::const_iterator& i)
+{
+  return i->first+i->second.size();
+}
+
+void DiskCacheEntry::cacheData
+(const unsigned char* data, size_t len, off_t offset)
+{
+  if(len == 0) {
+    return;
+  }
+  const char* cdata = reinterpret_cast<const char*>(data);
+  off_t end = offset+len;
+  // Find the first cell which overlaps or touches [offset, end).
+  std::map<off_t, std::string>::iterator first = cells_.upper_bound(offset);
+  if(first != cells_.begin()) {
+    --first;
+    if(cellEnd(first) < offset) {
+      ++first;
+    }
+  }
+  std::map<off_t, std::string>::iterator last = first;
+  while(last != cells_.end() && last->first <= end) {
+    ++last;
+  }
+  if(first == last) {
+    cells_.insert(std::make_pair(offset, std::string(cdata, len)));
+    size_ += len;
+    return;
+  }
+  std::map<off_t, std::string>::iterator next = first;
+  ++next;
+  if(next == last && first->first <= offset) {
+    // Only one cell is involved and it starts before the new data.
+    // This is the common case: sequential writes to the same piece.
+    std::string& cell = first->second;
+    size_t pos = offset-first->first;
+    size_t overwrite = std::min(cell.size()-pos, len);
+    cell.replace(pos, overwrite, cdata, overwrite);
+    if(overwrite < len) {
+      cell.append(cdata+overwrite, len-overwrite);
+      size_ += len-overwrite;
+    }
+    return;
+  }
+  std::map<off_t, std::string>::iterator lastCell = last;
+  --lastCell;
+  off_t mergedStart = std::min(first->first, offset);
+  off_t mergedEnd = std::max(cellEnd(lastCell), end);
+  std::string merged(mergedEnd-mergedStart, '\0');
+  for(std::map<off_t, std::string>::iterator i = first; i != last; ++i) {
+    merged.replace(i->first-mergedStart, i->second.size(), i->second);
+    size_ -= i->second.size();
+  }
+  merged.replace(offset-mergedStart, len, cdata, len);
+  cells_.erase(first, last);
+  cells_.insert(std::make_pair(mergedStart, merged));
+  size_ += merged.size();
+}
+
+size_t DiskCacheEntry::readData
+(unsigned char* data, size_t len, off_t offset) const
+{
+  off_t end = offset+len;
+  std::map<off_t, std::string>::const_iterator i = cells_.upper_bound(offset);
+  if(i != cells_.begin()) {
+    --i;
+    if(cellEnd(i) <= offset) {
+      ++i;
+    }
+  }
+  size_t copied = 0;
+  for(; i != cells_.end() && i->first < end; ++i) {
+    off_t first = std::max(i->first, offset);
+    off_t last = std::min(cellEnd(i), end);
+    memcpy(data+(first-offset), i->second.data()+(first-i->first), last-first);
+    copied = last-offset;
+  }
+  return copied;
+}
+
+bool DiskCacheEntry::covers(off_t offset, size_t len) const
+{
+  std::map<off_t, std::string>::const_iterator i = cells_.upper_bound(offset);
+  if(i == cells_.begin()) {
+    return false;
+  }
+  --i;
+  return cellEnd(i) >= static_cast<off_t>(offset+len);
+}
+
+void DiskCacheEntry::flush()
+{
+  while(!cells_.empty()) {
+    std::map<off_t, std::string>::iterator i = cells_.begin();
+    diskAdaptor_->writeData
+      (reinterpret_cast<const unsigned char*>(i->second.data()),
+       i->second.size(), i->first);
+    size_ -= i->second.size();
+    cells_.erase(i);
+  }
+}
+
+void DiskCacheEntry::clear()
+{
+  cells_.clear();
+  size_ = 0;
+}
+
+} // namespace aria2
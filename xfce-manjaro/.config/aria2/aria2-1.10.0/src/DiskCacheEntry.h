@@ -0,0 +1,122 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_DISK_CACHE_ENTRY_H_
+#define _D_DISK_CACHE_ENTRY_H_
+
+#include "common.h"
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <string>
+#include <map>
+
+namespace aria2 {
+
+class DiskAdaptor;
+
+// Holds data written to one piece which is not yet written to
+// disk. Adjacent and overlapping writes are coalesced into one
+// contiguous cell, so that a fully downloaded piece is written to disk
+// by one DiskAdaptor::writeData() call.
+class DiskCacheEntry {
+private:
+  // Cached data is written to this object on flush().
+  DiskAdaptor* diskAdaptor_;
+
+  size_t index_;
+
+  // Key is the absolute offset of the cell in the download.
+  std::map<off_t, std::string> cells_;
+
+  // Total number of bytes in cells_.
+  size_t size_;
+
+  // Updated by DiskCache to order entries by the time of last update.
+  uint64_t lastUpdate_;
+public:
+  DiskCacheEntry(DiskAdaptor* diskAdaptor, size_t index);
+
+  ~DiskCacheEntry();
+
+  // Stores data in cache. If the range overlaps previously cached
+  // data, the new data wins.
+  void cacheData(const unsigned char* data, size_t len, off_t offset);
+
+  // Copies cached data in the range [offset, offset+len) to data.
+  // Bytes which are not cached are left untouched.  Returns the
+  // length from offset to the end of the last copied byte, or 0 if no
+  // byte is copied.
+  size_t readData(unsigned char* data, size_t len, off_t offset) const;
+
+  // Returns true if the whole range [offset, offset+len) is cached.
+  bool covers(off_t offset, size_t len) const;
+
+  // Writes all cached data to DiskAdaptor and drops it. If
+  // DiskAdaptor throws exception, data not yet written is kept.
+  void flush();
+
+  // Drops all cached data without writing it.
+  void clear();
+
+  size_t getIndex() const
+  {
+    return index_;
+  }
+
+  size_t getSize() const
+  {
+    return size_;
+  }
+
+  size_t countCell() const
+  {
+    return cells_.size();
+  }
+
+  uint64_t getLastUpdate() const
+  {
+    return lastUpdate_;
+  }
+
+  void setLastUpdate(uint64_t lastUpdate)
+  {
+    lastUpdate_ = lastUpdate;
+  }
+};
+
+} // namespace aria2
+
+#endif // _D_DISK_CACHE_ENTRY_H_
@@ -0,0 +1,72 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DiskIOCompletionCommand.h"
+#include "DownloadEngine.h"
+#include "DiskIOThreadPool.h"
+#include "RequestGroupMan.h"
+#include "FileAllocationEntry.h"
+#include "CheckIntegrityEntry.h"
+
+namespace aria2 {
+
+DiskIOCompletionCommand::DiskIOCompletionCommand
+(cuid_t cuid, DownloadEngine* e):Command(cuid), e_(e)
+{
+  e_->addDiskIOThreadPoolCheck(this);
+  e_->getDiskIOThreadPool()->setWatched(true);
+}
+
+DiskIOCompletionCommand::~DiskIOCompletionCommand()
+{
+  e_->deleteDiskIOThreadPoolCheck(this);
+  e_->getDiskIOThreadPool()->setWatched(false);
+}
+
+bool DiskIOCompletionCommand::execute()
+{
+  const SharedHandle<DiskIOThreadPool>& pool = e_->getDiskIOThreadPool();
+  if(pool->processCompletions() > 0) {
+    // The commands activated above must run without waiting for the
+    // next event.
+    e_->setNoWait(true);
+  }
+  if(pool->countPendingJob() == 0) {
+    return true;
+  }
+  e_->addCommand(this);
+  return false;
+}
+
+} // namespace aria2
@@ -0,0 +1,117 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_DISK_IO_JOB_H_
+#define _D_DISK_IO_JOB_H_
+
+#include "common.h"
+#include "SharedHandle.h"
+
+namespace aria2 {
+
+class Command;
+class Exception;
+
+// A unit of blocking disk work which DiskIOThreadPool runs in a
+// worker thread. execute() and run() are called in the worker
+// thread. The other member functions must be called in the main
+// thread only.
+class DiskIOJob {
+private:
+  Command* command_;
+
+  bool completed_;
+
+  SharedHandle<Exception> exception_;
+public:
+  DiskIOJob();
+
+  virtual ~DiskIOJob();
+
+  virtual void execute() = 0;
+
+  // Calls execute() and stores the exception thrown by it, if any.
+  void run();
+
+  // Marks this job completed and activates the command waiting for
+  // it.
+  void complete();
+
+  bool completed() const
+  {
+    return completed_;
+  }
+
+  // Sets the command which is activated when this job is
+  // completed. Pass 0 when the command is going away.
+  void setCommand(Command* command)
+  {
+    command_ = command;
+  }
+
+  // Returns the exception thrown by execute(). If execute() returned
+  // normally, returns null handle.
+  const SharedHandle<Exception>& getException() const
+  {
+    return exception_;
+  }
+};
+
+// Calls (obj->*func)() in execute().
+template<typename T>
+class MemFunDiskIOJob:public DiskIOJob {
+private:
+  SharedHandle<T> obj_;
+
+  void (T::*func_)();
+public:
+  MemFunDiskIOJob(const SharedHandle<T>& obj, void (T::*func)()):
+    obj_(obj), func_(func) {}
+
+  virtual void execute()
+  {
+    (obj_.get()->*func_)();
+  }
+};
+
+template<typename T>
+SharedHandle<DiskIOJob>
+createDiskIOJob(const SharedHandle<T>& obj, void (T::*func)())
+{
+  return SharedHandle<DiskIOJob>(new MemFunDiskIOJob<T>(obj, func));
+}
+
+} // namespace aria2
+
+#endif // _D_DISK_IO_JOB_H_
@@ -0,0 +1,240 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DiskIOThreadPool.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef HAVE_EVENTFD
+# include <sys/eventfd.h>
+#endif // HAVE_EVENTFD
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+
+#include "DiskIOJob.h"
+#include "DlAbortEx.h"
+#include "StringFormat.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "a2io.h"
+
+namespace aria2 {
+
+static void setNonBlockingMode(int fd)
+{
+  int flags;
+  while((flags = fcntl(fd, F_GETFL, 0)) == -1 && errno == EINTR);
+  while(fcntl(fd, F_SETFL, flags|O_NONBLOCK) == -1 && errno == EINTR);
+}
+
+const size_t DiskIOThreadPool::MAX_DEFAULT_THREAD;
+
+size_t DiskIOThreadPool::getDefaultNumThread()
+{
+#ifdef _SC_NPROCESSORS_ONLN
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if(n > 0) {
+    return std::min(static_cast<size_t>(n), MAX_DEFAULT_THREAD);
+  }
+#endif // _SC_NPROCESSORS_ONLN
+  return 1;
+}
+
+DiskIOThreadPool::DiskIOThreadPool(size_t numThread):
+  shutdown_(false),
+  readFd_(-1),
+  writeFd_(-1),
+  watched_(false),
+  logger_(LogFactory::getInstance())
+{
+#ifdef HAVE_EVENTFD
+  readFd_ = writeFd_ = eventfd(0, 0);
+  if(readFd_ == -1) {
+    throw DL_ABORT_EX
+      (StringFormat("Failed to create eventfd: %s", strerror(errno)).str());
+  }
+  setNonBlockingMode(readFd_);
+#else // !HAVE_EVENTFD
+  int fds[2];
+  if(pipe(fds) == -1) {
+    throw DL_ABORT_EX
+      (StringFormat("Failed to create pipe: %s", strerror(errno)).str());
+  }
+  readFd_ = fds[0];
+  writeFd_ = fds[1];
+  setNonBlockingMode(readFd_);
+  setNonBlockingMode(writeFd_);
+#endif // !HAVE_EVENTFD
+  pthread_mutex_init(&mutex_, 0);
+  pthread_cond_init(&cond_, 0);
+  for(size_t i = 0; i < numThread; ++i) {
+    pthread_t thread;
+    int r = pthread_create(&thread, 0, &DiskIOThreadPool::workerMain, this);
+    if(r != 0) {
+      stop();
+      throw DL_ABORT_EX
+        (StringFormat("Failed to create disk I/O thread: %s",
+                      strerror(r)).str());
+    }
+    threads_.push_back(thread);
+  }
+  if(logger_->debug()) {
+    logger_->debug("Started %lu disk I/O threads.",
+                   static_cast<unsigned long>(threads_.size()));
+  }
+}
+
+DiskIOThreadPool::~DiskIOThreadPool()
+{
+  stop();
+}
+
+void DiskIOThreadPool::stop()
+{
+  pthread_mutex_lock(&mutex_);
+  shutdown_ = true;
+  // Jobs not started yet are never run. Their handles are released
+  // with pendingJobs_.
+  jobQueue_.clear();
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&mutex_);
+  for(std::vector<pthread_t>::const_iterator i = threads_.begin(),
+        eoi = threads_.end(); i != eoi; ++i) {
+    pthread_join(*i, 0);
+  }
+  threads_.clear();
+  pthread_cond_destroy(&cond_);
+  pthread_mutex_destroy(&mutex_);
+  close(readFd_);
+  if(writeFd_ != readFd_) {
+    close(writeFd_);
+  }
+}
+
+void* DiskIOThreadPool::workerMain(void* arg)
+{
+  static_cast<DiskIOThreadPool*>(arg)->work();
+  return 0;
+}
+
+void DiskIOThreadPool::work()
+{
+  pthread_mutex_lock(&mutex_);
+  while(1) {
+    while(!shutdown_ && jobQueue_.empty()) {
+      pthread_cond_wait(&cond_, &mutex_);
+    }
+    if(shutdown_) {
+      break;
+    }
+    DiskIOJob* job = jobQueue_.front();
+    jobQueue_.pop_front();
+    pthread_mutex_unlock(&mutex_);
+    job->run();
+    pthread_mutex_lock(&mutex_);
+    doneQueue_.push_back(job);
+    notify();
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+
+void DiskIOThreadPool::notify()
+{
+#ifdef HAVE_EVENTFD
+  uint64_t val = 1;
+#else // !HAVE_EVENTFD
+  char val = 0;
+#endif // !HAVE_EVENTFD
+  // If the write fails with EAGAIN, the descriptor is already
+  // readable and the main thread will pick up this job as well.
+  while(write(writeFd_, &val, sizeof(val)) == -1 && errno == EINTR);
+}
+
+void DiskIOThreadPool::drainNotification()
+{
+#ifdef HAVE_EVENTFD
+  uint64_t val;
+  while(read(readFd_, &val, sizeof(val)) == -1 && errno == EINTR);
+#else // !HAVE_EVENTFD
+  char buf[256];
+  ssize_t r;
+  while((r = read(readFd_, buf, sizeof(buf))) > 0 ||
+        (r == -1 && errno == EINTR));
+#endif // !HAVE_EVENTFD
+}
+
+void DiskIOThreadPool::post(const SharedHandle<DiskIOJob>& job)
+{
+  pendingJobs_.push_back(job);
+  pthread_mutex_lock(&mutex_);
+  jobQueue_.push_back(job.get());
+  pthread_cond_signal(&cond_);
+  pthread_mutex_unlock(&mutex_);
+}
+
+namespace {
+class FindJob {
+private:
+  const DiskIOJob* job_;
+public:
+  FindJob(const DiskIOJob* job):job_(job) {}
+
+  bool operator()(const SharedHandle<DiskIOJob>& job) const
+  {
+    return job.get() == job_;
+  }
+};
+} // namespace
+
+size_t DiskIOThreadPool::processCompletions()
+{
+  drainNotification();
+  std::deque<DiskIOJob*> done;
+  pthread_mutex_lock(&mutex_);
+  done.swap(doneQueue_);
+  pthread_mutex_unlock(&mutex_);
+  for(std::deque<DiskIOJob*>::const_iterator i = done.begin(),
+        eoi = done.end(); i != eoi; ++i) {
+    std::deque<SharedHandle<DiskIOJob> >::iterator j =
+      std::find_if(pendingJobs_.begin(), pendingJobs_.end(), FindJob(*i));
+    assert(j != pendingJobs_.end());
+    (*j)->complete();
+    pendingJobs_.erase(j);
+  }
+  return done.size();
+}
+
+} // namespace aria2
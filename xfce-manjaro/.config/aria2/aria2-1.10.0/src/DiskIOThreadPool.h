@@ -0,0 +1,145 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_DISK_IO_THREAD_POOL_H_
+#define _D_DISK_IO_THREAD_POOL_H_
+
+#include "common.h"
+
+#include <pthread.h>
+
+#include <deque>
+#include <vector>
+
+#include "SharedHandle.h"
+
+namespace aria2 {
+
+class DiskIOJob;
+class Logger;
+
+// Runs DiskIOJob in worker threads so that hashing and file
+// allocation do not stall the event loop. When a job is done, the
+// descriptor returned by getFd() becomes readable. The main thread
+// then calls processCompletions() to mark the finished jobs
+// completed.
+//
+// SharedHandle is not thread-safe, so the handles of the posted jobs
+// are kept in pendingJobs_ which only the main thread touches. The
+// worker threads see raw pointers.
+class DiskIOThreadPool {
+private:
+  std::vector<pthread_t> threads_;
+
+  pthread_mutex_t mutex_;
+
+  pthread_cond_t cond_;
+
+  // Guarded by mutex_.
+  std::deque<DiskIOJob*> jobQueue_;
+
+  // Guarded by mutex_.
+  std::deque<DiskIOJob*> doneQueue_;
+
+  // Guarded by mutex_.
+  bool shutdown_;
+
+  std::deque<SharedHandle<DiskIOJob> > pendingJobs_;
+
+  // If eventfd is available, both refer to the same descriptor.
+  // Otherwise, they are the read and write end of a pipe.
+  int readFd_;
+
+  int writeFd_;
+
+  bool watched_;
+
+  Logger* logger_;
+
+  static void* workerMain(void* arg);
+
+  void work();
+
+  void notify();
+
+  void drainNotification();
+
+  void stop();
+public:
+  DiskIOThreadPool(size_t numThread);
+
+  ~DiskIOThreadPool();
+
+  // Returns the number of online CPU cores, but at most
+  // MAX_DEFAULT_THREAD. Returns 1 if the number cannot be determined.
+  static size_t getDefaultNumThread();
+
+  static const size_t MAX_DEFAULT_THREAD = 8;
+
+  int getFd() const
+  {
+    return readFd_;
+  }
+
+  void post(const SharedHandle<DiskIOJob>& job);
+
+  // Marks the jobs finished by worker threads completed. Returns the
+  // number of jobs completed.
+  size_t processCompletions();
+
+  size_t countPendingJob() const
+  {
+    return pendingJobs_.size();
+  }
+
+  size_t getNumThread() const
+  {
+    return threads_.size();
+  }
+
+  // True if there is a command watching getFd().
+  bool watched() const
+  {
+    return watched_;
+  }
+
+  void setWatched(bool f)
+  {
+    watched_ = f;
+  }
+};
+
+} // namespace aria2
+
+#endif // _D_DISK_IO_THREAD_POOL_H_
@@ -85,6 +85,11 @@ public:
   // opens file in read/write mode. This is an optional
   // functionality. The default implementation is do noting.
   virtual void disableReadOnly() {}
+
+  // Returns the file descriptor of the opened file. If the file is
+  // not opened or this object is not backed by a file, returns -1.
+  // The default implementation returns -1.
+  virtual int getFd() const { return -1; }
 };
 
 typedef SharedHandle<DiskWriter> DiskWriterHandle;
@@ -61,6 +61,7 @@
 #include "wallclock.h"
 #include "ServerStatMan.h"
 #include "FileAllocationEntry.h"
+#include "BufferPool.h"
 #ifdef ENABLE_MESSAGE_DIGEST
 # include "MessageDigestHelper.h"
 #endif // ENABLE_MESSAGE_DIGEST
@@ -76,7 +77,7 @@ DownloadCommand::DownloadCommand(cuid_t cuid,
                                  DownloadEngine* e,
                                  const SocketHandle& s):
   AbstractCommand(cuid, req, fileEntry, requestGroup, e, s),
-  buf_(new unsigned char[BUFSIZE]),
+  buf_(BufferPool::getInstance()->allocate()),
   startupIdleTime_(10),
   lowestDownloadSpeedLimit_(0)
 #ifdef ENABLE_MESSAGE_DIGEST
@@ -106,7 +107,7 @@ DownloadCommand::DownloadCommand(cuid_t cuid,
 DownloadCommand::~DownloadCommand() {
   peerStat_->downloadStop();
   getSegmentMan()->updateFastestPeerStat(peerStat_);
-  delete [] buf_;
+  BufferPool::getInstance()->deallocate(buf_);
 }
 
 bool DownloadCommand::executeInternal() {
@@ -187,6 +188,8 @@ bool DownloadCommand::executeInternal() {
     segment->updateWrittenLength(bufSizeFinal);
   }
   peerStat_->updateDownloadLength(bufSize);
+  getDownloadEngine()->getRequestGroupMan()->updateOverallDownloadLength
+    (bufSize);
   getSegmentMan()->updateDownloadSpeedFor(peerStat_);
   bool segmentPartComplete = false;
   // Note that GrowSegment::complete() always returns false.
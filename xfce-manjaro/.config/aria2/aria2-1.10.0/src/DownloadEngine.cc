@@ -71,6 +71,9 @@
 # include "BtAnnounce.h"
 # include "BtRuntime.h"
 #endif // ENABLE_BITTORRENT
+#ifdef ENABLE_DISK_IO_THREAD
+# include "DiskIOThreadPool.h"
+#endif // ENABLE_DISK_IO_THREAD
 
 namespace aria2 {
 
@@ -111,8 +114,23 @@ DownloadEngine::~DownloadEngine() {
 }
 
 void DownloadEngine::cleanQueue() {
-  std::for_each(commands_.begin(), commands_.end(), Deleter());
-  commands_.clear();
+  commands_.deleteAll();
+}
+
+static void executeCommand(CommandScheduler& commands)
+{
+  // Commands added to the ready queue during this loop are executed
+  // in the next iteration.
+  size_t max = commands.countReady();
+  for(size_t i = 0; i < max; ++i) {
+    Command* com = commands.popReady();
+    com->transitStatus();
+    if(com->execute()) {
+      delete com;
+    } else {
+      com->clearIOEvents();
+    }
+  }
 }
 
 static void executeCommand(std::deque<Command*>& commands,
@@ -146,10 +164,16 @@ void DownloadEngine::run()
     if(cp.difference(global::wallclock) >= refreshInterval_) {
       refreshInterval_ = DEFAULT_REFRESH_INTERVAL;
       cp = global::wallclock;
-      executeCommand(commands_, Command::STATUS_ALL);
-    } else {
-      executeCommand(commands_, Command::STATUS_ACTIVE);
+      // Commands sleeping in the timer wheel check these conditions
+      // when they are executed.
+      if(haltRequested_ || requestGroupMan_->downloadFinished() ||
+         requestGroupMan_->findNewlyStoppedGroup()) {
+        commands_.wakeAll();
+      } else {
+        commands_.refresh(global::wallclock.getTime());
+      }
     }
+    executeCommand(commands_);
     executeCommand(routineCommands_, Command::STATUS_ALL);
     afterEachIteration();
     if(!commands_.empty()) {
@@ -265,6 +289,26 @@ bool DownloadEngine::deleteNameResolverCheck
 }
 #endif // ENABLE_ASYNC_DNS
 
+#ifdef ENABLE_DISK_IO_THREAD
+bool DownloadEngine::addDiskIOThreadPoolCheck(Command* command)
+{
+  return eventPoll_->addEvents(diskIOThreadPool_->getFd(), command,
+                               EventPoll::EVENT_READ);
+}
+
+bool DownloadEngine::deleteDiskIOThreadPoolCheck(Command* command)
+{
+  return eventPoll_->deleteEvents(diskIOThreadPool_->getFd(), command,
+                                  EventPoll::EVENT_READ);
+}
+
+void DownloadEngine::setDiskIOThreadPool
+(const SharedHandle<DiskIOThreadPool>& pool)
+{
+  diskIOThreadPool_ = pool;
+}
+#endif // ENABLE_DISK_IO_THREAD
+
 void DownloadEngine::setNoWait(bool b)
 {
   noWait_ = b;
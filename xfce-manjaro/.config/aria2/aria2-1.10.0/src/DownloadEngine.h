@@ -53,6 +53,7 @@
 #include "FileAllocationMan.h"
 #include "CheckIntegrityMan.h"
 #include "DNSCache.h"
+#include "CommandScheduler.h"
 
 namespace aria2 {
 
@@ -69,6 +70,9 @@ class Command;
 #ifdef ENABLE_BITTORRENT
 class BtRegistry;
 #endif // ENABLE_BITTORRENT
+#ifdef ENABLE_DISK_IO_THREAD
+class DiskIOThreadPool;
+#endif // ENABLE_DISK_IO_THREAD
 
 class DownloadEngine {
 private:
@@ -155,11 +159,16 @@ private:
   std::multimap<std::string, SocketPoolEntry>::iterator
   findSocketPoolEntry(const std::string& key);
 
-  std::deque<Command*> commands_;
+  CommandScheduler commands_;
   SharedHandle<RequestGroupMan> requestGroupMan_;
   SharedHandle<FileAllocationMan> fileAllocationMan_;
   SharedHandle<CheckIntegrityMan> checkIntegrityMan_;
   Option* option_;
+#ifdef ENABLE_DISK_IO_THREAD
+  // Declared last so that the worker threads are joined before the
+  // other members are destroyed.
+  SharedHandle<DiskIOThreadPool> diskIOThreadPool_;
+#endif // ENABLE_DISK_IO_THREAD
 public:  
   DownloadEngine(const SharedHandle<EventPoll>& eventPoll);
 
@@ -186,14 +195,37 @@ public:
                                Command* command);
 #endif // ENABLE_ASYNC_DNS
 
+#ifdef ENABLE_DISK_IO_THREAD
+  bool addDiskIOThreadPoolCheck(Command* command);
+
+  bool deleteDiskIOThreadPoolCheck(Command* command);
+
+  void setDiskIOThreadPool(const SharedHandle<DiskIOThreadPool>& pool);
+
+  // Returns null handle if disk I/O threads are disabled.
+  const SharedHandle<DiskIOThreadPool>& getDiskIOThreadPool() const
+  {
+    return diskIOThreadPool_;
+  }
+#endif // ENABLE_DISK_IO_THREAD
+
   void addCommand(const std::vector<Command*>& commands)
   {
-    commands_.insert(commands_.end(), commands.begin(), commands.end());
+    for(std::vector<Command*>::const_iterator i = commands.begin(),
+          eoi = commands.end(); i != eoi; ++i) {
+      commands_.add(*i);
+    }
   }
 
   void addCommand(Command* command)
   {
-    commands_.push_back(command);
+    commands_.add(command);
+  }
+
+  // Returns the number of Commands, excluding routine Commands.
+  size_t countCommand() const
+  {
+    return commands_.size();
   }
 
   const SharedHandle<RequestGroupMan>& getRequestGroupMan() const
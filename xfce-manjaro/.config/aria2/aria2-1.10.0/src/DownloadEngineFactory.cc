@@ -61,6 +61,9 @@
 #ifdef HAVE_EPOLL
 # include "EpollEventPoll.h"
 #endif // HAVE_EPOLL
+#ifdef HAVE_IO_URING
+# include "IoUringEventPoll.h"
+#endif // HAVE_IO_URING
 #ifdef HAVE_PORT_ASSOCIATE
 # include "PortEventPoll.h"
 #endif // HAVE_PORT_ASSOCIATE
@@ -76,6 +79,9 @@
 #ifdef ENABLE_XML_RPC
 # include "HttpListenCommand.h"
 #endif // ENABLE_XML_RPC
+#ifdef ENABLE_DISK_IO_THREAD
+# include "DiskIOThreadPool.h"
+#endif // ENABLE_DISK_IO_THREAD
 
 namespace aria2 {
 
@@ -101,6 +107,17 @@ DownloadEngineFactory::newDownloadEngine
     }
   } else
 #endif // HAVE_EPLL
+#ifdef HAVE_IO_URING
+  if(pollMethod == V_IO_URING) {
+    SharedHandle<IoUringEventPoll> up(new IoUringEventPoll());
+    if(up->good()) {
+      eventPoll = up;
+    } else {
+      throw DL_ABORT_EX("Initializing IoUringEventPoll failed."
+                        " Try --event-poll=select");
+    }
+  } else
+#endif // HAVE_IO_URING
 #ifdef HAVE_KQUEUE
     if(pollMethod == V_KQUEUE) {
       SharedHandle<KqueueEventPoll> kp(new KqueueEventPoll());
@@ -135,6 +152,13 @@ DownloadEngineFactory::newDownloadEngine
           }
   DownloadEngineHandle e(new DownloadEngine(eventPoll));
   e->setOption(op);
+#ifdef ENABLE_DISK_IO_THREAD
+  if(op->getAsInt(PREF_DISK_IO_THREADS) > 0) {
+    e->setDiskIOThreadPool
+      (SharedHandle<DiskIOThreadPool>
+       (new DiskIOThreadPool(op->getAsInt(PREF_DISK_IO_THREADS))));
+  }
+#endif // ENABLE_DISK_IO_THREAD
 
   RequestGroupManHandle
     requestGroupMan(new RequestGroupMan(requestGroups, MAX_CONCURRENT_DOWNLOADS,
@@ -45,7 +45,8 @@
 namespace aria2 {
 
 EpollEventPoll::KSocketEntry::KSocketEntry(sock_t s):
-  SocketEntry<KCommandEvent, KADNSEvent>(s) {}
+  SocketEntry<KCommandEvent, KADNSEvent>(s),
+  registeredEvents_(0), dirty_(false), renewed_(false) {}
 
 int accumulateEvent(int events, const EpollEventPoll::KEvent& event)
 {
@@ -78,11 +79,11 @@ struct epoll_event EpollEventPoll::KSocketEntry::getEvents()
 }
 
 EpollEventPoll::EpollEventPoll():
-  epEventsSize_(EPOLL_EVENTS_MAX),
-  epEvents_(new struct epoll_event[epEventsSize_]),
+  epEvents_(EPOLL_EVENTS_MIN),
+  numCtl_(0),
   logger_(LogFactory::getInstance())
 {
-  epfd_ = epoll_create(EPOLL_EVENTS_MAX);
+  epfd_ = epoll_create(EPOLL_EVENTS_MIN);
 }
 
 EpollEventPoll::~EpollEventPoll()
@@ -96,7 +97,6 @@ EpollEventPoll::~EpollEventPoll()
                      epfd_, strerror(errno));
     }
   }
-  delete [] epEvents_;
 }
 
 bool EpollEventPoll::good() const
@@ -104,14 +104,111 @@ bool EpollEventPoll::good() const
   return epfd_ != -1;
 }
 
+void EpollEventPoll::markDirty(KSocketEntry* entry)
+{
+  if(!entry->dirty_) {
+    entry->dirty_ = true;
+    dirtyEntries_.push_back(entry);
+  }
+}
+
+bool EpollEventPoll::updateEvents(KSocketEntry* entry)
+{
+  struct epoll_event epEvent = entry->getEvents();
+  int r = 0;
+  if(epEvent.events == 0) {
+    if(entry->registeredEvents_ != 0) {
+      // If socket is closed, then it is automatically removed from
+      // epoll and EPOLL_CTL_DEL fails. In kernel before 2.6.9,
+      // epoll_ctl with EPOLL_CTL_DEL requires non-null pointer of
+      // epoll_event.
+      ++numCtl_;
+      r = epoll_ctl(epfd_, EPOLL_CTL_DEL, entry->getSocket(), &epEvent);
+      if(r == -1 && logger_->debug()) {
+        logger_->debug("Failed to delete socket event, but may be ignored:%s",
+                       strerror(errno));
+      }
+    }
+    entry->registeredEvents_ = 0;
+    return true;
+  }
+  if(entry->registeredEvents_ == 0) {
+    ++numCtl_;
+    r = epoll_ctl(epfd_, EPOLL_CTL_ADD, entry->getSocket(), &epEvent);
+  } else if(entry->renewed_ ||
+            entry->registeredEvents_ != static_cast<int>(epEvent.events)) {
+    ++numCtl_;
+    r = epoll_ctl(epfd_, EPOLL_CTL_MOD, entry->getSocket(), &epEvent);
+    if(r == -1) {
+      // try EPOLL_CTL_ADD: There is a chance that previously socket X
+      // is added to epoll, but it is closed and socket X is reused. In
+      // this case, EPOLL_CTL_MOD is failed with ENOENT.
+      ++numCtl_;
+      r = epoll_ctl(epfd_, EPOLL_CTL_ADD, entry->getSocket(), &epEvent);
+    }
+  }
+  if(r == -1) {
+    logger_->info("Failed to add socket event %d:%s",
+                  entry->getSocket(), strerror(errno));
+    entry->registeredEvents_ = 0;
+    return false;
+  } else {
+    entry->registeredEvents_ = epEvent.events;
+    return true;
+  }
+}
+
+bool EpollEventPoll::updateEvents()
+{
+  bool erased = false;
+  // These entries are not empty, so they survive the compaction
+  // below.
+  std::vector<KSocketEntry*> failedEntries;
+  for(std::vector<KSocketEntry*>::const_iterator i = dirtyEntries_.begin(),
+        eoi = dirtyEntries_.end(); i != eoi; ++i) {
+    KSocketEntry* entry = *i;
+    entry->dirty_ = false;
+    if(!updateEvents(entry)) {
+      failedEntries.push_back(entry);
+    }
+    entry->renewed_ = false;
+    if(entry->eventEmpty()) {
+      erased = true;
+    }
+  }
+  dirtyEntries_.clear();
+  if(erased) {
+    std::deque<SharedHandle<KSocketEntry> >::iterator dst =
+      socketEntries_.begin();
+    for(std::deque<SharedHandle<KSocketEntry> >::iterator i =
+          socketEntries_.begin(), eoi = socketEntries_.end(); i != eoi; ++i) {
+      if(!(*i)->eventEmpty()) {
+        *dst++ = *i;
+      }
+    }
+    socketEntries_.erase(dst, socketEntries_.end());
+  }
+  if(epEvents_.size() < socketEntries_.size()) {
+    epEvents_.resize(std::max(epEvents_.size()*2, socketEntries_.size()));
+  }
+  // The commands are notified after the loop, because they may
+  // change their events.
+  for(std::vector<KSocketEntry*>::const_iterator i = failedEntries.begin(),
+        eoi = failedEntries.end(); i != eoi; ++i) {
+    (*i)->processEvents(EPOLLERR);
+  }
+  return !failedEntries.empty();
+}
+
 void EpollEventPoll::poll(const struct timeval& tv)
 {
-  // timeout is millisec
-  int timeout = tv.tv_sec*1000+tv.tv_usec/1000;
+  // timeout is millisec. Don't wait if some commands were already
+  // notified of errors.
+  int timeout = updateEvents() ? 0 : tv.tv_sec*1000+tv.tv_usec/1000;
 
   int res;
-  while((res = epoll_wait(epfd_, epEvents_, EPOLL_EVENTS_MAX, timeout)) == -1 &&
-        errno == EINTR);
+  while((res = epoll_wait(epfd_, &epEvents_[0], epEvents_.size(), timeout))
+        == -1 && errno == EINTR);
 
   if(res > 0) {
     for(int i = 0; i < res; ++i) {
@@ -162,43 +259,19 @@ bool EpollEventPoll::addEvents(sock_t socket,
   SharedHandle<KSocketEntry> socketEntry(new KSocketEntry(socket));
   std::deque<SharedHandle<KSocketEntry> >::iterator i =
     std::lower_bound(socketEntries_.begin(), socketEntries_.end(), socketEntry);
-  int r = 0;
   if(i != socketEntries_.end() && (*i) == socketEntry) {
-
+    size_t count = (*i)->countEvent();
     event.addSelf(*i);
-
-    struct epoll_event epEvent = (*i)->getEvents();
-    r = epoll_ctl(epfd_, EPOLL_CTL_MOD, (*i)->getSocket(), &epEvent);
-    if(r == -1) {
-      // try EPOLL_CTL_ADD: There is a chance that previously socket X is
-      // added to epoll, but it is closed and is not yet removed from
-      // SocketEntries. In this case, EPOLL_CTL_MOD is failed with ENOENT.
-
-      r = epoll_ctl(epfd_, EPOLL_CTL_ADD, (*i)->getSocket(),
-                    &epEvent);
+    if((*i)->countEvent() > count) {
+      (*i)->renewed_ = true;
     }
+    markDirty((*i).get());
   } else {
     socketEntries_.insert(i, socketEntry);
-    if(socketEntries_.size() > epEventsSize_) {
-      epEventsSize_ *= 2;
-      delete [] epEvents_;
-      epEvents_ = new struct epoll_event[epEventsSize_];
-    }
-
     event.addSelf(socketEntry);
-
-    struct epoll_event epEvent = socketEntry->getEvents();
-    r = epoll_ctl(epfd_, EPOLL_CTL_ADD, socketEntry->getSocket(), &epEvent);
-  }
-  if(r == -1) {
-    if(logger_->debug()) {
-      logger_->debug("Failed to add socket event %d:%s",
-                     socket, strerror(errno));
-    }
-    return false;
-  } else {
-    return true;
+    markDirty(socketEntry.get());
   }
+  return true;
 }
 
 bool EpollEventPoll::addEvents(sock_t socket, Command* command,
@@ -223,36 +296,10 @@ bool EpollEventPoll::deleteEvents(sock_t socket,
   std::deque<SharedHandle<KSocketEntry> >::iterator i =
     std::lower_bound(socketEntries_.begin(), socketEntries_.end(), socketEntry);
   if(i != socketEntries_.end() && (*i) == socketEntry) {
-
     event.removeSelf(*i);
-
-    int r = 0;
-    if((*i)->eventEmpty()) {
-      // In kernel before 2.6.9, epoll_ctl with EPOLL_CTL_DEL requires non-null
-      // pointer of epoll_event.
-      struct epoll_event ev = {0,{0}};
-      r = epoll_ctl(epfd_, EPOLL_CTL_DEL, (*i)->getSocket(), &ev);
-      socketEntries_.erase(i);
-    } else {
-      // If socket is closed, then it seems it is automatically removed from
-      // epoll, so following EPOLL_CTL_MOD may fail.
-      struct epoll_event epEvent = (*i)->getEvents();
-      r = epoll_ctl(epfd_, EPOLL_CTL_MOD, (*i)->getSocket(), &epEvent);
-      if(r == -1) {
-        if(logger_->debug()) {
-          logger_->debug("Failed to delete socket event, but may be ignored:%s",
-                         strerror(errno));
-        }
-      }
-    }
-    if(r == -1) {
-      if(logger_->debug()) {
-        logger_->debug("Failed to delete socket event:%s", strerror(errno));
-      }
-      return false;
-    } else {
-      return true;
-    }
+    // The entry is removed in updateEvents() if it becomes empty.
+    markDirty((*i).get());
+    return true;
   } else {
     if(logger_->debug()) {
       logger_->debug("Socket %d is not found in SocketEntries.", socket);
@@ -40,6 +40,7 @@
 # include <sys/epoll.h>
 
 #include <deque>
+#include <vector>
 
 #include "Event.h"
 #ifdef ENABLE_ASYNC_DNS
@@ -62,6 +63,21 @@ private:
 
   class KSocketEntry:
     public SocketEntry<KCommandEvent, KADNSEvent> {
+  private:
+    // The events registered in epoll. 0 if the socket is not
+    // registered.
+    int registeredEvents_;
+
+    // True if this entry is in dirtyEntries_.
+    bool dirty_;
+
+    // True if a Command or resolver started watching this socket
+    // since the last update. The previous socket with this descriptor
+    // may have been closed, so epoll_ctl must be called even if the
+    // events are unchanged.
+    bool renewed_;
+
+    friend class EpollEventPoll;
   public:
     KSocketEntry(sock_t socket);
 
@@ -76,16 +92,37 @@ private:
   std::deque<SharedHandle<KAsyncNameResolverEntry> > nameResolverEntries_;
 #endif // ENABLE_ASYNC_DNS
 
+  // Entries whose events changed since the last poll(). Their
+  // changes are sent to epoll in one pass by updateEvents(), so that a
+  // Command which disables and enables an event in the same iteration
+  // costs no system call.
+  std::vector<KSocketEntry*> dirtyEntries_;
+
   int epfd_;
 
-  size_t epEventsSize_;
+  // Grows with the number of sockets, so that epoll_wait() can return
+  // all events at once.
+  std::vector<struct epoll_event> epEvents_;
 
-  struct epoll_event* epEvents_;
+  static const size_t EPOLL_EVENTS_MIN = 1024;
 
-  static const size_t EPOLL_EVENTS_MAX = 1024;
+  // The number of epoll_ctl calls, for statistics.
+  uint64_t numCtl_;
 
   Logger* logger_;
 
+  void markDirty(KSocketEntry* entry);
+
+  // Applies the changes of dirtyEntries_ to epoll. If epoll_ctl
+  // fails for a socket, its commands get an error event, so that they
+  // find the problem when they use the socket. Returns true if that
+  // happened.
+  bool updateEvents();
+
+  // Returns false if epoll_ctl failed to add or modify the events of
+  // entry.
+  bool updateEvents(KSocketEntry* entry);
+
   bool addEvents(sock_t socket, const KEvent& event);
 
   bool deleteEvents(sock_t socket, const KEvent& event);
@@ -105,6 +142,15 @@ public:
 
   virtual void poll(const struct timeval& tv);
 
+  // Returns the number of epoll_ctl calls so far.
+  uint64_t getNumCtl() const
+  {
+    return numCtl_;
+  }
+
+  // The events are registered to epoll in the next poll(), so this
+  // function always returns true. If the registration fails, command
+  // gets an error event instead.
   virtual bool addEvents(sock_t socket,
                          Command* command, EventPoll::EventType events);
 
@@ -279,6 +279,17 @@ public:
     socket_ = socket;
   }
 
+  // Returns the number of Commands and resolvers watching this
+  // socket.
+  size_t countEvent() const
+  {
+#ifdef ENABLE_ASYNC_DNS
+    return commandEvents_.size()+adnsEvents_.size();
+#else // !ENABLE_ASYNC_DNS
+    return commandEvents_.size();
+#endif // !ENABLE_ASYNC_DNS
+  }
+
   bool eventEmpty() const
   {
 #ifdef ENABLE_ASYNC_DNS
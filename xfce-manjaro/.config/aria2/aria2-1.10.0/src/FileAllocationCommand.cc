@@ -49,6 +49,7 @@
 #include "RequestGroupMan.h"
 #include "CheckIntegrityEntry.h"
 #include "ServerStatMan.h"
+#include "DiskIOJob.h"
 
 namespace aria2 {
 
@@ -66,7 +67,12 @@ bool FileAllocationCommand::executeInternal()
     getDownloadEngine()->getFileAllocationMan()->dropPickedEntry();
     return true;
   }
-  fileAllocationEntry_->allocateChunk();
+  if(!fileAllocationEntry_->finished() &&
+     !executeDiskIOJob
+     (createDiskIOJob(fileAllocationEntry_,
+                      &FileAllocationEntry::allocateChunk))) {
+    return false;
+  }
   if(fileAllocationEntry_->finished()) {
     if(getLogger()->debug()) {
       getLogger()->debug
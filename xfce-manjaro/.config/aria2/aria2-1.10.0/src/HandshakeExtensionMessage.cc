@@ -45,6 +45,7 @@
 #include "bittorrent_helper.h"
 #include "RequestGroup.h"
 #include "PieceStorage.h"
+#include "PeerStorage.h"
 
 namespace aria2 {
 
@@ -102,7 +103,7 @@ std::string HandshakeExtensionMessage::toString() const
 void HandshakeExtensionMessage::doReceivedAction()
 {
   if(tcpPort_ > 0) {
-    peer_->setPort(tcpPort_);
+    peerStorage_->updatePeerPort(peer_, tcpPort_);
     peer_->setIncomingPeer(false);
   }
   for(std::map<std::string, uint8_t>::const_iterator itr = extensions_.begin(),
@@ -151,6 +152,12 @@ void HandshakeExtensionMessage::setPeer(const SharedHandle<Peer>& peer)
   peer_ = peer;
 }
 
+void HandshakeExtensionMessage::setPeerStorage
+(const SharedHandle<PeerStorage>& peerStorage)
+{
+  peerStorage_ = peerStorage;
+}
+
 uint8_t HandshakeExtensionMessage::getExtensionMessageID(const std::string& name) const
 {
   std::map<std::string, uint8_t>::const_iterator i = extensions_.find(name);
@@ -175,34 +182,40 @@ HandshakeExtensionMessage::create(const unsigned char* data, size_t length)
       ("Creating HandshakeExtensionMessage from %s",
        util::percentEncode(data, length).c_str());
   }
-  SharedHandle<ValueBase> decoded = bencode2::decode(data+1, length-1);
-  const Dict* dict = asDict(decoded);
-  if(!dict) {
+  bencode2::ViewDecoder decoder;
+  decoder.decode(data+1, length-1);
+  const bencode2::View* dict = decoder.getRoot();
+  if(!dict || dict->type != bencode2::View::DICT) {
     throw DL_ABORT_EX
       ("Unexpected payload format for extended message handshake");
   }
-  const Integer* port = asInteger(dict->get("p"));
-  if(port && 0 < port->i() && port->i() < 65536) {
-    msg->tcpPort_ = port->i();
+  const bencode2::View* port =
+    decoder.get(dict, "p", bencode2::View::INTEGER);
+  if(port && 0 < port->i && port->i < 65536) {
+    msg->tcpPort_ = port->i;
   }
-  const String* version = asString(dict->get("v"));
+  const bencode2::View* version =
+    decoder.get(dict, "v", bencode2::View::STRING);
   if(version) {
     msg->clientVersion_ = version->s();
   }
-  const Dict* extDict = asDict(dict->get("m"));
+  const bencode2::View* extDict =
+    decoder.get(dict, "m", bencode2::View::DICT);
   if(extDict) {
-    for(Dict::ValueType::const_iterator i = extDict->begin(),
-          eoi = extDict->end(); i != eoi; ++i) {
-      const Integer* extId = asInteger((*i).second);
-      if(extId) {
-        msg->extensions_[(*i).first] = extId->i();
+    const bencode2::View* key = decoder.first(extDict);
+    for(size_t i = 0; i < extDict->size; ++i) {
+      const bencode2::View* extId = key+1;
+      if(extId->type == bencode2::View::INTEGER) {
+        msg->extensions_[key->s()] = extId->i;
       }
+      key = decoder.next(extId);
     }
   }
-  const Integer* metadataSize = asInteger(dict->get("metadata_size"));
+  const bencode2::View* metadataSize =
+    decoder.get(dict, "metadata_size", bencode2::View::INTEGER);
   // Only accept metadata smaller than 1MiB
-  if(metadataSize && metadataSize->i() <= 1024*1024) {
-    msg->metadataSize_ = metadataSize->i();
+  if(metadataSize && metadataSize->i <= 1024*1024) {
+    msg->metadataSize_ = metadataSize->i;
   }
   return msg;
 }
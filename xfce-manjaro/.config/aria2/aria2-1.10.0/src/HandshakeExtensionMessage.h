@@ -46,6 +46,7 @@ namespace aria2 {
 class Peer;
 class Logger;
 class DownloadContext;
+class PeerStorage;
 
 class HandshakeExtensionMessage:public ExtensionMessage {
 private:
@@ -61,6 +62,8 @@ private:
 
   SharedHandle<Peer> peer_;
 
+  SharedHandle<PeerStorage> peerStorage_;
+
   Logger* logger_;
 
 public:
@@ -135,6 +138,8 @@ public:
 
   void setPeer(const SharedHandle<Peer>& peer);
 
+  void setPeerStorage(const SharedHandle<PeerStorage>& peerStorage);
+
   static SharedHandle<HandshakeExtensionMessage>
   create(const unsigned char* data, size_t dataLength);
 };
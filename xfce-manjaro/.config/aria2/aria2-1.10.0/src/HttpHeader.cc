@@ -34,7 +34,9 @@
 /* copyright --> */
 #include "HttpHeader.h"
 
+#include <cstring>
 #include <istream>
+#include <algorithm>
 
 #include "Range.h"
 #include "util.h"
@@ -98,17 +100,97 @@ const std::string HttpHeader::S401("401");
   
 const std::string HttpHeader::S404("404");
 
+// Indexed by FieldId.
+static const char* FIELD_NAMES[] = {
+  "location",
+  "transfer-encoding",
+  "content-encoding",
+  "content-disposition",
+  "set-cookie",
+  "content-type",
+  "retry-after",
+  "connection",
+  "content-length",
+  "content-range",
+  "last-modified",
+  "accept-encoding"
+};
+
+static char lowercase(char c)
+{
+  return 'A' <= c && c <= 'Z' ? c-'A'+'a' : c;
+}
+
+static bool isTrimChar(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int HttpHeader::getFieldId(const char* first, const char* last)
+{
+  size_t length = last-first;
+  for(int i = 0; i < MAX_FIELD_ID; ++i) {
+    const char* name = FIELD_NAMES[i];
+    if(strlen(name) != length) {
+      continue;
+    }
+    const char* p = first;
+    for(; p != last && lowercase(*p) == *name; ++p, ++name);
+    if(p == last) {
+      return i;
+    }
+  }
+  return -1;
+}
+
 void HttpHeader::put(const std::string& name, const std::string& value) {
-  std::multimap<std::string, std::string>::value_type vt
-    (util::toLower(name), value);
-  table_.insert(vt);
+  int id = getFieldId(name.data(), name.data()+name.size());
+  if(id == -1) {
+    std::multimap<std::string, std::string>::value_type vt
+      (util::toLower(name), value);
+    table_.insert(vt);
+  } else {
+    fields_[id].push_back(value);
+  }
+}
+
+void HttpHeader::putField(const char* first, const char* last)
+{
+  for(; first != last && isTrimChar(*first); ++first);
+  for(; first != last && isTrimChar(*(last-1)); --last);
+  if(first == last) {
+    return;
+  }
+  const char* nameLast = std::find(first, last, ':');
+  const char* valueFirst = nameLast == last ? last : nameLast+1;
+  for(; first != nameLast && isTrimChar(*(nameLast-1)); --nameLast);
+  for(; valueFirst != last && isTrimChar(*valueFirst); ++valueFirst);
+  int id = getFieldId(first, nameLast);
+  if(id == -1) {
+    std::string name(first, nameLast);
+    std::transform(name.begin(), name.end(), name.begin(), lowercase);
+    std::multimap<std::string, std::string>::value_type vt
+      (name, std::string(valueFirst, last));
+    table_.insert(vt);
+  } else {
+    fields_[id].push_back(std::string(valueFirst, last));
+  }
 }
 
 bool HttpHeader::defined(const std::string& name) const {
-  return table_.count(util::toLower(name)) >= 1;
+  int id = getFieldId(name.data(), name.data()+name.size());
+  if(id == -1) {
+    return table_.count(util::toLower(name)) >= 1;
+  } else {
+    return defined(static_cast<FieldId>(id));
+  }
 }
 
 const std::string& HttpHeader::getFirst(const std::string& name) const {
+  int id = getFieldId(name.data(), name.data()+name.size());
+  if(id != -1) {
+    return getFirst(static_cast<FieldId>(id));
+  }
   std::multimap<std::string, std::string>::const_iterator itr =
     table_.find(util::toLower(name));
   if(itr == table_.end()) {
@@ -118,8 +200,21 @@ const std::string& HttpHeader::getFirst(const std::string& name) const {
   }
 }
 
+const std::string& HttpHeader::getFirst(FieldId id) const
+{
+  if(fields_[id].empty()) {
+    return A2STR::NIL;
+  } else {
+    return fields_[id].front();
+  }
+}
+
 std::vector<std::string> HttpHeader::get(const std::string& name) const
 {
+  int id = getFieldId(name.data(), name.data()+name.size());
+  if(id != -1) {
+    return get(static_cast<FieldId>(id));
+  }
   std::vector<std::string> v;
   std::string n(util::toLower(name));
   std::pair<std::multimap<std::string, std::string>::const_iterator,
@@ -146,11 +241,24 @@ uint64_t HttpHeader::getFirstAsULLInt(const std::string& name) const {
   }
 }
 
+unsigned int HttpHeader::getFirstAsUInt(FieldId id) const {
+  return getFirstAsULLInt(id);
+}
+
+uint64_t HttpHeader::getFirstAsULLInt(FieldId id) const {
+  const std::string& value = getFirst(id);
+  if(value.empty()) {
+    return 0;
+  } else {
+    return util::parseULLInt(value);
+  }
+}
+
 RangeHandle HttpHeader::getRange() const
 {
-  const std::string& rangeStr = getFirst(CONTENT_RANGE);
+  const std::string& rangeStr = getFirst(HD_CONTENT_RANGE);
   if(rangeStr.empty()) {
-    const std::string& contentLengthStr = getFirst(CONTENT_LENGTH);
+    const std::string& contentLengthStr = getFirst(HD_CONTENT_LENGTH);
     if(contentLengthStr.empty()) {
       return SharedHandle<Range>(new Range());
     } else {
@@ -214,18 +322,15 @@ void HttpHeader::fill(std::istream& in)
 {
   std::string line;
   while(std::getline(in, line)) {
-    line = util::trim(line);
-    if(line.empty()) {
-      continue;
-    }
-    std::pair<std::string, std::string> hp;
-    util::split(hp, line, ':');
-    put(hp.first, hp.second);
+    putField(line.data(), line.data()+line.size());
   }
 }
 
 void HttpHeader::clearField()
 {
+  for(int i = 0; i < MAX_FIELD_ID; ++i) {
+    fields_[i].clear();
+  }
   table_.clear();
 }
 
@@ -49,7 +49,29 @@ namespace aria2 {
 class Range;
 
 class HttpHeader {
+public:
+  // The fields which aria2 looks up are interned to these IDs when
+  // they are put, and their values are stored in an array indexed by
+  // them.
+  enum FieldId {
+    HD_LOCATION,
+    HD_TRANSFER_ENCODING,
+    HD_CONTENT_ENCODING,
+    HD_CONTENT_DISPOSITION,
+    HD_SET_COOKIE,
+    HD_CONTENT_TYPE,
+    HD_RETRY_AFTER,
+    HD_CONNECTION,
+    HD_CONTENT_LENGTH,
+    HD_CONTENT_RANGE,
+    HD_LAST_MODIFIED,
+    HD_ACCEPT_ENCODING,
+    MAX_FIELD_ID
+  };
 private:
+  std::vector<std::string> fields_[MAX_FIELD_ID];
+
+  // The other fields. The keys are lowercased.
   std::multimap<std::string, std::string> table_;
 
   // for HTTP response header only
@@ -75,6 +97,30 @@ public:
   unsigned int getFirstAsUInt(const std::string& name) const;
   uint64_t getFirstAsULLInt(const std::string& name) const;
 
+  bool defined(FieldId id) const
+  {
+    return !fields_[id].empty();
+  }
+
+  const std::string& getFirst(FieldId id) const;
+
+  const std::vector<std::string>& get(FieldId id) const
+  {
+    return fields_[id];
+  }
+
+  unsigned int getFirstAsUInt(FieldId id) const;
+  uint64_t getFirstAsULLInt(FieldId id) const;
+
+  // Parses the header field line [first, last), "name: value", and
+  // puts it. Whitespace around name and value is ignored. Nothing is
+  // put for an empty line.
+  void putField(const char* first, const char* last);
+
+  // Returns the ID of the field name [first, last), compared case
+  // insensitively, or -1 if it is not interned.
+  static int getFieldId(const char* first, const char* last);
+
   SharedHandle<Range> getRange() const;
 
   const std::string& getResponseStatus() const
@@ -107,7 +153,7 @@ public:
 
   void fill(std::istream& in);
 
-  // Clears table_. responseStatus_ and version_ are unchanged.
+  // Clears fields. responseStatus_ and version_ are unchanged.
   void clearField();
 
   static const std::string LOCATION;
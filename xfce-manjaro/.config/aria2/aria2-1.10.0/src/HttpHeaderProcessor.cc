@@ -34,7 +34,7 @@
 /* copyright --> */
 #include "HttpHeaderProcessor.h"
 
-#include <sstream>
+#include <cstring>
 #include <vector>
 
 #include "HttpHeader.h"
@@ -47,7 +47,10 @@
 namespace aria2 {
 
 HttpHeaderProcessor::HttpHeaderProcessor():
-  limit_(21/*lines*/*8190/*per line*/) {}
+  limit_(21/*lines*/*8190/*per line*/),
+  state_(IN_LINE),
+  lastLineEnd_(0),
+  headerLength_(0) {}
 // The above values come from Apache's documentation
 // http://httpd.apache.org/docs/2.2/en/mod/core.html: See
 // LimitRequestFieldSize and LimitRequestLine directive.  Also the
@@ -59,13 +62,17 @@ HttpHeaderProcessor::~HttpHeaderProcessor() {}
 void HttpHeaderProcessor::update(const unsigned char* data, size_t length)
 {
   checkHeaderLimit(length);
-  buf_ += std::string(&data[0], &data[length]);
+  size_t offset = buf_.size();
+  buf_.append(reinterpret_cast<const char*>(data), length);
+  scan(offset);
 }
 
 void HttpHeaderProcessor::update(const std::string& data)
 {
   checkHeaderLimit(data.size());
+  size_t offset = buf_.size();
   buf_ += data;
+  scan(offset);
 }
 
 void HttpHeaderProcessor::checkHeaderLimit(size_t incomingLength)
@@ -75,23 +82,44 @@ void HttpHeaderProcessor::checkHeaderLimit(size_t incomingLength)
   }
 }
 
-bool HttpHeaderProcessor::eoh() const
+void HttpHeaderProcessor::scan(size_t offset)
 {
-  if(buf_.find("\r\n\r\n") == std::string::npos &&
-     buf_.find("\n\n") == std::string::npos) {
-    return false;
-  } else {
-    return true;
+  if(headerLength_) {
+    return;
+  }
+  const char* first = buf_.data();
+  const char* last = first+buf_.size();
+  for(const char* p = first+offset; p != last; ++p) {
+    if(state_ == IN_LINE) {
+      p = reinterpret_cast<const char*>(memchr(p, '\n', last-p));
+      if(!p) {
+        return;
+      }
+      lastLineEnd_ = p-first;
+      if(lastLineEnd_ > 0 && *(p-1) == '\r') {
+        --lastLineEnd_;
+      }
+      state_ = LINE_START;
+    } else if(*p == '\n') {
+      headerLength_ = p-first+1;
+      return;
+    } else if(*p == '\r' && state_ == LINE_START) {
+      state_ = LINE_START_CR;
+    } else {
+      state_ = IN_LINE;
+    }
   }
 }
 
+bool HttpHeaderProcessor::eoh() const
+{
+  return headerLength_ > 0;
+}
+
 size_t HttpHeaderProcessor::getPutBackDataLength() const
 {
-  std::string::size_type delimpos = std::string::npos;
-  if((delimpos = buf_.find("\r\n\r\n")) != std::string::npos) {
-    return buf_.size()-(delimpos+4);
-  } else if((delimpos = buf_.find("\n\n")) != std::string::npos) {
-    return buf_.size()-(delimpos+2);
+  if(headerLength_) {
+    return buf_.size()-headerLength_;
   } else {
     return 0;
   }
@@ -100,23 +128,50 @@ size_t HttpHeaderProcessor::getPutBackDataLength() const
 void HttpHeaderProcessor::clear()
 {
   buf_.erase();
+  state_ = IN_LINE;
+  lastLineEnd_ = 0;
+  headerLength_ = 0;
+}
+
+size_t HttpHeaderProcessor::getFirstLineEnd() const
+{
+  const char* first = buf_.data();
+  const char* p = reinterpret_cast<const char*>
+    (memchr(first, '\n', buf_.size()));
+  if(!p) {
+    return std::string::npos;
+  }
+  if(p != first && *(p-1) == '\r') {
+    --p;
+  }
+  return p-first;
+}
+
+void HttpHeaderProcessor::putFields
+(HttpHeader& httpHeader, size_t firstLineEnd) const
+{
+  const char* first = buf_.data();
+  const char* last = first+(headerLength_ ? headerLength_ : buf_.size());
+  for(const char* p = first+firstLineEnd; p != last;) {
+    const char* eol = reinterpret_cast<const char*>(memchr(p, '\n', last-p));
+    if(!eol) {
+      eol = last;
+    }
+    httpHeader.putField(p, eol);
+    p = eol == last ? last : eol+1;
+  }
 }
 
 SharedHandle<HttpHeader> HttpHeaderProcessor::getHttpResponseHeader()
 {
-  std::string::size_type delimpos = std::string::npos;
-  if(((delimpos = buf_.find("\r\n")) == std::string::npos &&
-      (delimpos = buf_.find("\n")) == std::string::npos) ||
-     delimpos < 12) {
+  size_t delimpos = getFirstLineEnd();
+  if(delimpos == std::string::npos || delimpos < 12) {
     throw DL_RETRY_EX(EX_NO_STATUS_HEADER);
   }
   HttpHeaderHandle httpHeader(new HttpHeader());
   httpHeader->setVersion(buf_.substr(0, 8));
   httpHeader->setResponseStatus(buf_.substr(9, 3));
-  std::istringstream strm(buf_);
-  // TODO 1st line(HTTP/1.1 200...) is also send to HttpHeader, but it should
-  // not.
-  httpHeader->fill(strm);
+  putFields(*httpHeader.get(), delimpos);
   return httpHeader;
 }
 
@@ -125,10 +180,8 @@ SharedHandle<HttpHeader> HttpHeaderProcessor::getHttpRequestHeader()
   // The minimum case of the first line is:
   // GET / HTTP/1.x
   // At least 14bytes before \r\n or \n.
-  std::string::size_type delimpos = std::string::npos;
-  if(((delimpos = buf_.find("\r\n")) == std::string::npos &&
-      (delimpos = buf_.find("\n")) == std::string::npos) ||
-     delimpos < 14) {
+  size_t delimpos = getFirstLineEnd();
+  if(delimpos == std::string::npos || delimpos < 14) {
     throw DL_RETRY_EX(EX_NO_STATUS_HEADER);
   }
   std::vector<std::string> firstLine;
@@ -140,19 +193,16 @@ SharedHandle<HttpHeader> HttpHeaderProcessor::getHttpRequestHeader()
   httpHeader->setMethod(firstLine[0]);
   httpHeader->setRequestPath(firstLine[1]);
   httpHeader->setVersion(firstLine[2]);
-  std::istringstream strm(buf_.substr(delimpos));
-  httpHeader->fill(strm);
+  putFields(*httpHeader.get(), delimpos);
   return httpHeader;
 }
 
 std::string HttpHeaderProcessor::getHeaderString() const
 {
-  std::string::size_type delimpos = std::string::npos;
-  if((delimpos = buf_.find("\r\n\r\n")) == std::string::npos &&
-     (delimpos = buf_.find("\n\n")) == std::string::npos) {
-    return buf_;
+  if(headerLength_) {
+    return buf_.substr(0, lastLineEnd_);
   } else {
-    return buf_.substr(0, delimpos);
+    return buf_;
   }
 }
 
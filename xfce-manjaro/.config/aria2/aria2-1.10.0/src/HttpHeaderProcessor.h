@@ -44,13 +44,44 @@ namespace aria2 {
 
 class HttpHeader;
 
+// Accumulates a HTTP header and finds its end. Each received byte is
+// scanned once: the scan stops at the end of buf_ and resumes there
+// on the next update(). A header ends with an empty line. Lines may
+// end with CRLF or LF.
 class HttpHeaderProcessor {
 private:
+  enum State {
+    // In a line which is not empty.
+    IN_LINE,
+    // At the start of a line.
+    LINE_START,
+    // After CR at the start of a line.
+    LINE_START_CR
+  };
+
   std::string buf_;
   size_t limit_;
 
+  State state_;
+
+  // The position of the line break which ends the last line seen.
+  size_t lastLineEnd_;
+
+  // The length of the header including the empty line which ends it.
+  // 0 until the end of header is found.
+  size_t headerLength_;
+
   void checkHeaderLimit(size_t incomingLength);
 
+  // Scans buf_ from offset for the end of header.
+  void scan(size_t offset);
+
+  // Returns the end of the first line, excluding its line break.
+  size_t getFirstLineEnd() const;
+
+  // Puts the header fields after the first line to httpHeader.
+  void putFields(HttpHeader& httpHeader, size_t firstLineEnd) const;
+
 public:
   HttpHeaderProcessor();
 
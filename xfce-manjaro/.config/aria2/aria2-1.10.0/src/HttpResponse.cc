@@ -77,7 +77,7 @@ void HttpResponse::validateResponse() const
      status == HttpHeader::S302 ||
      status == HttpHeader::S303 ||
      status == HttpHeader::S307) {
-    if(!httpHeader_->defined(HttpHeader::LOCATION)) {
+    if(!httpHeader_->defined(HttpHeader::HD_LOCATION)) {
       throw DL_ABORT_EX
         (StringFormat(EX_LOCATION_HEADER_REQUIRED,
                       util::parseUInt(status)).str());
@@ -85,7 +85,7 @@ void HttpResponse::validateResponse() const
     return;
   } else if(status == HttpHeader::S200 ||
             status == HttpHeader::S206) {
-    if(!httpHeader_->defined(HttpHeader::TRANSFER_ENCODING)) {
+    if(!httpHeader_->defined(HttpHeader::HD_TRANSFER_ENCODING)) {
       // compare the received range against the requested range
       RangeHandle responseRange = httpHeader_->getRange();
       if(!httpRequest_->isRangeSatisfied(responseRange)) {
@@ -111,7 +111,7 @@ std::string HttpResponse::determinFilename() const
 {
   std::string contentDisposition =
     util::getContentDispositionFilename
-    (httpHeader_->getFirst(HttpHeader::CONTENT_DISPOSITION));
+    (httpHeader_->getFirst(HttpHeader::HD_CONTENT_DISPOSITION));
   if(contentDisposition.empty()) {
     std::string file = util::percentDecode(httpRequest_->getFile());
     if(file.empty()) {
@@ -130,7 +130,7 @@ std::string HttpResponse::determinFilename() const
 
 void HttpResponse::retrieveCookie()
 {
-  std::vector<std::string> v = httpHeader_->get(HttpHeader::SET_COOKIE);
+  std::vector<std::string> v = httpHeader_->get(HttpHeader::HD_SET_COOKIE);
   for(std::vector<std::string>::const_iterator itr = v.begin(), eoi = v.end();
       itr != eoi; ++itr) {
     httpRequest_->getCookieStorage()->parseAndStore(*itr,
@@ -146,7 +146,7 @@ bool HttpResponse::isRedirect() const
           HttpHeader::S302 == status ||
           HttpHeader::S303 == status ||
           HttpHeader::S307 == status) &&
-    httpHeader_->defined(HttpHeader::LOCATION);
+    httpHeader_->defined(HttpHeader::HD_LOCATION);
 }
 
 void HttpResponse::processRedirect()
@@ -167,18 +167,18 @@ void HttpResponse::processRedirect()
 
 std::string HttpResponse::getRedirectURI() const
 {
-  return httpHeader_->getFirst(HttpHeader::LOCATION);
+  return httpHeader_->getFirst(HttpHeader::HD_LOCATION);
 }
 
 bool HttpResponse::isTransferEncodingSpecified() const
 {
-  return httpHeader_->defined(HttpHeader::TRANSFER_ENCODING);
+  return httpHeader_->defined(HttpHeader::HD_TRANSFER_ENCODING);
 }
 
 std::string HttpResponse::getTransferEncoding() const
 {
   // TODO See TODO in getTransferEncodingDecoder()
-  return httpHeader_->getFirst(HttpHeader::TRANSFER_ENCODING);
+  return httpHeader_->getFirst(HttpHeader::HD_TRANSFER_ENCODING);
 }
 
 SharedHandle<Decoder> HttpResponse::getTransferEncodingDecoder() const
@@ -195,12 +195,12 @@ SharedHandle<Decoder> HttpResponse::getTransferEncodingDecoder() const
 
 bool HttpResponse::isContentEncodingSpecified() const
 {
-  return httpHeader_->defined(HttpHeader::CONTENT_ENCODING);
+  return httpHeader_->defined(HttpHeader::HD_CONTENT_ENCODING);
 }
 
 const std::string& HttpResponse::getContentEncoding() const
 {
-  return httpHeader_->getFirst(HttpHeader::CONTENT_ENCODING);
+  return httpHeader_->getFirst(HttpHeader::HD_CONTENT_ENCODING);
 }
 
 SharedHandle<Decoder> HttpResponse::getContentEncodingDecoder() const
@@ -238,7 +238,7 @@ std::string HttpResponse::getContentType() const
     return A2STR::NIL;
   } else {
     return
-      util::split(httpHeader_->getFirst(HttpHeader::CONTENT_TYPE), ";").first;
+      util::split(httpHeader_->getFirst(HttpHeader::HD_CONTENT_TYPE), ";").first;
   }
 }
 
@@ -260,23 +260,23 @@ const std::string& HttpResponse::getResponseStatus() const
 
 bool HttpResponse::hasRetryAfter() const
 {
-  return httpHeader_->defined(HttpHeader::RETRY_AFTER);
+  return httpHeader_->defined(HttpHeader::HD_RETRY_AFTER);
 }
 
 time_t HttpResponse::getRetryAfter() const
 {
-  return httpHeader_->getFirstAsUInt(HttpHeader::RETRY_AFTER);
+  return httpHeader_->getFirstAsUInt(HttpHeader::HD_RETRY_AFTER);
 }
 
 Time HttpResponse::getLastModifiedTime() const
 {
-  return Time::parseHTTPDate(httpHeader_->getFirst(HttpHeader::LAST_MODIFIED));
+  return Time::parseHTTPDate(httpHeader_->getFirst(HttpHeader::HD_LAST_MODIFIED));
 }
 
 bool HttpResponse::supportsPersistentConnection() const
 {
   std::string connection =
-    util::toLower(httpHeader_->getFirst(HttpHeader::CONNECTION));
+    util::toLower(httpHeader_->getFirst(HttpHeader::HD_CONNECTION));
   std::string version = httpHeader_->getVersion();
 
   return
@@ -176,7 +176,7 @@ bool HttpResponseCommand::executeInternal()
       getFileEntry()->setLength(0);
       if(getRequest()->getMethod() == Request::METHOD_GET &&
          (totalLength != 0 ||
-          !httpResponse->getHttpHeader()->defined(HttpHeader::CONTENT_LENGTH))){
+          !httpResponse->getHttpHeader()->defined(HttpHeader::HD_CONTENT_LENGTH))){
         // DownloadContext::knowsTotalLength() == true only when
         // server says the size of file is 0 explicitly.
         getDownloadContext()->markTotalLengthIsUnknown();
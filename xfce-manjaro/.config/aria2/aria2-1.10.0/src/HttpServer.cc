@@ -89,18 +89,18 @@ SharedHandle<HttpHeader> HttpServer::receiveRequest()
     lastBody_.clear();
     lastBody_.str("");
     lastContentLength_ =
-      lastRequestHeader_->getFirstAsUInt(HttpHeader::CONTENT_LENGTH);
+      lastRequestHeader_->getFirstAsUInt(HttpHeader::HD_CONTENT_LENGTH);
     headerProcessor_->clear();
 
     std::string connection =
-      util::toLower(lastRequestHeader_->getFirst(HttpHeader::CONNECTION));
+      util::toLower(lastRequestHeader_->getFirst(HttpHeader::HD_CONNECTION));
     acceptsPersistentConnection_ =
       connection.find(HttpHeader::CLOSE) == std::string::npos &&
       (lastRequestHeader_->getVersion() == HttpHeader::HTTP_1_1 ||
        connection.find("keep-alive") != std::string::npos);
 
     std::vector<std::string> acceptEncodings;
-    util::split(lastRequestHeader_->getFirst(HttpHeader::ACCEPT_ENCODING),
+    util::split(lastRequestHeader_->getFirst(HttpHeader::HD_ACCEPT_ENCODING),
                 std::back_inserter(acceptEncodings), A2STR::COMMA_C, true);
     acceptsGZip_ =
       std::find(acceptEncodings.begin(), acceptEncodings.end(), "gzip")
@@ -94,7 +94,7 @@ bool HttpSkipResponseCommand::executeInternal()
     // If content-length header is not present, then EOF is expected in the end.
     // In this case, the content is thrown away and socket cannot be pooled. 
     if(getRequest()->getMethod() == Request::METHOD_HEAD ||
-       httpResponse_->getHttpHeader()->defined(HttpHeader::CONTENT_LENGTH)) {
+       httpResponse_->getHttpHeader()->defined(HttpHeader::HD_CONTENT_LENGTH)) {
       poolConnection();
     }
     return processResponse();
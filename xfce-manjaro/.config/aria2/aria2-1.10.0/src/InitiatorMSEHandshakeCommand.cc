@@ -92,6 +92,7 @@ InitiatorMSEHandshakeCommand::~InitiatorMSEHandshakeCommand()
 }
 
 bool InitiatorMSEHandshakeCommand::executeInternal() {
+  Seq prevSequence = sequence_;
   switch(sequence_) {
   case INITIATOR_SEND_KEY: {
     if(!getSocket()->isWritable(0)) {
@@ -169,6 +170,9 @@ bool InitiatorMSEHandshakeCommand::executeInternal() {
     break;
   }
   }
+  if(sequence_ == prevSequence) {
+    sleepUntilTimeout();
+  }
   getDownloadEngine()->addCommand(this);
   return false;
 }
@@ -0,0 +1,549 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "IoUringEventPoll.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+
+#include "Command.h"
+#include "LogFactory.h"
+#include "Logger.h"
+
+namespace aria2 {
+
+IoUringEventPoll::KSocketEntry::KSocketEntry(sock_t s):
+  SocketEntry<KCommandEvent, KADNSEvent>(s),
+  registeredEvents_(0), userData_(0), dirty_(false), renewed_(false) {}
+
+int accumulateEvent(int events, const IoUringEventPoll::KEvent& event)
+{
+  return events|event.getEvents();
+}
+
+int IoUringEventPoll::KSocketEntry::getEvents()
+{
+#ifdef ENABLE_ASYNC_DNS
+
+  return
+    std::accumulate(adnsEvents_.begin(),
+                    adnsEvents_.end(),
+                    std::accumulate(commandEvents_.begin(),
+                                    commandEvents_.end(), 0, accumulateEvent),
+                    accumulateEvent);
+
+#else // !ENABLE_ASYNC_DNS
+
+  return
+    std::accumulate(commandEvents_.begin(), commandEvents_.end(), 0,
+                    accumulateEvent);
+
+#endif // !ENABLE_ASYNC_DNS
+}
+
+IoUringEventPoll::IoUringEventPoll():
+  ringfd_(-1),
+  sqRing_(MAP_FAILED), sqRingSize_(0),
+  cqRing_(MAP_FAILED), cqRingSize_(0),
+  sqes_(reinterpret_cast<struct io_uring_sqe*>(MAP_FAILED)), sqesSize_(0),
+  sqHead_(0), sqTail_(0), sqMask_(0), sqEntries_(0),
+  cqHead_(0), cqTail_(0), cqMask_(0), cqes_(0),
+  toSubmit_(0),
+  generation_(0),
+  numEnter_(0),
+  logger_(LogFactory::getInstance())
+{
+  setup();
+}
+
+IoUringEventPoll::~IoUringEventPoll()
+{
+  teardown();
+}
+
+void IoUringEventPoll::setup()
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = CQ_ENTRIES;
+  ringfd_ = syscall(__NR_io_uring_setup, SQ_ENTRIES, &params);
+  if(ringfd_ == -1) {
+    logger_->info("io_uring_setup failed: %s", strerror(errno));
+    return;
+  }
+  // Needed to wait for completions with a timeout without a timeout
+  // request in the ring. Available since Linux 5.11.
+  if(!(params.features&IORING_FEAT_EXT_ARG)) {
+    logger_->info("io_uring does not support IORING_FEAT_EXT_ARG.");
+    teardown();
+    return;
+  }
+  sqRingSize_ = params.sq_off.array+params.sq_entries*sizeof(unsigned int);
+  cqRingSize_ =
+    params.cq_off.cqes+params.cq_entries*sizeof(struct io_uring_cqe);
+  if(params.features&IORING_FEAT_SINGLE_MMAP) {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = mmap(0, sqRingSize_, PROT_READ|PROT_WRITE,
+                 MAP_SHARED|MAP_POPULATE, ringfd_, IORING_OFF_SQ_RING);
+  if(sqRing_ == MAP_FAILED) {
+    logger_->info("Failed to map io_uring submission queue: %s",
+                  strerror(errno));
+    teardown();
+    return;
+  }
+  if(params.features&IORING_FEAT_SINGLE_MMAP) {
+    cqRing_ = sqRing_;
+  } else {
+    cqRing_ = mmap(0, cqRingSize_, PROT_READ|PROT_WRITE,
+                   MAP_SHARED|MAP_POPULATE, ringfd_, IORING_OFF_CQ_RING);
+    if(cqRing_ == MAP_FAILED) {
+      logger_->info("Failed to map io_uring completion queue: %s",
+                    strerror(errno));
+      teardown();
+      return;
+    }
+  }
+  sqesSize_ = params.sq_entries*sizeof(struct io_uring_sqe);
+  sqes_ = reinterpret_cast<struct io_uring_sqe*>
+    (mmap(0, sqesSize_, PROT_READ|PROT_WRITE,
+          MAP_SHARED|MAP_POPULATE, ringfd_, IORING_OFF_SQES));
+  if(sqes_ == MAP_FAILED) {
+    logger_->info("Failed to map io_uring submission entries: %s",
+                  strerror(errno));
+    teardown();
+    return;
+  }
+  char* sq = reinterpret_cast<char*>(sqRing_);
+  sqHead_ = reinterpret_cast<unsigned int*>(sq+params.sq_off.head);
+  sqTail_ = reinterpret_cast<unsigned int*>(sq+params.sq_off.tail);
+  sqMask_ = *reinterpret_cast<unsigned int*>(sq+params.sq_off.ring_mask);
+  sqEntries_ = params.sq_entries;
+  // Submission entry i always sits in slot i of the index array.
+  unsigned int* array = reinterpret_cast<unsigned int*>(sq+params.sq_off.array);
+  for(unsigned int i = 0; i < sqEntries_; ++i) {
+    array[i] = i;
+  }
+  char* cq = reinterpret_cast<char*>(cqRing_);
+  cqHead_ = reinterpret_cast<unsigned int*>(cq+params.cq_off.head);
+  cqTail_ = reinterpret_cast<unsigned int*>(cq+params.cq_off.tail);
+  cqMask_ = *reinterpret_cast<unsigned int*>(cq+params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq+params.cq_off.cqes);
+}
+
+void IoUringEventPoll::teardown()
+{
+  if(sqes_ != MAP_FAILED) {
+    munmap(sqes_, sqesSize_);
+    sqes_ = reinterpret_cast<struct io_uring_sqe*>(MAP_FAILED);
+  }
+  if(cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+    munmap(cqRing_, cqRingSize_);
+  }
+  cqRing_ = MAP_FAILED;
+  if(sqRing_ != MAP_FAILED) {
+    munmap(sqRing_, sqRingSize_);
+    sqRing_ = MAP_FAILED;
+  }
+  if(ringfd_ != -1) {
+    int r;
+    while((r = close(ringfd_)) == -1 && errno == EINTR);
+    if(r == -1) {
+      logger_->error("Error occurred while closing io_uring file descriptor"
+                     " %d: %s",
+                     ringfd_, strerror(errno));
+    }
+    ringfd_ = -1;
+  }
+}
+
+bool IoUringEventPoll::good() const
+{
+  return ringfd_ != -1;
+}
+
+void IoUringEventPoll::markDirty(KSocketEntry* entry)
+{
+  if(!entry->dirty_) {
+    entry->dirty_ = true;
+    dirtyEntries_.push_back(entry);
+  }
+}
+
+int IoUringEventPoll::enter(unsigned int minComplete, unsigned int flags,
+                            const struct timeval* tv)
+{
+  struct io_uring_getevents_arg arg;
+  struct __kernel_timespec ts;
+  void* argp = 0;
+  size_t argsz = 0;
+  if(tv) {
+    ts.tv_sec = tv->tv_sec;
+    ts.tv_nsec = tv->tv_usec*1000;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG/8;
+    arg.ts = reinterpret_cast<uintptr_t>(&ts);
+    argp = &arg;
+    argsz = sizeof(arg);
+    flags |= IORING_ENTER_EXT_ARG;
+  }
+  int r;
+  do {
+    ++numEnter_;
+    r = syscall(__NR_io_uring_enter, ringfd_, toSubmit_, minComplete, flags,
+                argp, argsz);
+  } while(r == -1 && errno == EINTR);
+  if(r >= 0) {
+    // The kernel returns the number of consumed submission entries
+    // even if waiting timed out.
+    toSubmit_ -= std::min(static_cast<unsigned int>(r), toSubmit_);
+  }
+  return r;
+}
+
+struct io_uring_sqe* IoUringEventPoll::getSqe()
+{
+  unsigned int tail = *sqTail_;
+  if(tail-__atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+    if(enter(0, 0, 0) == -1 && logger_->debug()) {
+      logger_->debug("io_uring_enter failed: %s", strerror(errno));
+    }
+    if(tail-__atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+      return 0;
+    }
+  }
+  struct io_uring_sqe* sqe = &sqes_[tail&sqMask_];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  __atomic_store_n(sqTail_, tail+1, __ATOMIC_RELEASE);
+  ++toSubmit_;
+  return sqe;
+}
+
+bool IoUringEventPoll::updateEvents(KSocketEntry* entry)
+{
+  int events = entry->getEvents();
+  if(entry->userData_ != 0 &&
+     (events == 0 || entry->renewed_ || entry->registeredEvents_ != events)) {
+    // Until this request is processed, the kernel keeps a reference to
+    // the file of the socket, even if the Command already closed it.
+    // It is at most one loop iteration.
+    struct io_uring_sqe* sqe = getSqe();
+    if(!sqe) {
+      return false;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = entry->userData_;
+    sqe->user_data = 0;
+    entry->userData_ = 0;
+    entry->registeredEvents_ = 0;
+  }
+  if(events != 0 && entry->userData_ == 0) {
+    struct io_uring_sqe* sqe = getSqe();
+    if(!sqe) {
+      return false;
+    }
+    if(++generation_ == 0) {
+      ++generation_;
+    }
+    // Requests are one-shot: multishot poll reports edges, but
+    // Commands expect to be woken up again as long as the socket is
+    // ready, as with poll() and epoll. The request is re-armed after
+    // it completes.
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = entry->getSocket();
+#ifdef WORDS_BIGENDIAN
+    sqe->poll32_events = (static_cast<uint32_t>(events) << 16)|
+      (static_cast<uint32_t>(events) >> 16);
+#else // !WORDS_BIGENDIAN
+    sqe->poll32_events = events;
+#endif // !WORDS_BIGENDIAN
+    sqe->user_data = (static_cast<uint64_t>(generation_) << 32)|
+      static_cast<uint32_t>(entry->getSocket());
+    entry->userData_ = sqe->user_data;
+    entry->registeredEvents_ = events;
+  }
+  return true;
+}
+
+void IoUringEventPoll::updateEvents()
+{
+  bool erased = false;
+  std::vector<KSocketEntry*> failed;
+  for(std::vector<KSocketEntry*>::const_iterator i = dirtyEntries_.begin(),
+        eoi = dirtyEntries_.end(); i != eoi; ++i) {
+    KSocketEntry* entry = *i;
+    entry->dirty_ = false;
+    if(!updateEvents(entry)) {
+      failed.push_back(entry);
+      continue;
+    }
+    entry->renewed_ = false;
+    if(entry->eventEmpty()) {
+      erased = true;
+    }
+  }
+  dirtyEntries_.clear();
+  if(!failed.empty()) {
+    if(logger_->debug()) {
+      logger_->debug("io_uring submission queue is full. %lu sockets will"
+                     " be updated later.",
+                     static_cast<unsigned long>(failed.size()));
+    }
+    std::for_each(failed.begin(), failed.end(),
+                  std::bind1st(std::mem_fun(&IoUringEventPoll::markDirty),
+                               this));
+  }
+  if(erased) {
+    std::deque<SharedHandle<KSocketEntry> >::iterator dst =
+      socketEntries_.begin();
+    for(std::deque<SharedHandle<KSocketEntry> >::iterator i =
+          socketEntries_.begin(), eoi = socketEntries_.end(); i != eoi; ++i) {
+      if(!(*i)->eventEmpty() || (*i)->dirty_) {
+        *dst++ = *i;
+      }
+    }
+    socketEntries_.erase(dst, socketEntries_.end());
+  }
+}
+
+IoUringEventPoll::KSocketEntry* IoUringEventPoll::findEntry(sock_t socket)
+{
+  size_t low = 0;
+  size_t high = socketEntries_.size();
+  while(low < high) {
+    size_t mid = low+(high-low)/2;
+    if(socketEntries_[mid]->getSocket() < socket) {
+      low = mid+1;
+    } else {
+      high = mid;
+    }
+  }
+  if(low < socketEntries_.size() &&
+     socketEntries_[low]->getSocket() == socket) {
+    return socketEntries_[low].get();
+  } else {
+    return 0;
+  }
+}
+
+void IoUringEventPoll::processCompletions()
+{
+  unsigned int head = *cqHead_;
+  unsigned int tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+  for(; head != tail; ++head) {
+    const struct io_uring_cqe& cqe = cqes_[head&cqMask_];
+    if(cqe.user_data == 0) {
+      // Completion of IORING_OP_POLL_REMOVE.
+      continue;
+    }
+    KSocketEntry* entry =
+      findEntry(static_cast<sock_t>(cqe.user_data&0xffffffffu));
+    if(!entry || entry->userData_ != cqe.user_data) {
+      // The request was replaced or removed.
+      continue;
+    }
+    entry->userData_ = 0;
+    entry->registeredEvents_ = 0;
+    if(cqe.res < 0) {
+      // Not re-armed until the events of the socket change, as
+      // EpollEventPoll does when epoll_ctl fails.
+      if(logger_->debug()) {
+        logger_->debug("Failed to poll socket %d:%s",
+                       entry->getSocket(), strerror(-cqe.res));
+      }
+      continue;
+    }
+    entry->processEvents(cqe.res);
+    markDirty(entry);
+  }
+  __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+void IoUringEventPoll::poll(const struct timeval& tv)
+{
+  updateEvents();
+
+  // Submits the queued requests and waits for completions in one
+  // system call.
+  if(enter(1, IORING_ENTER_GETEVENTS, &tv) == -1 &&
+     errno != ETIME && logger_->debug()) {
+    logger_->debug("io_uring_enter failed: %s", strerror(errno));
+  }
+  processCompletions();
+
+#ifdef ENABLE_ASYNC_DNS
+  // It turns out that we have to call ares_process_fd before ares's
+  // own timeout and ares may create new sockets or closes socket in
+  // their API. So we call ares_process_fd for all ares_channel and
+  // re-register their sockets.
+  for(std::deque<SharedHandle<KAsyncNameResolverEntry> >::iterator i =
+        nameResolverEntries_.begin(), eoi = nameResolverEntries_.end();
+      i != eoi; ++i) {
+    (*i)->processTimeout();
+    (*i)->removeSocketEvents(this);
+    (*i)->addSocketEvents(this);
+  }
+#endif // ENABLE_ASYNC_DNS
+}
+
+static int translateEvents(EventPoll::EventType events)
+{
+  int newEvents = 0;
+  if(EventPoll::EVENT_READ&events) {
+    newEvents |= IoUringEventPoll::IEV_READ;
+  }
+  if(EventPoll::EVENT_WRITE&events) {
+    newEvents |= IoUringEventPoll::IEV_WRITE;
+  }
+  if(EventPoll::EVENT_ERROR&events) {
+    newEvents |= IoUringEventPoll::IEV_ERROR;
+  }
+  if(EventPoll::EVENT_HUP&events) {
+    newEvents |= IoUringEventPoll::IEV_HUP;
+  }
+  return newEvents;
+}
+
+bool IoUringEventPoll::addEvents(sock_t socket,
+                                 const IoUringEventPoll::KEvent& event)
+{
+  SharedHandle<KSocketEntry> socketEntry(new KSocketEntry(socket));
+  std::deque<SharedHandle<KSocketEntry> >::iterator i =
+    std::lower_bound(socketEntries_.begin(), socketEntries_.end(), socketEntry);
+  if(i != socketEntries_.end() && (*i) == socketEntry) {
+    size_t count = (*i)->countEvent();
+    event.addSelf(*i);
+    if((*i)->countEvent() > count) {
+      (*i)->renewed_ = true;
+    }
+    markDirty((*i).get());
+  } else {
+    socketEntries_.insert(i, socketEntry);
+    event.addSelf(socketEntry);
+    markDirty(socketEntry.get());
+  }
+  return true;
+}
+
+bool IoUringEventPoll::addEvents(sock_t socket, Command* command,
+                                 EventPoll::EventType events)
+{
+  return addEvents(socket, KCommandEvent(command, translateEvents(events)));
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::addEvents(sock_t socket, Command* command, int events,
+                                 const SharedHandle<AsyncNameResolver>& rs)
+{
+  return addEvents(socket, KADNSEvent(rs, command, socket, events));
+}
+#endif // ENABLE_ASYNC_DNS
+
+bool IoUringEventPoll::deleteEvents(sock_t socket,
+                                    const IoUringEventPoll::KEvent& event)
+{
+  SharedHandle<KSocketEntry> socketEntry(new KSocketEntry(socket));
+  std::deque<SharedHandle<KSocketEntry> >::iterator i =
+    std::lower_bound(socketEntries_.begin(), socketEntries_.end(), socketEntry);
+  if(i != socketEntries_.end() && (*i) == socketEntry) {
+    event.removeSelf(*i);
+    // The entry is removed in updateEvents() if it becomes empty.
+    markDirty((*i).get());
+    return true;
+  } else {
+    if(logger_->debug()) {
+      logger_->debug("Socket %d is not found in SocketEntries.", socket);
+    }
+    return false;
+  }
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::deleteEvents(sock_t socket, Command* command,
+                                    const SharedHandle<AsyncNameResolver>& rs)
+{
+  return deleteEvents(socket, KADNSEvent(rs, command, socket, 0));
+}
+#endif // ENABLE_ASYNC_DNS
+
+bool IoUringEventPoll::deleteEvents(sock_t socket, Command* command,
+                                    EventPoll::EventType events)
+{
+  return deleteEvents(socket, KCommandEvent(command, translateEvents(events)));
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::addNameResolver
+(const SharedHandle<AsyncNameResolver>& resolver, Command* command)
+{
+  SharedHandle<KAsyncNameResolverEntry> entry
+    (new KAsyncNameResolverEntry(resolver, command));
+  std::deque<SharedHandle<KAsyncNameResolverEntry> >::iterator itr =
+    std::find(nameResolverEntries_.begin(), nameResolverEntries_.end(), entry);
+  if(itr == nameResolverEntries_.end()) {
+    nameResolverEntries_.push_back(entry);
+    entry->addSocketEvents(this);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool IoUringEventPoll::deleteNameResolver
+(const SharedHandle<AsyncNameResolver>& resolver, Command* command)
+{
+  SharedHandle<KAsyncNameResolverEntry> entry
+    (new KAsyncNameResolverEntry(resolver, command));
+  std::deque<SharedHandle<KAsyncNameResolverEntry> >::iterator itr =
+    std::find(nameResolverEntries_.begin(), nameResolverEntries_.end(), entry);
+  if(itr == nameResolverEntries_.end()) {
+    return false;
+  } else {
+    (*itr)->removeSocketEvents(this);
+    nameResolverEntries_.erase(itr);
+    return true;
+  }
+}
+#endif // ENABLE_ASYNC_DNS
+
+} // namespace aria2
@@ -0,0 +1,210 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_IO_URING_EVENT_POLL_H_
+#define _D_IO_URING_EVENT_POLL_H_
+
+#include "EventPoll.h"
+
+#include <poll.h>
+#include <linux/io_uring.h>
+
+#include <deque>
+#include <vector>
+
+#include "Event.h"
+#ifdef ENABLE_ASYNC_DNS
+# include "AsyncNameResolver.h"
+#endif // ENABLE_ASYNC_DNS
+
+namespace aria2 {
+
+class Logger;
+
+// EventPoll using io_uring. Each socket has one poll request in the
+// ring at a time. Changes and re-arms are queued as submission
+// entries and sent to the kernel by the same io_uring_enter() call
+// which waits for completions, so that one iteration of the event
+// loop costs one system call however many sockets change.
+class IoUringEventPoll : public EventPoll {
+private:
+  class KSocketEntry;
+
+  typedef Event<KSocketEntry> KEvent;
+  typedef CommandEvent<KSocketEntry, IoUringEventPoll> KCommandEvent;
+  typedef ADNSEvent<KSocketEntry, IoUringEventPoll> KADNSEvent;
+  typedef AsyncNameResolverEntry<IoUringEventPoll> KAsyncNameResolverEntry;
+  friend class AsyncNameResolverEntry<IoUringEventPoll>;
+
+  class KSocketEntry:
+    public SocketEntry<KCommandEvent, KADNSEvent> {
+  private:
+    // The events of the poll request in the ring.
+    int registeredEvents_;
+
+    // The user_data of the poll request in the ring. 0 if no request
+    // is pending.
+    uint64_t userData_;
+
+    // True if this entry is in dirtyEntries_.
+    bool dirty_;
+
+    // True if a Command or resolver started watching this socket
+    // since the last update. The previous socket with this descriptor
+    // may have been closed, so the poll request must be replaced.
+    bool renewed_;
+
+    friend class IoUringEventPoll;
+  public:
+    KSocketEntry(sock_t socket);
+
+    int getEvents();
+  };
+
+  friend int accumulateEvent(int events, const KEvent& event);
+
+private:
+  std::deque<SharedHandle<KSocketEntry> > socketEntries_;
+#ifdef ENABLE_ASYNC_DNS
+  std::deque<SharedHandle<KAsyncNameResolverEntry> > nameResolverEntries_;
+#endif // ENABLE_ASYNC_DNS
+
+  // Entries which need a new poll request: their events changed or
+  // their last request completed.
+  std::vector<KSocketEntry*> dirtyEntries_;
+
+  int ringfd_;
+
+  void* sqRing_;
+  size_t sqRingSize_;
+  void* cqRing_;
+  size_t cqRingSize_;
+  struct io_uring_sqe* sqes_;
+  size_t sqesSize_;
+
+  unsigned int* sqHead_;
+  unsigned int* sqTail_;
+  unsigned int sqMask_;
+  unsigned int sqEntries_;
+  unsigned int* cqHead_;
+  unsigned int* cqTail_;
+  unsigned int cqMask_;
+  struct io_uring_cqe* cqes_;
+
+  // The number of submission entries queued but not yet consumed by
+  // the kernel.
+  unsigned int toSubmit_;
+
+  // Distinguishes poll requests for the same descriptor, so that a
+  // completion of a replaced request is ignored.
+  uint32_t generation_;
+
+  // The number of io_uring_enter calls, for statistics.
+  uint64_t numEnter_;
+
+  Logger* logger_;
+
+  static const unsigned int SQ_ENTRIES = 4096;
+
+  static const unsigned int CQ_ENTRIES = 16384;
+
+  void setup();
+
+  void teardown();
+
+  void markDirty(KSocketEntry* entry);
+
+  // Returns the next free submission entry, submitting queued ones
+  // first if the ring is full. Returns 0 on error.
+  struct io_uring_sqe* getSqe();
+
+  int enter(unsigned int minComplete, unsigned int flags,
+            const struct timeval* tv);
+
+  // Queues the changes of dirtyEntries_.
+  void updateEvents();
+
+  bool updateEvents(KSocketEntry* entry);
+
+  void processCompletions();
+
+  KSocketEntry* findEntry(sock_t socket);
+
+  bool addEvents(sock_t socket, const KEvent& event);
+
+  bool deleteEvents(sock_t socket, const KEvent& event);
+
+  bool addEvents(sock_t socket, Command* command, int events,
+                 const SharedHandle<AsyncNameResolver>& rs);
+
+  bool deleteEvents(sock_t socket, Command* command,
+                    const SharedHandle<AsyncNameResolver>& rs);
+
+public:
+  IoUringEventPoll();
+
+  bool good() const;
+
+  virtual ~IoUringEventPoll();
+
+  virtual void poll(const struct timeval& tv);
+
+  // Returns the number of io_uring_enter calls so far.
+  uint64_t getNumEnter() const
+  {
+    return numEnter_;
+  }
+
+  virtual bool addEvents(sock_t socket,
+                         Command* command, EventPoll::EventType events);
+
+  virtual bool deleteEvents(sock_t socket,
+                            Command* command, EventPoll::EventType events);
+#ifdef ENABLE_ASYNC_DNS
+
+  virtual bool addNameResolver(const SharedHandle<AsyncNameResolver>& resolver,
+                               Command* command);
+  virtual bool deleteNameResolver
+  (const SharedHandle<AsyncNameResolver>& resolver, Command* command);
+#endif // ENABLE_ASYNC_DNS
+
+  static const int IEV_READ = POLLIN;
+  static const int IEV_WRITE = POLLOUT;
+  static const int IEV_ERROR = POLLERR;
+  static const int IEV_HUP = POLLHUP;
+};
+
+} // namespace aria2
+
+#endif // _D_IO_URING_EVENT_POLL_H_
@@ -46,12 +46,75 @@
 #include "FileEntry.h"
 #include "BitfieldMan.h"
 #include "DownloadContext.h"
+#include "DiskIOJob.h"
+#include "DlAbortEx.h"
 
 namespace aria2 {
 
 #define BUFSIZE (256*1024)
 #define ALIGNMENT 512
 
+static unsigned char* allocateBuffer()
+{
+#ifdef HAVE_POSIX_MEMALIGN
+  return reinterpret_cast<unsigned char*>
+    (util::allocateAlignedMemory(ALIGNMENT, BUFSIZE));
+#else // !HAVE_POSIX_MEMALIGN
+  return new unsigned char[BUFSIZE];
+#endif // !HAVE_POSIX_MEMALIGN
+}
+
+static void freeBuffer(unsigned char* buffer)
+{
+#ifdef HAVE_POSIX_MEMALIGN
+  free(buffer);
+#else // !HAVE_POSIX_MEMALIGN
+  delete [] buffer;
+#endif // !HAVE_POSIX_MEMALIGN
+}
+
+#ifdef ENABLE_DISK_IO_THREAD
+
+// Reads the next part of the file and adds it to the digest in a
+// worker thread. The handles are copied and released in the main
+// thread only. The job owns its buffer because the validator may be
+// gone when the job finishes.
+class IteratableChecksumValidator::ChunkJob:public DiskIOJob {
+private:
+  SharedHandle<DiskAdaptor> diskAdaptor_;
+
+  SharedHandle<MessageDigestContext> ctx_;
+
+  off_t offset_;
+
+  unsigned char* buffer_;
+
+  size_t length_;
+public:
+  ChunkJob(const SharedHandle<DiskAdaptor>& diskAdaptor,
+           const SharedHandle<MessageDigestContext>& ctx, off_t offset):
+    diskAdaptor_(diskAdaptor), ctx_(ctx), offset_(offset),
+    buffer_(allocateBuffer()), length_(0) {}
+
+  virtual ~ChunkJob()
+  {
+    freeBuffer(buffer_);
+  }
+
+  virtual void execute()
+  {
+    length_ = diskAdaptor_->readData(buffer_, BUFSIZE, offset_);
+    ctx_->digestUpdate(buffer_, length_);
+  }
+
+  size_t getLength() const
+  {
+    return length_;
+  }
+};
+
+#endif // ENABLE_DISK_IO_THREAD
+
 IteratableChecksumValidator::IteratableChecksumValidator
 (const SharedHandle<DownloadContext>& dctx,
  const PieceStorageHandle& pieceStorage):
@@ -59,15 +122,26 @@ IteratableChecksumValidator::IteratableChecksumValidator
   pieceStorage_(pieceStorage),
   currentOffset_(0),
   logger_(LogFactory::getInstance()),
-  buffer_(0) {}
+  buffer_(0)
+#ifdef ENABLE_DISK_IO_THREAD
+  , chunkJobPosted_(false)
+#endif // ENABLE_DISK_IO_THREAD
+{}
 
 IteratableChecksumValidator::~IteratableChecksumValidator()
 {
-#ifdef HAVE_POSIX_MEMALIGN
-  free(buffer_);
-#else // !HAVE_POSIX_MEMALIGN
-  delete [] buffer_;
-#endif // !HAVE_POSIX_MEMALIGN
+  freeBuffer(buffer_);
+}
+
+void IteratableChecksumValidator::updatePieceStorage()
+{
+  std::string actualChecksum = util::toHex(ctx_->digestFinal());
+  if(dctx_->getChecksum() == actualChecksum) {
+    pieceStorage_->markAllPiecesDone();
+  } else {
+    BitfieldMan bitfield(dctx_->getPieceLength(), dctx_->getTotalLength());
+    pieceStorage_->setBitfield(bitfield.getBitfield(), bitfield.getBitfieldLength());
+  }
 }
 
 void IteratableChecksumValidator::validateChunk()
@@ -79,17 +153,40 @@ void IteratableChecksumValidator::validateChunk()
     ctx_->digestUpdate(buffer_, length);
     currentOffset_ += length;
     if(finished()) {
-      std::string actualChecksum = util::toHex(ctx_->digestFinal());
-      if(dctx_->getChecksum() == actualChecksum) {
-        pieceStorage_->markAllPiecesDone();
-      } else {
-        BitfieldMan bitfield(dctx_->getPieceLength(), dctx_->getTotalLength());
-        pieceStorage_->setBitfield(bitfield.getBitfield(), bitfield.getBitfieldLength());
-      }
+      updatePieceStorage();
     }
   }
 }
 
+#ifdef ENABLE_DISK_IO_THREAD
+
+SharedHandle<DiskIOJob> IteratableChecksumValidator::createChunkJob()
+{
+  if(chunkJobPosted_ || finished()) {
+    return SharedHandle<DiskIOJob>();
+  }
+  chunkJobPosted_ = true;
+  return SharedHandle<DiskIOJob>
+    (new ChunkJob(pieceStorage_->getDiskAdaptor(), ctx_, currentOffset_));
+}
+
+void IteratableChecksumValidator::finishChunkJob
+(const SharedHandle<DiskIOJob>& job)
+{
+  chunkJobPosted_ = false;
+  if(!job->getException().isNull()) {
+    // DiskIOJob::run() stores the exception as DlAbortEx.
+    throw DlAbortEx(__FILE__, __LINE__,
+                    *static_cast<DlAbortEx*>(job->getException().get()));
+  }
+  currentOffset_ += static_pointer_cast<ChunkJob>(job)->getLength();
+  if(finished()) {
+    updatePieceStorage();
+  }
+}
+
+#endif // ENABLE_DISK_IO_THREAD
+
 bool IteratableChecksumValidator::finished() const
 {
   if((uint64_t)currentOffset_ >= dctx_->getTotalLength()) {
@@ -107,19 +204,16 @@ uint64_t IteratableChecksumValidator::getTotalLength() const
 
 void IteratableChecksumValidator::init()
 {
-#ifdef HAVE_POSIX_MEMALIGN
-  free(buffer_);
-  buffer_ = reinterpret_cast<unsigned char*>
-    (util::allocateAlignedMemory(ALIGNMENT, BUFSIZE));
-#else // !HAVE_POSIX_MEMALIGN
-  delete [] buffer_;
-  buffer_ = new unsigned char[BUFSIZE];
-#endif // !HAVE_POSIX_MEMALIGN
+  freeBuffer(buffer_);
+  buffer_ = allocateBuffer();
   pieceStorage_->getDiskAdaptor()->enableDirectIO();
   currentOffset_ = 0;
   ctx_.reset(new MessageDigestContext());
   ctx_->trySetAlgo(dctx_->getChecksumHashAlgo());
   ctx_->digestInit();
+#ifdef ENABLE_DISK_IO_THREAD
+  chunkJobPosted_ = false;
+#endif // ENABLE_DISK_IO_THREAD
 }
 
 } // namespace aria2
@@ -59,6 +59,15 @@ private:
 
   unsigned char* buffer_;
 
+#ifdef ENABLE_DISK_IO_THREAD
+  class ChunkJob;
+
+  // True while the job returned by createChunkJob() is not finished.
+  // The file is hashed in order, so there is one job at a time.
+  bool chunkJobPosted_;
+#endif // ENABLE_DISK_IO_THREAD
+
+  void updatePieceStorage();
 public:
   IteratableChecksumValidator(const SharedHandle<DownloadContext>& dctx,
                               const SharedHandle<PieceStorage>& pieceStorage);
@@ -77,6 +86,19 @@ public:
   }
 
   virtual uint64_t getTotalLength() const;
+
+#ifdef ENABLE_DISK_IO_THREAD
+  // The file is read and hashed in a worker thread, but PieceStorage
+  // and the progress are updated in finishChunkJob().
+  virtual bool concurrent() const
+  {
+    return true;
+  }
+
+  virtual SharedHandle<DiskIOJob> createChunkJob();
+
+  virtual void finishChunkJob(const SharedHandle<DiskIOJob>& job);
+#endif // ENABLE_DISK_IO_THREAD
 };
 
 typedef SharedHandle<IteratableChecksumValidator> IteratableChecksumValidatorHandle;
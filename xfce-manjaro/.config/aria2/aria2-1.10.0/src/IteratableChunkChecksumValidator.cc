@@ -37,6 +37,8 @@
 #include <cerrno>
 #include <cstring>
 #include <cstdlib>
+#include <vector>
+#include <algorithm>
 
 #include "util.h"
 #include "message.h"
@@ -51,12 +53,260 @@
 #include "Logger.h"
 #include "messageDigest.h"
 #include "StringFormat.h"
+#include "DiskIOJob.h"
+#include "sha1.h"
+#include "a2io.h"
+#ifdef ENABLE_DISK_IO_THREAD
+# include <pthread.h>
+#endif // ENABLE_DISK_IO_THREAD
 
 namespace aria2 {
 
 #define BUFSIZE (256*1024)
 #define ALIGNMENT 512
 
+static unsigned char* allocateBuffer(size_t length = BUFSIZE)
+{
+#ifdef HAVE_POSIX_MEMALIGN
+  return reinterpret_cast<unsigned char*>
+    (util::allocateAlignedMemory(ALIGNMENT, length));
+#else // !HAVE_POSIX_MEMALIGN
+  return new unsigned char[length];
+#endif // !HAVE_POSIX_MEMALIGN
+}
+
+static void freeBuffer(unsigned char* buffer)
+{
+#ifdef HAVE_POSIX_MEMALIGN
+  free(buffer);
+#else // !HAVE_POSIX_MEMALIGN
+  delete [] buffer;
+#endif // !HAVE_POSIX_MEMALIGN
+}
+
+// Reads length bytes at offset through reader using buffer, which
+// must be BUFSIZE bytes long and aligned for direct I/O, and returns
+// the hex digest of them.
+template<typename Reader>
+static std::string digestRange
+(Reader& reader, MessageDigestContext* ctx, unsigned char* buffer,
+ off_t offset, size_t length, const std::string& path)
+{
+  ctx->digestReset();
+  off_t curoffset = offset/ALIGNMENT*ALIGNMENT;
+  off_t max = offset+length;
+  off_t woffset;
+  if(curoffset < offset) {
+    woffset = offset-curoffset;
+  } else {
+    woffset = 0;
+  }
+  while(curoffset < max) {
+    size_t r = reader.readData(buffer, BUFSIZE, curoffset);
+    if(r == 0 || r < static_cast<size_t>(woffset)) {
+      throw DL_ABORT_EX
+        (StringFormat(EX_FILE_READ, path.c_str(),
+                      util::safeStrerror(errno).c_str()).str());
+    }
+    size_t wlength;
+    if(max < static_cast<off_t>(curoffset+r)) {
+      wlength = max-curoffset-woffset;
+    } else {
+      wlength = r-woffset;
+    }
+    ctx->digestUpdate(buffer+woffset, wlength);
+    curoffset += r;
+    woffset = 0;
+  }
+  return util::toHex(ctx->digestFinal());
+}
+
+// Reads exactly length bytes at offset to buffer.
+static void readFully
+(DiskAdaptor& diskAdaptor, unsigned char* buffer, size_t length,
+ off_t offset, const std::string& path)
+{
+  while(length) {
+    ssize_t r = diskAdaptor.readData(buffer, length, offset);
+    if(r <= 0) {
+      throw DL_ABORT_EX
+        (StringFormat(EX_FILE_READ, path.c_str(),
+                      util::safeStrerror(errno).c_str()).str());
+    }
+    buffer += r;
+    length -= r;
+    offset += r;
+  }
+}
+
+// Returns true if length bytes at offset are in a hole of the files,
+// which reads as zeros, so that they need not be read. A range beyond
+// the end of a file is not a hole. Errors are left to the reads.
+static bool isHole(DiskAdaptor& diskAdaptor, off_t offset, size_t length)
+{
+#ifdef SEEK_DATA
+  while(length) {
+    int fd;
+    off_t fileOffset;
+    size_t n;
+    try {
+      n = diskAdaptor.getFileRange(fd, fileOffset, offset, length);
+    } catch(RecoverableException& e) {
+      return false;
+    }
+    if(n == 0) {
+      return false;
+    }
+    a2_struct_stat fstatbuf;
+    if(a2fstat(fd, &fstatbuf) == -1 ||
+       fstatbuf.st_size < static_cast<off_t>(fileOffset+n)) {
+      return false;
+    }
+    off_t dataOffset = a2lseek(fd, fileOffset, SEEK_DATA);
+    if(dataOffset == -1) {
+      // ENXIO means there is no data after fileOffset.
+      if(errno != ENXIO) {
+        return false;
+      }
+    } else if(dataOffset < static_cast<off_t>(fileOffset+n)) {
+      return false;
+    }
+    offset += n;
+    length -= n;
+  }
+  return true;
+#else // !SEEK_DATA
+  return false;
+#endif // !SEEK_DATA
+}
+
+#ifdef ENABLE_DISK_IO_THREAD
+
+// Lets one ChunkJob read at a time, so that the disk is read in
+// order and DiskAdaptor, which is not thread-safe, is used by one
+// thread at a time. Hashing is done outside of the lock. The buffers
+// are reused, so their number is bounded by the number of jobs
+// running at once.
+class IteratableChunkChecksumValidator::Reader {
+private:
+  SharedHandle<DiskAdaptor> diskAdaptor_;
+
+  pthread_mutex_t mutex_;
+
+  // Guarded by mutex_.
+  std::vector<unsigned char*> buffers_;
+public:
+  Reader(const SharedHandle<DiskAdaptor>& diskAdaptor):
+    diskAdaptor_(diskAdaptor)
+  {
+    pthread_mutex_init(&mutex_, 0);
+  }
+
+  ~Reader()
+  {
+    std::for_each(buffers_.begin(), buffers_.end(), freeBuffer);
+    pthread_mutex_destroy(&mutex_);
+  }
+
+  ssize_t readData(unsigned char* data, size_t len, off_t offset)
+  {
+    pthread_mutex_lock(&mutex_);
+    try {
+      ssize_t r = diskAdaptor_->readData(data, len, offset);
+      pthread_mutex_unlock(&mutex_);
+      return r;
+    } catch(...) {
+      pthread_mutex_unlock(&mutex_);
+      throw;
+    }
+  }
+
+  bool isHole(off_t offset, size_t length)
+  {
+    pthread_mutex_lock(&mutex_);
+    bool r = aria2::isHole(*diskAdaptor_.get(), offset, length);
+    pthread_mutex_unlock(&mutex_);
+    return r;
+  }
+
+  unsigned char* getBuffer()
+  {
+    pthread_mutex_lock(&mutex_);
+    unsigned char* buffer = 0;
+    if(!buffers_.empty()) {
+      buffer = buffers_.back();
+      buffers_.pop_back();
+    }
+    pthread_mutex_unlock(&mutex_);
+    if(!buffer) {
+      buffer = allocateBuffer();
+    }
+    return buffer;
+  }
+
+  void putBuffer(unsigned char* buffer)
+  {
+    pthread_mutex_lock(&mutex_);
+    buffers_.push_back(buffer);
+    pthread_mutex_unlock(&mutex_);
+  }
+};
+
+// Computes the hash of one piece in a worker thread.
+class IteratableChunkChecksumValidator::ChunkJob:public DiskIOJob {
+private:
+  SharedHandle<Reader> reader_;
+
+  SharedHandle<MessageDigestContext> ctx_;
+
+  size_t index_;
+
+  off_t offset_;
+
+  size_t length_;
+
+  std::string path_;
+
+  std::string actualChecksum_;
+public:
+  ChunkJob(const SharedHandle<Reader>& reader,
+           const SharedHandle<MessageDigestContext>& ctx,
+           size_t index, off_t offset, size_t length,
+           const std::string& path):
+    reader_(reader), ctx_(ctx), index_(index), offset_(offset),
+    length_(length), path_(path) {}
+
+  virtual void execute()
+  {
+    unsigned char* buffer = reader_->getBuffer();
+    try {
+      actualChecksum_ = digestRange(*reader_.get(), ctx_.get(), buffer,
+                                    offset_, length_, path_);
+    } catch(...) {
+      reader_->putBuffer(buffer);
+      throw;
+    }
+    reader_->putBuffer(buffer);
+  }
+
+  size_t getIndex() const
+  {
+    return index_;
+  }
+
+  off_t getOffset() const
+  {
+    return offset_;
+  }
+
+  const std::string& getActualChecksum() const
+  {
+    return actualChecksum_;
+  }
+};
+
+#endif // ENABLE_DISK_IO_THREAD
+
 IteratableChunkChecksumValidator::
 IteratableChunkChecksumValidator(const SharedHandle<DownloadContext>& dctx,
                                  const PieceStorageHandle& pieceStorage):
@@ -65,75 +315,261 @@ IteratableChunkChecksumValidator(const SharedHandle<DownloadContext>& dctx,
   bitfield_(new BitfieldMan(dctx_->getPieceLength(), dctx_->getTotalLength())),
   currentIndex_(0),
   logger_(LogFactory::getInstance()),
-  buffer_(0) {}
+  buffer_(0),
+  lanes_(1),
+  singleUntil_(0),
+  numChunkJob_(0) {}
 
 IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator()
 {
-#ifdef HAVE_POSIX_MEMALIGN
-  free(buffer_);
-#else // !HAVE_POSIX_MEMALIGN
-  delete [] buffer_;
-#endif // !HAVE_POSIX_MEMALIGN
+  freeBuffer(buffer_);
 }
 
+void IteratableChunkChecksumValidator::updateBitfield
+(size_t index, const std::string& actualChecksum)
+{
+  if(actualChecksum == dctx_->getPieceHashes()[index]) {
+    bitfield_->setBit(index);
+  } else {
+    if(logger_->info()) {
+      logger_->info(EX_INVALID_CHUNK_CHECKSUM,
+                    index,
+                    util::itos((off_t)index*dctx_->getPieceLength(),
+                               true).c_str(),
+                    dctx_->getPieceHashes()[index].c_str(),
+                    actualChecksum.c_str());
+    }
+    bitfield_->unsetBit(index);
+  }
+}
+
+bool IteratableChunkChecksumValidator::skipHole()
+{
+  const size_t length = getChunkLength(currentIndex_);
+#ifdef ENABLE_DISK_IO_THREAD
+  bool hole = reader_.isNull() ?
+    isHole(*pieceStorage_->getDiskAdaptor().get(), getCurrentOffset(), length) :
+    reader_->isHole(getCurrentOffset(), length);
+#else // !ENABLE_DISK_IO_THREAD
+  bool hole =
+    isHole(*pieceStorage_->getDiskAdaptor().get(), getCurrentOffset(), length);
+#endif // !ENABLE_DISK_IO_THREAD
+  if(!hole) {
+    return false;
+  }
+  // Only a piece of zeros can be in a hole. It is not logged as a
+  // checksum error because holes are expected in a file which is not
+  // fully allocated.
+  if(getZeroChecksum(length) == dctx_->getPieceHashes()[currentIndex_]) {
+    bitfield_->setBit(currentIndex_);
+  } else {
+    bitfield_->unsetBit(currentIndex_);
+  }
+  ++currentIndex_;
+  return true;
+}
+
+const std::string&
+IteratableChunkChecksumValidator::getZeroChecksum(size_t length)
+{
+  std::string& checksum =
+    length == dctx_->getPieceLength() ? zeroChecksum_ : lastZeroChecksum_;
+  if(checksum.empty()) {
+    memset(buffer_, 0, BUFSIZE);
+    ctx_->digestReset();
+    for(size_t rem = length; rem > 0;) {
+      size_t n = std::min(rem, static_cast<size_t>(BUFSIZE));
+      ctx_->digestUpdate(buffer_, n);
+      rem -= n;
+    }
+    checksum = util::toHex(ctx_->digestFinal());
+  }
+  return checksum;
+}
 
 void IteratableChunkChecksumValidator::validateChunk()
 {
   if(!finished()) {
-    std::string actualChecksum;
-    try {
-      actualChecksum = calculateActualChecksum();
-      if(actualChecksum == dctx_->getPieceHashes()[currentIndex_]) {
-        bitfield_->setBit(currentIndex_);
-      } else {
-        if(logger_->info()) {
-          logger_->info(EX_INVALID_CHUNK_CHECKSUM,
-                        currentIndex_,
-                        util::itos(getCurrentOffset(), true).c_str(),
-                        dctx_->getPieceHashes()[currentIndex_].c_str(),
-                        actualChecksum.c_str());
+    if(!skipHole() && !validateLanes()) {
+      std::string actualChecksum;
+      try {
+        actualChecksum = calculateActualChecksum();
+        updateBitfield(currentIndex_, actualChecksum);
+      } catch(RecoverableException& ex) {
+        if(logger_->debug()) {
+          logger_->debug("Caught exception while validating piece index=%d."
+                         " Some part of file may be missing."
+                         " Continue operation.",
+                         ex, currentIndex_);
         }
         bitfield_->unsetBit(currentIndex_);
       }
-    } catch(RecoverableException& ex) {
-      if(logger_->debug()) {
-        logger_->debug("Caught exception while validating piece index=%d."
-                       " Some part of file may be missing. Continue operation.",
-                       ex, currentIndex_);
+      ++currentIndex_;
+    }
+    if(finished()) {
+      pieceStorage_->setBitfield(bitfield_->getBitfield(), bitfield_->getBitfieldLength());
+    }
+  }
+}
+
+bool IteratableChunkChecksumValidator::validateLanes()
+{
+  // The last piece may be shorter, so it is always validated alone.
+  if(lanes_ == 1 || currentIndex_ < singleUntil_ ||
+     currentIndex_+lanes_ >= dctx_->getNumPieces()) {
+    return false;
+  }
+  // The pieces in holes are skipped one by one.
+  for(size_t i = 1; i < lanes_; ++i) {
+    if(isHole(*pieceStorage_->getDiskAdaptor().get(),
+              (off_t)(currentIndex_+i)*dctx_->getPieceLength(),
+              dctx_->getPieceLength())) {
+      return false;
+    }
+  }
+  std::vector<std::string> actualChecksums;
+  try {
+    actualChecksums = digestLanes();
+  } catch(RecoverableException& ex) {
+    // Find out which pieces are affected.
+    singleUntil_ = currentIndex_+lanes_;
+    if(logger_->debug()) {
+      logger_->debug("Caught exception while validating pieces index=%d-%d."
+                     " Validate them one by one.",
+                     ex, currentIndex_, singleUntil_-1);
+    }
+    return false;
+  }
+  for(size_t i = 0; i < lanes_; ++i) {
+    updateBitfield(currentIndex_+i, actualChecksums[i]);
+  }
+  currentIndex_ += lanes_;
+  return true;
+}
+
+// Each piece is read into its own part of buffer_, BUFSIZE bytes at a
+// time. If a piece is not longer than BUFSIZE, the pieces are
+// adjacent in the file and buffer_, and they are read at once.
+std::vector<std::string> IteratableChunkChecksumValidator::digestLanes()
+{
+  const SharedHandle<DiskAdaptor>& diskAdaptor =
+    pieceStorage_->getDiskAdaptor();
+  const size_t pieceLength = dctx_->getPieceLength();
+  const size_t step = std::min(pieceLength, static_cast<size_t>(BUFSIZE));
+  const off_t offset = getCurrentOffset();
+  std::vector<sha1::Context> ctxs(lanes_);
+  std::vector<sha1::Context*> ctxptrs(lanes_);
+  std::vector<const unsigned char*> data(lanes_);
+  for(size_t i = 0; i < lanes_; ++i) {
+    sha1::init(ctxs[i]);
+    ctxptrs[i] = &ctxs[i];
+    data[i] = buffer_+i*step;
+  }
+  for(size_t pos = 0; pos < pieceLength; pos += step) {
+    size_t length = std::min(step, pieceLength-pos);
+    if(step == pieceLength) {
+      readFully(*diskAdaptor.get(), buffer_, step*lanes_, offset,
+                dctx_->getBasePath());
+    } else {
+      for(size_t i = 0; i < lanes_; ++i) {
+        readFully(*diskAdaptor.get(), buffer_+i*step, length,
+                  offset+(off_t)i*pieceLength+pos, dctx_->getBasePath());
       }
-      bitfield_->unsetBit(currentIndex_);
     }
+    sha1::update(&ctxptrs[0], &data[0], length, lanes_);
+  }
+  std::vector<std::string> actualChecksums;
+  for(size_t i = 0; i < lanes_; ++i) {
+    unsigned char md[sha1::DIGEST_LENGTH];
+    sha1::final(ctxs[i], md);
+    actualChecksums.push_back(util::toHex(md, sizeof(md)));
+  }
+  return actualChecksums;
+}
 
-    ++currentIndex_;
+#ifdef ENABLE_DISK_IO_THREAD
+
+SharedHandle<DiskIOJob> IteratableChunkChecksumValidator::createChunkJob()
+{
+  if(currentIndex_ >= dctx_->getNumPieces()) {
+    return SharedHandle<DiskIOJob>();
+  }
+  if(reader_.isNull()) {
+    reader_.reset(new Reader(pieceStorage_->getDiskAdaptor()));
+  }
+  while(currentIndex_ < dctx_->getNumPieces() && skipHole());
+  if(currentIndex_ >= dctx_->getNumPieces()) {
     if(finished()) {
-      pieceStorage_->setBitfield(bitfield_->getBitfield(), bitfield_->getBitfieldLength());
+      pieceStorage_->setBitfield(bitfield_->getBitfield(),
+                                 bitfield_->getBitfieldLength());
     }
+    return SharedHandle<DiskIOJob>();
   }
+  SharedHandle<MessageDigestContext> ctx(new MessageDigestContext());
+  ctx->trySetAlgo(dctx_->getPieceHashAlgo());
+  ctx->digestInit();
+  SharedHandle<DiskIOJob> job
+    (new ChunkJob(reader_, ctx, currentIndex_, getCurrentOffset(),
+                  getChunkLength(currentIndex_), dctx_->getBasePath()));
+  ++currentIndex_;
+  ++numChunkJob_;
+  return job;
 }
 
-std::string IteratableChunkChecksumValidator::calculateActualChecksum()
+void IteratableChunkChecksumValidator::finishChunkJob
+(const SharedHandle<DiskIOJob>& job)
+{
+  SharedHandle<ChunkJob> chunkJob = static_pointer_cast<ChunkJob>(job);
+  if(chunkJob->getException().isNull()) {
+    updateBitfield(chunkJob->getIndex(), chunkJob->getActualChecksum());
+  } else {
+    if(logger_->debug()) {
+      logger_->debug("Caught exception while validating piece index=%d."
+                     " Some part of file may be missing. Continue operation.",
+                     *chunkJob->getException().get(), chunkJob->getIndex());
+    }
+    bitfield_->unsetBit(chunkJob->getIndex());
+  }
+  --numChunkJob_;
+  if(finished()) {
+    pieceStorage_->setBitfield(bitfield_->getBitfield(), bitfield_->getBitfieldLength());
+  }
+}
+
+#endif // ENABLE_DISK_IO_THREAD
+
+size_t IteratableChunkChecksumValidator::getChunkLength(size_t index) const
 {
-  off_t offset = getCurrentOffset();
-  size_t length;
   // When validating last piece
-  if(currentIndex_+1 == dctx_->getNumPieces()) {
-    length = dctx_->getTotalLength()-offset;
+  if(index+1 == dctx_->getNumPieces()) {
+    return dctx_->getTotalLength()-(off_t)index*dctx_->getPieceLength();
   } else {
-    length = dctx_->getPieceLength();
+    return dctx_->getPieceLength();
   }
-  return digest(offset, length);
+}
+
+std::string IteratableChunkChecksumValidator::calculateActualChecksum()
+{
+  return digest(getCurrentOffset(), getChunkLength(currentIndex_));
 }
 
 void IteratableChunkChecksumValidator::init()
 {
-#ifdef HAVE_POSIX_MEMALIGN
-  free(buffer_);
-  buffer_ = reinterpret_cast<unsigned char*>
-    (util::allocateAlignedMemory(ALIGNMENT, BUFSIZE));
-#else // !HAVE_POSIX_MEMALIGN
-  delete [] buffer_;
-  buffer_ = new unsigned char[BUFSIZE];
-#endif // !HAVE_POSIX_MEMALIGN
+  // SHA-1 pieces are hashed in the lanes of the multi-buffer kernel if
+  // the CPU has one. The reads must stay aligned for direct I/O.
+  if(sha1::getLanes() > 1 &&
+     MessageDigestContext::getCanonicalAlgo(dctx_->getPieceHashAlgo()) ==
+     MessageDigestContext::SHA1 &&
+     dctx_->getPieceLength()%ALIGNMENT == 0) {
+    lanes_ = sha1::getLanes();
+  } else {
+    lanes_ = 1;
+  }
+  singleUntil_ = 0;
+  zeroChecksum_.clear();
+  lastZeroChecksum_.clear();
+  freeBuffer(buffer_);
+  buffer_ = allocateBuffer(BUFSIZE*lanes_);
   if(dctx_->getFileEntries().size() == 1) {
     pieceStorage_->getDiskAdaptor()->enableDirectIO();
   }
@@ -142,44 +578,21 @@ void IteratableChunkChecksumValidator::init()
   ctx_->digestInit();
   bitfield_->clearAllBit();
   currentIndex_ = 0;
+#ifdef ENABLE_DISK_IO_THREAD
+  reader_.reset();
+#endif // ENABLE_DISK_IO_THREAD
 }
 
 std::string IteratableChunkChecksumValidator::digest(off_t offset, size_t length)
 {
-  ctx_->digestReset();
-  off_t curoffset = offset/ALIGNMENT*ALIGNMENT;
-  off_t max = offset+length;
-  off_t woffset;
-  if(curoffset < offset) {
-    woffset = offset-curoffset;
-  } else {
-    woffset = 0;
-  }
-  while(curoffset < max) {
-    size_t r = pieceStorage_->getDiskAdaptor()->readData(buffer_, BUFSIZE,
-                                                         curoffset);
-    if(r == 0 || r < static_cast<size_t>(woffset)) {
-      throw DL_ABORT_EX
-        (StringFormat(EX_FILE_READ, dctx_->getBasePath().c_str(),
-                      strerror(errno)).str());
-    }
-    size_t wlength;
-    if(max < static_cast<off_t>(curoffset+r)) {
-      wlength = max-curoffset-woffset;
-    } else {
-      wlength = r-woffset;
-    }
-    ctx_->digestUpdate(buffer_+woffset, wlength);
-    curoffset += r;
-    woffset = 0;
-  }
-  return util::toHex(ctx_->digestFinal());
+  return digestRange(*pieceStorage_->getDiskAdaptor().get(), ctx_.get(),
+                     buffer_, offset, length, dctx_->getBasePath());
 }
 
 
 bool IteratableChunkChecksumValidator::finished() const
 {
-  if(currentIndex_ >= dctx_->getNumPieces()) {
+  if(currentIndex_ >= dctx_->getNumPieces() && numChunkJob_ == 0) {
     pieceStorage_->getDiskAdaptor()->disableDirectIO();
     return true;
   } else {
@@ -37,6 +37,9 @@
 
 #include "IteratableValidator.h"
 
+#include <string>
+#include <vector>
+
 namespace aria2 {
 
 class DownloadContext;
@@ -55,11 +58,43 @@ private:
   Logger* logger_;
   SharedHandle<MessageDigestContext> ctx_;
   unsigned char* buffer_;
+  // The number of pieces hashed at once by validateChunk().
+  size_t lanes_;
+  // Pieces before this index are validated one by one.
+  size_t singleUntil_;
+  // The checksums of a piece of zeros and of a last piece of zeros.
+  // Empty until they are needed.
+  std::string zeroChecksum_;
+  std::string lastZeroChecksum_;
+#ifdef ENABLE_DISK_IO_THREAD
+  class Reader;
+  class ChunkJob;
+
+  // Shared by the jobs created by createChunkJob().
+  SharedHandle<Reader> reader_;
+#endif // ENABLE_DISK_IO_THREAD
+  // The number of jobs created by createChunkJob() and not finished
+  // yet.
+  size_t numChunkJob_;
 
   std::string calculateActualChecksum();
 
   std::string digest(off_t offset, size_t length);
 
+  // Validates the current piece without reading it if it is in a
+  // hole of the file. Returns true if it did.
+  bool skipHole();
+
+  const std::string& getZeroChecksum(size_t length);
+
+  bool validateLanes();
+
+  std::vector<std::string> digestLanes();
+
+  size_t getChunkLength(size_t index) const;
+
+  void updateBitfield(size_t index, const std::string& actualChecksum);
+
 public:
   IteratableChunkChecksumValidator(const SharedHandle<DownloadContext>& dctx,
                                    const SharedHandle<PieceStorage>& pieceStorage);
@@ -75,6 +110,19 @@ public:
   virtual off_t getCurrentOffset() const;
 
   virtual uint64_t getTotalLength() const;
+
+#ifdef ENABLE_DISK_IO_THREAD
+  // Pieces are hashed concurrently while the disk is read by one job
+  // at a time.
+  virtual bool concurrent() const
+  {
+    return true;
+  }
+
+  virtual SharedHandle<DiskIOJob> createChunkJob();
+
+  virtual void finishChunkJob(const SharedHandle<DiskIOJob>& job);
+#endif // ENABLE_DISK_IO_THREAD
 };
 
 typedef SharedHandle<IteratableChunkChecksumValidator> IteratableChunkChecksumValidatorHandle;
@@ -41,6 +41,8 @@
 
 namespace aria2 {
 
+class DiskIOJob;
+
 /**
  * This class provides the interface to validate files.
  *
@@ -48,6 +50,11 @@ namespace aria2 {
  * Then, call validateChunk() until finished() returns true.
  * The progress information is available using getCurrentOffset() and
  * getTotalLength().
+ *
+ * If concurrent() returns true, the chunks can be validated in
+ * DiskIOThreadPool instead: call createChunkJob() to get the jobs and
+ * pass each finished job to finishChunkJob() until finished() returns
+ * true.
  */
 class IteratableValidator
 {
@@ -63,6 +70,22 @@ public:
   virtual off_t getCurrentOffset() const = 0;
 
   virtual uint64_t getTotalLength() const = 0;
+
+  virtual bool concurrent() const
+  {
+    return false;
+  }
+
+  // Returns the job which validates the next chunk in a worker
+  // thread. If all chunks are already handed out, returns null
+  // handle.
+  virtual SharedHandle<DiskIOJob> createChunkJob()
+  {
+    return SharedHandle<DiskIOJob>();
+  }
+
+  // Applies the result of the job returned by createChunkJob().
+  virtual void finishChunkJob(const SharedHandle<DiskIOJob>& job) {}
 };
 
 typedef SharedHandle<IteratableValidator> IteratableValidatorHandle;
@@ -0,0 +1,97 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "LazyFileAllocator.h"
+
+#include <algorithm>
+
+#include "DiskAdaptor.h"
+#include "FileEntry.h"
+#include "BitfieldMan.h"
+#include "RecoverableException.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+
+namespace aria2 {
+
+LazyFileAllocator::LazyFileAllocator
+(const SharedHandle<DiskAdaptor>& diskAdaptor, const BitfieldMan* bitfieldMan,
+ size_t batchLength):
+  diskAdaptor_(diskAdaptor),
+  bitfieldMan_(bitfieldMan),
+  piecesPerBatch_(std::max(static_cast<size_t>(1),
+                           batchLength/bitfieldMan->getBlockLength())),
+  batches_(new BitfieldMan(piecesPerBatch_*bitfieldMan->getBlockLength(),
+                           bitfieldMan->getTotalLength())),
+  enabled_(true),
+  logger_(LogFactory::getInstance()) {}
+
+void LazyFileAllocator::reserve(size_t index)
+{
+  size_t batch = index/piecesPerBatch_;
+  if(!enabled_ || batches_->isBitSet(batch)) {
+    return;
+  }
+  batches_->setBit(batch);
+  size_t first = batch*piecesPerBatch_;
+  size_t last = std::min(first+piecesPerBatch_, bitfieldMan_->countBlock());
+  for(size_t i = first; i < last; ++i) {
+    if(bitfieldMan_->isBitSet(i)) {
+      return;
+    }
+  }
+  off_t offset = (off_t)batch*batches_->getBlockLength();
+  uint64_t length = batches_->getBlockLength(batch);
+  if(logger_->debug()) {
+    logger_->debug("Allocating pieces %lu-%lu, offset=%s, length=%s",
+                   static_cast<unsigned long>(first),
+                   static_cast<unsigned long>(last-1),
+                   util::itos(offset).c_str(), util::uitos(length).c_str());
+  }
+  try {
+    diskAdaptor_->allocate(offset, length);
+  } catch(RecoverableException& e) {
+    logger_->info("Lazy file allocation failed. The rest of the file is"
+                  " not allocated.", e);
+    enabled_ = false;
+  }
+}
+
+bool LazyFileAllocator::isAllocated(size_t index) const
+{
+  return batches_->isBitSet(index/piecesPerBatch_);
+}
+
+} // namespace aria2
@@ -0,0 +1,99 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_LAZY_FILE_ALLOCATOR_H_
+#define _D_LAZY_FILE_ALLOCATOR_H_
+
+#include "common.h"
+#include "SharedHandle.h"
+
+namespace aria2 {
+
+class DiskAdaptor;
+class BitfieldMan;
+class Logger;
+
+// Allocates the space of a download while it is downloaded, which is
+// --file-allocation=lazy. The pieces are grouped into batches of
+// about BATCH_LENGTH bytes, and a batch is allocated at once when one
+// of its pieces is checked out for the first time. So the download
+// starts without waiting for allocation, and the file is still laid
+// out in large extents.
+class LazyFileAllocator {
+private:
+  SharedHandle<DiskAdaptor> diskAdaptor_;
+
+  // The pieces which have been downloaded.
+  const BitfieldMan* bitfieldMan_;
+
+  size_t piecesPerBatch_;
+
+  // A bit is set for each batch which is known to be allocated.
+  SharedHandle<BitfieldMan> batches_;
+
+  // False after the allocation failed, for example, because the file
+  // system does not support it.
+  bool enabled_;
+
+  Logger* logger_;
+public:
+  static const size_t BATCH_LENGTH = 16*1024*1024;
+
+  // A batch has batchLength/pieceLength pieces, at least one.
+  LazyFileAllocator(const SharedHandle<DiskAdaptor>& diskAdaptor,
+                    const BitfieldMan* bitfieldMan,
+                    size_t batchLength = BATCH_LENGTH);
+
+  // Allocates the batch which contains the piece index unless it is
+  // allocated already. A batch which has a downloaded piece was
+  // allocated before the download was resumed and is left alone. If
+  // allocation fails, it is logged and not tried again.
+  void reserve(size_t index);
+
+  bool isAllocated(size_t index) const;
+
+  bool isEnabled() const
+  {
+    return enabled_;
+  }
+
+  size_t getPiecesPerBatch() const
+  {
+    return piecesPerBatch_;
+  }
+};
+
+} // namespace aria2
+
+#endif // _D_LAZY_FILE_ALLOCATOR_H_
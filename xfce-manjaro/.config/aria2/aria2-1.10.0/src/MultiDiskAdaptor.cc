@@ -387,13 +387,69 @@ static void throwOnDiskWriterNotOpened(const SharedHandle<DiskWriterEntry>& e,
                   e->getFilePath().c_str()).str());  
 }
 
+// Stores the buffers in iov which cover the next len bytes in out.
+// iovpos and bufpos point to the current position in iov and they are
+// advanced by len bytes.
+static void sliceIovec
+(std::vector<struct iovec>& out, const struct iovec* iov,
+ int& iovpos, size_t& bufpos, size_t len)
+{
+  out.clear();
+  while(len > 0) {
+    size_t n = std::min(len, iov[iovpos].iov_len-bufpos);
+    if(n > 0) {
+      struct iovec v;
+      v.iov_base = reinterpret_cast<char*>(iov[iovpos].iov_base)+bufpos;
+      v.iov_len = n;
+      out.push_back(v);
+      len -= n;
+      bufpos += n;
+    }
+    if(bufpos == iov[iovpos].iov_len) {
+      ++iovpos;
+      bufpos = 0;
+    }
+  }
+}
+
+static size_t totalLength(const struct iovec* iov, int iovcnt)
+{
+  size_t len = 0;
+  for(int i = 0; i < iovcnt; ++i) {
+    len += iov[i].iov_len;
+  }
+  return len;
+}
+
 void MultiDiskAdaptor::writeData(const unsigned char* data, size_t len,
                                  off_t offset)
+{
+  struct iovec iov;
+  iov.iov_base = const_cast<unsigned char*>(data);
+  iov.iov_len = len;
+  writeDataVec(&iov, 1, offset);
+}
+
+ssize_t MultiDiskAdaptor::readData
+(unsigned char* data, size_t len, off_t offset)
+{
+  struct iovec iov;
+  iov.iov_base = data;
+  iov.iov_len = len;
+  return readDataVec(&iov, 1, offset);
+}
+
+void MultiDiskAdaptor::writeDataVec
+(const struct iovec* iov, int iovcnt, off_t offset)
 {
   DiskWriterEntries::const_iterator first =
     findFirstDiskWriterEntry(diskWriterEntries_, offset);
 
+  size_t len = totalLength(iov, iovcnt);
   size_t rem = len;
+  int iovpos = 0;
+  size_t bufpos = 0;
+  std::vector<struct iovec> vec;
   off_t fileOffset = offset-(*first)->getFileEntry()->getOffset();
   for(DiskWriterEntries::const_iterator i = first,
         eoi = diskWriterEntries_.end(); i != eoi; ++i) {
@@ -405,7 +461,10 @@ void MultiDiskAdaptor::writeData(const unsigned char* data, size_t len,
       throwOnDiskWriterNotOpened(*i, offset+(len-rem));
     }
 
-    (*i)->getDiskWriter()->writeData(data+(len-rem), writeLength, fileOffset);
+    sliceIovec(vec, iov, iovpos, bufpos, writeLength);
+    if(!vec.empty()) {
+      (*i)->getDiskWriter()->writeDataVec(&vec[0], vec.size(), fileOffset);
+    }
     rem -= writeLength;
     fileOffset = 0;
     if(rem == 0) {
@@ -414,14 +473,18 @@ void MultiDiskAdaptor::writeData(const unsigned char* data, size_t len,
   }
 }
 
-ssize_t MultiDiskAdaptor::readData
-(unsigned char* data, size_t len, off_t offset)
+ssize_t MultiDiskAdaptor::readDataVec
+(const struct iovec* iov, int iovcnt, off_t offset)
 {
   DiskWriterEntries::const_iterator first =
     findFirstDiskWriterEntry(diskWriterEntries_, offset);
 
+  size_t len = totalLength(iov, iovcnt);
   size_t rem = len;
   size_t totalReadLength = 0;
+  int iovpos = 0;
+  size_t bufpos = 0;
+  std::vector<struct iovec> vec;
   off_t fileOffset = offset-(*first)->getFileEntry()->getOffset();
   for(DiskWriterEntries::const_iterator i = first,
         eoi = diskWriterEntries_.end(); i != eoi; ++i) {
@@ -433,8 +496,11 @@ ssize_t MultiDiskAdaptor::readData
       throwOnDiskWriterNotOpened(*i, offset+(len-rem));
     }
 
-    totalReadLength +=
-      (*i)->getDiskWriter()->readData(data+(len-rem), readLength, fileOffset);
+    sliceIovec(vec, iov, iovpos, bufpos, readLength);
+    if(!vec.empty()) {
+      totalReadLength +=
+        (*i)->getDiskWriter()->readDataVec(&vec[0], vec.size(), fileOffset);
+    }
     rem -= readLength;
     fileOffset = 0;
     if(rem == 0) {
@@ -444,6 +510,45 @@ ssize_t MultiDiskAdaptor::readData
   return totalReadLength;
 }
 
+void MultiDiskAdaptor::allocate(off_t offset, uint64_t length)
+{
+  DiskWriterEntries::const_iterator first =
+    findFirstDiskWriterEntry(diskWriterEntries_, offset);
+  uint64_t rem = length;
+  off_t fileOffset = offset-(*first)->getFileEntry()->getOffset();
+  for(DiskWriterEntries::const_iterator i = first,
+        eoi = diskWriterEntries_.end(); i != eoi && rem > 0; ++i) {
+    uint64_t allocLength =
+      std::min(rem, (*i)->getFileEntry()->getLength()-fileOffset);
+    if((*i)->needsFileAllocation() && allocLength > 0) {
+      openIfNot(*i, &DiskWriterEntry::openFile);
+      if(!(*i)->isOpen()) {
+        throwOnDiskWriterNotOpened(*i, offset+(length-rem));
+      }
+      (*i)->getDiskWriter()->allocate(fileOffset, allocLength);
+    }
+    rem -= allocLength;
+    fileOffset = 0;
+  }
+}
+
+size_t MultiDiskAdaptor::getFileRange
+(int& fd, off_t& fileOffset, off_t offset, size_t len)
+{
+  DiskWriterEntries::const_iterator i =
+    findFirstDiskWriterEntry(diskWriterEntries_, offset);
+  openIfNot(*i, &DiskWriterEntry::openFile);
+  if(!(*i)->isOpen()) {
+    return 0;
+  }
+  fd = (*i)->getDiskWriter()->getFd();
+  if(fd == -1) {
+    return 0;
+  }
+  fileOffset = offset-(*i)->getFileEntry()->getOffset();
+  return calculateLength(*i, fileOffset, len);
+}
+
 bool MultiDiskAdaptor::fileExists()
 {
   return std::find_if(getFileEntries().begin(), getFileEntries().end(),
@@ -151,10 +151,21 @@ public:
 
   virtual ssize_t readData(unsigned char* data, size_t len, off_t offset);
 
+  virtual void writeDataVec(const struct iovec* iov, int iovcnt, off_t offset);
+
+  virtual ssize_t readDataVec(const struct iovec* iov, int iovcnt, off_t offset);
+
+  virtual size_t getFileRange
+  (int& fd, off_t& fileOffset, off_t offset, size_t len);
+
   virtual bool fileExists();
 
   virtual uint64_t size();
 
+  // Allocates the part of the range which belongs to the files
+  // needing file allocation. The other files are not created.
+  virtual void allocate(off_t offset, uint64_t length);
+
   virtual SharedHandle<FileAllocationIterator> fileAllocationIterator();
 
   virtual void enableDirectIO();
@@ -42,6 +42,9 @@
 #include "help_tags.h"
 #include "StringFormat.h"
 #include "File.h"
+#ifdef ENABLE_DISK_IO_THREAD
+# include "DiskIOThreadPool.h"
+#endif // ENABLE_DISK_IO_THREAD
 
 namespace aria2 {
 
@@ -183,6 +186,28 @@ OptionHandlers OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    SharedHandle<OptionHandler> op(new UnitNumberOptionHandler
+                                   (PREF_DISK_CACHE,
+                                    TEXT_DISK_CACHE,
+                                    "16M",
+                                    0));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_FILE);
+    handlers.push_back(op);
+  }
+#ifdef ENABLE_DISK_IO_THREAD
+  {
+    SharedHandle<OptionHandler> op(new NumberOptionHandler
+                                   (PREF_DISK_IO_THREADS,
+                                    TEXT_DISK_IO_THREADS,
+                                    util::uitos
+                                    (DiskIOThreadPool::getDefaultNumThread()),
+                                    0, 16));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+#endif // ENABLE_DISK_IO_THREAD
   {
     SharedHandle<NumberOptionHandler> op(new NumberOptionHandler
                                          (PREF_DNS_TIMEOUT,
@@ -220,6 +245,9 @@ OptionHandlers OptionHandlerFactory::createOptionHandlers()
 #ifdef HAVE_EPOLL
       V_EPOLL,
 #endif // HAVE_EPOLL
+#ifdef HAVE_IO_URING
+      V_IO_URING,
+#endif // HAVE_IO_URING
 #ifdef HAVE_KQUEUE
       V_KQUEUE,
 #endif // HAVE_KQUEUE
@@ -249,14 +277,18 @@ OptionHandlers OptionHandlerFactory::createOptionHandlers()
     handlers.push_back(op);
   }
   {
+    std::string params[] = {
+      V_NONE, V_PREALLOC,
+#ifdef HAVE_SOME_FALLOCATE
+      V_FALLOC, V_LAZY,
+#endif // HAVE_SOME_FALLOCATE
+    };
     SharedHandle<OptionHandler> op(new ParameterOptionHandler
                                    (PREF_FILE_ALLOCATION,
                                     TEXT_FILE_ALLOCATION,
                                     V_PREALLOC,
-                                    V_NONE, V_PREALLOC,
-#ifdef HAVE_SOME_FALLOCATE
-                                    V_FALLOC,
-#endif // HAVE_SOME_FALLOCATE
+                                    std::vector<std::string>
+                                    (vbegin(params), vend(params)),
                                     'a'));
     op->addTag(TAG_BASIC);
     op->addTag(TAG_FILE);
@@ -66,7 +66,8 @@ PeerAbstractCommand::PeerAbstractCommand(cuid_t cuid,
   peer_(peer),
   checkSocketIsReadable_(false),
   checkSocketIsWritable_(false),
-  noCheck_(false)
+  noCheck_(false),
+  eventReceived_(false)
 {
   if(!socket_.isNull() && socket_->isOpen()) {
     setReadCheckSocket(socket_);
@@ -94,10 +95,11 @@ bool PeerAbstractCommand::execute()
     return true;
   }
   try {
-    if(noCheck_ ||
-       (checkSocketIsReadable_ && readEventEnabled()) ||
-       (checkSocketIsWritable_ && writeEventEnabled()) ||
-       hupEventEnabled()) {
+    eventReceived_ = noCheck_ ||
+      (checkSocketIsReadable_ && readEventEnabled()) ||
+      (checkSocketIsWritable_ && writeEventEnabled()) ||
+      hupEventEnabled();
+    if(eventReceived_) {
       checkPoint_ = global::wallclock;
     } else if(errorEventEnabled()) {
       throw DL_ABORT_EX
@@ -199,6 +201,13 @@ void PeerAbstractCommand::updateKeepAlive()
   checkPoint_ = global::wallclock;
 }
 
+void PeerAbstractCommand::sleepUntilTimeout()
+{
+  if(!eventReceived_ && !noCheck_) {
+    setWakeupTime(checkPoint_.getTime()+timeout_);
+  }
+}
+
 void PeerAbstractCommand::createSocket()
 {
   socket_.reset(new SocketCore());
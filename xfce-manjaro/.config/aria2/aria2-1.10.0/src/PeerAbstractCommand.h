@@ -59,6 +59,9 @@ private:
   SharedHandle<SocketCore> readCheckTarget_;
   SharedHandle<SocketCore> writeCheckTarget_;
   bool noCheck_;
+  // True if this execution has an event to process, or noCheck_ is
+  // set.
+  bool eventReceived_;
 protected:
   DownloadEngine* getDownloadEngine() const
   {
@@ -91,6 +94,12 @@ protected:
   void disableWriteCheckSocket();
   void setNoCheck(bool check);
   void updateKeepAlive();
+  // Makes this command sleep in the timer wheel of DownloadEngine until
+  // it times out or an event arrives, if this execution had no event
+  // to process and noCheck is not set. Call this right before DownloadEngine::addCommand(this)
+  // only if the execution made no progress, so that executing the
+  // command again without an event would not make progress either.
+  void sleepUntilTimeout();
 public:
   PeerAbstractCommand(cuid_t cuid,
                       const SharedHandle<Peer>& peer,
@@ -40,6 +40,7 @@
 #include <string>
 
 #include "TimerA2.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -52,7 +53,7 @@ private:
   Timer lastUpdated_;
 public:
   PeerAddrEntry
-  (const std::string& ipaddr, uint16_t port, Timer updated = Timer()):
+  (const std::string& ipaddr, uint16_t port, Timer updated = global::wallclock):
     ipaddr_(ipaddr), port_(port), lastUpdated_(updated) {}
 
   const std::string& getIPAddress() const
@@ -72,7 +73,7 @@ public:
 
   void notifyUpdate()
   {
-    lastUpdated_.reset();
+    lastUpdated_ = global::wallclock;
   }
 
   bool operator==(const PeerAddrEntry& entry) const
@@ -57,33 +57,49 @@ PeerConnection::PeerConnection(cuid_t cuid, const SocketHandle& socket)
   :cuid_(cuid),
    socket_(socket),
    logger_(LogFactory::getInstance()),
-   resbuf_(new unsigned char[MAX_PAYLOAD_LEN]),
+   resbuf_(BufferPool::getInstance()->allocate()),
    resbufLength_(0),
    currentPayloadLength_(0),
    lenbufLength_(0),
    socketBuffer_(socket),
    encryptionEnabled_(false),
    prevPeek_(false)
-{}
+{
+  assert(MAX_PAYLOAD_LEN <= BufferPool::getInstance()->getBlockSize());
+}
 
 PeerConnection::~PeerConnection()
 {
-  delete [] resbuf_;
+  BufferPool::getInstance()->deallocate(resbuf_);
 }
 
-void PeerConnection::pushStr(const std::string& data)
+void PeerConnection::pushEncryptedBytes(const unsigned char* data, size_t len)
 {
-  if(encryptionEnabled_) {
-    const size_t len = data.size();
-    unsigned char* chunk = new unsigned char[len];
-    try {
-      encryptor_->encrypt
-        (chunk, len, reinterpret_cast<const unsigned char*>(data.data()), len);
-    } catch(RecoverableException& e) {
+  const SharedHandle<BufferPool>& pool = BufferPool::getInstance();
+  bool pooled = len <= pool->getBlockSize();
+  unsigned char* chunk = pooled ? pool->allocate() : new unsigned char[len];
+  try {
+    encryptor_->encrypt(chunk, len, data, len);
+  } catch(RecoverableException& e) {
+    if(pooled) {
+      pool->deallocate(chunk);
+    } else {
       delete [] chunk;
-      throw;
     }
+    throw;
+  }
+  if(pooled) {
+    socketBuffer_.pushPooledBytes(chunk, len);
+  } else {
     socketBuffer_.pushBytes(chunk, len);
+  }
+}
+
+void PeerConnection::pushStr(const std::string& data)
+{
+  if(encryptionEnabled_) {
+    pushEncryptedBytes
+      (reinterpret_cast<const unsigned char*>(data.data()), data.size());
   } else {
     socketBuffer_.pushStr(data);
   }
@@ -92,21 +108,33 @@ void PeerConnection::pushStr(const std::string& data)
 void PeerConnection::pushBytes(unsigned char* data, size_t len)
 {
   if(encryptionEnabled_) {
-    unsigned char* chunk = new unsigned char[len];
     try {
-      encryptor_->encrypt(chunk, len, data, len);
+      pushEncryptedBytes(data, len);
     } catch(RecoverableException& e) {
       delete [] data;
-      delete [] chunk;
       throw;
     }
     delete [] data;
-    socketBuffer_.pushBytes(chunk, len);
   } else {
     socketBuffer_.pushBytes(data, len);
   }
 }
 
+void PeerConnection::pushPooledBytes(unsigned char* data, size_t len)
+{
+  if(encryptionEnabled_) {
+    try {
+      pushEncryptedBytes(data, len);
+    } catch(RecoverableException& e) {
+      BufferPool::getInstance()->deallocate(data);
+      throw;
+    }
+    BufferPool::getInstance()->deallocate(data);
+  } else {
+    socketBuffer_.pushPooledBytes(data, len);
+  }
+}
+
 bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength) {
   if(resbufLength_ == 0 && 4 > lenbufLength_) {
     if(!socket_->isReadable(0)) {
@@ -264,6 +292,14 @@ bool PeerConnection::sendBufferIsEmpty() const
   return socketBuffer_.sendBufferIsEmpty();
 }
 
+ssize_t PeerConnection::sendFile(int fd, off_t offset, size_t len)
+{
+  if(encryptionEnabled_ || !socketBuffer_.sendBufferIsEmpty()) {
+    return 0;
+  }
+  return socketBuffer_.sendFile(fd, offset, len);
+}
+
 ssize_t PeerConnection::sendPendingData()
 {
   ssize_t writtenLength = socketBuffer_.send();
@@ -41,6 +41,7 @@
 
 #include "SharedHandle.h"
 #include "SocketBuffer.h"
+#include "BufferPool.h"
 #include "Command.h"
 
 namespace aria2 {
@@ -76,6 +77,10 @@ private:
 
   void readData(unsigned char* data, size_t& length, bool encryption);
 
+  // Encrypts len bytes of data and pushes the result into send
+  // buffer. data is not deleted.
+  void pushEncryptedBytes(const unsigned char* data, size_t len);
+
   ssize_t sendData(const unsigned char* data, size_t length, bool encryption);
 
 public:
@@ -87,6 +92,10 @@ public:
   // ownership of data, so caller must not delete or alter it.
   void pushBytes(unsigned char* data, size_t len);
 
+  // Same as pushBytes() but data must be allocated by
+  // BufferPool::getInstance().
+  void pushPooledBytes(unsigned char* data, size_t len);
+
   void pushStr(const std::string& data);
 
   bool receiveMessage(unsigned char* data, size_t& dataLength);
@@ -109,15 +118,23 @@ public:
   
   ssize_t sendPendingData();
 
+  // Sends up to len bytes of the file fd starting at offset without
+  // copying them into user space. Returns the number of bytes
+  // sent. Returns 0 and sends nothing if encryption is enabled or
+  // there is pending data to send.
+  ssize_t sendFile(int fd, off_t offset, size_t len);
+
   const unsigned char* getBuffer() const
   {
     return resbuf_;
   }
 
+  // Returns the receive buffer and replaces it with a new one. The
+  // returned buffer is allocated by BufferPool::getInstance().
   unsigned char* detachBuffer()
   {
     unsigned char* detachbuf = resbuf_;
-    resbuf_ = new unsigned char[MAX_PAYLOAD_LEN];
+    resbuf_ = BufferPool::getInstance()->allocate();
     return detachbuf;
   }
 };
@@ -246,6 +246,7 @@ PeerInteractionCommand::~PeerInteractionCommand() {
 
 bool PeerInteractionCommand::executeInternal() {
   setNoCheck(false);
+  Seq prevSequence = sequence_;
   switch(sequence_) {
   case INITIATOR_SEND_HANDSHAKE:
     if(!getSocket()->isWritable(0)) {
@@ -315,6 +316,12 @@ bool PeerInteractionCommand::executeInternal() {
   if(btInteractive_->countPendingMessage() > 0) {
     setNoCheck(true);
   }
+  // Once wired, doInteractionProcessing() has periodic work to do,
+  // such as choking, HAVE and keep-alive messages, so the command
+  // keeps waking up on each refresh.
+  if(sequence_ != WIRED && sequence_ == prevSequence) {
+    sleepUntilTimeout();
+  }
   getDownloadEngine()->addCommand(this);
   return false;
 }
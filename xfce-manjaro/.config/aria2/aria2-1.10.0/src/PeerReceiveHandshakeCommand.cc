@@ -153,6 +153,7 @@ bool PeerReceiveHandshakeCommand::executeInternal()
     }
     return true;
   } else {
+    sleepUntilTimeout();
     getDownloadEngine()->addCommand(this);
     return false;
   }
@@ -37,7 +37,7 @@
 
 #include "common.h"
 
-#include <deque>
+#include <list>
 #include <vector>
 
 #include "SharedHandle.h"
@@ -65,7 +65,7 @@ public:
   /**
    * Returns internal peer list.
    */
-  virtual const std::deque<SharedHandle<Peer> >& getPeers() = 0;
+  virtual const std::list<SharedHandle<Peer> >& getPeers() = 0;
 
   /**
    * Returns one of the unused peers.
@@ -97,6 +97,14 @@ public:
    */
   virtual void returnPeer(const SharedHandle<Peer>& peer) = 0;
 
+  /**
+   * Changes the port of peer to port, which peer told us after the
+   * connection was established. Use this function instead of
+   * Peer::setPort() so that the peer can still be found by its
+   * address and port.
+   */
+  virtual void updatePeerPort(const SharedHandle<Peer>& peer, uint16_t port) = 0;
+
   virtual bool chokeRoundIntervalElapsed() = 0;
 
   virtual void executeChoke() = 0;
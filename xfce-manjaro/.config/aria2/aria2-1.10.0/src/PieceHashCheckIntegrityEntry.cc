@@ -35,6 +35,7 @@
 #include "PieceHashCheckIntegrityEntry.h"
 #include "RequestGroup.h"
 #include "IteratableChunkChecksumValidator.h"
+#include "DiskIOJob.h"
 #include "DownloadContext.h"
 #include "PieceStorage.h"
 
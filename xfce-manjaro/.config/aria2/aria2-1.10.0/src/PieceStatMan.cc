@@ -71,7 +71,8 @@ public:
 
 PieceStatMan::PieceStatMan(size_t pieceNum, bool randomShuffle):
   pieceStats_(pieceNum),
-  sortedPieceStatIndexes_(pieceNum)
+  sortedPieceStatIndexes_(pieceNum),
+  bucketStarts_(1, 0)
 {
   std::generate(pieceStats_.begin(), pieceStats_.end(), GenPieceStat());
   std::vector<SharedHandle<PieceStat> > sortedPieceStats(pieceStats_);
@@ -91,31 +92,65 @@ PieceStatMan::PieceStatMan(size_t pieceNum, bool randomShuffle):
   }  
 }
 
-class PieceStatRarer {
-private:
-  const std::vector<SharedHandle<PieceStat> >& pieceStats_;
-public:
-  PieceStatRarer(const std::vector<SharedHandle<PieceStat> >& ps):
-    pieceStats_(ps) {}
+void PieceStatMan::swapOrder(size_t order1, size_t order2)
+{
+  if(order1 == order2) {
+    return;
+  }
+  size_t index1 = sortedPieceStatIndexes_[order1];
+  size_t index2 = sortedPieceStatIndexes_[order2];
+  sortedPieceStatIndexes_[order1] = index2;
+  sortedPieceStatIndexes_[order2] = index1;
+  pieceStats_[index1]->setOrder(order2);
+  pieceStats_[index2]->setOrder(order1);
+}
 
-  bool operator()(size_t lhs, size_t rhs) const
-  {
-    return pieceStats_[lhs] < pieceStats_[rhs];
+void PieceStatMan::addCount(size_t index)
+{
+  const SharedHandle<PieceStat>& pieceStat = pieceStats_[index];
+  size_t count = pieceStat->getCount();
+  if(count == SIZE_MAX) {
+    return;
   }
-};
+  if(count+1 == bucketStarts_.size()) {
+    bucketStarts_.push_back(sortedPieceStatIndexes_.size());
+  }
+  // Move the piece to the last position of its bucket, which becomes
+  // the first position of the next bucket.
+  size_t last = --bucketStarts_[count+1];
+  swapOrder(pieceStat->getOrder(), last);
+  pieceStat->addCount();
+}
+
+void PieceStatMan::subCount(size_t index)
+{
+  const SharedHandle<PieceStat>& pieceStat = pieceStats_[index];
+  size_t count = pieceStat->getCount();
+  if(count == 0) {
+    return;
+  }
+  // Move the piece to the first position of its bucket, which becomes
+  // the last position of the previous bucket.
+  size_t first = bucketStarts_[count]++;
+  swapOrder(pieceStat->getOrder(), first);
+  pieceStat->subCount();
+}
 
 void PieceStatMan::addPieceStats(const unsigned char* bitfield,
                                  size_t bitfieldLength)
 {
   const size_t nbits = pieceStats_.size();
   assert(nbits <= bitfieldLength*8);
-  for(size_t i = 0; i < nbits; ++i) {
-    if(bitfield::test(bitfield, nbits, i)) {
-      pieceStats_[i]->addCount();
+  for(size_t i = 0, len = (nbits+7)/8; i < len; ++i) {
+    if(bitfield[i] == 0) {
+      continue;
+    }
+    for(size_t j = i*8, end = std::min(j+8, nbits); j < end; ++j) {
+      if(bitfield::test(bitfield, nbits, j)) {
+        addCount(j);
+      }
     }
   }
-  std::sort(sortedPieceStatIndexes_.begin(), sortedPieceStatIndexes_.end(),
-            PieceStatRarer(pieceStats_));
 }
 
 void PieceStatMan::subtractPieceStats(const unsigned char* bitfield,
@@ -123,13 +158,16 @@ void PieceStatMan::subtractPieceStats(const unsigned char* bitfield,
 {
   const size_t nbits = pieceStats_.size();
   assert(nbits <= bitfieldLength*8);
-  for(size_t i = 0; i < nbits; ++i) {
-    if(bitfield::test(bitfield, nbits, i)) {
-      pieceStats_[i]->subCount();
+  for(size_t i = 0, len = (nbits+7)/8; i < len; ++i) {
+    if(bitfield[i] == 0) {
+      continue;
+    }
+    for(size_t j = i*8, end = std::min(j+8, nbits); j < end; ++j) {
+      if(bitfield::test(bitfield, nbits, j)) {
+        subCount(j);
+      }
     }
   }
-  std::sort(sortedPieceStatIndexes_.begin(), sortedPieceStatIndexes_.end(),
-            PieceStatRarer(pieceStats_));
 }
 
 void PieceStatMan::updatePieceStats(const unsigned char* newBitfield,
@@ -138,33 +176,25 @@ void PieceStatMan::updatePieceStats(const unsigned char* newBitfield,
 {
   const size_t nbits = pieceStats_.size();
   assert(nbits <= newBitfieldLength*8);
-  for(size_t i = 0; i < nbits; ++i) {
-    if(bitfield::test(newBitfield, nbits, i) &&
-       !bitfield::test(oldBitfield, nbits, i)) {
-      pieceStats_[i]->addCount();
-    } else if(!bitfield::test(newBitfield, nbits, i) &&
-              bitfield::test(oldBitfield, nbits, i)) {
-      pieceStats_[i]->subCount();
+  for(size_t i = 0, len = (nbits+7)/8; i < len; ++i) {
+    if(newBitfield[i] == oldBitfield[i]) {
+      continue;
+    }
+    for(size_t j = i*8, end = std::min(j+8, nbits); j < end; ++j) {
+      if(bitfield::test(newBitfield, nbits, j) &&
+         !bitfield::test(oldBitfield, nbits, j)) {
+        addCount(j);
+      } else if(!bitfield::test(newBitfield, nbits, j) &&
+                bitfield::test(oldBitfield, nbits, j)) {
+        subCount(j);
+      }
     }
   }
-  std::sort(sortedPieceStatIndexes_.begin(), sortedPieceStatIndexes_.end(),
-            PieceStatRarer(pieceStats_));
 }
 
 void PieceStatMan::addPieceStats(size_t index)
 {
-  std::vector<size_t>::iterator cur =
-    std::lower_bound(sortedPieceStatIndexes_.begin(),
-                     sortedPieceStatIndexes_.end(),
-                     index, PieceStatRarer(pieceStats_));
-
-  pieceStats_[index]->addCount();
-
-  std::vector<size_t>::iterator to =
-    std::upper_bound(cur+1, sortedPieceStatIndexes_.end(),
-                     index, PieceStatRarer(pieceStats_));
-  
-  std::rotate(cur, cur+1, to);
+  addCount(index);
 }
 
 } // namespace aria2
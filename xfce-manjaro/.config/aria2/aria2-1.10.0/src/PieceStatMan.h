@@ -45,6 +45,7 @@ namespace aria2 {
 
 class PieceStat {
 private:
+  // Position of this object in PieceStatMan::getRarerPieceIndexes().
   size_t order_;
   size_t index_;
   size_t count_;
@@ -85,11 +86,27 @@ public:
 
 };
 
+// Keeps piece indexes sorted by the number of peers which have the
+// piece. sortedPieceStatIndexes_ is divided into buckets of pieces
+// with the same count, and the bucket of count c starts at
+// bucketStarts_[c]. A count change moves a piece to the boundary of
+// its bucket by one swap, so that a bitfield update costs time
+// proportional to the number of bits set in it.
 class PieceStatMan {
 private:
   std::vector<SharedHandle<PieceStat> > pieceStats_;
 
   std::vector<size_t> sortedPieceStatIndexes_;
+
+  // bucketStarts_[c] is the position of the first piece whose count
+  // is c or more in sortedPieceStatIndexes_.
+  std::vector<size_t> bucketStarts_;
+
+  void swapOrder(size_t order1, size_t order2);
+
+  void addCount(size_t index);
+
+  void subCount(size_t index);
 public:
   PieceStatMan(size_t pieceNum, bool randomShuffle);
 
@@ -41,6 +41,11 @@
 #include "FileAllocationEntry.h"
 #include "CheckIntegrityEntry.h"
 #include "ServerStatMan.h"
+#include "DiskIOJob.h"
+#ifdef ENABLE_DISK_IO_THREAD
+# include "DiskIOThreadPool.h"
+# include "DiskIOCompletionCommand.h"
+#endif // ENABLE_DISK_IO_THREAD
 
 namespace aria2 {
 
@@ -57,11 +62,32 @@ RealtimeCommand::RealtimeCommand(cuid_t cuid, RequestGroup* requestGroup,
 
 RealtimeCommand::~RealtimeCommand()
 {
+#ifdef ENABLE_DISK_IO_THREAD
+  if(!diskIOJob_.isNull()) {
+    diskIOJob_->setCommand(0);
+  }
+#endif // ENABLE_DISK_IO_THREAD
   requestGroup_->decreaseNumCommand();
 }
 
 bool RealtimeCommand::execute()
 {
+#ifdef ENABLE_DISK_IO_THREAD
+  if(!diskIOJob_.isNull()) {
+    if(!diskIOJob_->completed()) {
+      // Sleep until DiskIOCompletionCommand activates this command.
+      setStatusInactive();
+      e_->addCommand(this);
+      return false;
+    }
+    SharedHandle<DiskIOJob> job = diskIOJob_;
+    diskIOJob_.reset();
+    if(!job->getException().isNull()) {
+      setStatusRealtime();
+      return handleException(*job->getException().get());
+    }
+  }
+#endif // ENABLE_DISK_IO_THREAD
   setStatusRealtime();
   e_->setNoWait(true);
   try {
@@ -72,4 +98,32 @@ bool RealtimeCommand::execute()
   }
 }
 
+bool RealtimeCommand::executeDiskIOJob(const SharedHandle<DiskIOJob>& job)
+{
+#ifdef ENABLE_DISK_IO_THREAD
+  const SharedHandle<DiskIOThreadPool>& pool = e_->getDiskIOThreadPool();
+  if(!pool.isNull()) {
+    postDiskIOJob(job);
+    diskIOJob_ = job;
+    setStatusInactive();
+    e_->addCommand(this);
+    return false;
+  }
+#endif // ENABLE_DISK_IO_THREAD
+  job->execute();
+  return true;
+}
+
+#ifdef ENABLE_DISK_IO_THREAD
+void RealtimeCommand::postDiskIOJob(const SharedHandle<DiskIOJob>& job)
+{
+  const SharedHandle<DiskIOThreadPool>& pool = e_->getDiskIOThreadPool();
+  job->setCommand(this);
+  pool->post(job);
+  if(!pool->watched()) {
+    e_->addCommand(new DiskIOCompletionCommand(e_->newCUID(), e_));
+  }
+}
+#endif // ENABLE_DISK_IO_THREAD
+
 } // namespace aria2
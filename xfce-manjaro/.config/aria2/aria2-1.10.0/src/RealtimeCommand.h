@@ -36,17 +36,23 @@
 #define _D_REALTIME_COMMAND_H_
 
 #include "Command.h"
+#include "SharedHandle.h"
 
 namespace aria2 {
 
 class RequestGroup;
 class DownloadEngine;
 class Exception;
+class DiskIOJob;
 
 class RealtimeCommand : public Command {
 private:
   RequestGroup* requestGroup_;
   DownloadEngine* e_;
+#ifdef ENABLE_DISK_IO_THREAD
+  // The job posted to DiskIOThreadPool and not processed yet.
+  SharedHandle<DiskIOJob> diskIOJob_;
+#endif // ENABLE_DISK_IO_THREAD
 protected:
   DownloadEngine* getDownloadEngine() const
   {
@@ -57,6 +63,20 @@ protected:
   {
     return requestGroup_;
   }
+
+  // Runs job. If disk I/O threads are enabled, job is posted to
+  // DiskIOThreadPool and this function returns false. In this case,
+  // the caller must return false from executeInternal() and
+  // executeInternal() is called again when job is done. Otherwise,
+  // job is run synchronously and this function returns true.
+  bool executeDiskIOJob(const SharedHandle<DiskIOJob>& job);
+
+#ifdef ENABLE_DISK_IO_THREAD
+  // Posts job to DiskIOThreadPool, which must exist. This command is
+  // activated when job is done. Unlike executeDiskIOJob(), the caller
+  // keeps track of job.
+  void postDiskIOJob(const SharedHandle<DiskIOJob>& job);
+#endif // ENABLE_DISK_IO_THREAD
 public:
   RealtimeCommand(cuid_t cuid, RequestGroup* requestGroup, DownloadEngine* e);
 
@@ -87,6 +87,7 @@ bool ReceiverMSEHandshakeCommand::exitBeforeExecute()
 
 bool ReceiverMSEHandshakeCommand::executeInternal()
 {
+  Seq prevSequence = sequence_;
   switch(sequence_) {
   case RECEIVER_IDENTIFY_HANDSHAKE: {
     MSEHandshake::HANDSHAKE_TYPE type = mseHandshake_->identifyHandshakeType();
@@ -184,6 +185,9 @@ bool ReceiverMSEHandshakeCommand::executeInternal()
     }
     break;
   }
+  if(sequence_ == prevSequence) {
+    sleepUntilTimeout();
+  }
   getDownloadEngine()->addCommand(this);
   return false;
 }
@@ -79,6 +79,7 @@
 #include "ServerStatMan.h"
 #include "Segment.h"
 #include "FileAllocationEntry.h"
+#include "DiskCache.h"
 #ifdef ENABLE_MESSAGE_DIGEST
 # include "CheckIntegrityCommand.h"
 # include "ChecksumCheckIntegrityEntry.h"
@@ -140,7 +141,8 @@ RequestGroup::RequestGroup(const SharedHandle<Option>& option):
   resumeFailureCount_(0),
   logger_(LogFactory::getInstance())
 {
-  fileAllocationEnabled_ = option_->get(PREF_FILE_ALLOCATION) != V_NONE;
+  fileAllocationEnabled_ = option_->get(PREF_FILE_ALLOCATION) != V_NONE &&
+    option_->get(PREF_FILE_ALLOCATION) != V_LAZY;
   // Add types to be sent as a Accept header value here.
   // It would be good to put this value in Option so that user can tweak
   // and add this list.
@@ -164,6 +166,16 @@ bool RequestGroup::downloadFinished() const
   }
 }
 
+bool RequestGroup::stopConditionMet() const
+{
+#ifdef ENABLE_BITTORRENT
+  if(!btRuntime_.isNull() && btRuntime_->isHalt()) {
+    return true;
+  }
+#endif // ENABLE_BITTORRENT
+  return haltRequested_ || downloadFinished();
+}
+
 bool RequestGroup::allDownloadFinished() const
 {
   if(pieceStorage_.isNull()) {
@@ -535,6 +547,9 @@ void RequestGroup::initPieceStorage()
     if(!diskWriterFactory_.isNull()) {
       ps->setDiskWriterFactory(diskWriterFactory_);
     }
+    if(!diskCache_.isNull()) {
+      ps->setDiskCache(diskCache_);
+    }
     tempPieceStorage = ps;
   } else {
     UnknownLengthPieceStorageHandle ps
@@ -1033,6 +1048,11 @@ void RequestGroup::setDiskWriterFactory(const DiskWriterFactoryHandle& diskWrite
   diskWriterFactory_ = diskWriterFactory;
 }
 
+void RequestGroup::setDiskCache(const SharedHandle<DiskCache>& diskCache)
+{
+  diskCache_ = diskCache;
+}
+
 void RequestGroup::addPostDownloadHandler
 (const SharedHandle<PostDownloadHandler>& handler)
 {
@@ -61,6 +61,7 @@ class Dependency;
 class PreDownloadHandler;
 class PostDownloadHandler;
 class DiskWriterFactory;
+class DiskCache;
 class Option;
 class Logger;
 class RequestGroup;
@@ -113,6 +114,8 @@ private:
 
   SharedHandle<DiskWriterFactory> diskWriterFactory_;
 
+  SharedHandle<DiskCache> diskCache_;
+
   SharedHandle<Dependency> dependency_;
 
   bool fileAllocationEnabled_;
@@ -223,6 +226,11 @@ public:
 
   bool downloadFinished() const;
 
+  // Returns true if the download has finished, or halt has been
+  // requested for this object or its BtRuntime. The Commands of this
+  // object exit or change what they do then.
+  bool stopConditionMet() const;
+
   bool allDownloadFinished() const;
 
   void closeFile();
@@ -307,6 +315,15 @@ public:
     return diskWriterFactory_;
   }
 
+  // diskCache is shared by all downloads. It is used for a download
+  // whose total length is known.
+  void setDiskCache(const SharedHandle<DiskCache>& diskCache);
+
+  const SharedHandle<DiskCache>& getDiskCache() const
+  {
+    return diskCache_;
+  }
+
   void setFileAllocationEnabled(bool f)
   {
     fileAllocationEnabled_ = f;
@@ -71,9 +71,68 @@
 #include "CheckIntegrityEntry.h"
 #include "Segment.h"
 #include "DlAbortEx.h"
+#include "DiskCache.h"
 
 namespace aria2 {
 
+static gid_t gidOf(const SharedHandle<RequestGroup>& group)
+{
+  return group->getGID();
+}
+
+static gid_t gidOf(const SharedHandle<DownloadResult>& result)
+{
+  return result->gid;
+}
+
+// If GID is duplicated, index keeps the first one, which is what
+// linear search would find.
+template<typename Index, typename InputIterator>
+static void addIndex(Index& index, InputIterator first, InputIterator last)
+{
+  for(; first != last; ++first) {
+    index.insert(std::make_pair(gidOf(*first), *first));
+  }
+}
+
+template<typename Index, typename T>
+static void addIndex(Index& index, const SharedHandle<T>& item)
+{
+  index.insert(std::make_pair(gidOf(item), item));
+}
+
+template<typename Index, typename T>
+static void eraseIndex(Index& index, const SharedHandle<T>& item)
+{
+  typename Index::iterator i = index.find(gidOf(item));
+  if(i != index.end() && (*i).second.get() == item.get()) {
+    index.erase(i);
+  }
+}
+
+// Comparing pointers is much cheaper than comparing GIDs through
+// SharedHandle.
+template<typename T>
+static typename std::deque<SharedHandle<T> >::iterator findItem
+(std::deque<SharedHandle<T> >& items, const SharedHandle<T>& item)
+{
+  typename std::deque<SharedHandle<T> >::iterator i = items.begin();
+  for(typename std::deque<SharedHandle<T> >::iterator eoi = items.end();
+      i != eoi && (*i).get() != item.get(); ++i);
+  return i;
+}
+
+template<typename Index>
+static typename Index::mapped_type findIndex(const Index& index, gid_t gid)
+{
+  typename Index::const_iterator i = index.find(gid);
+  if(i == index.end()) {
+    return typename Index::mapped_type();
+  } else {
+    return (*i).second;
+  }
+}
+
 RequestGroupMan::RequestGroupMan
 (const std::vector<SharedHandle<RequestGroup> >& requestGroups,
  unsigned int maxSimultaneousDownloads,
@@ -83,12 +142,20 @@ RequestGroupMan::RequestGroupMan
   maxSimultaneousDownloads_(maxSimultaneousDownloads),
   option_(option),
   serverStatMan_(new ServerStatMan()),
-  maxOverallDownloadSpeedLimit_
-  (option->getAsInt(PREF_MAX_OVERALL_DOWNLOAD_LIMIT)),
-  maxOverallUploadSpeedLimit_(option->getAsInt(PREF_MAX_OVERALL_UPLOAD_LIMIT)),
+  downloadBucket_(option->getAsInt(PREF_MAX_OVERALL_DOWNLOAD_LIMIT)),
+  uploadBucket_(option->getAsInt(PREF_MAX_OVERALL_UPLOAD_LIMIT)),
   xmlRpc_(option->getAsBool(PREF_ENABLE_XML_RPC)),
   queueCheck_(true)
-{}
+{
+  addIndex(reservedGroupIndex_,
+           reservedGroups_.begin(), reservedGroups_.end());
+  int64_t diskCacheSize = option->getAsLLInt(PREF_DISK_CACHE);
+  if(diskCacheSize > 0) {
+    diskCache_.reset(new DiskCache(diskCacheSize));
+  }
+}
+
+RequestGroupMan::~RequestGroupMan() {}
 
 bool RequestGroupMan::downloadFinished()
 {
@@ -104,6 +171,7 @@ void RequestGroupMan::addRequestGroup
 (const SharedHandle<RequestGroup>& group)
 {
   requestGroups_.push_back(group);
+  addIndex(requestGroupIndex_, group);
 }
 
 void RequestGroupMan::addReservedGroup
@@ -113,6 +181,7 @@ void RequestGroupMan::addReservedGroup
     requestQueueCheck();
   }
   reservedGroups_.insert(reservedGroups_.end(), groups.begin(), groups.end());
+  addIndex(reservedGroupIndex_, groups.begin(), groups.end());
 }
 
 void RequestGroupMan::addReservedGroup
@@ -122,6 +191,7 @@ void RequestGroupMan::addReservedGroup
     requestQueueCheck();
   }
   reservedGroups_.push_back(group);
+  addIndex(reservedGroupIndex_, group);
 }
 
 void RequestGroupMan::insertReservedGroup
@@ -133,6 +203,7 @@ void RequestGroupMan::insertReservedGroup
   reservedGroups_.insert
     (reservedGroups_.begin()+std::min(reservedGroups_.size(), pos),
      groups.begin(), groups.end());
+  addIndex(reservedGroupIndex_, groups.begin(), groups.end());
 }
 
 void RequestGroupMan::insertReservedGroup
@@ -143,6 +214,7 @@ void RequestGroupMan::insertReservedGroup
   }
   reservedGroups_.insert
     (reservedGroups_.begin()+std::min(reservedGroups_.size(), pos), group);
+  addIndex(reservedGroupIndex_, group);
 }
 
 size_t RequestGroupMan::countRequestGroup() const
@@ -159,52 +231,29 @@ SharedHandle<RequestGroup> RequestGroupMan::getRequestGroup(size_t index) const
   }
 }
 
-template<typename Iterator>
-static Iterator findByGID(Iterator first, Iterator last, gid_t gid)
-{
-  for(; first != last; ++first) {
-    if((*first)->getGID() == gid) {
-      return first;
-    }
-  }
-  return first;
-}
-
 SharedHandle<RequestGroup>
 RequestGroupMan::findRequestGroup(gid_t gid) const
 {
-  std::deque<SharedHandle<RequestGroup> >::const_iterator i =
-    findByGID(requestGroups_.begin(), requestGroups_.end(), gid);
-  if(i == requestGroups_.end()) {
-    return SharedHandle<RequestGroup>();
-  } else {
-    return *i;
-  }
+  return findIndex(requestGroupIndex_, gid);
 }
 
 SharedHandle<RequestGroup>
 RequestGroupMan::findReservedGroup(gid_t gid) const
 {
-  std::deque<SharedHandle<RequestGroup> >::const_iterator i =
-    findByGID(reservedGroups_.begin(), reservedGroups_.end(), gid);
-  if(i == reservedGroups_.end()) {
-    return SharedHandle<RequestGroup>();
-  } else {
-    return *i;
-  }
+  return findIndex(reservedGroupIndex_, gid);
 }
 
 size_t RequestGroupMan::changeReservedGroupPosition
 (gid_t gid, int pos, HOW how)
 {
-  std::deque<SharedHandle<RequestGroup> >::iterator i =
-    findByGID(reservedGroups_.begin(), reservedGroups_.end(), gid);
-  if(i == reservedGroups_.end()) {
+  SharedHandle<RequestGroup> rg = findReservedGroup(gid);
+  if(rg.isNull()) {
     throw DL_ABORT_EX
       (StringFormat("GID#%s not found in the waiting queue.",
                     util::itos(gid).c_str()).str());
   }
-  SharedHandle<RequestGroup> rg = *i;
+  std::deque<SharedHandle<RequestGroup> >::iterator i =
+    findItem(reservedGroups_, rg);
   const size_t maxPos = reservedGroups_.size()-1;
   if(how == POS_SET) {
     if(pos < 0) {
@@ -240,12 +289,12 @@ size_t RequestGroupMan::changeReservedGroupPosition
 
 bool RequestGroupMan::removeReservedGroup(gid_t gid)
 {
-  std::deque<SharedHandle<RequestGroup> >::iterator i =
-    findByGID(reservedGroups_.begin(), reservedGroups_.end(), gid);
-  if(i == reservedGroups_.end()) {
+  SharedHandle<RequestGroup> rg = findReservedGroup(gid);
+  if(rg.isNull()) {
     return false;
   } else {
-    reservedGroups_.erase(i);
+    reservedGroups_.erase(findItem(reservedGroups_, rg));
+    eraseIndex(reservedGroupIndex_, rg);
     return true;
   }
 }
@@ -267,8 +316,7 @@ static void executeStopHook
 class ProcessStoppedRequestGroup {
 private:
   DownloadEngine* e_;
-  std::deque<SharedHandle<DownloadResult> >& downloadResults_;
-  std::deque<SharedHandle<RequestGroup> >& reservedGroups_;
+  RequestGroupMan* requestGroupMan_;
   Logger* logger_;
 
   void saveSignature(const SharedHandle<RequestGroup>& group)
@@ -288,12 +336,9 @@ private:
   }
 public:
   ProcessStoppedRequestGroup
-  (DownloadEngine* e,
-   std::deque<SharedHandle<DownloadResult> >& downloadResults,
-   std::deque<SharedHandle<RequestGroup> >& reservedGroups):
+  (DownloadEngine* e, RequestGroupMan* requestGroupMan):
     e_(e),
-    downloadResults_(downloadResults),
-    reservedGroups_(reservedGroups),
+    requestGroupMan_(requestGroupMan),
     logger_(LogFactory::getInstance()) {}
 
   void operator()(const SharedHandle<RequestGroup>& group)
@@ -330,7 +375,7 @@ public:
                 ("Adding %lu RequestGroups as a result of PostDownloadHandler.",
                  static_cast<unsigned long>(nextGroups.size()));
             }
-            e_->getRequestGroupMan()->insertReservedGroup(0, nextGroups);
+            requestGroupMan_->insertReservedGroup(0, nextGroups);
           }
         } else {
           group->saveControlFile();
@@ -338,10 +383,12 @@ public:
       } catch(RecoverableException& ex) {
         logger_->error(EX_EXCEPTION_CAUGHT, ex);
       }
+      SharedHandle<DownloadResult> result;
       if(group->isPauseRequested()) {
-        reservedGroups_.push_front(group);
+        requestGroupMan_->insertReservedGroup(0, group);
       } else {
-        downloadResults_.push_back(group->createDownloadResult());
+        result = group->createDownloadResult();
+        requestGroupMan_->addDownloadResult(result);
       }
       group->releaseRuntimeResource(e_);
       if(group->isPauseRequested()) {
@@ -351,7 +398,7 @@ public:
         // TODO Should we have to prepend spend uris to remaining uris
         // in case PREF_REUSE_URI is disabed?
       } else {
-        executeStopHook(downloadResults_.back(), e_->getOption());
+        executeStopHook(result, e_->getOption());
       }
     }
   }
@@ -419,14 +466,17 @@ void RequestGroupMan::removeStoppedGroup(DownloadEngine* e)
   updateServerStat();
 
   std::for_each(requestGroups_.begin(), requestGroups_.end(),
-                ProcessStoppedRequestGroup
-                (e, downloadResults_, reservedGroups_));
+                ProcessStoppedRequestGroup(e, this));
   std::deque<SharedHandle<RequestGroup> >::iterator i =
     std::remove_if(requestGroups_.begin(),
                    requestGroups_.end(),
                    FindStoppedRequestGroup());
   if(i != requestGroups_.end()) {
+    // Rebuild index because std::remove_if leaves unspecified values
+    // in [i, requestGroups_.end()).
     requestGroups_.erase(i, requestGroups_.end());
+    requestGroupIndex_.clear();
+    addIndex(requestGroupIndex_, requestGroups_.begin(), requestGroups_.end());
   }
 
   size_t numRemoved = numPrev-requestGroups_.size();
@@ -438,6 +488,23 @@ void RequestGroupMan::removeStoppedGroup(DownloadEngine* e)
   }
 }
 
+bool RequestGroupMan::findNewlyStoppedGroup()
+{
+  std::set<gid_t> stoppedGids;
+  bool found = false;
+  for(std::deque<SharedHandle<RequestGroup> >::const_iterator i =
+        requestGroups_.begin(), eoi = requestGroups_.end(); i != eoi; ++i) {
+    if((*i)->stopConditionMet()) {
+      stoppedGids.insert((*i)->getGID());
+      if(stoppedGids_.count((*i)->getGID()) == 0) {
+        found = true;
+      }
+    }
+  }
+  stoppedGids_.swap(stoppedGids);
+  return found;
+}
+
 void RequestGroupMan::configureRequestGroup
 (const SharedHandle<RequestGroup>& requestGroup) const
 {
@@ -453,6 +520,7 @@ void RequestGroupMan::configureRequestGroup
       (SharedHandle<URISelector>(new AdaptiveURISelector(serverStatMan_,
                                                          requestGroup.get())));
   }
+  requestGroup->setDiskCache(diskCache_);
 }
 
 static void createInitialCommand(const SharedHandle<RequestGroup>& requestGroup,
@@ -474,6 +542,7 @@ void RequestGroupMan::fillRequestGroupFromReserver(DownloadEngine* e)
   while(count < num && !reservedGroups_.empty()) {
     SharedHandle<RequestGroup> groupToAdd = reservedGroups_.front();
     reservedGroups_.pop_front();
+    eraseIndex(reservedGroupIndex_, groupToAdd);
     std::vector<Command*> commands;
     try {
       if(groupToAdd->isPauseRequested()||!groupToAdd->isDependencyResolved()) {
@@ -490,6 +559,7 @@ void RequestGroupMan::fillRequestGroupFromReserver(DownloadEngine* e)
         requestQueueCheck();
       }
       requestGroups_.push_back(groupToAdd);
+      addIndex(requestGroupIndex_, groupToAdd);
       ++count;
       e->addCommand(commands);
       commands.clear();
@@ -506,11 +576,12 @@ void RequestGroupMan::fillRequestGroupFromReserver(DownloadEngine* e)
         logger_->debug("Commands deleted");
       }
       groupToAdd->releaseRuntimeResource(e);
-      downloadResults_.push_back(groupToAdd->createDownloadResult());
+      addDownloadResult(groupToAdd->createDownloadResult());
     }
   }
   if(!temp.empty()) {
     reservedGroups_.insert(reservedGroups_.begin(), temp.begin(), temp.end());
+    addIndex(reservedGroupIndex_, temp.begin(), temp.end());
   }
   if(count > 0) {
     e->setNoWait(true);
@@ -748,18 +819,20 @@ TransferStat RequestGroupMan::calculateStat()
 SharedHandle<DownloadResult>
 RequestGroupMan::findDownloadResult(gid_t gid) const
 {
-  for(std::deque<SharedHandle<DownloadResult> >::const_iterator i =
-        downloadResults_.begin(), eoi = downloadResults_.end(); i != eoi; ++i) {
-    if((*i)->gid == gid) {
-      return *i;
-    }
-  }
-  return SharedHandle<DownloadResult>();
+  return findIndex(downloadResultIndex_, gid);
+}
+
+void RequestGroupMan::addDownloadResult
+(const SharedHandle<DownloadResult>& downloadResult)
+{
+  downloadResults_.push_back(downloadResult);
+  addIndex(downloadResultIndex_, downloadResult);
 }
 
 void RequestGroupMan::purgeDownloadResult()
 {
   downloadResults_.clear();
+  downloadResultIndex_.clear();
 }
 
 SharedHandle<ServerStat>
@@ -832,18 +905,6 @@ void RequestGroupMan::removeStaleServerStat(time_t timeout)
   serverStatMan_->removeStaleServerStat(timeout);
 }
 
-bool RequestGroupMan::doesOverallDownloadSpeedExceed()
-{
-  return maxOverallDownloadSpeedLimit_ > 0 &&
-    maxOverallDownloadSpeedLimit_ < calculateStat().getDownloadSpeed();
-}
-
-bool RequestGroupMan::doesOverallUploadSpeedExceed()
-{
-  return maxOverallUploadSpeedLimit_ > 0 &&
-    maxOverallUploadSpeedLimit_ < calculateStat().getUploadSpeed();
-}
-
 void RequestGroupMan::getUsedHosts
 (std::vector<std::pair<size_t, std::string> >& usedHosts)
 {
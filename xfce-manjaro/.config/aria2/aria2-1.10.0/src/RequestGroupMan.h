@@ -41,11 +41,14 @@
 #include <deque>
 #include <iosfwd>
 #include <vector>
+#include <set>
 
 #include "SharedHandle.h"
 #include "DownloadResult.h"
 #include "TransferStat.h"
 #include "RequestGroup.h"
+#include "a2unordered_map.h"
+#include "TokenBucket.h"
 
 namespace aria2 {
 
@@ -56,12 +59,25 @@ struct DownloadResult;
 class ServerStatMan;
 class ServerStat;
 class Option;
+class DiskCache;
 
 class RequestGroupMan {
 private:
   std::deque<SharedHandle<RequestGroup> > requestGroups_;
   std::deque<SharedHandle<RequestGroup> > reservedGroups_;
   std::deque<SharedHandle<DownloadResult> > downloadResults_;
+
+  typedef UnorderedMap<gid_t, SharedHandle<RequestGroup> >::type
+  RequestGroupIndex;
+  typedef UnorderedMap<gid_t, SharedHandle<DownloadResult> >::type
+  DownloadResultIndex;
+
+  // Indexes of requestGroups_, reservedGroups_ and downloadResults_
+  // by GID.
+  RequestGroupIndex requestGroupIndex_;
+  RequestGroupIndex reservedGroupIndex_;
+  DownloadResultIndex downloadResultIndex_;
+
   Logger* logger_;
   unsigned int maxSimultaneousDownloads_;
 
@@ -69,15 +85,24 @@ private:
 
   SharedHandle<ServerStatMan> serverStatMan_;
 
-  unsigned int maxOverallDownloadSpeedLimit_;
+  // Bytes transferred by all RequestGroups are taken from these
+  // buckets. Their rates are the overall speed limits.
+  TokenBucket downloadBucket_;
 
-  unsigned int maxOverallUploadSpeedLimit_;
+  TokenBucket uploadBucket_;
 
   // truf if XML-RPC is enabled.
   bool xmlRpc_;
 
+  // Shared by all RequestGroups. Null if disk cache is disabled.
+  SharedHandle<DiskCache> diskCache_;
+
   bool queueCheck_;
 
+  // GIDs of the RequestGroups which met their stop condition when
+  // findNewlyStoppedGroup() was called last time.
+  std::set<gid_t> stoppedGids_;
+
   std::string
   formatDownloadResult(const std::string& status,
                        const SharedHandle<DownloadResult>& downloadResult) const;
@@ -89,6 +114,8 @@ public:
                   unsigned int maxSimultaneousDownloads,
                   const Option* option);
 
+  ~RequestGroupMan();
+
   bool downloadFinished();
 
   void save();
@@ -101,6 +128,11 @@ public:
 
   void removeStoppedGroup(DownloadEngine* e);
 
+  // Returns true if a RequestGroup has met its stop condition since the
+  // last call. See RequestGroup::stopConditionMet(). Commands sleeping
+  // in the timer wheel of DownloadEngine must be woken up then.
+  bool findNewlyStoppedGroup();
+
   void fillRequestGroupFromReserver(DownloadEngine* e);
 
   void addRequestGroup(const SharedHandle<RequestGroup>& group);
@@ -147,8 +179,15 @@ public:
   // beyond the end of the queue, it moves the download to the
   // beginning or the end of the queue respectively.  Returns the
   // destination position.
+  //
+  // The GID is looked up in O(1), but finding the download in the
+  // queue and moving it are linear in the number of waiting
+  // downloads.
   size_t changeReservedGroupPosition(gid_t gid, int pos, HOW how);
 
+  // Removes the download denoted by gid from the waiting queue. Like
+  // changeReservedGroupPosition(), this is linear in the number of
+  // waiting downloads.
   bool removeReservedGroup(gid_t gid);
 
   void showDownloadResults(std::ostream& o) const;
@@ -202,6 +241,8 @@ public:
 
   SharedHandle<DownloadResult> findDownloadResult(gid_t gid) const;
 
+  void addDownloadResult(const SharedHandle<DownloadResult>& downloadResult);
+
   // Removes all download results.
   void purgeDownloadResult();
 
@@ -221,34 +262,52 @@ public:
 
   void removeStaleServerStat(time_t timeout);
 
-  // Returns true if current download speed exceeds
-  // maxOverallDownloadSpeedLimit_.  Always returns false if
-  // maxOverallDownloadSpeedLimit_ == 0.  Otherwise returns false.
-  bool doesOverallDownloadSpeedExceed();
+  // Returns true if the bytes downloaded recently exceed the overall
+  // download speed limit.  Always returns false if the limit is 0.
+  bool doesOverallDownloadSpeedExceed()
+  {
+    return downloadBucket_.exceeded();
+  }
+
+  // Counts bytes downloaded by any RequestGroup against the overall
+  // download speed limit.
+  void updateOverallDownloadLength(size_t bytes)
+  {
+    downloadBucket_.consume(bytes);
+  }
 
   void setMaxOverallDownloadSpeedLimit(unsigned int speed)
   {
-    maxOverallDownloadSpeedLimit_ = speed;
+    downloadBucket_.setRate(speed);
   }
 
   unsigned int getMaxOverallDownloadSpeedLimit() const
   {
-    return maxOverallDownloadSpeedLimit_;
+    return downloadBucket_.getRate();
   }
 
-  // Returns true if current upload speed exceeds
-  // maxOverallUploadSpeedLimit_. Always returns false if
-  // maxOverallUploadSpeedLimit_ == 0. Otherwise returns false.
-  bool doesOverallUploadSpeedExceed();
+  // Returns true if the bytes uploaded recently exceed the overall
+  // upload speed limit. Always returns false if the limit is 0.
+  bool doesOverallUploadSpeedExceed()
+  {
+    return uploadBucket_.exceeded();
+  }
+
+  // Counts bytes uploaded by any RequestGroup against the overall
+  // upload speed limit.
+  void updateOverallUploadLength(size_t bytes)
+  {
+    uploadBucket_.consume(bytes);
+  }
 
   void setMaxOverallUploadSpeedLimit(unsigned int speed)
   {
-    maxOverallUploadSpeedLimit_ = speed;
+    uploadBucket_.setRate(speed);
   }
 
   unsigned int getMaxOverallUploadSpeedLimit() const
   {
-    return maxOverallUploadSpeedLimit_;
+    return uploadBucket_.getRate();
   }
 
   void setMaxSimultaneousDownloads(unsigned int max)
@@ -41,9 +41,13 @@
 #include "DlAbortEx.h"
 #include "message.h"
 #include "StringFormat.h"
+#include "BufferPool.h"
+#include "a2io.h"
 
 namespace aria2 {
 
+uint64_t SocketBuffer::zeroCopySendLength_ = 0;
+
 SocketBuffer::SocketBuffer(const SharedHandle<SocketCore>& socket):
   socket_(socket), offset_(0) {}
 
@@ -53,9 +57,25 @@ SocketBuffer::~SocketBuffer()
                 std::mem_fun_ref(&BufEntry::deleteBuf));
 }
 
+void SocketBuffer::BufEntry::deleteBuf()
+{
+  if(type == TYPE_BYTES) {
+    delete [] bytes;
+  } else if(type == TYPE_POOLED_BYTES) {
+    BufferPool::getInstance()->deallocate(bytes);
+  } else if(type == TYPE_STR) {
+    delete str;
+  }
+}
+
 void SocketBuffer::pushBytes(unsigned char* bytes, size_t len)
 {
-  bufq_.push_back(BufEntry(bytes, len));
+  bufq_.push_back(BufEntry(TYPE_BYTES, bytes, len));
+}
+
+void SocketBuffer::pushPooledBytes(unsigned char* bytes, size_t len)
+{
+  bufq_.push_back(BufEntry(TYPE_POOLED_BYTES, bytes, len));
 }
 
 void SocketBuffer::pushStr(const std::string& data)
@@ -64,13 +84,81 @@ void SocketBuffer::pushStr(const std::string& data)
 }
 
 ssize_t SocketBuffer::send()
+{
+  if(socket_->supportsWriteDataVec()) {
+    return sendVec();
+  } else {
+    return sendEach();
+  }
+}
+
+ssize_t SocketBuffer::sendVec()
+{
+  size_t totalslen = 0;
+  struct iovec iov[IOV_MAX];
+  while(!bufq_.empty()) {
+    int iovcnt = 0;
+    size_t r = 0;
+    for(std::deque<BufEntry>::const_iterator i = bufq_.begin(),
+          eoi = bufq_.end(); i != eoi && iovcnt < IOV_MAX; ++i, ++iovcnt) {
+      const BufEntry& buf = *i;
+      if(buf.type == TYPE_BYTES || buf.type == TYPE_POOLED_BYTES) {
+        iov[iovcnt].iov_base = buf.bytes;
+        iov[iovcnt].iov_len = buf.bytesLen;
+      } else {
+        iov[iovcnt].iov_base = const_cast<char*>(buf.str->data());
+        iov[iovcnt].iov_len = buf.str->size();
+      }
+      r += iov[iovcnt].iov_len;
+    }
+    iov[0].iov_base = static_cast<char*>(iov[0].iov_base)+offset_;
+    iov[0].iov_len -= offset_;
+    r -= offset_;
+    ssize_t slen = socket_->writeDataVec(iov, iovcnt);
+    if(slen == 0 && !socket_->wantRead() && !socket_->wantWrite()) {
+      throw DL_ABORT_EX(StringFormat(EX_SOCKET_SEND,
+                                     "Connection closed.").str());
+    }
+    totalslen += slen;
+    consume(slen);
+    if(static_cast<size_t>(slen) < r) {
+      break;
+    }
+  }
+  return totalslen;
+}
+
+void SocketBuffer::consume(size_t slen)
+{
+  while(!bufq_.empty()) {
+    BufEntry& buf = bufq_[0];
+    size_t len;
+    if(buf.type == TYPE_BYTES || buf.type == TYPE_POOLED_BYTES) {
+      len = buf.bytesLen;
+    } else {
+      len = buf.str->size();
+    }
+    size_t rest = len-offset_;
+    if(slen < rest) {
+      offset_ += slen;
+      break;
+    } else {
+      slen -= rest;
+      offset_ = 0;
+      buf.deleteBuf();
+      bufq_.pop_front();
+    }
+  }
+}
+
+ssize_t SocketBuffer::sendEach()
 {
   size_t totalslen = 0;
   while(!bufq_.empty()) {
     BufEntry& buf = bufq_[0];
     const char* data;
     ssize_t r;
-    if(buf.type == TYPE_BYTES) {
+    if(buf.type == TYPE_BYTES || buf.type == TYPE_POOLED_BYTES) {
       data = reinterpret_cast<const char*>(buf.bytes);
       r = buf.bytesLen-offset_;
     } else {
@@ -96,6 +184,17 @@ ssize_t SocketBuffer::send()
   return totalslen;
 }
 
+ssize_t SocketBuffer::sendFile(int fd, off_t offset, size_t len)
+{
+  assert(bufq_.empty());
+  if(!socket_->supportsSendFile()) {
+    return 0;
+  }
+  ssize_t slen = socket_->sendFile(fd, offset, len);
+  zeroCopySendLength_ += slen;
+  return slen;
+}
+
 bool SocketBuffer::sendBufferIsEmpty() const
 {
   return bufq_.empty();
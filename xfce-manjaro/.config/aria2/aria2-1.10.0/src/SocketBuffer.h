@@ -37,6 +37,8 @@
 
 #include "common.h"
 
+#include <sys/types.h>
+
 #include <string>
 #include <deque>
 
@@ -50,6 +52,7 @@ class SocketBuffer {
 private:
   enum BUF_TYPE {
     TYPE_BYTES,
+    TYPE_POOLED_BYTES,
     TYPE_STR
   };
   struct BufEntry {
@@ -58,17 +61,10 @@ private:
     size_t bytesLen;
     std::string* str;
 
-    void deleteBuf()
-    {
-      if(type == TYPE_BYTES) {
-        delete [] bytes;
-      } else if(type == TYPE_STR) {
-        delete str;
-      }
-    }
-      
-    BufEntry(unsigned char* bytes, size_t len):
-      type(TYPE_BYTES), bytes(bytes), bytesLen(len) {}
+    void deleteBuf();
+
+    BufEntry(BUF_TYPE type, unsigned char* bytes, size_t len):
+      type(type), bytes(bytes), bytesLen(len) {}
 
     BufEntry(const std::string& str):
       type(TYPE_STR), str(new std::string(str)) {}
@@ -82,6 +78,21 @@ private:
   // but it cannot always send whole data. In this case, offset points
   // to the data to be sent in the next send() call.
   size_t offset_;
+
+  // The number of bytes sent by sendFile() in this process.
+  static uint64_t zeroCopySendLength_;
+
+  // Sends data in queue with one writeData() call per entry.
+  ssize_t sendEach();
+
+  // Sends data in queue, gathering up to IOV_MAX entries into one
+  // SocketCore::writeDataVec() call.
+  ssize_t sendVec();
+
+  // Removes sent entries from the head of queue and updates
+  // offset_. slen is the number of bytes just sent starting at
+  // offset_ of bufq_[0].
+  void consume(size_t slen);
 public:
   SocketBuffer(const SharedHandle<SocketCore>& socket);
 
@@ -92,12 +103,28 @@ public:
   // later bytes after this call. This function doesn't send data.
   void pushBytes(unsigned char* bytes, size_t len);
 
+  // Same as pushBytes() but bytes must be allocated by
+  // BufferPool::getInstance(). The block is returned to the pool when
+  // it is sent.
+  void pushPooledBytes(unsigned char* bytes, size_t len);
+
   // Feeds data into queue. This function doesn't send data.
   void pushStr(const std::string& data);
 
   // Sends data in queue.  Returns the number of bytes sent.
   ssize_t send();
 
+  // Sends up to len bytes of the file fd starting at offset directly
+  // from the file. The queue must be empty. Returns the number of
+  // bytes sent, which is 0 if zero-copy send is not supported by the
+  // socket.
+  ssize_t sendFile(int fd, off_t offset, size_t len);
+
+  static uint64_t getZeroCopySendLength()
+  {
+    return zeroCopySendLength_;
+  }
+
   // Returns true if queue is empty.
   bool sendBufferIsEmpty() const;
 
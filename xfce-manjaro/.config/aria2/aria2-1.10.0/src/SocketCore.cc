@@ -38,9 +38,13 @@
 #ifdef HAVE_IFADDRS_H
 # include <ifaddrs.h>
 #endif // HAVE_IFADDRS_H
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif // HAVE_SYS_SENDFILE_H
 
 #include <cerrno>
 #include <cstring>
+#include <cassert>
 
 #ifdef HAVE_LIBGNUTLS
 # include <gnutls/x509.h>
@@ -721,6 +725,73 @@ ssize_t SocketCore::writeData(const char* data, size_t len)
   return ret;
 }
 
+bool SocketCore::supportsWriteDataVec() const
+{
+#ifndef __MINGW32__
+  return !secure_;
+#else // __MINGW32__
+  return false;
+#endif // __MINGW32__
+}
+
+ssize_t SocketCore::writeDataVec(const struct iovec* iov, int iovcnt)
+{
+  wantRead_ = false;
+  wantWrite_ = false;
+#ifndef __MINGW32__
+  assert(!secure_);
+  assert(iovcnt <= IOV_MAX);
+  ssize_t ret;
+  while((ret = writev(sockfd_, iov, iovcnt)) == -1 && errno == EINTR);
+  if(ret == -1) {
+    if(A2_WOULDBLOCK(errno)) {
+      wantWrite_ = true;
+      ret = 0;
+    } else {
+      throw DL_RETRY_EX(StringFormat(EX_SOCKET_SEND, errorMsg()).str());
+    }
+  }
+  return ret;
+#else // __MINGW32__
+  abort();
+#endif // __MINGW32__
+}
+
+bool SocketCore::supportsSendFile() const
+{
+#if defined HAVE_SENDFILE && defined HAVE_SYS_SENDFILE_H
+  return !secure_;
+#else // !(HAVE_SENDFILE && HAVE_SYS_SENDFILE_H)
+  return false;
+#endif // !(HAVE_SENDFILE && HAVE_SYS_SENDFILE_H)
+}
+
+ssize_t SocketCore::sendFile(int fd, off_t offset, size_t len)
+{
+  wantRead_ = false;
+  wantWrite_ = false;
+#if defined HAVE_SENDFILE && defined HAVE_SYS_SENDFILE_H
+  assert(!secure_);
+  ssize_t ret;
+  while((ret = sendfile(sockfd_, fd, &offset, len)) == -1 && errno == EINTR);
+  if(ret == -1) {
+    if(A2_WOULDBLOCK(errno)) {
+      wantWrite_ = true;
+      ret = 0;
+    } else if(errno == EINVAL || errno == ENOSYS) {
+      // The file does not support sendfile. The caller falls back to
+      // writeData().
+      ret = 0;
+    } else {
+      throw DL_RETRY_EX(StringFormat(EX_SOCKET_SEND, errorMsg()).str());
+    }
+  }
+  return ret;
+#else // !(HAVE_SENDFILE && HAVE_SYS_SENDFILE_H)
+  abort();
+#endif // !(HAVE_SENDFILE && HAVE_SYS_SENDFILE_H)
+}
+
 void SocketCore::readData(char* data, size_t& len)
 {
   ssize_t ret = 0;
@@ -1164,6 +1235,59 @@ ssize_t SocketCore::readDataFrom(char* data, size_t len,
   return r;
 }
 
+bool SocketCore::supportsDatagramBatch() const
+{
+#if defined HAVE_RECVMMSG && defined HAVE_SENDMMSG
+  return true;
+#else // !(HAVE_RECVMMSG && HAVE_SENDMMSG)
+  return false;
+#endif // !(HAVE_RECVMMSG && HAVE_SENDMMSG)
+}
+
+int SocketCore::readDataFromBatch(struct mmsghdr* msgs, unsigned int vlen)
+{
+  wantRead_ = false;
+  wantWrite_ = false;
+#if defined HAVE_RECVMMSG && defined HAVE_SENDMMSG
+  int r;
+  while((r = recvmmsg(sockfd_, msgs, vlen, 0, 0)) == -1 &&
+        A2_EINTR == SOCKET_ERRNO);
+  if(r == -1) {
+    if(A2_WOULDBLOCK(SOCKET_ERRNO)) {
+      wantRead_ = true;
+      r = 0;
+    } else {
+      throw DL_RETRY_EX(StringFormat(EX_SOCKET_RECV, errorMsg()).str());
+    }
+  }
+  return r;
+#else // !(HAVE_RECVMMSG && HAVE_SENDMMSG)
+  abort();
+#endif // !(HAVE_RECVMMSG && HAVE_SENDMMSG)
+}
+
+int SocketCore::writeDataToBatch(struct mmsghdr* msgs, unsigned int vlen)
+{
+  wantRead_ = false;
+  wantWrite_ = false;
+#if defined HAVE_RECVMMSG && defined HAVE_SENDMMSG
+  int r;
+  while((r = sendmmsg(sockfd_, msgs, vlen, 0)) == -1 &&
+        A2_EINTR == SOCKET_ERRNO);
+  if(r == -1) {
+    if(A2_WOULDBLOCK(SOCKET_ERRNO)) {
+      wantWrite_ = true;
+      r = 0;
+    } else {
+      throw DL_ABORT_EX(StringFormat(EX_SOCKET_SEND, errorMsg()).str());
+    }
+  }
+  return r;
+#else // !(HAVE_RECVMMSG && HAVE_SENDMMSG)
+  abort();
+#endif // !(HAVE_RECVMMSG && HAVE_SENDMMSG)
+}
+
 std::string SocketCore::getSocketError() const
 {
   int error;
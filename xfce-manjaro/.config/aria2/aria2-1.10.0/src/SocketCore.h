@@ -237,6 +237,33 @@ public:
   ssize_t writeData(const char* data, size_t len,
                     const std::string& host, uint16_t port);
 
+  // Returns true if writeDataVec() is available for this socket. It
+  // is not available for TLS connections.
+  bool supportsWriteDataVec() const;
+
+  /**
+   * Sends the iovcnt buffers described by iov in one system call.
+   * Returns the number of bytes sent, which may be less than the sum
+   * of iov_len. If the underlying socket gets EAGAIN, wantWrite_ is
+   * set and 0 is returned. iovcnt must not exceed IOV_MAX.  Call this
+   * function only if supportsWriteDataVec() returns true.
+   */
+  ssize_t writeDataVec(const struct iovec* iov, int iovcnt);
+
+  // Returns true if sendFile() is available for this socket. It is
+  // not available for TLS connections.
+  bool supportsSendFile() const;
+
+  /**
+   * Sends up to len bytes read from the file descriptor fd starting
+   * at offset, without copying them into user space. Returns the
+   * number of bytes sent. If the underlying socket gets EAGAIN,
+   * wantWrite_ is set and 0 is returned. If offset is at or beyond
+   * the end of the file, 0 is returned and wantWrite_ is not set.
+   * Call this function only if supportsSendFile() returns true.
+   */
+  ssize_t sendFile(int fd, off_t offset, size_t len);
+
   ssize_t writeData(const unsigned char* data, size_t len,
                     const std::string& host,
                     uint16_t port)
@@ -278,6 +305,31 @@ public:
     return readDataFrom(reinterpret_cast<char*>(data), len, sender);
   }
 
+  // Returns true if readDataFromBatch() and writeDataToBatch() are
+  // available. They need recvmmsg(2) and sendmmsg(2).
+  bool supportsDatagramBatch() const;
+
+  /**
+   * Receives up to vlen datagrams in one system call into the buffers
+   * described by msgs and returns the number of datagrams received.
+   * The sender address and length of each datagram are stored in
+   * msgs. If the underlying socket gets EAGAIN, wantRead_ is set and 0
+   * is returned. Call this function only if supportsDatagramBatch()
+   * returns true.
+   */
+  int readDataFromBatch(struct mmsghdr* msgs, unsigned int vlen);
+
+  /**
+   * Sends up to vlen datagrams described by msgs in one system call
+   * and returns the number of datagrams sent. Each of msgs must have
+   * its destination address. If the underlying socket gets EAGAIN
+   * before any datagram is sent, wantWrite_ is set and 0 is returned.
+   * If the first datagram cannot be sent for other reasons, exception
+   * is thrown. Call this function only if supportsDatagramBatch()
+   * returns true.
+   */
+  int writeDataToBatch(struct mmsghdr* msgs, unsigned int vlen);
+
   /**
    * Reads up to len bytes from this socket, but bytes are not removed from
    * this socket.
@@ -71,6 +71,7 @@ bool TimeBasedCommand::execute()
   if(routineCommand_) {
     e_->addRoutineCommand(this);
   } else {
+    setWakeupTime(checkPoint_.getTime()+interval_);
     e_->addCommand(this);
   }
   return false;
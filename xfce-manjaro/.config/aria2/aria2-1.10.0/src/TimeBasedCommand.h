@@ -78,7 +78,10 @@ protected:
   }
 public:
   /**
-   * preProcess() is called each time when excute() is called.
+   * preProcess() is called each time when excute() is called.  Unless
+   * this is a routine command, execute() is called only when the
+   * interval has elapsed, halt is requested or all downloads have
+   * finished.
    */
   virtual void preProcess() {};
 
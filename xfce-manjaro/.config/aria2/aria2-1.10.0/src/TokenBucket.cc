@@ -0,0 +1,90 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "TokenBucket.h"
+
+#include <algorithm>
+
+#include "wallclock.h"
+
+namespace aria2 {
+
+TokenBucket::TokenBucket(unsigned int rate):
+  rate_(rate), tokens_(rate), lastRefill_(global::wallclock) {}
+
+void TokenBucket::setRate(unsigned int rate)
+{
+  rate_ = rate;
+  tokens_ = rate;
+  lastRefill_ = global::wallclock;
+}
+
+void TokenBucket::refill()
+{
+  const int64_t capacity = rate_;
+  if(global::wallclock < lastRefill_ || tokens_ >= capacity) {
+    // If the clock went backwards, start over from now.
+    lastRefill_ = global::wallclock;
+    return;
+  }
+  int64_t elapsed = lastRefill_.differenceInMillis(global::wallclock);
+  // Avoid overflow. An hour is enough to pay off any debt.
+  elapsed = std::min(elapsed, static_cast<int64_t>(3600*1000));
+  int64_t tokens = capacity*elapsed/1000;
+  // Leave lastRefill_ untouched while elapsed time is worth less than a
+  // token, so that slow rates still accumulate.
+  if(tokens > 0) {
+    tokens_ = std::min(tokens_+tokens, capacity);
+    lastRefill_ = global::wallclock;
+  }
+}
+
+void TokenBucket::consume(size_t bytes)
+{
+  if(rate_ > 0) {
+    refill();
+    tokens_ -= bytes;
+  }
+}
+
+bool TokenBucket::exceeded()
+{
+  if(rate_ == 0) {
+    return false;
+  }
+  refill();
+  return tokens_ <= 0;
+}
+
+} // namespace aria2
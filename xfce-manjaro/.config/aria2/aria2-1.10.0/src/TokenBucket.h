@@ -2,7 +2,7 @@
 /*
  * aria2 - The high speed download utility
  *
- * Copyright (C) 2006 Tatsuhiro Tsujikawa
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
  *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -32,76 +32,61 @@
  * files in the program, then also delete it here.
  */
 /* copyright --> */
-#ifndef _D_BNODE_H_
-#define _D_BNODE_H_
+#ifndef _D_TOKEN_BUCKET_H_
+#define _D_TOKEN_BUCKET_H_
 
 #include "common.h"
 
-#include <vector>
+#include <stdint.h>
 
-#include "SharedHandle.h"
+#include "TimerA2.h"
 
 namespace aria2 {
 
-class DHTBucket;
-class DHTNode;
-
-class BNode {
+// Limits the rate of a transfer. Tokens are bytes: they accumulate at
+// rate bytes per second, up to one second worth of bytes, and each
+// transfer takes its length from them. The limit is exceeded while no
+// tokens are left. Time is measured with global::wallclock, so a
+// check costs O(1) regardless of the number of connections.
+//
+// This class is not thread-safe. All transfers run in the single
+// DownloadEngine thread, so the buckets are plain counters rather than
+// atomics.
+class TokenBucket {
 private:
-  SharedHandle<DHTBucket> bucket_;
+  // 0 means no limit.
+  unsigned int rate_;
 
-  BNode* up_;
+  // Becomes negative if a transfer takes more bytes than left.
+  int64_t tokens_;
 
-  BNode* left_;
-  
-  BNode* right_;
+  Timer lastRefill_;
 
+  void refill();
 public:
-  BNode(const SharedHandle<DHTBucket>& bucket = SharedHandle<DHTBucket>());
+  TokenBucket(unsigned int rate = 0);
 
-  ~BNode();
+  // Changes the rate and fills the bucket.
+  void setRate(unsigned int rate);
 
-  const SharedHandle<DHTBucket>& getBucket() const
+  unsigned int getRate() const
   {
-    return bucket_;
+    return rate_;
   }
 
-  void setBucket(const SharedHandle<DHTBucket>& bucket);
-
-  BNode* getLeft() const
-  {
-    return left_;
-  }
+  // Takes bytes from the bucket.
+  void consume(size_t bytes);
 
-  void setLeft(BNode* left);
+  // Returns true if the rate limit is reached. Always returns false
+  // if rate is 0.
+  bool exceeded();
 
-  BNode* getRight() const
+  int64_t getTokens() const
   {
-    return right_;
+    return tokens_;
   }
-
-  void setRight(BNode* right);
-
-  BNode* getUp() const
-  {
-    return up_;
-  }
-
-  void setUp(BNode* up);
-  
-  bool isInRange(const unsigned char* key) const;
-
-  static BNode* findBNodeFor(BNode* b, const unsigned char* key);
-
-  static SharedHandle<DHTBucket> findBucketFor(BNode* b, const unsigned char* key);
-
-  static void findClosestKNodes(std::vector<SharedHandle<DHTNode> >& nodes,
-                                BNode* b, const unsigned char* key);
-
-  static void enumerateBucket(std::vector<SharedHandle<DHTBucket> >& buckets,
-                              const BNode* b);
 };
 
 } // namespace aria2
 
-#endif // _D_BNODE_H_
+#endif // _D_TOKEN_BUCKET_H_
@@ -58,7 +58,11 @@ std::string UTMetadataDataExtensionMessage::getPayload()
   dict.put("msg_type", Integer::g(1));
   dict.put("piece", Integer::g(getIndex()));
   dict.put("total_size", Integer::g(totalSize_));
-  return bencode2::encode(&dict)+data_;
+  std::string payload;
+  payload.reserve(bencode2::encodedLength(&dict)+data_.size());
+  bencode2::encode(payload, &dict);
+  payload += data_;
+  return payload;
 }
 
 std::string UTMetadataDataExtensionMessage::toString() const
@@ -157,17 +157,20 @@ UTPexExtensionMessage::create(const unsigned char* data, size_t len)
   }
   UTPexExtensionMessageHandle msg(new UTPexExtensionMessage(*data));
 
-  SharedHandle<ValueBase> decoded = bencode2::decode(data+1, len-1);
-  const Dict* dict = asDict(decoded);
-  if(dict) {
-    const String* added = asString(dict->get("added"));
-    if(added) {
-      bittorrent::extractPeer(added, std::back_inserter(msg->freshPeers_));
-    }
-    const String* dropped = asString(dict->get("dropped"));
-    if(dropped) {
-      bittorrent::extractPeer(dropped, std::back_inserter(msg->droppedPeers_));
-    }
+  bencode2::ViewDecoder decoder;
+  decoder.decode(data+1, len-1);
+  const bencode2::View* dict = decoder.getRoot();
+  const bencode2::View* added =
+    decoder.get(dict, "added", bencode2::View::STRING);
+  if(added) {
+    bittorrent::extractPeer
+      (decoder, added, std::back_inserter(msg->freshPeers_));
+  }
+  const bencode2::View* dropped =
+    decoder.get(dict, "dropped", bencode2::View::STRING);
+  if(dropped) {
+    bittorrent::extractPeer
+      (decoder, dropped, std::back_inserter(msg->droppedPeers_));
   }
   return msg;
 }
@@ -109,6 +109,8 @@ XmlRpcMethodFactory::create(const std::string& methodName)
     return SharedHandle<XmlRpcMethod>(new GetVersionXmlRpcMethod());
   } else if(methodName == GetSessionInfoXmlRpcMethod::getMethodName()) {
     return SharedHandle<XmlRpcMethod>(new GetSessionInfoXmlRpcMethod());
+  } else if(methodName == GetGlobalStatXmlRpcMethod::getMethodName()) {
+    return SharedHandle<XmlRpcMethod>(new GetGlobalStatXmlRpcMethod());
   } else if(methodName == ShutdownXmlRpcMethod::getMethodName()) {
     return SharedHandle<XmlRpcMethod>(new ShutdownXmlRpcMethod());
   } else if(methodName == ForceShutdownXmlRpcMethod::getMethodName()) {
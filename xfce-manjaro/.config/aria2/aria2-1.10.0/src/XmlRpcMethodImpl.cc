@@ -67,6 +67,8 @@
 #include "FileAllocationEntry.h"
 #include "CheckIntegrityEntry.h"
 #include "Segment.h"
+#include "SocketBuffer.h"
+#include "BufferPool.h"
 #ifdef ENABLE_BITTORRENT
 # include "bittorrent_helper.h"
 # include "BtRegistry.h"
@@ -74,6 +76,10 @@
 # include "Peer.h"
 # include "BtRuntime.h"
 # include "BtAnnounce.h"
+# include "DHTRegistry.h"
+# include "DHTMessageTracker.h"
+# include "DHTMessageCallback.h"
+# include "DHTConnectionImpl.h"
 #endif // ENABLE_BITTORRENT
 
 namespace aria2 {
@@ -137,6 +143,19 @@ const std::string KEY_COMMENT = "comment";
 const std::string KEY_CREATION_DATE = "creationDate";
 const std::string KEY_MODE = "mode";
 const std::string KEY_SERVERS = "servers";
+const std::string KEY_NUM_WAITING = "numWaiting";
+const std::string KEY_NUM_STOPPED = "numStopped";
+const std::string KEY_NUM_ACTIVE = "numActive";
+const std::string KEY_ZERO_COPY_UPLOAD_LENGTH = "zeroCopyUploadLength";
+const std::string KEY_BUFFER_POOL_IN_USE = "bufferPoolInUse";
+const std::string KEY_BUFFER_POOL_HIGH_WATER = "bufferPoolHighWater";
+const std::string KEY_BUFFER_POOL_MISS = "bufferPoolMiss";
+const std::string KEY_DHT_PENDING_QUERIES = "dhtPendingQueries";
+const std::string KEY_DHT_QUERY_TIMEOUTS = "dhtQueryTimeouts";
+const std::string KEY_DHT_RECEIVE_CALLS = "dhtReceiveCalls";
+const std::string KEY_DHT_RECEIVED_PACKETS = "dhtReceivedPackets";
+const std::string KEY_DHT_SEND_CALLS = "dhtSendCalls";
+const std::string KEY_DHT_SENT_PACKETS = "dhtSentPackets";
 }
 
 static SharedHandle<ValueBase> createGIDResponse(gid_t gid)
@@ -1079,6 +1098,44 @@ SharedHandle<ValueBase> GetSessionInfoXmlRpcMethod::process
   return result;
 }
 
+SharedHandle<ValueBase> GetGlobalStatXmlRpcMethod::process
+(const XmlRpcRequest& req, DownloadEngine* e)
+{
+  const SharedHandle<RequestGroupMan>& rgman = e->getRequestGroupMan();
+  TransferStat ts = rgman->calculateStat();
+  SharedHandle<Dict> res = Dict::g();
+  res->put(KEY_DOWNLOAD_SPEED, util::uitos(ts.getDownloadSpeed()));
+  res->put(KEY_UPLOAD_SPEED, util::uitos(ts.getUploadSpeed()));
+  res->put(KEY_NUM_WAITING, util::uitos(rgman->getReservedGroups().size()));
+  res->put(KEY_NUM_STOPPED, util::uitos(rgman->getDownloadResults().size()));
+  res->put(KEY_NUM_ACTIVE, util::uitos(rgman->getRequestGroups().size()));
+  res->put(KEY_ZERO_COPY_UPLOAD_LENGTH,
+           util::uitos(SocketBuffer::getZeroCopySendLength()));
+  const SharedHandle<BufferPool>& pool = BufferPool::getInstance();
+  res->put(KEY_BUFFER_POOL_IN_USE, util::uitos(pool->countInUse()));
+  res->put(KEY_BUFFER_POOL_HIGH_WATER, util::uitos(pool->getHighWater()));
+  res->put(KEY_BUFFER_POOL_MISS, util::uitos(pool->countMiss()));
+#ifdef ENABLE_BITTORRENT
+  const SharedHandle<DHTMessageTracker>& tracker =
+    DHTRegistry::getData().messageTracker;
+  if(!tracker.isNull()) {
+    res->put(KEY_DHT_PENDING_QUERIES, util::uitos(tracker->countEntry()));
+    res->put(KEY_DHT_QUERY_TIMEOUTS, util::uitos(tracker->getNumTimeout()));
+  }
+  const SharedHandle<DHTConnectionImpl>& connection =
+    DHTRegistry::getData().connection;
+  if(!connection.isNull()) {
+    res->put(KEY_DHT_RECEIVE_CALLS,
+             util::uitos(connection->getNumReceiveCall()));
+    res->put(KEY_DHT_RECEIVED_PACKETS,
+             util::uitos(connection->getNumReceivedPacket()));
+    res->put(KEY_DHT_SEND_CALLS, util::uitos(connection->getNumSendCall()));
+    res->put(KEY_DHT_SENT_PACKETS, util::uitos(connection->getNumSentPacket()));
+  }
+#endif // ENABLE_BITTORRENT
+  return res;
+}
+
 SharedHandle<ValueBase> GetServersXmlRpcMethod::process
 (const XmlRpcRequest& req, DownloadEngine* e)
 {
@@ -485,6 +485,18 @@ public:
   }
 };
 
+class GetGlobalStatXmlRpcMethod:public XmlRpcMethod {
+protected:
+  virtual SharedHandle<ValueBase> process
+  (const XmlRpcRequest& req, DownloadEngine* e);
+public:
+  static const std::string& getMethodName()
+  {
+    static std::string methodName = "aria2.getGlobalStat";
+    return methodName;
+  }
+};
+
 class ShutdownXmlRpcMethod:public XmlRpcMethod {
 protected:
   virtual SharedHandle<ValueBase> process
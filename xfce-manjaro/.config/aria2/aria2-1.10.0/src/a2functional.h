@@ -175,6 +175,14 @@ public:
   }
 };
 
+class ArrayDeleter {
+public:
+  template<class T>
+  void operator()(T* ptr) {
+    delete [] ptr;
+  }
+};
+
 template<typename T>
 class Append {
 private:
@@ -40,6 +40,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <cerrno>
+#include <climits>
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #endif // HAVE_POLL_H
@@ -137,6 +138,22 @@
 # define a2mkdir(path, openMode) mkdir(path, openMode)
 #endif // !__MINGW32__
 
+#ifdef __MINGW32__
+// mingw32 does not have struct iovec. It is only used to pass a list
+// of buffers to BinaryStream::writeDataVec() and readDataVec().
+struct iovec {
+  void* iov_base;
+  size_t iov_len;
+};
+#else // !__MINGW32__
+# include <sys/uio.h>
+#endif // !__MINGW32__
+
+// The minimum value of IOV_MAX guaranteed by POSIX.
+#ifndef IOV_MAX
+# define IOV_MAX 16
+#endif // IOV_MAX
+
 #if defined HAVE_POSIX_MEMALIGN && defined O_DIRECT
 # define ENABLE_DIRECT_IO 1
 #endif // HAVE_POSIX_MEMALIGN && O_DIRECT
@@ -0,0 +1,68 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_A2_UNORDERED_MAP_H_
+#define _D_A2_UNORDERED_MAP_H_
+
+#include "common.h"
+
+#include <string>
+
+#ifdef HAVE_TR1_UNORDERED_MAP
+# include <tr1/unordered_map>
+#else // !HAVE_TR1_UNORDERED_MAP
+# include <map>
+#endif // !HAVE_TR1_UNORDERED_MAP
+
+namespace aria2 {
+
+// Hash table which maps Key to Value. Since C++98 lacks template
+// typedef, use UnorderedMap<Key, Value>::type. If
+// std::tr1::unordered_map is not available, std::map is used instead
+// and Hash is ignored.
+#ifdef HAVE_TR1_UNORDERED_MAP
+template<typename Key, typename Value, typename Hash = std::tr1::hash<Key> >
+struct UnorderedMap {
+  typedef std::tr1::unordered_map<Key, Value, Hash> type;
+};
+#else // !HAVE_TR1_UNORDERED_MAP
+template<typename Key, typename Value, typename Hash = void>
+struct UnorderedMap {
+  typedef std::map<Key, Value> type;
+};
+#endif // !HAVE_TR1_UNORDERED_MAP
+
+} // namespace aria2
+
+#endif // _D_A2_UNORDERED_MAP_H_
@@ -34,8 +34,9 @@
 /* copyright --> */
 #include "bencode2.h"
 
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <iterator>
 
 #include "StringFormat.h"
 #include "DlAbortEx.h"
@@ -44,85 +45,138 @@ namespace aria2 {
 
 namespace bencode2 {
 
-static SharedHandle<ValueBase> decodeiter(std::istream& ss, size_t depth);
+// The decoder reads directly from memory: first points to the next
+// byte to read and is advanced past each parsed term. Strings are
+// copied once, from the input into the resulting String.
 
-static void checkdelim(std::istream& ss, const char delim = ':')
+static SharedHandle<ValueBase> decodeiter
+(const unsigned char*& first, const unsigned char* last, size_t depth);
+
+static void checkdelim
+(const unsigned char*& first, const unsigned char* last,
+ const char delim = ':')
 {
-  char d;
-  if(!(ss.get(d) && d == delim)) {
+  if(first == last || *first != delim) {
     throw DL_ABORT_EX
       (StringFormat("Bencode decoding failed: Delimiter '%c' not found.",
                     delim).str());
   }
+  ++first;
 }
 
-static std::string decoderawstring(std::istream& ss)
+// Parses a non-negative decimal number which fits in int, as the
+// length of a string.
+static size_t decodelength
+(const unsigned char*& first, const unsigned char* last)
 {
-  int length;
-  ss >> length;
-  if(!ss || length < 0) {
+  if(first == last || !('0' <= *first && *first <= '9')) {
     throw DL_ABORT_EX("Bencode decoding failed:"
                       " A positive integer expected but none found.");
   }
-  // TODO check length, it must be less than or equal to INT_MAX
-  checkdelim(ss);
-  char* buf = new char[length];
-  ss.read(buf, length);
-  std::string str(&buf[0], &buf[length]);
-  delete [] buf;
-  if(ss.gcount() != static_cast<int>(length)) {
+  size_t length = 0;
+  for(; first != last && '0' <= *first && *first <= '9'; ++first) {
+    length = length*10+(*first-'0');
+    if(length > static_cast<size_t>(INT32_MAX)) {
+      throw DL_ABORT_EX("Bencode decoding failed:"
+                        " A positive integer expected but none found.");
+    }
+  }
+  return length;
+}
+
+static std::pair<const unsigned char*, size_t> decoderawstring
+(const unsigned char*& first, const unsigned char* last)
+{
+  size_t length = decodelength(first, last);
+  checkdelim(first, last);
+  size_t avail = last-first;
+  if(avail < length) {
     throw DL_ABORT_EX
       (StringFormat("Bencode decoding failed:"
                     " Expected %lu bytes of data, but only %d read.",
-                    static_cast<unsigned long>(length), ss.gcount()).str());
+                    static_cast<unsigned long>(length),
+                    static_cast<int>(avail)).str());
   }
+  std::pair<const unsigned char*, size_t> str(first, length);
+  first += length;
   return str;
 }
 
-static SharedHandle<ValueBase> decodestring(std::istream& ss)
+static SharedHandle<ValueBase> decodestring
+(const unsigned char*& first, const unsigned char* last)
 {
-  return String::g(decoderawstring(ss));
+  std::pair<const unsigned char*, size_t> str = decoderawstring(first, last);
+  return String::g(str.first, str.second);
 }
 
-static SharedHandle<ValueBase> decodeinteger(std::istream& ss)
+static Integer::ValueType decoderawinteger
+(const unsigned char*& first, const unsigned char* last)
 {
-  Integer::ValueType iv;
-  ss >> iv;
-  if(!ss) {
+  bool negative = false;
+  if(first != last && *first == '-') {
+    negative = true;
+    ++first;
+  }
+  if(first == last || !('0' <= *first && *first <= '9')) {
     throw DL_ABORT_EX("Bencode decoding failed:"
                       " Integer expected but none found");
   }
-  checkdelim(ss, 'e');
-  return Integer::g(iv);
+  // Accumulates as a negative number, so that INT64_MIN is accepted.
+  Integer::ValueType iv = 0;
+  for(; first != last && '0' <= *first && *first <= '9'; ++first) {
+    int digit = *first-'0';
+    if(iv < (INT64_MIN+digit)/10) {
+      throw DL_ABORT_EX("Bencode decoding failed:"
+                        " Integer expected but none found");
+    }
+    iv = iv*10-digit;
+  }
+  if(!negative) {
+    if(iv == INT64_MIN) {
+      throw DL_ABORT_EX("Bencode decoding failed:"
+                        " Integer expected but none found");
+    }
+    iv = -iv;
+  }
+  checkdelim(first, last, 'e');
+  return iv;
+}
+
+static SharedHandle<ValueBase> decodeinteger
+(const unsigned char*& first, const unsigned char* last)
+{
+  return Integer::g(decoderawinteger(first, last));
 }
 
-static SharedHandle<ValueBase> decodedict(std::istream& ss, size_t depth)
+static SharedHandle<ValueBase> decodedict
+(const unsigned char*& first, const unsigned char* last, size_t depth)
 {
   SharedHandle<Dict> dict = Dict::g();
-  char c;
-  while(ss.get(c)) {
-    if(c == 'e') {
+  while(first != last) {
+    if(*first == 'e') {
+      ++first;
       return dict;
     } else {
-      ss.unget();
-      std::string key = decoderawstring(ss);
-      dict->put(key, decodeiter(ss, depth));
+      std::pair<const unsigned char*, size_t> key =
+        decoderawstring(first, last);
+      dict->put(std::string(&key.first[0], &key.first[key.second]),
+                decodeiter(first, last, depth));
     }
   }
   throw DL_ABORT_EX("Bencode decoding failed:"
                     " Unexpected EOF in dict context. 'e' expected.");
 }
 
-static SharedHandle<ValueBase> decodelist(std::istream& ss, size_t depth)
+static SharedHandle<ValueBase> decodelist
+(const unsigned char*& first, const unsigned char* last, size_t depth)
 {
   SharedHandle<List> list = List::g();
-  char c;
-  while(ss.get(c)) {
-    if(c == 'e') {
+  while(first != last) {
+    if(*first == 'e') {
+      ++first;
       return list;
     } else {
-      ss.unget();
-      list->append(decodeiter(ss, depth));
+      list->append(decodeiter(first, last, depth));
     }
   }
   throw DL_ABORT_EX("Bencode decoding failed:"
@@ -136,30 +190,39 @@ static void checkDepth(size_t depth)
   }
 }
 
-static SharedHandle<ValueBase> decodeiter(std::istream& ss, size_t depth)
+static void checkTerm
+(const unsigned char* first, const unsigned char* last, size_t depth)
 {
   checkDepth(depth);
-  char c;
-  if(!ss.get(c)) {
+  if(first == last) {
     throw DL_ABORT_EX("Bencode decoding failed:"
                       " Unexpected EOF in term context."
                       " 'd', 'l', 'i' or digit is expected.");
   }
+}
+
+static SharedHandle<ValueBase> decodeiter
+(const unsigned char*& first, const unsigned char* last, size_t depth)
+{
+  checkTerm(first, last, depth);
+  unsigned char c = *first;
   if(c == 'd') {
-    return decodedict(ss, depth+1);
+    return decodedict(++first, last, depth+1);
   } else if(c == 'l') {
-    return decodelist(ss, depth+1);
+    return decodelist(++first, last, depth+1);
   } else if(c == 'i') {
-    return decodeinteger(ss);
+    return decodeinteger(++first, last);
   } else {
-    ss.unget();
-    return decodestring(ss);
+    return decodestring(first, last);
   }
 }
 
 SharedHandle<ValueBase> decode(std::istream& in)
 {
-  return decodeiter(in, 0);
+  std::string s((std::istreambuf_iterator<char>(in)),
+                std::istreambuf_iterator<char>());
+  const unsigned char* first = reinterpret_cast<const unsigned char*>(s.data());
+  return decodeiter(first, first+s.size(), 0);
 }
 
 SharedHandle<ValueBase> decode(const std::string& s)
@@ -170,24 +233,25 @@ SharedHandle<ValueBase> decode(const std::string& s)
 
 SharedHandle<ValueBase> decode(const std::string& s, size_t& end)
 {
-  if(s.empty()) {
-    return SharedHandle<ValueBase>();
-  }
-  std::istringstream ss(s);
-
-  SharedHandle<ValueBase> vlb = decodeiter(ss, 0);
-  end = ss.tellg();
-  return vlb;
+  return decode(reinterpret_cast<const unsigned char*>(s.data()), s.size(),
+                end);
 }
 
 SharedHandle<ValueBase> decode(const unsigned char* data, size_t length)
 {
-  return decode(std::string(&data[0], &data[length]));
+  size_t end;
+  return decode(data, length, end);
 }
 
 SharedHandle<ValueBase> decode(const unsigned char* data, size_t length, size_t& end)
 {
-  return decode(std::string(&data[0], &data[length]), end);
+  if(length == 0) {
+    return SharedHandle<ValueBase>();
+  }
+  const unsigned char* first = data;
+  SharedHandle<ValueBase> vlb = decodeiter(first, data+length, 0);
+  end = first-data;
+  return vlb;
 }
 
 SharedHandle<ValueBase> decodeFromFile(const std::string& filename)
@@ -202,55 +266,280 @@ SharedHandle<ValueBase> decodeFromFile(const std::string& filename)
   }
 }
 
-std::string encode(const ValueBase* vlb)
+static void decodeviewiter
+(std::vector<View>& views,
+ const unsigned char*& first, const unsigned char* last, size_t depth)
 {
-  class BencodeValueBaseVisitor:public ValueBaseVisitor {
-  private:
-    std::ostringstream out_;
-  public:
-    virtual void visit(const String& string)
-    {
-      const std::string& s = string.s();
-      out_ << s.size() << ":";
-      out_.write(s.data(), s.size());
+  checkTerm(first, last, depth);
+  // views may be reallocated while elements are decoded, so v is
+  // copied in when it is complete.
+  size_t index = views.size();
+  views.push_back(View());
+  View v;
+  v.data = first;
+  v.i = 0;
+  v.size = 0;
+  unsigned char c = *first;
+  if(c == 'd' || c == 'l') {
+    v.type = c == 'd' ? View::DICT : View::LIST;
+    ++first;
+    while(1) {
+      if(first == last) {
+        throw DL_ABORT_EX
+          (StringFormat("Bencode decoding failed:"
+                        " Unexpected EOF in %s context. 'e' expected.",
+                        v.type == View::DICT ? "dict" : "list").str());
+      }
+      if(*first == 'e') {
+        ++first;
+        break;
+      }
+      if(v.type == View::DICT) {
+        View key;
+        key.type = View::STRING;
+        std::pair<const unsigned char*, size_t> str =
+          decoderawstring(first, last);
+        key.data = str.first;
+        key.length = str.second;
+        key.i = 0;
+        key.size = 0;
+        key.next = views.size()+1;
+        views.push_back(key);
+      }
+      decodeviewiter(views, first, last, depth+1);
+      ++v.size;
     }
+    v.length = first-v.data;
+  } else if(c == 'i') {
+    v.type = View::INTEGER;
+    v.i = decoderawinteger(++first, last);
+    v.length = first-v.data;
+  } else {
+    v.type = View::STRING;
+    std::pair<const unsigned char*, size_t> str =
+      decoderawstring(first, last);
+    v.data = str.first;
+    v.length = str.second;
+  }
+  v.next = views.size();
+  views[index] = v;
+}
 
-    virtual void visit(const Integer& integer)
-    {
-      out_ << "i" << integer.i() << "e";
+size_t ViewDecoder::decode(const unsigned char* data, size_t length)
+{
+  views_.clear();
+  if(length == 0) {
+    return 0;
+  }
+  const unsigned char* first = data;
+  try {
+    decodeviewiter(views_, first, data+length, 0);
+  } catch(RecoverableException& e) {
+    views_.clear();
+    throw;
+  }
+  return first-data;
+}
+
+const View* ViewDecoder::get(const View* dict, const std::string& key) const
+{
+  if(!dict || dict->type != View::DICT) {
+    return 0;
+  }
+  const View* value = 0;
+  const View* k = first(dict);
+  for(size_t i = 0; i < dict->size; ++i) {
+    const View* v = k+1;
+    if(k->length == key.size() &&
+       memcmp(k->data, key.data(), key.size()) == 0) {
+      value = v;
     }
+    k = next(v);
+  }
+  return value;
+}
 
-    virtual void visit(const List& list)
-    {
-      out_ << "l";
-      for(List::ValueType::const_iterator i = list.begin(), eoi = list.end();
-          i != eoi; ++i){
-        (*i)->accept(*this);
-      }
-      out_ << "e";
+const View* ViewDecoder::get
+(const View* dict, const std::string& key, View::Type type) const
+{
+  const View* value = get(dict, key);
+  if(value && value->type == type) {
+    return value;
+  } else {
+    return 0;
+  }
+}
+
+// Returns the number of characters of the decimal representation of
+// n.
+static size_t countDigits(uint64_t n)
+{
+  size_t len = 1;
+  for(; n >= 10; n /= 10) {
+    ++len;
+  }
+  return len;
+}
+
+static size_t integerLength(Integer::ValueType i)
+{
+  if(i < 0) {
+    return 1+countDigits(-static_cast<uint64_t>(i));
+  } else {
+    return countDigits(i);
+  }
+}
+
+static unsigned char* writeDigits(unsigned char* dst, uint64_t n)
+{
+  unsigned char* last = dst+countDigits(n);
+  unsigned char* p = last;
+  do {
+    *--p = '0'+n%10;
+    n /= 10;
+  } while(n);
+  return last;
+}
+
+static unsigned char* writeInteger(unsigned char* dst, Integer::ValueType i)
+{
+  if(i < 0) {
+    *dst++ = '-';
+    return writeDigits(dst, -static_cast<uint64_t>(i));
+  } else {
+    return writeDigits(dst, i);
+  }
+}
+
+static unsigned char* writeString(unsigned char* dst, const std::string& s)
+{
+  dst = writeDigits(dst, s.size());
+  *dst++ = ':';
+  memcpy(dst, s.data(), s.size());
+  return dst+s.size();
+}
+
+namespace {
+
+class LengthVisitor:public ValueBaseVisitor {
+private:
+  size_t length_;
+public:
+  LengthVisitor():length_(0) {}
+
+  virtual void visit(const String& string)
+  {
+    const std::string& s = string.s();
+    length_ += countDigits(s.size())+1+s.size();
+  }
+
+  virtual void visit(const Integer& integer)
+  {
+    length_ += integerLength(integer.i())+2;
+  }
+
+  virtual void visit(const List& list)
+  {
+    length_ += 2;
+    for(List::ValueType::const_iterator i = list.begin(), eoi = list.end();
+        i != eoi; ++i){
+      (*i)->accept(*this);
     }
+  }
 
-    virtual void visit(const Dict& dict)
-    {
-      out_ << "d";
-      for(Dict::ValueType::const_iterator i = dict.begin(), eoi = dict.end();
-          i != eoi; ++i){
-        const std::string& key = (*i).first;
-        out_ << key.size() << ":";
-        out_.write(key.data(), key.size());
-        (*i).second->accept(*this);
-      }
-      out_ << "e";
+  virtual void visit(const Dict& dict)
+  {
+    length_ += 2;
+    for(Dict::ValueType::const_iterator i = dict.begin(), eoi = dict.end();
+        i != eoi; ++i){
+      const std::string& key = (*i).first;
+      length_ += countDigits(key.size())+1+key.size();
+      (*i).second->accept(*this);
+    }
+  }
+
+  size_t getLength() const
+  {
+    return length_;
+  }
+};
+
+class WriteVisitor:public ValueBaseVisitor {
+private:
+  unsigned char* dst_;
+public:
+  WriteVisitor(unsigned char* dst):dst_(dst) {}
+
+  virtual void visit(const String& string)
+  {
+    dst_ = writeString(dst_, string.s());
+  }
+
+  virtual void visit(const Integer& integer)
+  {
+    *dst_++ = 'i';
+    dst_ = writeInteger(dst_, integer.i());
+    *dst_++ = 'e';
+  }
+
+  virtual void visit(const List& list)
+  {
+    *dst_++ = 'l';
+    for(List::ValueType::const_iterator i = list.begin(), eoi = list.end();
+        i != eoi; ++i){
+      (*i)->accept(*this);
     }
+    *dst_++ = 'e';
+  }
 
-    std::string getResult() const
-    {
-      return out_.str();
+  virtual void visit(const Dict& dict)
+  {
+    *dst_++ = 'd';
+    for(Dict::ValueType::const_iterator i = dict.begin(), eoi = dict.end();
+        i != eoi; ++i){
+      dst_ = writeString(dst_, (*i).first);
+      (*i).second->accept(*this);
     }
-  };
-  BencodeValueBaseVisitor visitor;
+    *dst_++ = 'e';
+  }
+
+  unsigned char* getPosition() const
+  {
+    return dst_;
+  }
+};
+
+} // namespace
+
+size_t encodedLength(const ValueBase* vlb)
+{
+  LengthVisitor visitor;
   vlb->accept(visitor);
-  return visitor.getResult();
+  return visitor.getLength();
+}
+
+unsigned char* encode(unsigned char* dst, const ValueBase* vlb)
+{
+  WriteVisitor visitor(dst);
+  vlb->accept(visitor);
+  return visitor.getPosition();
+}
+
+void encode(std::string& out, const ValueBase* vlb)
+{
+  size_t offset = out.size();
+  size_t length = encodedLength(vlb);
+  out.resize(offset+length);
+  if(length) {
+    encode(reinterpret_cast<unsigned char*>(&out[offset]), vlb);
+  }
+}
+
+std::string encode(const ValueBase* vlb)
+{
+  std::string out;
+  encode(out, vlb);
+  return out;
 }
 
 std::string encode(const SharedHandle<ValueBase>& vlb)
@@ -38,6 +38,7 @@
 #include "common.h"
 
 #include <string>
+#include <vector>
 #include <iosfwd>
 
 #include "ValueBase.h"
@@ -64,6 +65,93 @@ SharedHandle<ValueBase> decode
 
 SharedHandle<ValueBase> decodeFromFile(const std::string& filename);
 
+// A term decoded by ViewDecoder. It refers to the decoded buffer
+// instead of copying from it, so it is only valid while the buffer
+// and the ViewDecoder are.
+struct View {
+  enum Type {
+    STRING,
+    INTEGER,
+    LIST,
+    DICT
+  };
+
+  Type type;
+
+  // The string of a STRING. For the other types, the whole encoded
+  // term.
+  const unsigned char* data;
+  size_t length;
+
+  // The value of an INTEGER.
+  Integer::ValueType i;
+
+  // The number of elements of a LIST, or of entries of a DICT.
+  size_t size;
+
+  // The index of the first term after this one and all of its
+  // elements.
+  size_t next;
+
+  std::string s() const
+  {
+    return std::string(&data[0], &data[length]);
+  }
+};
+
+// Decodes without copying: strings are views into the input and all
+// terms of one decode are stored in a single vector, in depth-first
+// order. The vector keeps its capacity, so reusing a ViewDecoder
+// decodes without memory allocation once it has grown.
+class ViewDecoder {
+private:
+  std::vector<View> views_;
+public:
+  // Decodes the term at the beginning of data and returns its encoded
+  // length. Throws DlAbortEx if data is malformed. Views from a
+  // previous call are invalidated.
+  size_t decode(const unsigned char* data, size_t length);
+
+  // Returns the term decoded last, or 0 if there is none.
+  const View* getRoot() const
+  {
+    return views_.empty() ? 0 : &views_[0];
+  }
+
+  // Returns the first element of a LIST, or the first key of a
+  // DICT. The value of a key is the term right after it.
+  const View* first(const View* v) const
+  {
+    return v+1;
+  }
+
+  // Returns the term after v and all of its elements.
+  const View* next(const View* v) const
+  {
+    return &views_[0]+v->next;
+  }
+
+  // Returns the value for key in dict, or 0 if dict is 0, not a DICT,
+  // or does not have key. If key appears more than once, the last
+  // value is returned, as Dict does.
+  const View* get(const View* dict, const std::string& key) const;
+
+  // Same as above, but also returns 0 if the value is not of type.
+  const View* get
+  (const View* dict, const std::string& key, View::Type type) const;
+};
+
+// Returns the length of the bencoded vlb.
+size_t encodedLength(const ValueBase* vlb);
+
+// Writes the bencoded vlb to dst, which must have room for
+// encodedLength(vlb) bytes. Returns the position after the last
+// written byte.
+unsigned char* encode(unsigned char* dst, const ValueBase* vlb);
+
+// Appends the bencoded vlb to out. out is grown once.
+void encode(std::string& out, const ValueBase* vlb);
+
 std::string encode(const ValueBase* vlb);
 
 std::string encode(const SharedHandle<ValueBase>& vlb);
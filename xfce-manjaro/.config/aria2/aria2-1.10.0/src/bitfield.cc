@@ -34,6 +34,17 @@
 /* copyright --> */
 #include "bitfield.h"
 
+#include <algorithm>
+
+// x86 kernels need function level target attributes, which appeared
+// in GCC 4.9.
+#if defined __GNUC__ && !defined __clang__ &&                          \
+  (defined __x86_64__ || defined __i386__) &&                           \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+# define A2_X86_BITFIELD_KERNEL 1
+# include <immintrin.h>
+#endif
+
 namespace aria2 {
 
 namespace bitfield {
@@ -46,6 +57,495 @@ void flipBit(unsigned char* data, size_t length, size_t bitIndex)
   data[byteIndex] ^= mask;
 }
 
+namespace {
+
+// A kernel works on len whole bytes of x = p1 & p2 & ~n1 & ~n2.
+// None of the operands may be 0.
+struct Kernel {
+  const char* name;
+  // Stores x to dst. Returns true if any bit of x is set.
+  bool (*compute)
+  (unsigned char* dst,
+   const unsigned char* p1, const unsigned char* p2,
+   const unsigned char* n1, const unsigned char* n2,
+   size_t len);
+  // Returns the number of set bits in x.
+  size_t (*count)
+  (const unsigned char* p1, const unsigned char* p2,
+   const unsigned char* n1, const unsigned char* n2,
+   size_t len);
+  // Returns the index of the first non-zero byte of x, or len if
+  // there is none.
+  size_t (*findFirst)
+  (const unsigned char* p1, const unsigned char* p2,
+   const unsigned char* n1, const unsigned char* n2,
+   size_t len);
+};
+
+inline unsigned char combine
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t i)
+{
+  return p1[i]&p2[i]&~(n1[i]|n2[i]);
+}
+
+bool computeGeneric
+(unsigned char* dst,
+ const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  unsigned char bits = 0;
+  for(size_t i = 0; i < len; ++i) {
+    dst[i] = combine(p1, p2, n1, n2, i);
+    bits |= dst[i];
+  }
+  return bits != 0;
+}
+
+size_t countGeneric
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  size_t count = 0;
+  for(size_t i = 0; i < len; ++i) {
+    count += countBit32(combine(p1, p2, n1, n2, i));
+  }
+  return count;
+}
+
+size_t findFirstGeneric
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  for(size_t i = 0; i < len; ++i) {
+    if(combine(p1, p2, n1, n2, i)) {
+      return i;
+    }
+  }
+  return len;
+}
+
+inline uint64_t combine64
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t i)
+{
+  uint64_t a, b, c, d;
+  memcpy(&a, p1+i, sizeof(a));
+  memcpy(&b, p2+i, sizeof(b));
+  memcpy(&c, n1+i, sizeof(c));
+  memcpy(&d, n2+i, sizeof(d));
+  return a&b&~(c|d);
+}
+
+inline size_t countBit64(uint64_t v)
+{
+  v = v-((v >> 1)&0x5555555555555555ULL);
+  v = (v&0x3333333333333333ULL)+((v >> 2)&0x3333333333333333ULL);
+  v = (v+(v >> 4))&0x0f0f0f0f0f0f0f0fULL;
+  return (v*0x0101010101010101ULL) >> 56;
+}
+
+bool computeWord64
+(unsigned char* dst,
+ const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  uint64_t bits = 0;
+  size_t i = 0;
+  for(; i+8 <= len; i += 8) {
+    uint64_t x = combine64(p1, p2, n1, n2, i);
+    memcpy(dst+i, &x, sizeof(x));
+    bits |= x;
+  }
+  return computeGeneric(dst+i, p1+i, p2+i, n1+i, n2+i, len-i) || bits != 0;
+}
+
+size_t countWord64
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  size_t count = 0;
+  size_t i = 0;
+  for(; i+8 <= len; i += 8) {
+    count += countBit64(combine64(p1, p2, n1, n2, i));
+  }
+  return count+countGeneric(p1+i, p2+i, n1+i, n2+i, len-i);
+}
+
+size_t findFirstWord64
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  size_t i = 0;
+  for(; i+8 <= len; i += 8) {
+    if(combine64(p1, p2, n1, n2, i)) {
+      break;
+    }
+  }
+  return i+findFirstGeneric(p1+i, p2+i, n1+i, n2+i, len-i);
+}
+
+#ifdef A2_X86_BITFIELD_KERNEL
+
+__attribute__((target("sse2")))
+inline __m128i combine128
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t i)
+{
+  __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1+i));
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p2+i));
+  __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n1+i));
+  __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n2+i));
+  return _mm_andnot_si128(_mm_or_si128(c, d), _mm_and_si128(a, b));
+}
+
+__attribute__((target("sse2")))
+bool computeSSE2
+(unsigned char* dst,
+ const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  __m128i bits = _mm_setzero_si128();
+  size_t i = 0;
+  for(; i+16 <= len; i += 16) {
+    __m128i x = combine128(p1, p2, n1, n2, i);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i), x);
+    bits = _mm_or_si128(bits, x);
+  }
+  return computeWord64(dst+i, p1+i, p2+i, n1+i, n2+i, len-i) ||
+    _mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128())) != 0xffff;
+}
+
+__attribute__((target("sse2")))
+size_t countSSE2
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  const __m128i m1 = _mm_set1_epi8(0x55);
+  const __m128i m2 = _mm_set1_epi8(0x33);
+  const __m128i m4 = _mm_set1_epi8(0x0f);
+  __m128i sum = _mm_setzero_si128();
+  size_t i = 0;
+  for(; i+16 <= len; i += 16) {
+    __m128i v = combine128(p1, p2, n1, n2, i);
+    v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+    v = _mm_add_epi8(_mm_and_si128(v, m2),
+                     _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+    v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(v, _mm_setzero_si128()));
+  }
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+  return lanes[0]+lanes[1]+countWord64(p1+i, p2+i, n1+i, n2+i, len-i);
+}
+
+__attribute__((target("sse2")))
+size_t findFirstSSE2
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  size_t i = 0;
+  for(; i+16 <= len; i += 16) {
+    unsigned int zero = _mm_movemask_epi8
+      (_mm_cmpeq_epi8(combine128(p1, p2, n1, n2, i), _mm_setzero_si128()));
+    if(zero != 0xffffu) {
+      return i+__builtin_ctz(~zero);
+    }
+  }
+  return i+findFirstWord64(p1+i, p2+i, n1+i, n2+i, len-i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i combine256
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t i)
+{
+  __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p1+i));
+  __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p2+i));
+  __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(n1+i));
+  __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(n2+i));
+  return _mm256_andnot_si256(_mm256_or_si256(c, d), _mm256_and_si256(a, b));
+}
+
+__attribute__((target("avx2")))
+bool computeAVX2
+(unsigned char* dst,
+ const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  __m256i bits = _mm256_setzero_si256();
+  size_t i = 0;
+  for(; i+32 <= len; i += 32) {
+    __m256i x = combine256(p1, p2, n1, n2, i);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i), x);
+    bits = _mm256_or_si256(bits, x);
+  }
+  return computeWord64(dst+i, p1+i, p2+i, n1+i, n2+i, len-i) ||
+    !_mm256_testz_si256(bits, bits);
+}
+
+__attribute__((target("avx2")))
+size_t countAVX2
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  // The number of set bits in each 4 bit value.
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                       1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3,
+                                       1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i m4 = _mm256_set1_epi8(0x0f);
+  __m256i sum = _mm256_setzero_si256();
+  size_t i = 0;
+  for(; i+32 <= len; i += 32) {
+    __m256i v = combine256(p1, p2, n1, n2, i);
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, m4));
+    __m256i hi = _mm256_shuffle_epi8
+      (lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), m4));
+    sum = _mm256_add_epi64
+      (sum, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+  return lanes[0]+lanes[1]+lanes[2]+lanes[3]+
+    countWord64(p1+i, p2+i, n1+i, n2+i, len-i);
+}
+
+__attribute__((target("avx2")))
+size_t findFirstAVX2
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  size_t i = 0;
+  for(; i+32 <= len; i += 32) {
+    unsigned int zero = _mm256_movemask_epi8
+      (_mm256_cmpeq_epi8(combine256(p1, p2, n1, n2, i),
+                         _mm256_setzero_si256()));
+    if(zero != 0xffffffffu) {
+      return i+__builtin_ctz(~zero);
+    }
+  }
+  return i+findFirstWord64(p1+i, p2+i, n1+i, n2+i, len-i);
+}
+
+#endif // A2_X86_BITFIELD_KERNEL
+
+// Slowest first.
+const Kernel KERNELS[] = {
+  { "generic", computeGeneric, countGeneric, findFirstGeneric },
+  { "word64", computeWord64, countWord64, findFirstWord64 },
+#ifdef A2_X86_BITFIELD_KERNEL
+  { "sse2", computeSSE2, countSSE2, findFirstSSE2 },
+  { "avx2", computeAVX2, countAVX2, findFirstAVX2 },
+#endif // A2_X86_BITFIELD_KERNEL
+};
+
+const size_t NUM_KERNEL = sizeof(KERNELS)/sizeof(KERNELS[0]);
+
+bool isAvailable(const Kernel& kernel)
+{
+#ifdef A2_X86_BITFIELD_KERNEL
+  __builtin_cpu_init();
+  if(strcmp(kernel.name, "sse2") == 0) {
+    return __builtin_cpu_supports("sse2");
+  } else if(strcmp(kernel.name, "avx2") == 0) {
+    return __builtin_cpu_supports("avx2");
+  }
+#endif // A2_X86_BITFIELD_KERNEL
+  return true;
+}
+
+// Operands which are 0 are replaced with these buffers and the
+// bitfield is processed CHUNK bytes at a time.
+const size_t CHUNK = 4096;
+
+unsigned char zeroBits[CHUNK];
+
+unsigned char oneBits[CHUNK];
+
+const Kernel* kernel_ = 0;
+
+const Kernel* getCurrentKernel()
+{
+  if(!kernel_) {
+    memset(oneBits, 0xff, sizeof(oneBits));
+    for(size_t i = 0; i < NUM_KERNEL; ++i) {
+      if(isAvailable(KERNELS[i])) {
+        kernel_ = &KERNELS[i];
+      }
+    }
+  }
+  return kernel_;
+}
+
+// Calls f on each chunk of len bytes with 0 operands replaced.
+class Chunker {
+private:
+  const unsigned char* p1_;
+  const unsigned char* p2_;
+  const unsigned char* n1_;
+  const unsigned char* n2_;
+  size_t len_;
+  size_t offset_;
+  size_t chunkLen_;
+public:
+  Chunker(const unsigned char* p1, const unsigned char* p2,
+          const unsigned char* n1, const unsigned char* n2,
+          size_t len):
+    p1_(p1), p2_(p2), n1_(n1), n2_(n2), len_(len), offset_(0),
+    chunkLen_(p1 && p2 && n1 && n2 ? len : CHUNK) {}
+
+  bool finished() const { return offset_ >= len_; }
+
+  void next() { offset_ += chunkLen_; }
+
+  size_t offset() const { return offset_; }
+
+  size_t length() const { return std::min(chunkLen_, len_-offset_); }
+
+  const unsigned char* p1() const { return p1_ ? p1_+offset_ : oneBits; }
+
+  const unsigned char* p2() const { return p2_ ? p2_+offset_ : oneBits; }
+
+  const unsigned char* n1() const { return n1_ ? n1_+offset_ : zeroBits; }
+
+  const unsigned char* n2() const { return n2_ ? n2_+offset_ : zeroBits; }
+};
+
+unsigned char combineAt
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t i)
+{
+  unsigned char x = 0xff;
+  if(p1) { x &= p1[i]; }
+  if(p2) { x &= p2[i]; }
+  if(n1) { x &= ~n1[i]; }
+  if(n2) { x &= ~n2[i]; }
+  return x;
+}
+
+} // namespace
+
+bool computeBits
+(unsigned char* dst,
+ const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t nbits)
+{
+  if(!dst) {
+    size_t index;
+    return findFirstBit(index, p1, p2, n1, n2, nbits);
+  }
+  const Kernel* kernel = getCurrentKernel();
+  const size_t len = nbits/8;
+  bool bits = false;
+  for(Chunker c(p1, p2, n1, n2, len); !c.finished(); c.next()) {
+    if(kernel->compute(dst+c.offset(), c.p1(), c.p2(), c.n1(), c.n2(),
+                       c.length())) {
+      bits = true;
+    }
+  }
+  if(nbits%8) {
+    dst[len] = combineAt(p1, p2, n1, n2, len)&lastByteMask(nbits);
+    bits |= dst[len] != 0;
+  }
+  return bits;
+}
+
+size_t countBits
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t nbits)
+{
+  const Kernel* kernel = getCurrentKernel();
+  const size_t len = nbits/8;
+  size_t count = 0;
+  for(Chunker c(p1, p2, n1, n2, len); !c.finished(); c.next()) {
+    count += kernel->count(c.p1(), c.p2(), c.n1(), c.n2(), c.length());
+  }
+  if(nbits%8) {
+    count += countBit32(combineAt(p1, p2, n1, n2, len)&lastByteMask(nbits));
+  }
+  return count;
+}
+
+bool findFirstBit
+(size_t& index,
+ const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t nbits)
+{
+  const Kernel* kernel = getCurrentKernel();
+  const size_t len = nbits/8;
+  size_t byteIndex = len;
+  for(Chunker c(p1, p2, n1, n2, len); !c.finished(); c.next()) {
+    size_t i = kernel->findFirst(c.p1(), c.p2(), c.n1(), c.n2(), c.length());
+    if(i < c.length()) {
+      byteIndex = c.offset()+i;
+      break;
+    }
+  }
+  unsigned char x = 0;
+  if(byteIndex < len) {
+    x = combineAt(p1, p2, n1, n2, byteIndex);
+  } else if(nbits%8) {
+    x = combineAt(p1, p2, n1, n2, len)&lastByteMask(nbits);
+  }
+  if(x == 0) {
+    return false;
+  }
+  index = byteIndex*8;
+  for(unsigned char mask = 128; !(x&mask); mask >>= 1) {
+    ++index;
+  }
+  return true;
+}
+
+std::vector<std::string> getAvailableKernels()
+{
+  std::vector<std::string> names;
+  for(size_t i = 0; i < NUM_KERNEL; ++i) {
+    if(isAvailable(KERNELS[i])) {
+      names.push_back(KERNELS[i].name);
+    }
+  }
+  return names;
+}
+
+bool selectKernel(const std::string& name)
+{
+  getCurrentKernel();
+  for(size_t i = 0; i < NUM_KERNEL; ++i) {
+    if(name == KERNELS[i].name && isAvailable(KERNELS[i])) {
+      kernel_ = &KERNELS[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string getKernel()
+{
+  return getCurrentKernel()->name;
+}
+
 } // namespace bitfield
 
 } // namespace aria2
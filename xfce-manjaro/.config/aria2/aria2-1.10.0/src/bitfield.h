@@ -40,6 +40,8 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "util.h"
 
@@ -127,6 +129,50 @@ inline size_t countSetBit(const unsigned char* bitfield, size_t nbits)
 
 void flipBit(unsigned char* data, size_t length, size_t bitIndex);
 
+// The following functions scan the bitfield
+//
+//   x = p1 & p2 & ~n1 & ~n2
+//
+// of nbits bits, computing it a word at a time, without storing it
+// unless requested. Any of p1, p2, n1 and n2 may be 0: p1 and p2 are
+// then treated as all bits set, and n1 and n2 as no bits set. The
+// work is done by the fastest kernel the CPU supports, see
+// selectKernel().
+
+// Stores x to dst, which must hold (nbits+7)/8 bytes, unless dst is
+// 0. Bits after nbits in the last byte of dst are cleared. Returns
+// true if any bit of x is set.
+bool computeBits
+(unsigned char* dst,
+ const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t nbits);
+
+// Returns the number of set bits in x.
+size_t countBits
+(const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t nbits);
+
+// Stores the index of the first set bit of x to index. Returns false
+// if no bit is set.
+bool findFirstBit
+(size_t& index,
+ const unsigned char* p1, const unsigned char* p2,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t nbits);
+
+// Returns the names of the kernels this CPU can run, slowest
+// first. "generic" is always available.
+std::vector<std::string> getAvailableKernels();
+
+// Makes the kernel name used by the functions above. Returns false
+// if name is not available, leaving the current kernel unchanged.
+bool selectKernel(const std::string& name);
+
+// Returns the name of the kernel in use.
+std::string getKernel();
+
 // Stores first missing bit index of bitfield to index.  bitfield
 // contains nbits. Returns true if missing bit index is
 // found. Otherwise returns false.
@@ -960,7 +960,7 @@ std::string metadata2Torrent
   }
   if(!announceList.empty()) {
     torrent += "13:announce-list";
-    torrent += bencode2::encode(&announceList);
+    bencode2::encode(torrent, &announceList);
   }
   torrent +=
     strconcat("4:info", metadata, "e");
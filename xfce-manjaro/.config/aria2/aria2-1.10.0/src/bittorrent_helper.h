@@ -47,6 +47,7 @@
 #include "a2netcompat.h"
 #include "Peer.h"
 #include "ValueBase.h"
+#include "bencode2.h"
 
 namespace aria2 {
 
@@ -215,6 +216,28 @@ std::string metadata2Torrent
 // Constructs BitTorrent Magnet URI using attrs.
 std::string torrent2Magnet(const SharedHandle<TorrentAttribute>& attrs);
 
+// Extracts peers from compact peer data: 4 bytes of IPv4 address
+// and 2 bytes of port, both in network byte order, per peer. Nothing
+// is extracted if length is not a multiple of 6.
+template<typename OutputIterator>
+OutputIterator extractCompactPeer
+(const unsigned char* data, size_t length, OutputIterator dest)
+{
+  if(length%6 == 0) {
+    for(size_t i = 0; i < length; i += 6) {
+      struct in_addr in;
+      memcpy(&in.s_addr, data+i, sizeof(uint32_t));
+      std::string ipaddr = inet_ntoa(in);
+      uint16_t port_nworder;
+      memcpy(&port_nworder, data+i+4, sizeof(uint16_t));
+      uint16_t port = ntohs(port_nworder);
+      *dest = SharedHandle<Peer>(new Peer(ipaddr, port));
+      ++dest;
+    }
+  }
+  return dest;
+}
+
 template<typename OutputIterator>
 void extractPeer(const ValueBase* peerData, OutputIterator dest)
 {
@@ -228,20 +251,9 @@ void extractPeer(const ValueBase* peerData, OutputIterator dest)
 
     virtual void visit(const String& peerData)
     {
-      size_t length = peerData.s().size();
-      if(length%6 == 0) {
-        const char* base = peerData.s().data();
-        for(size_t i = 0; i < length; i += 6) {
-          struct in_addr in;
-          memcpy(&in.s_addr, base+i, sizeof(uint32_t));
-          std::string ipaddr = inet_ntoa(in);
-          uint16_t port_nworder;
-          memcpy(&port_nworder, base+i+4, sizeof(uint16_t));
-          uint16_t port = ntohs(port_nworder);
-          *dest_ = SharedHandle<Peer>(new Peer(ipaddr, port));
-          ++dest_;
-        }
-      }
+      dest_ = extractCompactPeer
+        (reinterpret_cast<const unsigned char*>(peerData.s().data()),
+         peerData.s().size(), dest_);
     }
 
     virtual void visit(const Integer& v) {}
@@ -280,6 +292,35 @@ void extractPeer(const SharedHandle<ValueBase>& peerData, OutputIterator dest)
   return extractPeer(peerData.get(), dest);
 }
 
+// Same as above, but peerData is a term decoded by decoder.
+template<typename OutputIterator>
+void extractPeer
+(const bencode2::ViewDecoder& decoder, const bencode2::View* peerData,
+ OutputIterator dest)
+{
+  if(!peerData) {
+    return;
+  }
+  if(peerData->type == bencode2::View::STRING) {
+    extractCompactPeer(peerData->data, peerData->length, dest);
+  } else if(peerData->type == bencode2::View::LIST) {
+    static const std::string IP = "ip";
+    static const std::string PORT = "port";
+    const bencode2::View* peerDict = decoder.first(peerData);
+    for(size_t i = 0; i < peerData->size; ++i) {
+      const bencode2::View* ip =
+        decoder.get(peerDict, IP, bencode2::View::STRING);
+      const bencode2::View* port =
+        decoder.get(peerDict, PORT, bencode2::View::INTEGER);
+      if(ip && port && 0 < port->i && port->i < 65536) {
+        *dest = SharedHandle<Peer>(new Peer(ip->s(), port->i));
+        ++dest;
+      }
+      peerDict = decoder.next(peerDict);
+    }
+  }
+}
+
 } // namespace bittorrent
 
 } // namespace aria2
@@ -43,6 +43,7 @@
 #include "SharedHandle.h"
 #include "DlAbortEx.h"
 #include "StringFormat.h"
+#include "sha1.h"
 
 #ifdef HAVE_LIBSSL
 #include <openssl/evp.h>
@@ -76,8 +77,13 @@ private:
   gcry_md_hd_t ctx_;
 #endif // HAVE_LIBGCRYPT  
   DigestAlgo algo_;
+  // SHA-1 is computed by sha1.h instead of the library if the CPU has
+  // the SHA extensions.
+  sha1::Context sha1ctx_;
+  bool sha1Kernel_;
 public:
-  MessageDigestContext():algo_(getDigestAlgo(MessageDigestContext::SHA1))
+  MessageDigestContext():algo_(getDigestAlgo(MessageDigestContext::SHA1)),
+                         sha1Kernel_(false)
   {}
 
   ~MessageDigestContext()
@@ -116,27 +122,74 @@ public:
 
   std::string digestFinal();
 
-#if defined(HAVE_OLD_LIBSSL)
   void digestInit()
   {
-    EVP_DigestInit(&ctx_, algo_);
+    sha1Kernel_ = sha1::hasSingleKernel() &&
+      algo_ == getDigestAlgo(MessageDigestContext::SHA1);
+    if(sha1Kernel_) {
+      sha1::init(sha1ctx_);
+    } else {
+      libDigestInit();
+    }
   }
 
   void digestReset()
   {
-    EVP_DigestInit(&ctx_, algo_);
+    if(sha1Kernel_) {
+      sha1::init(sha1ctx_);
+    } else {
+      libDigestReset();
+    }
   }
 
   void digestUpdate(const void* data, size_t length)
+  {
+    if(sha1Kernel_) {
+      sha1::update(sha1ctx_, data, length);
+    } else {
+      libDigestUpdate(data, length);
+    }
+  }
+
+  void digestFinal(unsigned char* md)
+  {
+    if(sha1Kernel_) {
+      sha1::final(sha1ctx_, md);
+    } else {
+      libDigestFinal(md);
+    }
+  }
+
+  void digestFree()
+  {
+    if(!sha1Kernel_) {
+      libDigestFree();
+    }
+  }
+
+#if defined(HAVE_OLD_LIBSSL)
+private:
+  void libDigestInit()
+  {
+    EVP_DigestInit(&ctx_, algo_);
+  }
+
+  void libDigestReset()
+  {
+    EVP_DigestInit(&ctx_, algo_);
+  }
+
+  void libDigestUpdate(const void* data, size_t length)
   {
     EVP_DigestUpdate(&ctx_, data, length);
   }
 
-  void digestFinal(unsigned char* md) {
+  void libDigestFinal(unsigned char* md) {
     unsigned int len;
     EVP_DigestFinal(&ctx_, md, &len);
   }
-  void digestFree() {/*empty*/}
+  void libDigestFree() {/*empty*/}
+public:
   size_t digestLength() const {
     return digestLength(algo_);
   }
@@ -145,23 +198,25 @@ public:
   }
 
 #elif defined(HAVE_LIBSSL)
-  void digestInit() {
+private:
+  void libDigestInit() {
     EVP_MD_CTX_init(&ctx_);
-    digestReset();
+    libDigestReset();
   }
-  void digestReset() {
+  void libDigestReset() {
     EVP_DigestInit_ex(&ctx_, algo_, 0);
   }
-  void digestUpdate(const void* data, size_t length) {
+  void libDigestUpdate(const void* data, size_t length) {
     EVP_DigestUpdate(&ctx_, data, length);
   }
-  void digestFinal(unsigned char* md) {
+  void libDigestFinal(unsigned char* md) {
     unsigned int len;
     EVP_DigestFinal_ex(&ctx_, md, &len);
   }
-  void digestFree() {
+  void libDigestFree() {
     EVP_MD_CTX_cleanup(&ctx_);
   }
+public:
   size_t digestLength() const {
     return digestLength(algo_);
   }
@@ -170,22 +225,24 @@ public:
   }
 
 #elif defined(HAVE_LIBGCRYPT)
-  void digestInit() {
+private:
+  void libDigestInit() {
     gcry_md_open(&ctx_, algo_, 0);
   }
-  void digestReset() {
+  void libDigestReset() {
     gcry_md_reset(ctx_);
   }
-  void digestUpdate(const void* data, size_t length) {
+  void libDigestUpdate(const void* data, size_t length) {
     gcry_md_write(ctx_, data, length);
   }
-  void digestFinal(unsigned char* md) {
+  void libDigestFinal(unsigned char* md) {
     gcry_md_final(ctx_);
     memcpy(md, gcry_md_read(ctx_, 0), gcry_md_get_algo_dlen(algo_));
   }
-  void digestFree() {
+  void libDigestFree() {
     gcry_md_close(ctx_);
   }
+public:
   size_t digestLength() const {
     return digestLength(algo_);
   }
@@ -83,6 +83,7 @@ const std::string PREF_STARTUP_IDLE_TIME("startup-idle-time");
 const std::string PREF_FILE_ALLOCATION("file-allocation");
 const std::string V_PREALLOC("prealloc");
 const std::string V_FALLOC("falloc");
+const std::string V_LAZY("lazy");
 // value: 1*digit
 const std::string PREF_NO_FILE_ALLOCATION_LIMIT("no-file-allocation-limit");
 // value: true | false
@@ -150,6 +151,7 @@ const std::string PREF_MAX_FILE_NOT_FOUND("max-file-not-found");
 // value: epoll | select
 const std::string PREF_EVENT_POLL("event-poll");
 const std::string V_EPOLL("epoll");
+const std::string V_IO_URING("io_uring");
 const std::string V_KQUEUE("kqueue");
 const std::string V_PORT("port");
 const std::string V_POLL("poll");
@@ -198,6 +200,10 @@ const std::string PREF_MIN_SPLIT_SIZE("min-split-size");
 const std::string PREF_CONDITIONAL_GET("conditional-get");
 // value: true | false
 const std::string PREF_SELECT_LEAST_USED_HOST("select-least-used-host");
+// value: 1*digit
+const std::string PREF_DISK_CACHE("disk-cache");
+// value: 1*digit
+const std::string PREF_DISK_IO_THREADS("disk-io-threads");
 
 /**
  * FTP related preferences
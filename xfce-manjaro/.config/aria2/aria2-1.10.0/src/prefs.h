@@ -85,6 +85,7 @@ extern const std::string PREF_STARTUP_IDLE_TIME;
 extern const std::string PREF_FILE_ALLOCATION;
 extern const std::string V_PREALLOC;
 extern const std::string V_FALLOC;
+extern const std::string V_LAZY;
 // value: 1*digit
 extern const std::string PREF_NO_FILE_ALLOCATION_LIMIT;
 // value: true | false
@@ -154,6 +155,7 @@ extern const std::string PREF_MAX_FILE_NOT_FOUND;
 // value: epoll | select
 extern const std::string PREF_EVENT_POLL;
 extern const std::string V_EPOLL;
+extern const std::string V_IO_URING;
 extern const std::string V_KQUEUE;
 extern const std::string V_PORT;
 extern const std::string V_POLL;
@@ -202,6 +204,10 @@ extern const std::string PREF_MIN_SPLIT_SIZE;
 extern const std::string PREF_CONDITIONAL_GET;
 // value: true | false
 extern const std::string PREF_SELECT_LEAST_USED_HOST;
+// value: 1*digit
+extern const std::string PREF_DISK_CACHE;
+// value: 1*digit
+extern const std::string PREF_DISK_IO_THREADS;
 
 /**
  * FTP related preferences
@@ -0,0 +1,591 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "sha1.h"
+
+#include <cstring>
+#include <algorithm>
+
+// x86 kernels need function level target attributes, which appeared
+// in GCC 4.9.
+#if defined __GNUC__ && !defined __clang__ &&                          \
+  (defined __x86_64__ || defined __i386__) &&                           \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+# define A2_X86_SHA1_KERNEL 1
+# include <immintrin.h>
+# include <cpuid.h>
+#endif
+
+namespace aria2 {
+
+namespace sha1 {
+
+namespace {
+
+const uint32_t K0 = 0x5a827999u;
+const uint32_t K1 = 0x6ed9eba1u;
+const uint32_t K2 = 0x8f1bbcdcu;
+const uint32_t K3 = 0xca62c1d6u;
+
+// A kernel hashes nblocks blocks of each of lanes messages. The
+// message i starts at data[i] and its state is h[i].
+struct Kernel {
+  const char* name;
+  size_t lanes;
+  void (*compress)
+  (uint32_t* const* h, const unsigned char* const* data, size_t nblocks);
+};
+
+inline uint32_t rol(uint32_t x, int n)
+{
+  return (x << n)|(x >> (32-n));
+}
+
+inline uint32_t loadBE32(const unsigned char* p)
+{
+  return
+    (static_cast<uint32_t>(p[0]) << 24)|(static_cast<uint32_t>(p[1]) << 16)|
+    (static_cast<uint32_t>(p[2]) << 8)|static_cast<uint32_t>(p[3]);
+}
+
+// The 80 rounds are unrolled 5 at a time, rotating the roles of the
+// variables instead of moving them. These macros are shared by the
+// scalar and the vector kernels, which define ADD, XOR, AND, OR and
+// ROL for their type.
+#define SHA1_F0(b, c, d) XOR(d, AND(b, XOR(c, d)))
+#define SHA1_F1(b, c, d) XOR(b, XOR(c, d))
+#define SHA1_F2(b, c, d) OR(AND(b, c), AND(d, OR(b, c)))
+#define SHA1_F3(b, c, d) SHA1_F1(b, c, d)
+
+#define SHA1_ROUND(a, b, c, d, e, f, k, t)                              \
+  e = ADD(e, ADD(ADD(ROL(a, 5), f(b, c, d)), ADD(k, W(t))));            \
+  b = ROL(b, 30)
+
+#define SHA1_ROUND5(f, k, t)                                            \
+  SHA1_ROUND(a, b, c, d, e, f, k, t);                                   \
+  SHA1_ROUND(e, a, b, c, d, f, k, t+1);                                 \
+  SHA1_ROUND(d, e, a, b, c, f, k, t+2);                                 \
+  SHA1_ROUND(c, d, e, a, b, f, k, t+3);                                 \
+  SHA1_ROUND(b, c, d, e, a, f, k, t+4)
+
+// W(t) for t >= 16 is computed in place in a 16 word ring.
+#define SHA1_W(t)                                                       \
+  ((t) < 16 ? w[t] :                                                    \
+   (w[(t)&15] = ROL(XOR(XOR(w[((t)-3)&15], w[((t)-8)&15]),             \
+                        XOR(w[((t)-14)&15], w[(t)&15])), 1)))
+
+#define SHA1_ROUNDS(k0, k1, k2, k3)                                     \
+  SHA1_ROUND5(SHA1_F0, k0, 0);                                          \
+  SHA1_ROUND5(SHA1_F0, k0, 5);                                          \
+  SHA1_ROUND5(SHA1_F0, k0, 10);                                         \
+  SHA1_ROUND5(SHA1_F0, k0, 15);                                         \
+  SHA1_ROUND5(SHA1_F1, k1, 20);                                         \
+  SHA1_ROUND5(SHA1_F1, k1, 25);                                         \
+  SHA1_ROUND5(SHA1_F1, k1, 30);                                         \
+  SHA1_ROUND5(SHA1_F1, k1, 35);                                         \
+  SHA1_ROUND5(SHA1_F2, k2, 40);                                         \
+  SHA1_ROUND5(SHA1_F2, k2, 45);                                         \
+  SHA1_ROUND5(SHA1_F2, k2, 50);                                         \
+  SHA1_ROUND5(SHA1_F2, k2, 55);                                         \
+  SHA1_ROUND5(SHA1_F3, k3, 60);                                         \
+  SHA1_ROUND5(SHA1_F3, k3, 65);                                         \
+  SHA1_ROUND5(SHA1_F3, k3, 70);                                         \
+  SHA1_ROUND5(SHA1_F3, k3, 75)
+
+#define W(t) SHA1_W(t)
+
+#define ADD(x, y) ((x)+(y))
+#define XOR(x, y) ((x)^(y))
+#define AND(x, y) ((x)&(y))
+#define OR(x, y) ((x)|(y))
+#define ROL(x, n) rol(x, n)
+
+void compressGeneric
+(uint32_t* const* hs, const unsigned char* const* data, size_t nblocks)
+{
+  uint32_t* h = hs[0];
+  const unsigned char* p = data[0];
+  for(; nblocks; --nblocks, p += BLOCK_LENGTH) {
+    uint32_t w[16];
+    for(size_t i = 0; i < 16; ++i) {
+      w[i] = loadBE32(p+i*4);
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    SHA1_ROUNDS(K0, K1, K2, K3);
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+}
+
+#undef ADD
+#undef XOR
+#undef AND
+#undef OR
+#undef ROL
+
+#ifdef A2_X86_SHA1_KERNEL
+
+#define ADD(x, y) _mm_add_epi32(x, y)
+#define XOR(x, y) _mm_xor_si128(x, y)
+#define AND(x, y) _mm_and_si128(x, y)
+#define OR(x, y) _mm_or_si128(x, y)
+#define ROL(x, n) _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32-(n)))
+
+// 4 messages in the 32-bit lanes of SSE registers. Each 16 byte row
+// of the blocks is transposed so that a register holds the same word
+// of every message.
+__attribute__((target("ssse3")))
+void compressSSSE3
+(uint32_t* const* hs, const unsigned char* const* data, size_t nblocks)
+{
+  const __m128i bswap =
+    _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  const __m128i k0 = _mm_set1_epi32(K0);
+  const __m128i k1 = _mm_set1_epi32(K1);
+  const __m128i k2 = _mm_set1_epi32(K2);
+  const __m128i k3 = _mm_set1_epi32(K3);
+  __m128i s[5];
+  for(size_t i = 0; i < 5; ++i) {
+    s[i] = _mm_set_epi32(hs[3][i], hs[2][i], hs[1][i], hs[0][i]);
+  }
+  for(size_t n = 0; n < nblocks; ++n) {
+    __m128i w[16];
+    for(size_t i = 0; i < 16; i += 4) {
+      size_t off = n*BLOCK_LENGTH+i*4;
+      __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data[0]+off));
+      __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data[1]+off));
+      __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data[2]+off));
+      __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data[3]+off));
+      __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+      __m128i t1 = _mm_unpackhi_epi32(r0, r1);
+      __m128i t2 = _mm_unpacklo_epi32(r2, r3);
+      __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+      w[i] = _mm_shuffle_epi8(_mm_unpacklo_epi64(t0, t2), bswap);
+      w[i+1] = _mm_shuffle_epi8(_mm_unpackhi_epi64(t0, t2), bswap);
+      w[i+2] = _mm_shuffle_epi8(_mm_unpacklo_epi64(t1, t3), bswap);
+      w[i+3] = _mm_shuffle_epi8(_mm_unpackhi_epi64(t1, t3), bswap);
+    }
+    __m128i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+    SHA1_ROUNDS(k0, k1, k2, k3);
+    s[0] = _mm_add_epi32(s[0], a);
+    s[1] = _mm_add_epi32(s[1], b);
+    s[2] = _mm_add_epi32(s[2], c);
+    s[3] = _mm_add_epi32(s[3], d);
+    s[4] = _mm_add_epi32(s[4], e);
+  }
+  for(size_t i = 0; i < 5; ++i) {
+    uint32_t v[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(v), s[i]);
+    for(size_t j = 0; j < 4; ++j) {
+      hs[j][i] = v[j];
+    }
+  }
+}
+
+#undef ADD
+#undef XOR
+#undef AND
+#undef OR
+#undef ROL
+
+#define ADD(x, y) _mm256_add_epi32(x, y)
+#define XOR(x, y) _mm256_xor_si256(x, y)
+#define AND(x, y) _mm256_and_si256(x, y)
+#define OR(x, y) _mm256_or_si256(x, y)
+#define ROL(x, n)                                                       \
+  _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32-(n)))
+
+// 8 messages in the 32-bit lanes of AVX2 registers, transposing 32
+// byte rows.
+__attribute__((target("avx2")))
+void compressAVX2
+(uint32_t* const* hs, const unsigned char* const* data, size_t nblocks)
+{
+  const __m256i bswap =
+    _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  const __m256i k0 = _mm256_set1_epi32(K0);
+  const __m256i k1 = _mm256_set1_epi32(K1);
+  const __m256i k2 = _mm256_set1_epi32(K2);
+  const __m256i k3 = _mm256_set1_epi32(K3);
+  __m256i s[5];
+  for(size_t i = 0; i < 5; ++i) {
+    s[i] = _mm256_set_epi32(hs[7][i], hs[6][i], hs[5][i], hs[4][i],
+                            hs[3][i], hs[2][i], hs[1][i], hs[0][i]);
+  }
+  for(size_t n = 0; n < nblocks; ++n) {
+    __m256i w[16];
+    for(size_t i = 0; i < 16; i += 8) {
+      size_t off = n*BLOCK_LENGTH+i*4;
+      __m256i r[8];
+      for(size_t j = 0; j < 8; ++j) {
+        r[j] = _mm256_loadu_si256
+          (reinterpret_cast<const __m256i*>(data[j]+off));
+      }
+      __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+      __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+      __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+      __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+      __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+      __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+      __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+      __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+      __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+      __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+      __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+      __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+      __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+      __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+      __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+      __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+      w[i] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u0, u4, 0x20), bswap);
+      w[i+1] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u1, u5, 0x20), bswap);
+      w[i+2] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u2, u6, 0x20), bswap);
+      w[i+3] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u3, u7, 0x20), bswap);
+      w[i+4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u0, u4, 0x31), bswap);
+      w[i+5] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u1, u5, 0x31), bswap);
+      w[i+6] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u2, u6, 0x31), bswap);
+      w[i+7] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u3, u7, 0x31), bswap);
+    }
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+    SHA1_ROUNDS(k0, k1, k2, k3);
+    s[0] = _mm256_add_epi32(s[0], a);
+    s[1] = _mm256_add_epi32(s[1], b);
+    s[2] = _mm256_add_epi32(s[2], c);
+    s[3] = _mm256_add_epi32(s[3], d);
+    s[4] = _mm256_add_epi32(s[4], e);
+  }
+  for(size_t i = 0; i < 5; ++i) {
+    uint32_t v[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(v), s[i]);
+    for(size_t j = 0; j < 8; ++j) {
+      hs[j][i] = v[j];
+    }
+  }
+}
+
+#undef ADD
+#undef XOR
+#undef AND
+#undef OR
+#undef ROL
+
+// One group of 4 rounds with the SHA extensions. msg[g%4] holds the
+// words 4g..4g+3 of the message schedule. The next words are prepared
+// while the rounds run.
+#define SHANI_ROUNDS4(g, ein, eout)                                     \
+  if((g) < 4) {                                                         \
+    msg[g] = _mm_shuffle_epi8                                           \
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(p+(g)*16)), bswap); \
+  }                                                                     \
+  if((g) == 0) {                                                        \
+    ein = _mm_add_epi32(ein, msg[0]);                                   \
+  } else {                                                              \
+    ein = _mm_sha1nexte_epu32(ein, msg[(g)%4]);                         \
+  }                                                                     \
+  eout = abcd;                                                          \
+  if(3 <= (g) && (g) <= 18) {                                           \
+    msg[((g)+1)%4] = _mm_sha1msg2_epu32(msg[((g)+1)%4], msg[(g)%4]);    \
+  }                                                                     \
+  abcd = _mm_sha1rnds4_epu32(abcd, ein, (g)/5);                         \
+  if(1 <= (g) && (g) <= 16) {                                           \
+    msg[((g)+3)%4] = _mm_sha1msg1_epu32(msg[((g)+3)%4], msg[(g)%4]);    \
+  }                                                                     \
+  if(2 <= (g) && (g) <= 17) {                                           \
+    msg[((g)+2)%4] = _mm_xor_si128(msg[((g)+2)%4], msg[(g)%4]);         \
+  }
+
+__attribute__((target("sha,sse4.1")))
+void compressSHANI
+(uint32_t* const* hs, const unsigned char* const* data, size_t nblocks)
+{
+  const __m128i bswap =
+    _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  uint32_t* h = hs[0];
+  const unsigned char* p = data[0];
+  __m128i abcd = _mm_shuffle_epi32
+    (_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)), 0x1b);
+  __m128i e0 = _mm_set_epi32(h[4], 0, 0, 0);
+  for(; nblocks; --nblocks, p += BLOCK_LENGTH) {
+    __m128i abcdSave = abcd;
+    __m128i e0Save = e0;
+    __m128i e1;
+    __m128i msg[4];
+    SHANI_ROUNDS4(0, e0, e1);
+    SHANI_ROUNDS4(1, e1, e0);
+    SHANI_ROUNDS4(2, e0, e1);
+    SHANI_ROUNDS4(3, e1, e0);
+    SHANI_ROUNDS4(4, e0, e1);
+    SHANI_ROUNDS4(5, e1, e0);
+    SHANI_ROUNDS4(6, e0, e1);
+    SHANI_ROUNDS4(7, e1, e0);
+    SHANI_ROUNDS4(8, e0, e1);
+    SHANI_ROUNDS4(9, e1, e0);
+    SHANI_ROUNDS4(10, e0, e1);
+    SHANI_ROUNDS4(11, e1, e0);
+    SHANI_ROUNDS4(12, e0, e1);
+    SHANI_ROUNDS4(13, e1, e0);
+    SHANI_ROUNDS4(14, e0, e1);
+    SHANI_ROUNDS4(15, e1, e0);
+    SHANI_ROUNDS4(16, e0, e1);
+    SHANI_ROUNDS4(17, e1, e0);
+    SHANI_ROUNDS4(18, e0, e1);
+    SHANI_ROUNDS4(19, e1, e0);
+    e0 = _mm_sha1nexte_epu32(e0, e0Save);
+    abcd = _mm_add_epi32(abcd, abcdSave);
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(h), _mm_shuffle_epi32(abcd, 0x1b));
+  h[4] = _mm_extract_epi32(e0, 3);
+}
+
+#undef SHANI_ROUNDS4
+
+#endif // A2_X86_SHA1_KERNEL
+
+#undef W
+
+// Slowest first.
+const Kernel KERNELS[] = {
+  { "generic", 1, compressGeneric },
+#ifdef A2_X86_SHA1_KERNEL
+  { "ssse3", 4, compressSSSE3 },
+  { "shani", 1, compressSHANI },
+  { "avx2", 8, compressAVX2 },
+#endif // A2_X86_SHA1_KERNEL
+};
+
+const size_t NUM_KERNEL = sizeof(KERNELS)/sizeof(KERNELS[0]);
+
+#ifdef A2_X86_SHA1_KERNEL
+// __builtin_cpu_supports() does not know the SHA extensions in older
+// compilers, so CPUID leaf 7 is read directly.
+bool hasSHAExtensions()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if(__get_cpuid_max(0, 0) < 7) {
+    return false;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & (1 << 29)) && __builtin_cpu_supports("sse4.1");
+}
+#endif // A2_X86_SHA1_KERNEL
+
+bool isAvailable(const Kernel& kernel)
+{
+#ifdef A2_X86_SHA1_KERNEL
+  __builtin_cpu_init();
+  if(strcmp(kernel.name, "ssse3") == 0) {
+    return __builtin_cpu_supports("ssse3");
+  } else if(strcmp(kernel.name, "avx2") == 0) {
+    return __builtin_cpu_supports("avx2");
+  } else if(strcmp(kernel.name, "shani") == 0) {
+    return hasSHAExtensions();
+  }
+#endif // A2_X86_SHA1_KERNEL
+  return true;
+}
+
+const Kernel* kernel_ = 0;
+
+// The fastest kernel with 1 lane.
+const Kernel* singleKernel_ = 0;
+
+const Kernel* getCurrentKernel()
+{
+  if(!kernel_) {
+    for(size_t i = 0; i < NUM_KERNEL; ++i) {
+      if(isAvailable(KERNELS[i])) {
+        kernel_ = &KERNELS[i];
+        if(KERNELS[i].lanes == 1) {
+          singleKernel_ = &KERNELS[i];
+        }
+      }
+    }
+  }
+  return kernel_;
+}
+
+// Returns the current kernel if it has 1 lane, or the fastest one
+// otherwise.
+const Kernel* getSingleKernel()
+{
+  const Kernel* kernel = getCurrentKernel();
+  return kernel->lanes == 1 ? kernel : singleKernel_;
+}
+
+void compressSingle(uint32_t* h, const unsigned char* data, size_t nblocks)
+{
+  getSingleKernel()->compress(&h, &data, nblocks);
+}
+
+} // namespace
+
+void init(Context& ctx)
+{
+  ctx.h[0] = 0x67452301u;
+  ctx.h[1] = 0xefcdab89u;
+  ctx.h[2] = 0x98badcfeu;
+  ctx.h[3] = 0x10325476u;
+  ctx.h[4] = 0xc3d2e1f0u;
+  ctx.buflen = 0;
+  ctx.length = 0;
+}
+
+void update(Context& ctx, const void* data, size_t len)
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+  ctx.length += len;
+  if(ctx.buflen) {
+    size_t n = std::min(len, BLOCK_LENGTH-ctx.buflen);
+    memcpy(ctx.buf+ctx.buflen, p, n);
+    ctx.buflen += n;
+    p += n;
+    len -= n;
+    if(ctx.buflen < BLOCK_LENGTH) {
+      return;
+    }
+    compressSingle(ctx.h, ctx.buf, 1);
+    ctx.buflen = 0;
+  }
+  if(len >= BLOCK_LENGTH) {
+    compressSingle(ctx.h, p, len/BLOCK_LENGTH);
+    p += len/BLOCK_LENGTH*BLOCK_LENGTH;
+    len %= BLOCK_LENGTH;
+  }
+  memcpy(ctx.buf, p, len);
+  ctx.buflen = len;
+}
+
+void final(Context& ctx, unsigned char* md)
+{
+  uint64_t bits = ctx.length*8;
+  unsigned char pad[BLOCK_LENGTH*2];
+  memset(pad, 0, sizeof(pad));
+  pad[0] = 0x80;
+  size_t padlen = BLOCK_LENGTH-(ctx.length+8)%BLOCK_LENGTH;
+  for(size_t i = 0; i < 8; ++i) {
+    pad[padlen+i] = bits >> (56-i*8);
+  }
+  update(ctx, pad, padlen+8);
+  for(size_t i = 0; i < 5; ++i) {
+    md[i*4] = ctx.h[i] >> 24;
+    md[i*4+1] = ctx.h[i] >> 16;
+    md[i*4+2] = ctx.h[i] >> 8;
+    md[i*4+3] = ctx.h[i];
+  }
+}
+
+void update
+(Context* const* ctx, const unsigned char* const* data, size_t len, size_t n)
+{
+  const Kernel* kernel = getCurrentKernel();
+  size_t i = 0;
+  if(kernel->lanes > 1 && len >= BLOCK_LENGTH) {
+    for(; i+kernel->lanes <= n; i += kernel->lanes) {
+      bool aligned = true;
+      for(size_t j = i; j < i+kernel->lanes; ++j) {
+        if(ctx[j]->buflen) {
+          aligned = false;
+          break;
+        }
+      }
+      if(!aligned) {
+        break;
+      }
+      uint32_t* hs[8];
+      const unsigned char* ps[8];
+      for(size_t j = 0; j < kernel->lanes; ++j) {
+        hs[j] = ctx[i+j]->h;
+        ps[j] = data[i+j];
+      }
+      size_t nblocks = len/BLOCK_LENGTH;
+      kernel->compress(hs, ps, nblocks);
+      size_t done = nblocks*BLOCK_LENGTH;
+      for(size_t j = i; j < i+kernel->lanes; ++j) {
+        ctx[j]->length += done;
+        update(*ctx[j], data[j]+done, len-done);
+      }
+    }
+  }
+  // The rest is hashed one message at a time.
+  for(; i < n; ++i) {
+    update(*ctx[i], data[i], len);
+  }
+}
+
+size_t getLanes()
+{
+  return getCurrentKernel()->lanes;
+}
+
+bool hasSingleKernel()
+{
+  getCurrentKernel();
+  return singleKernel_ != &KERNELS[0];
+}
+
+std::vector<std::string> getAvailableKernels()
+{
+  std::vector<std::string> names;
+  for(size_t i = 0; i < NUM_KERNEL; ++i) {
+    if(isAvailable(KERNELS[i])) {
+      names.push_back(KERNELS[i].name);
+    }
+  }
+  return names;
+}
+
+bool selectKernel(const std::string& name)
+{
+  getCurrentKernel();
+  for(size_t i = 0; i < NUM_KERNEL; ++i) {
+    if(name == KERNELS[i].name && isAvailable(KERNELS[i])) {
+      kernel_ = &KERNELS[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string getKernel()
+{
+  return getCurrentKernel()->name;
+}
+
+} // namespace sha1
+
+} // namespace aria2
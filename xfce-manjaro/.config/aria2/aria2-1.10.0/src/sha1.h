@@ -0,0 +1,99 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef _D_SHA1_H_
+#define _D_SHA1_H_
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+
+namespace aria2 {
+
+namespace sha1 {
+
+const size_t DIGEST_LENGTH = 20;
+
+const size_t BLOCK_LENGTH = 64;
+
+// The hash state of one message.
+struct Context {
+  uint32_t h[5];
+  unsigned char buf[BLOCK_LENGTH];
+  // The number of bytes in buf.
+  size_t buflen;
+  // The number of bytes hashed so far.
+  uint64_t length;
+};
+
+void init(Context& ctx);
+
+void update(Context& ctx, const void* data, size_t len);
+
+// Stores the digest of ctx to md, which must be DIGEST_LENGTH bytes
+// long. ctx must be initialized again before reuse.
+void final(Context& ctx, unsigned char* md);
+
+// Appends len bytes of data[i] to ctx[i] for i < n. If the contexts
+// have nothing buffered, that is, the same number of bytes modulo
+// BLOCK_LENGTH were given to them so far, the messages are hashed in
+// parallel lanes of the current kernel.
+void update
+(Context* const* ctx, const unsigned char* const* data, size_t len, size_t n);
+
+// Returns the number of messages the current kernel hashes at once.
+size_t getLanes();
+
+// Returns true if the CPU can hash a single message faster than the
+// generic C code, that is, it has the SHA extensions. update() for a
+// single context uses them unless "generic" is selected.
+bool hasSingleKernel();
+
+// Returns the names of the kernels this CPU can run, slowest
+// first. "generic" is always available.
+std::vector<std::string> getAvailableKernels();
+
+// Makes the kernel name used by update(). Returns false if name is
+// not available, leaving the current kernel unchanged.
+bool selectKernel(const std::string& name);
+
+// Returns the name of the kernel in use.
+std::string getKernel();
+
+} // namespace sha1
+
+} // namespace aria2
+
+#endif // _D_SHA1_H_
@@ -137,7 +137,12 @@
     "                              almost same time as 'prealloc' and it blocks aria2\n" \
     "                              entirely until allocation finishes. 'falloc' may\n" \
     "                              not be available if your system doesn't have\n" \
-    "                              posix_fallocate() function.")
+    "                              posix_fallocate() function.\n"       \
+    "                              'lazy' doesn't allocate file space before download\n" \
+    "                              begins. Instead, it allocates the space of the\n" \
+    "                              pieces around each piece when the piece is\n" \
+    "                              downloaded first, using the same function as\n" \
+    "                              'falloc'.")
 #define TEXT_NO_FILE_ALLOCATION_LIMIT                                   \
   _(" --no-file-allocation-limit=SIZE No file allocation is made for files whose\n" \
     "                              size is smaller than SIZE.\n"        \
@@ -710,3 +715,17 @@
     "                              download completes but before seeding.\n" \
     "                              See --on-download-start option for the\n" \
     "                              requirement of COMMAND.")
+#define TEXT_DISK_CACHE                         \
+  _(" --disk-cache=SIZE            Enable disk cache. If SIZE is 0, the disk cache\n" \
+    "                              is disabled. Downloaded data is kept in memory\n" \
+    "                              and written to disk a whole piece at a time, when\n" \
+    "                              the piece completes or the total size of cached\n" \
+    "                              data exceeds SIZE.\n" \
+    "                              You can append K or M(1K = 1024, 1M = 1024K).")
+#define TEXT_DISK_IO_THREADS                    \
+  _(" --disk-io-threads=NUM        Run file allocation and hash checking in NUM\n" \
+    "                              worker threads so that they do not block network\n" \
+    "                              I/O. If NUM is 0, they run in the main thread.\n" \
+    "                              The pieces of a download are hashed by all NUM\n" \
+    "                              threads at once. The default is the number of\n" \
+    "                              CPU cores, but at most 8.")
@@ -1100,12 +1100,38 @@ void* allocateAlignedMemory(size_t alignment, size_t size)
   int res;
   if((res = posix_memalign(&buffer, alignment, size)) != 0) {
     throw FATAL_EXCEPTION
-      (StringFormat("Error in posix_memalign: %s", strerror(res)).str());
+      (StringFormat("Error in posix_memalign: %s",
+                    safeStrerror(res).c_str()).str());
   }
   return buffer;
 }
 #endif // HAVE_POSIX_MEMALIGN
 
+#ifdef HAVE_STRERROR_R
+// The XSI strerror_r() returns 0 and writes the message to buf. The
+// GNU one returns the message, which may or may not be in buf.
+static const char* getStrerrorResult(int r, const char* buf)
+{
+  return r == 0 ? buf : "Unknown error";
+}
+
+static const char* getStrerrorResult(const char* r, const char* buf)
+{
+  return r;
+}
+#endif // HAVE_STRERROR_R
+
+std::string safeStrerror(int errNum)
+{
+#ifdef HAVE_STRERROR_R
+  char buf[256];
+  buf[0] = '\0';
+  return getStrerrorResult(strerror_r(errNum, buf, sizeof(buf)), buf);
+#else // !HAVE_STRERROR_R
+  return strerror(errNum);
+#endif // !HAVE_STRERROR_R
+}
+
 std::pair<std::string, uint16_t>
 getNumericNameInfo(const struct sockaddr* sockaddr, socklen_t len)
 {
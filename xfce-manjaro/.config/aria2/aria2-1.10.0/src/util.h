@@ -275,6 +275,10 @@ std::string toString(const SharedHandle<BinaryStream>& binaryStream);
 void* allocateAlignedMemory(size_t alignment, size_t size);
 #endif // HAVE_POSIX_MEMALIGN
 
+// Returns the message of errNum like strerror(3). Unlike strerror(3),
+// this can be called in the worker threads of DiskIOThreadPool.
+std::string safeStrerror(int errNum);
+
 std::pair<std::string, uint16_t>
 getNumericNameInfo(const struct sockaddr* sockaddr, socklen_t len);
 
@@ -0,0 +1,79 @@
+#include "Benchmark.h"
+
+#include <sys/time.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <utility>
+
+#include "Platform.h"
+
+namespace aria2 {
+
+namespace benchmark {
+
+static std::vector<std::pair<const char*, BenchmarkFunc> >& getRegistry()
+{
+  static std::vector<std::pair<const char*, BenchmarkFunc> > registry;
+  return registry;
+}
+
+Registrar::Registrar(const char* name, BenchmarkFunc func)
+{
+  getRegistry().push_back(std::make_pair(name, func));
+}
+
+double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec+tv.tv_usec/1000000.0;
+}
+
+void report(const std::string& label, uint64_t count, double elapsed,
+            uint64_t bytes)
+{
+  if(elapsed <= 0) {
+    elapsed = 1e-9;
+  }
+  printf("  %-48s %10llu ops %10.2f ms %12.0f ops/s",
+         label.c_str(), static_cast<unsigned long long>(count),
+         elapsed*1000, count/elapsed);
+  if(bytes > 0) {
+    printf(" %9.1f MiB/s", bytes/elapsed/1024/1024);
+  }
+  printf("\n");
+}
+
+void note(const std::string& text)
+{
+  printf("  %-48s %s\n", "", text.c_str());
+}
+
+} // namespace benchmark
+
+} // namespace aria2
+
+// Runs all benchmarks, or only the ones whose names contain one of the
+// arguments.
+int main(int argc, char* argv[])
+{
+  aria2::Platform platform;
+  std::vector<std::pair<const char*, aria2::benchmark::BenchmarkFunc> >&
+    registry = aria2::benchmark::getRegistry();
+  for(size_t i = 0; i < registry.size(); ++i) {
+    bool selected = argc == 1;
+    for(int j = 1; j < argc; ++j) {
+      if(strstr(registry[i].first, argv[j])) {
+        selected = true;
+        break;
+      }
+    }
+    if(selected) {
+      printf("%s\n", registry[i].first);
+      registry[i].second();
+    }
+  }
+  return 0;
+}
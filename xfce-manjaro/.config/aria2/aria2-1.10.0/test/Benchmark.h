@@ -0,0 +1,40 @@
+#ifndef _D_BENCHMARK_H_
+#define _D_BENCHMARK_H_
+
+#include "common.h"
+
+#include <string>
+
+namespace aria2 {
+
+namespace benchmark {
+
+typedef void (*BenchmarkFunc)();
+
+// Registers a benchmark. Use BENCHMARK_REGISTRATION instead of
+// instantiating this class directly.
+class Registrar {
+public:
+  Registrar(const char* name, BenchmarkFunc func);
+};
+
+// Returns the current wall clock time in seconds.
+double now();
+
+// Prints one line of result. count is the number of operations done
+// in elapsed seconds. If bytes is not 0, throughput is also printed.
+void report(const std::string& label, uint64_t count, double elapsed,
+            uint64_t bytes = 0);
+
+// Prints arbitrary note, such as the number of system calls, under
+// the last result.
+void note(const std::string& text);
+
+} // namespace benchmark
+
+} // namespace aria2
+
+#define BENCHMARK_REGISTRATION(func)                                    \
+  static aria2::benchmark::Registrar func##Registrar(#func, func)
+
+#endif // _D_BENCHMARK_H_
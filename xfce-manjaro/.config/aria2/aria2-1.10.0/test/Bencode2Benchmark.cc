@@ -0,0 +1,292 @@
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include "bencode2.h"
+#include "ValueBase.h"
+#include "DlAbortEx.h"
+#include "util.h"
+
+namespace aria2 {
+
+static const size_t NUM_ROUNDS = 100000;
+
+// The decoder bencode2 used before it parsed directly from memory:
+// the input is copied into a std::istringstream, numbers are read by
+// operator>> and each string goes through a temporary buffer.
+namespace streamdecoder {
+
+static SharedHandle<ValueBase> decodeiter(std::istream& ss);
+
+static void checkdelim(std::istream& ss, const char delim = ':')
+{
+  char d;
+  if(!(ss.get(d) && d == delim)) {
+    throw DL_ABORT_EX("delimiter not found");
+  }
+}
+
+static std::string decoderawstring(std::istream& ss)
+{
+  int length;
+  ss >> length;
+  if(!ss || length < 0) {
+    throw DL_ABORT_EX("bad length");
+  }
+  checkdelim(ss);
+  char* buf = new char[length];
+  ss.read(buf, length);
+  std::string str(&buf[0], &buf[length]);
+  delete [] buf;
+  if(ss.gcount() != static_cast<int>(length)) {
+    throw DL_ABORT_EX("short string");
+  }
+  return str;
+}
+
+static SharedHandle<ValueBase> decodeiter(std::istream& ss)
+{
+  char c;
+  if(!ss.get(c)) {
+    throw DL_ABORT_EX("unexpected EOF");
+  }
+  if(c == 'd') {
+    SharedHandle<Dict> dict = Dict::g();
+    while(ss.get(c)) {
+      if(c == 'e') {
+        return dict;
+      }
+      ss.unget();
+      std::string key = decoderawstring(ss);
+      dict->put(key, decodeiter(ss));
+    }
+    throw DL_ABORT_EX("unexpected EOF");
+  } else if(c == 'l') {
+    SharedHandle<List> list = List::g();
+    while(ss.get(c)) {
+      if(c == 'e') {
+        return list;
+      }
+      ss.unget();
+      list->append(decodeiter(ss));
+    }
+    throw DL_ABORT_EX("unexpected EOF");
+  } else if(c == 'i') {
+    Integer::ValueType iv;
+    ss >> iv;
+    if(!ss) {
+      throw DL_ABORT_EX("bad integer");
+    }
+    checkdelim(ss, 'e');
+    return Integer::g(iv);
+  } else {
+    ss.unget();
+    return String::g(decoderawstring(ss));
+  }
+}
+
+static SharedHandle<ValueBase> decode(const unsigned char* data, size_t length)
+{
+  std::istringstream ss(std::string(&data[0], &data[length]));
+  return decodeiter(ss);
+}
+
+} // namespace streamdecoder
+
+// The encoder bencode2 used before it computed the length first: an
+// std::ostringstream is written by a visitor and copied out.
+namespace streamencoder {
+
+class Visitor:public ValueBaseVisitor {
+private:
+  std::ostringstream out_;
+public:
+  virtual void visit(const String& string)
+  {
+    const std::string& s = string.s();
+    out_ << s.size() << ":";
+    out_.write(s.data(), s.size());
+  }
+
+  virtual void visit(const Integer& integer)
+  {
+    out_ << "i" << integer.i() << "e";
+  }
+
+  virtual void visit(const List& list)
+  {
+    out_ << "l";
+    for(List::ValueType::const_iterator i = list.begin(), eoi = list.end();
+        i != eoi; ++i){
+      (*i)->accept(*this);
+    }
+    out_ << "e";
+  }
+
+  virtual void visit(const Dict& dict)
+  {
+    out_ << "d";
+    for(Dict::ValueType::const_iterator i = dict.begin(), eoi = dict.end();
+        i != eoi; ++i){
+      const std::string& key = (*i).first;
+      out_ << key.size() << ":";
+      out_.write(key.data(), key.size());
+      (*i).second->accept(*this);
+    }
+    out_ << "e";
+  }
+
+  std::string getResult() const
+  {
+    return out_.str();
+  }
+};
+
+static std::string encode(const ValueBase* vlb)
+{
+  Visitor visitor;
+  vlb->accept(visitor);
+  return visitor.getResult();
+}
+
+} // namespace streamencoder
+
+static std::string randomBytes(size_t length)
+{
+  std::string s;
+  for(size_t i = 0; i < length; ++i) {
+    s += static_cast<char>(rand()%256);
+  }
+  return s;
+}
+
+// A reply to get_peers with 8 compact nodes and 50 peers, as
+// DHTGetPeersReplyMessage creates it.
+static std::string createDHTGetPeersReply()
+{
+  Dict msg;
+  msg.put("t", randomBytes(2));
+  msg.put("y", "r");
+  SharedHandle<Dict> r = Dict::g();
+  r->put("id", randomBytes(20));
+  r->put("token", randomBytes(20));
+  r->put("nodes", randomBytes(26*8));
+  SharedHandle<List> values = List::g();
+  for(size_t i = 0; i < 50; ++i) {
+    values->append(randomBytes(6));
+  }
+  r->put("values", values);
+  msg.put("r", r);
+  return bencode2::encode(&msg);
+}
+
+// A find_node query.
+static std::string createDHTFindNode()
+{
+  Dict msg;
+  msg.put("t", randomBytes(2));
+  msg.put("y", "q");
+  msg.put("q", "find_node");
+  SharedHandle<Dict> a = Dict::g();
+  a->put("id", randomBytes(20));
+  a->put("target", randomBytes(20));
+  msg.put("a", a);
+  return bencode2::encode(&msg);
+}
+
+// A tracker response in the original, non-compact format with 50
+// peers.
+static std::string createTrackerResponse()
+{
+  Dict msg;
+  msg["interval"] = Integer::g(1800);
+  msg["min interval"] = Integer::g(900);
+  msg["complete"] = Integer::g(1234);
+  msg["incomplete"] = Integer::g(567);
+  SharedHandle<List> peers = List::g();
+  for(size_t i = 0; i < 50; ++i) {
+    SharedHandle<Dict> peer = Dict::g();
+    peer->put("peer id", randomBytes(20));
+    peer->put("ip", "192.168.0."+util::uitos(i));
+    peer->put("port", Integer::g(6881+i));
+    peers->append(peer);
+  }
+  msg["peers"] = peers;
+  return bencode2::encode(&msg);
+}
+
+static void run(const std::string& label, const std::string& payload)
+{
+  const unsigned char* data =
+    reinterpret_cast<const unsigned char*>(payload.data());
+  size_t length = payload.size();
+  bool same =
+    bencode2::encode(streamdecoder::decode(data, length)) == payload &&
+    bencode2::encode(bencode2::decode(data, length)) == payload;
+  if(!same) {
+    benchmark::note(label+": unexpected result");
+    return;
+  }
+  double start = benchmark::now();
+  for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+    streamdecoder::decode(data, length);
+  }
+  benchmark::report(label+" decode istream", NUM_ROUNDS,
+                    benchmark::now()-start,
+                    (uint64_t)length*NUM_ROUNDS);
+  start = benchmark::now();
+  for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+    bencode2::decode(data, length);
+  }
+  benchmark::report(label+" decode bencode2", NUM_ROUNDS,
+                    benchmark::now()-start,
+                    (uint64_t)length*NUM_ROUNDS);
+  // One ViewDecoder is reused, as a caller decoding many messages
+  // would keep one.
+  bencode2::ViewDecoder decoder;
+  size_t numViews = 0;
+  start = benchmark::now();
+  for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+    decoder.decode(data, length);
+    numViews += decoder.getRoot()->next;
+  }
+  benchmark::report(label+" decode view", NUM_ROUNDS,
+                    benchmark::now()-start,
+                    (uint64_t)length*NUM_ROUNDS);
+  if(numViews == 0) {
+    benchmark::note(label+": unexpected result");
+  }
+
+  SharedHandle<ValueBase> vlb = bencode2::decode(data, length);
+  if(streamencoder::encode(vlb.get()) != payload) {
+    benchmark::note(label+": unexpected result");
+    return;
+  }
+  start = benchmark::now();
+  for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+    streamencoder::encode(vlb.get());
+  }
+  benchmark::report(label+" encode ostream", NUM_ROUNDS,
+                    benchmark::now()-start, (uint64_t)length*NUM_ROUNDS);
+  start = benchmark::now();
+  for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+    bencode2::encode(vlb.get());
+  }
+  benchmark::report(label+" encode bencode2", NUM_ROUNDS,
+                    benchmark::now()-start, (uint64_t)length*NUM_ROUNDS);
+}
+
+static void benchmarkBencode2()
+{
+  srand(0);
+  run("DHT get_peers reply", createDHTGetPeersReply());
+  run("DHT find_node query", createDHTFindNode());
+  run("tracker response", createTrackerResponse());
+}
+
+BENCHMARK_REGISTRATION(benchmarkBencode2);
+
+} // namespace aria2
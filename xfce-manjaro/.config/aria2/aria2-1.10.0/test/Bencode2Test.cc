@@ -1,5 +1,7 @@
 #include "bencode2.h"
 
+#include <cstring>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "RecoverableException.h"
@@ -11,14 +13,24 @@ class Bencode2Test:public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(Bencode2Test);
   CPPUNIT_TEST(testDecode);
   CPPUNIT_TEST(testDecode_overflow);
+  CPPUNIT_TEST(testDecode_integer);
+  CPPUNIT_TEST(testDecode_binary);
+  CPPUNIT_TEST(testViewDecoder);
+  CPPUNIT_TEST(testViewDecoder_malformed);
   CPPUNIT_TEST(testEncode);
+  CPPUNIT_TEST(testEncode_buffer);
   CPPUNIT_TEST_SUITE_END();
 private:
 
 public:
   void testDecode();
   void testDecode_overflow();
+  void testDecode_integer();
+  void testDecode_binary();
+  void testViewDecoder();
+  void testViewDecoder_malformed();
   void testEncode();
+  void testEncode_buffer();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( Bencode2Test );
@@ -180,6 +192,132 @@ void Bencode2Test::testDecode_overflow()
   }
 }
 
+void Bencode2Test::testDecode_integer()
+{
+  CPPUNIT_ASSERT_EQUAL(static_cast<Integer::ValueType>(-123),
+                       asInteger(bencode2::decode("i-123e"))->i());
+  CPPUNIT_ASSERT_EQUAL(static_cast<Integer::ValueType>(0),
+                       asInteger(bencode2::decode("i0e"))->i());
+  CPPUNIT_ASSERT_EQUAL(static_cast<Integer::ValueType>(INT64_MAX),
+                       asInteger(bencode2::decode("i9223372036854775807e"))
+                       ->i());
+  CPPUNIT_ASSERT_EQUAL(static_cast<Integer::ValueType>(INT64_MIN),
+                       asInteger(bencode2::decode("i-9223372036854775808e"))
+                       ->i());
+  const char* malformed[] = {
+    "ie", "i-e", "i e", "i+1e", "i9223372036854775808e",
+    "i-9223372036854775809e"
+  };
+  for(size_t i = 0; i < sizeof(malformed)/sizeof(malformed[0]); ++i) {
+    try {
+      bencode2::decode(malformed[i]);
+      CPPUNIT_FAIL(std::string("exception must be thrown: ")+malformed[i]);
+    } catch(RecoverableException& e) {
+      CPPUNIT_ASSERT_EQUAL(std::string("Bencode decoding failed:"
+                                       " Integer expected but none found"),
+                           std::string(e.what()));
+    }
+  }
+}
+
+void Bencode2Test::testDecode_binary()
+{
+  const unsigned char data[] = {
+    'd', '1', ':', 'n', '3', ':', 0, 0xff, 0, 'e', 'x', 'y'
+  };
+  size_t end;
+  SharedHandle<ValueBase> r = bencode2::decode(data, sizeof(data), end);
+  CPPUNIT_ASSERT_EQUAL(std::string(&data[6], &data[9]),
+                       asString(asDict(r)->get("n"))->s());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, end);
+  // The length is limited to INT32_MAX.
+  try {
+    bencode2::decode("2147483648:a");
+    CPPUNIT_FAIL("exception must be thrown.");
+  } catch(RecoverableException& e) {
+    CPPUNIT_ASSERT_EQUAL(std::string("Bencode decoding failed:"
+                                     " A positive integer expected"
+                                     " but none found."),
+                         std::string(e.what()));
+  }
+}
+
+void Bencode2Test::testViewDecoder()
+{
+  const std::string s =
+    "d4:name5:aria24:sizei-123e5:filesl3:bin3:doce1:n0:4:sizei7ee"
+    "trailing";
+  const unsigned char* data =
+    reinterpret_cast<const unsigned char*>(s.data());
+  bencode2::ViewDecoder decoder;
+  CPPUNIT_ASSERT(!decoder.getRoot());
+  CPPUNIT_ASSERT_EQUAL(s.size()-8, decoder.decode(data, s.size()));
+  const bencode2::View* dict = decoder.getRoot();
+  CPPUNIT_ASSERT_EQUAL(bencode2::View::DICT, dict->type);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, dict->size);
+  CPPUNIT_ASSERT(data == dict->data);
+  CPPUNIT_ASSERT_EQUAL(s.size()-8, dict->length);
+  // Strings point into data.
+  const bencode2::View* name =
+    decoder.get(dict, "name", bencode2::View::STRING);
+  CPPUNIT_ASSERT(data+8 == name->data);
+  CPPUNIT_ASSERT_EQUAL(std::string("aria2"), name->s());
+  CPPUNIT_ASSERT_EQUAL(std::string(),
+                       decoder.get(dict, "n", bencode2::View::STRING)->s());
+  // The last value of a duplicated key is returned.
+  CPPUNIT_ASSERT_EQUAL(static_cast<Integer::ValueType>(7),
+                       decoder.get(dict, "size")->i);
+  CPPUNIT_ASSERT(!decoder.get(dict, "size", bencode2::View::STRING));
+  CPPUNIT_ASSERT(!decoder.get(dict, "none"));
+  CPPUNIT_ASSERT(!decoder.get(name, "name"));
+  CPPUNIT_ASSERT(!decoder.get(0, "name"));
+
+  const bencode2::View* files =
+    decoder.get(dict, "files", bencode2::View::LIST);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, files->size);
+  CPPUNIT_ASSERT_EQUAL(std::string("l3:bin3:doce"),
+                       std::string(&files->data[0],
+                                   &files->data[files->length]));
+  const bencode2::View* file = decoder.first(files);
+  CPPUNIT_ASSERT_EQUAL(std::string("bin"), file->s());
+  file = decoder.next(file);
+  CPPUNIT_ASSERT_EQUAL(std::string("doc"), file->s());
+  // The key after the list.
+  CPPUNIT_ASSERT_EQUAL(std::string("n"), decoder.next(file)->s());
+
+  // The decoder is reused.
+  CPPUNIT_ASSERT_EQUAL((size_t)5,
+                       decoder.decode
+                       (reinterpret_cast<const unsigned char*>("i-12e"), 5));
+  CPPUNIT_ASSERT_EQUAL(bencode2::View::INTEGER, decoder.getRoot()->type);
+  CPPUNIT_ASSERT_EQUAL(static_cast<Integer::ValueType>(-12),
+                       decoder.getRoot()->i);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, decoder.decode(data, 0));
+  CPPUNIT_ASSERT(!decoder.getRoot());
+}
+
+void Bencode2Test::testViewDecoder_malformed()
+{
+  std::string deep;
+  for(size_t i = 0; i < bencode2::MAX_STRUCTURE_DEPTH+1; ++i) {
+    deep = "l"+deep+"e";
+  }
+  const std::string malformed[] = {
+    "d4:name", "d4:name5:aria2", "li1e", "5:aria", "i+1e", "x", "di1ei2ee",
+    deep
+  };
+  bencode2::ViewDecoder decoder;
+  for(size_t i = 0; i < sizeof(malformed)/sizeof(malformed[0]); ++i) {
+    try {
+      decoder.decode(reinterpret_cast<const unsigned char*>
+                     (malformed[i].data()), malformed[i].size());
+      CPPUNIT_FAIL("exception must be thrown: "+malformed[i]);
+    } catch(RecoverableException& e) {
+      CPPUNIT_ASSERT(!decoder.getRoot());
+    }
+  }
+}
+
 void Bencode2Test::testEncode()
 {
   {
@@ -201,6 +339,38 @@ void Bencode2Test::testEncode()
                                      "e"),
                          bencode2::encode(&dict));
   }
+  {
+    List list;
+    list.append(Integer::g(-12));
+    list.append(Integer::g(0));
+    list.append(Integer::g(INT64_MIN));
+    list.append(String::g(""));
+    list.append(List::g());
+    list.append(Dict::g());
+    CPPUNIT_ASSERT_EQUAL(std::string("li-12ei0ei-9223372036854775808e"
+                                     "0:ledee"),
+                         bencode2::encode(&list));
+  }
+}
+
+void Bencode2Test::testEncode_buffer()
+{
+  Dict dict;
+  dict["id"] = String::g(std::string(20, 'a'));
+  dict["port"] = Integer::g(6881);
+  std::string expected = "d2:id20:aaaaaaaaaaaaaaaaaaaa4:porti6881ee";
+  CPPUNIT_ASSERT_EQUAL(expected.size(), bencode2::encodedLength(&dict));
+  // Appended to existing data.
+  std::string out = "prefix";
+  bencode2::encode(out, &dict);
+  CPPUNIT_ASSERT_EQUAL("prefix"+expected, out);
+
+  unsigned char buf[64];
+  memset(buf, 0xff, sizeof(buf));
+  unsigned char* last = bencode2::encode(buf, &dict);
+  CPPUNIT_ASSERT_EQUAL(expected.size(), static_cast<size_t>(last-buf));
+  CPPUNIT_ASSERT_EQUAL(expected, std::string(&buf[0], last));
+  CPPUNIT_ASSERT_EQUAL((unsigned char)0xff, *last);
 }
 
 } // namespace aria2
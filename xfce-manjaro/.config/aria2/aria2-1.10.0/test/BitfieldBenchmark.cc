@@ -0,0 +1,61 @@
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <vector>
+#include <string>
+
+#include "bitfield.h"
+
+namespace aria2 {
+
+// A 64GiB torrent with 16KiB pieces: 4Mi pieces, 512KiB bitfield.
+static const size_t NUM_PIECES = 4*1024*1024;
+static const size_t NUM_ROUNDS = 100;
+
+static void benchmarkBitfield()
+{
+  const size_t len = NUM_PIECES/8;
+  // Nearly complete download, so that scans cover most of the
+  // bitfield before finding a missing piece.
+  std::vector<unsigned char> have(len, 0xff);
+  std::vector<unsigned char> use(len, 0);
+  std::vector<unsigned char> peer(len, 0xff);
+  have[len-1] = 0xfe;
+  std::vector<unsigned char> dst(len);
+  std::string defaultKernel = bitfield::getKernel();
+  std::vector<std::string> kernels = bitfield::getAvailableKernels();
+  for(std::vector<std::string>::const_iterator i = kernels.begin(),
+        eoi = kernels.end(); i != eoi; ++i) {
+    bitfield::selectKernel(*i);
+    size_t sink = 0;
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      size_t index;
+      bitfield::findFirstBit(index, 0, 0, &have[0], &use[0], NUM_PIECES);
+      sink += index;
+    }
+    benchmark::report(*i+" findFirstBit", NUM_ROUNDS, benchmark::now()-start,
+                      (uint64_t)len*NUM_ROUNDS*2);
+    start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      sink += bitfield::countBits(&have[0], 0, 0, 0, NUM_PIECES);
+    }
+    benchmark::report(*i+" countBits", NUM_ROUNDS, benchmark::now()-start,
+                      (uint64_t)len*NUM_ROUNDS);
+    start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      sink += bitfield::computeBits(&dst[0], &peer[0], 0, &have[0], &use[0],
+                                    NUM_PIECES);
+    }
+    benchmark::report(*i+" computeBits", NUM_ROUNDS, benchmark::now()-start,
+                      (uint64_t)len*NUM_ROUNDS*3);
+    if(sink == 0) {
+      benchmark::note("unexpected result");
+    }
+  }
+  bitfield::selectKernel(defaultKernel);
+}
+
+BENCHMARK_REGISTRATION(benchmarkBitfield);
+
+} // namespace aria2
@@ -36,6 +36,7 @@ class BitfieldManTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testCountMissingBlock);
   CPPUNIT_TEST(testZeroLengthFilter);
   CPPUNIT_TEST(testGetFirstNMissingUnusedIndex);
+  CPPUNIT_TEST(testAllKernels);
   CPPUNIT_TEST_SUITE_END();
 public:
   void testGetBlockSize();
@@ -62,6 +63,7 @@ public:
   void testCountMissingBlock();
   void testZeroLengthFilter();
   void testGetFirstNMissingUnusedIndex();
+  void testAllKernels();
 };
 
 
@@ -640,4 +642,37 @@ void BitfieldManTest::testGetFirstNMissingUnusedIndex()
   CPPUNIT_ASSERT_EQUAL((size_t)9, out[0]);
 }
 
+void BitfieldManTest::testAllKernels()
+{
+  std::string defaultKernel = bitfield::getKernel();
+  std::vector<std::string> kernels = bitfield::getAvailableKernels();
+  for(std::vector<std::string>::const_iterator i = kernels.begin(),
+        eoi = kernels.end(); i != eoi; ++i) {
+    CPPUNIT_ASSERT(bitfield::selectKernel(*i));
+    testGetFirstMissingUnusedIndex();
+    testGetFirstMissingIndex();
+    testIsAllBitSet();
+    testFilter();
+    testAddFilter_zeroLength();
+    testAddNotFilter();
+    testAddNotFilter_zeroLength();
+    testAddNotFilter_overflow();
+    testGetSparceMissingUnusedIndex();
+    testGetSparceMissingUnusedIndex_setBit();
+    testGetSparceMissingUnusedIndex_withMinSplitSize();
+    testIsBitSetOffsetRange();
+    testGetMissingUnusedLength();
+    testSetBitRange();
+    testGetAllMissingIndexes();
+    testGetAllMissingIndexes_noarg();
+    testGetAllMissingIndexes_checkLastByte();
+    testGetAllMissingUnusedIndexes();
+    testCountFilteredBlock();
+    testCountMissingBlock();
+    testZeroLengthFilter();
+    testGetFirstNMissingUnusedIndex();
+  }
+  bitfield::selectKernel(defaultKernel);
+}
+
 } // namespace aria2
@@ -64,6 +64,7 @@ class BittorrentHelperTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testMetadata2Torrent);
   CPPUNIT_TEST(testTorrent2Magnet);
   CPPUNIT_TEST(testExtractPeerFromList);
+  CPPUNIT_TEST(testExtractPeerFromView);
   CPPUNIT_TEST(testExtract2PeersFromList);
   CPPUNIT_TEST_SUITE_END();
 public:
@@ -109,6 +110,7 @@ public:
   void testMetadata2Torrent();
   void testTorrent2Magnet();
   void testExtractPeerFromList();
+  void testExtractPeerFromView();
   void testExtract2PeersFromList();
 };
 
@@ -776,6 +778,47 @@ void BittorrentHelperTest::testExtractPeerFromList()
   CPPUNIT_ASSERT_EQUAL((uint16_t)2006, peer->getPort());
 }
 
+void BittorrentHelperTest::testExtractPeerFromView()
+{
+  std::string peersString =
+    "d5:peersld2:ip11:192.168.0.17:peer id20:aria2-00000000000000"
+    "4:porti65535eed2:ip11:192.168.0.24:porti65536eei1e"
+    "d2:ip11:192.168.0.34:porti2007eee"
+    "5:added12:";
+  unsigned char compact[12];
+  createcompact(compact, "192.168.0.4", 6881);
+  createcompact(compact+6, "192.168.0.5", 6882);
+  peersString.append(&compact[0], &compact[12]);
+  peersString += "e";
+
+  bencode2::ViewDecoder decoder;
+  decoder.decode(reinterpret_cast<const unsigned char*>(peersString.data()),
+                 peersString.size());
+  std::deque<SharedHandle<Peer> > peers;
+  // Entries with a bad port and non-dict entries are skipped.
+  extractPeer(decoder, decoder.get(decoder.getRoot(), "peers"),
+              std::back_inserter(peers));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, peers.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), peers[0]->getIPAddress());
+  CPPUNIT_ASSERT_EQUAL((uint16_t)65535, peers[0]->getPort());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), peers[1]->getIPAddress());
+  CPPUNIT_ASSERT_EQUAL((uint16_t)2007, peers[1]->getPort());
+
+  peers.clear();
+  extractPeer(decoder, decoder.get(decoder.getRoot(), "added"),
+              std::back_inserter(peers));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, peers.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.4"), peers[0]->getIPAddress());
+  CPPUNIT_ASSERT_EQUAL((uint16_t)6881, peers[0]->getPort());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.5"), peers[1]->getIPAddress());
+  CPPUNIT_ASSERT_EQUAL((uint16_t)6882, peers[1]->getPort());
+
+  peers.clear();
+  extractPeer(decoder, decoder.get(decoder.getRoot(), "none"),
+              std::back_inserter(peers));
+  CPPUNIT_ASSERT(peers.empty());
+}
+
 void BittorrentHelperTest::testExtract2PeersFromList()
 {
   std::string peersString =
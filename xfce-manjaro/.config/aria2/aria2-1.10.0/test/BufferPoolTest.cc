@@ -0,0 +1,75 @@
+#include "BufferPool.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class BufferPoolTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(BufferPoolTest);
+  CPPUNIT_TEST(testAllocate);
+  CPPUNIT_TEST(testDeallocate_maxFreeBlock);
+  CPPUNIT_TEST(testDeallocate_null);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testAllocate();
+  void testDeallocate_maxFreeBlock();
+  void testDeallocate_null();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( BufferPoolTest );
+
+void BufferPoolTest::testAllocate()
+{
+  BufferPool pool(16, 4);
+  CPPUNIT_ASSERT_EQUAL((size_t)16, pool.getBlockSize());
+
+  unsigned char* a = pool.allocate();
+  unsigned char* b = pool.allocate();
+  CPPUNIT_ASSERT(a != b);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.countInUse());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.getHighWater());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, pool.countMiss());
+
+  pool.deallocate(a);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.countInUse());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.countFreeBlock());
+
+  // Freed block is reused.
+  unsigned char* c = pool.allocate();
+  CPPUNIT_ASSERT(a == c);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, pool.countMiss());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countFreeBlock());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.getHighWater());
+
+  pool.deallocate(b);
+  pool.deallocate(c);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countInUse());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.getHighWater());
+}
+
+void BufferPoolTest::testDeallocate_maxFreeBlock()
+{
+  BufferPool pool(16, 2);
+  unsigned char* blocks[3];
+  for(size_t i = 0; i < 3; ++i) {
+    blocks[i] = pool.allocate();
+  }
+  for(size_t i = 0; i < 3; ++i) {
+    pool.deallocate(blocks[i]);
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countInUse());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.countFreeBlock());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.getHighWater());
+}
+
+void BufferPoolTest::testDeallocate_null()
+{
+  BufferPool pool(16, 2);
+  pool.deallocate(0);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countInUse());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countFreeBlock());
+}
+
+} // namespace aria2
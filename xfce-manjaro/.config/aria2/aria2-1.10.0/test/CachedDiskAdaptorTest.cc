@@ -0,0 +1,136 @@
+#include "CachedDiskAdaptor.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "DiskCache.h"
+#include "FileEntry.h"
+
+namespace aria2 {
+
+class CachedDiskAdaptorTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(CachedDiskAdaptorTest);
+  CPPUNIT_TEST(testWriteData);
+  CPPUNIT_TEST(testWriteData_acrossPieces);
+  CPPUNIT_TEST(testReadData);
+  CPPUNIT_TEST(testReadData_beyondFileEnd);
+  CPPUNIT_TEST(testEvict);
+  CPPUNIT_TEST(testCloseFile);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  SharedHandle<ByteArrayDiskWriter> writer_;
+  SharedHandle<DirectDiskAdaptor> direct_;
+  SharedHandle<DiskCache> diskCache_;
+  SharedHandle<CachedDiskAdaptor> adaptor_;
+public:
+  void setUp()
+  {
+    writer_.reset(new ByteArrayDiskWriter());
+    writer_->setString(std::string(64, '.'));
+    std::vector<SharedHandle<FileEntry> > fileEntries;
+    fileEntries.push_back(SharedHandle<FileEntry>(new FileEntry("file", 64, 0)));
+    direct_.reset(new DirectDiskAdaptor());
+    direct_->setDiskWriter(writer_);
+    direct_->setTotalLength(64);
+    direct_->setFileEntries(fileEntries.begin(), fileEntries.end());
+    diskCache_.reset(new DiskCache(1024));
+    adaptor_.reset(new CachedDiskAdaptor(direct_, diskCache_, 16));
+  }
+
+  void write(const std::string& data, off_t offset)
+  {
+    adaptor_->writeData(reinterpret_cast<const unsigned char*>(data.data()),
+                        data.size(), offset);
+  }
+
+  std::string read(size_t len, off_t offset)
+  {
+    unsigned char buf[64];
+    ssize_t r = adaptor_->readData(buf, len, offset);
+    return std::string(&buf[0], &buf[r]);
+  }
+
+  void testWriteData();
+  void testWriteData_acrossPieces();
+  void testReadData();
+  void testReadData_beyondFileEnd();
+  void testEvict();
+  void testCloseFile();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CachedDiskAdaptorTest);
+
+void CachedDiskAdaptorTest::testWriteData()
+{
+  write("0123", 16);
+  write("4567", 20);
+  CPPUNIT_ASSERT_EQUAL(std::string(64, '.'), writer_->getString());
+  CPPUNIT_ASSERT_EQUAL((size_t)8, diskCache_->getSize());
+
+  adaptor_->flushPiece(1);
+  CPPUNIT_ASSERT_EQUAL(std::string(16, '.')+"01234567"+std::string(40, '.'),
+                       writer_->getString());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, diskCache_->getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, diskCache_->countEntry());
+}
+
+void CachedDiskAdaptorTest::testWriteData_acrossPieces()
+{
+  write("0123456789", 12);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, diskCache_->countEntry());
+
+  adaptor_->flushPiece(0);
+  CPPUNIT_ASSERT_EQUAL(std::string(12, '.')+"0123"+std::string(48, '.'),
+                       writer_->getString());
+  adaptor_->flushCache();
+  CPPUNIT_ASSERT_EQUAL(std::string(12, '.')+"0123456789"+std::string(42, '.'),
+                       writer_->getString());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, diskCache_->getSize());
+}
+
+void CachedDiskAdaptorTest::testReadData()
+{
+  write("abcd", 14);
+  // Served from memory only.
+  CPPUNIT_ASSERT_EQUAL(std::string("bc"), read(2, 15));
+  // Mixed with data on disk.
+  CPPUNIT_ASSERT_EQUAL(std::string("..abcd.."), read(8, 12));
+}
+
+void CachedDiskAdaptorTest::testReadData_beyondFileEnd()
+{
+  writer_->setString(std::string(8, '.'));
+  write("ab", 10);
+  std::string data = read(16, 4);
+  CPPUNIT_ASSERT_EQUAL((size_t)8, data.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("....")+std::string(2, '\0')+"ab", data);
+}
+
+void CachedDiskAdaptorTest::testEvict()
+{
+  diskCache_.reset(new DiskCache(16));
+  adaptor_.reset(new CachedDiskAdaptor(direct_, diskCache_, 16));
+  write("0123456789", 0);
+  write("abcdefghij", 16);
+  // Piece 0 is the least recently updated and it was written back.
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789")+std::string(54, '.'),
+                       writer_->getString());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, diskCache_->getSize());
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789"), read(10, 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("abcdefghij"), read(10, 16));
+}
+
+void CachedDiskAdaptorTest::testCloseFile()
+{
+  write("0123", 60);
+  adaptor_->closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string(60, '.')+"0123", writer_->getString());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, diskCache_->getSize());
+}
+
+} // namespace aria2
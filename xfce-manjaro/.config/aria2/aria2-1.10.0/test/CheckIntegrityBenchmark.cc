@@ -0,0 +1,137 @@
+#include "Benchmark.h"
+
+#include <sys/select.h>
+#include <cstdio>
+#include <string>
+#include <deque>
+#include <vector>
+#include <fstream>
+
+#include "IteratableChunkChecksumValidator.h"
+#include "DownloadContext.h"
+#include "DefaultPieceStorage.h"
+#include "PieceSelector.h"
+#include "DiskAdaptor.h"
+#include "Option.h"
+#include "messageDigest.h"
+#include "DiskIOJob.h"
+#ifdef ENABLE_DISK_IO_THREAD
+# include "DiskIOThreadPool.h"
+#endif // ENABLE_DISK_IO_THREAD
+#include "util.h"
+
+namespace aria2 {
+
+// Verifies a 128MiB file with 256KiB pieces, as --check-integrity
+// does. The file is in the page cache, so hashing dominates.
+static const size_t PIECE_LENGTH = 256*1024;
+static const size_t NUM_PIECES = 512;
+static const uint64_t TOTAL_LENGTH = (uint64_t)PIECE_LENGTH*NUM_PIECES;
+
+static const std::string FILENAME = "/tmp/aria2_CheckIntegrityBenchmark";
+
+static void createFile()
+{
+  std::ofstream out(FILENAME.c_str(), std::ios::binary);
+  std::string data(PIECE_LENGTH, 'a');
+  for(size_t i = 0; i < NUM_PIECES; ++i) {
+    data[0] = i;
+    out.write(data.data(), data.size());
+  }
+}
+
+// Every piece is hashed whether or not its hash matches, so the hashes
+// are not computed beforehand.
+static SharedHandle<DownloadContext> createDownloadContext()
+{
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(PIECE_LENGTH, TOTAL_LENGTH, FILENAME));
+  std::deque<std::string> hashes
+    (NUM_PIECES, "ffffffffffffffffffffffffffffffffffffffff");
+  dctx->setPieceHashes(hashes.begin(), hashes.end());
+  dctx->setPieceHashAlgo(MessageDigestContext::SHA1);
+  return dctx;
+}
+
+static void benchmarkSequential()
+{
+  Option option;
+  SharedHandle<DownloadContext> dctx = createDownloadContext();
+  SharedHandle<DefaultPieceStorage> ps(new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->openFile();
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.init();
+  double start = benchmark::now();
+  while(!validator.finished()) {
+    validator.validateChunk();
+  }
+  benchmark::report("main thread", NUM_PIECES, benchmark::now()-start,
+                    TOTAL_LENGTH);
+  ps->getDiskAdaptor()->closeFile();
+}
+
+#ifdef ENABLE_DISK_IO_THREAD
+static void benchmarkThreads(size_t numThread)
+{
+  Option option;
+  SharedHandle<DownloadContext> dctx = createDownloadContext();
+  SharedHandle<DefaultPieceStorage> ps(new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->openFile();
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.init();
+  DiskIOThreadPool pool(numThread);
+  std::deque<SharedHandle<DiskIOJob> > jobs;
+  double start = benchmark::now();
+  // The same loop as CheckIntegrityCommand runs.
+  while(!validator.finished()) {
+    for(std::deque<SharedHandle<DiskIOJob> >::iterator i = jobs.begin();
+        i != jobs.end();) {
+      if((*i)->completed()) {
+        validator.finishChunkJob(*i);
+        i = jobs.erase(i);
+      } else {
+        ++i;
+      }
+    }
+    while(jobs.size() < numThread*2) {
+      SharedHandle<DiskIOJob> job = validator.createChunkJob();
+      if(job.isNull()) {
+        break;
+      }
+      pool.post(job);
+      jobs.push_back(job);
+    }
+    if(!jobs.empty()) {
+      fd_set rfds;
+      FD_ZERO(&rfds);
+      FD_SET(pool.getFd(), &rfds);
+      select(pool.getFd()+1, &rfds, 0, 0, 0);
+      pool.processCompletions();
+    }
+  }
+  benchmark::report(util::uitos(numThread)+" disk I/O threads", NUM_PIECES,
+                    benchmark::now()-start, TOTAL_LENGTH);
+  ps->getDiskAdaptor()->closeFile();
+}
+#endif // ENABLE_DISK_IO_THREAD
+
+static void benchmarkCheckIntegrity()
+{
+  createFile();
+  // Warm up the page cache.
+  benchmarkSequential();
+  benchmarkSequential();
+#ifdef ENABLE_DISK_IO_THREAD
+  const size_t numThreads[] = { 1, 2, 4, 8 };
+  for(size_t i = 0; i < sizeof(numThreads)/sizeof(numThreads[0]); ++i) {
+    benchmarkThreads(numThreads[i]);
+  }
+#endif // ENABLE_DISK_IO_THREAD
+  remove(FILENAME.c_str());
+}
+
+BENCHMARK_REGISTRATION(benchmarkCheckIntegrity);
+
+} // namespace aria2
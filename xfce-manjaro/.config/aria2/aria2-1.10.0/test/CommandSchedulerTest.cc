@@ -0,0 +1,210 @@
+#include "CommandScheduler.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Command.h"
+
+namespace aria2 {
+
+class CommandSchedulerTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(CommandSchedulerTest);
+  CPPUNIT_TEST(testAdd);
+  CPPUNIT_TEST(testActivate);
+  CPPUNIT_TEST(testRefresh);
+  CPPUNIT_TEST(testRefresh_farFuture);
+  CPPUNIT_TEST(testRefresh_clockJump);
+  CPPUNIT_TEST(testWakeAll);
+  CPPUNIT_TEST(testDeleteCommand);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  class MockCommand:public Command {
+  private:
+    bool* deleted_;
+  public:
+    MockCommand(cuid_t cuid, bool* deleted = 0):
+      Command(cuid), deleted_(deleted) {}
+
+    virtual ~MockCommand()
+    {
+      if(deleted_) {
+        *deleted_ = true;
+      }
+    }
+
+    virtual bool execute()
+    {
+      return true;
+    }
+  };
+
+  void testAdd();
+  void testActivate();
+  void testRefresh();
+  void testRefresh_farFuture();
+  void testRefresh_clockJump();
+  void testWakeAll();
+  void testDeleteCommand();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CommandSchedulerTest);
+
+void CommandSchedulerTest::testAdd()
+{
+  CommandScheduler sched;
+  MockCommand c1(1);
+  MockCommand c2(2);
+  c2.setStatusActive();
+  MockCommand c3(3);
+  c3.setStatusRealtime();
+  sched.add(&c1);
+  sched.add(&c2);
+  sched.add(&c3);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, sched.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, sched.countReady());
+  CPPUNIT_ASSERT(sched.popReady() == &c2);
+  CPPUNIT_ASSERT(sched.popReady() == &c3);
+  CPPUNIT_ASSERT(sched.popReady() == 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, sched.size());
+  // c1 waits for the next refresh.
+  sched.refresh(100);
+  CPPUNIT_ASSERT(sched.popReady() == &c1);
+  CPPUNIT_ASSERT(sched.empty());
+}
+
+void CommandSchedulerTest::testActivate()
+{
+  CommandScheduler sched;
+  MockCommand c1(1);
+  MockCommand c2(2);
+  sched.refresh(100);
+  c2.setWakeupTime(200);
+  sched.add(&c1);
+  sched.add(&c2);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countReady());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, sched.countWheel());
+
+  c2.setStatusActive();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, sched.countReady());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countWheel());
+  // Activating twice does not add it again.
+  c2.setStatusActive();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, sched.countReady());
+  CPPUNIT_ASSERT(sched.popReady() == &c2);
+  // Wakeup time is reset when the command leaves.
+  CPPUNIT_ASSERT_EQUAL((time_t)0, c2.getWakeupTime());
+  // Not scheduled, so nothing happens.
+  c2.setStatusActive();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countReady());
+
+  c1.setStatus(Command::STATUS_ONESHOT_REALTIME);
+  CPPUNIT_ASSERT(sched.popReady() == &c1);
+}
+
+void CommandSchedulerTest::testRefresh()
+{
+  CommandScheduler sched;
+  sched.refresh(1000);
+  time_t wakeups[] = { 1001, 1063, 1064, 1100, 1000+64*64-1 };
+  const size_t n = sizeof(wakeups)/sizeof(wakeups[0]);
+  MockCommand* commands[n];
+  for(size_t i = 0; i < n; ++i) {
+    commands[i] = new MockCommand(i);
+    commands[i]->setWakeupTime(wakeups[i]);
+    sched.add(commands[i]);
+  }
+  CPPUNIT_ASSERT_EQUAL(n, sched.countWheel());
+  time_t now = 1000;
+  for(size_t i = 0; i < n; ++i) {
+    // Refresh at various steps.
+    for(; now < wakeups[i]-1; now += 7) {
+      sched.refresh(now);
+      CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countReady());
+    }
+    now = wakeups[i]-1;
+    sched.refresh(now);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countReady());
+    now = wakeups[i];
+    sched.refresh(now);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, sched.countReady());
+    Command* c = sched.popReady();
+    CPPUNIT_ASSERT(c == commands[i]);
+    delete c;
+  }
+  CPPUNIT_ASSERT(sched.empty());
+}
+
+void CommandSchedulerTest::testRefresh_farFuture()
+{
+  CommandScheduler sched;
+  sched.refresh(1000);
+  MockCommand c1(1);
+  c1.setWakeupTime(1000+100000);
+  sched.add(&c1);
+  for(time_t now = 1000; now < 1000+100000; now += 1000) {
+    sched.refresh(now);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countReady());
+  }
+  sched.refresh(1000+100000);
+  CPPUNIT_ASSERT(sched.popReady() == &c1);
+}
+
+void CommandSchedulerTest::testRefresh_clockJump()
+{
+  CommandScheduler sched;
+  sched.refresh(1000);
+  MockCommand c1(1);
+  c1.setWakeupTime(1010);
+  MockCommand c2(2);
+  c2.setWakeupTime(1020);
+  sched.add(&c1);
+  sched.add(&c2);
+  // Clock goes backward.
+  sched.refresh(500);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countReady());
+  sched.refresh(1010);
+  CPPUNIT_ASSERT(sched.popReady() == &c1);
+  // Clock jumps far forward.
+  sched.refresh(1000000);
+  CPPUNIT_ASSERT(sched.popReady() == &c2);
+  CPPUNIT_ASSERT(sched.empty());
+}
+
+void CommandSchedulerTest::testWakeAll()
+{
+  CommandScheduler sched;
+  sched.refresh(1000);
+  MockCommand c1(1);
+  MockCommand c2(2);
+  c2.setWakeupTime(5000);
+  sched.add(&c1);
+  sched.add(&c2);
+  sched.wakeAll();
+  CPPUNIT_ASSERT_EQUAL((size_t)2, sched.countReady());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countWheel());
+  CPPUNIT_ASSERT(sched.popReady() == &c1);
+  CPPUNIT_ASSERT(sched.popReady() == &c2);
+}
+
+void CommandSchedulerTest::testDeleteCommand()
+{
+  CommandScheduler sched;
+  sched.refresh(1000);
+  bool deleted1 = false;
+  bool deleted2 = false;
+  MockCommand* c1 = new MockCommand(1, &deleted1);
+  c1->setWakeupTime(2000);
+  MockCommand* c2 = new MockCommand(2, &deleted2);
+  sched.add(c1);
+  sched.add(c2);
+  // Deleting a scheduled command removes it from the scheduler.
+  delete c1;
+  CPPUNIT_ASSERT_EQUAL((size_t)1, sched.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, sched.countWheel());
+  sched.deleteAll();
+  CPPUNIT_ASSERT(deleted2);
+  CPPUNIT_ASSERT(sched.empty());
+}
+
+} // namespace aria2
@@ -0,0 +1,95 @@
+#include "Benchmark.h"
+
+#include <string>
+
+#include "DHTConnectionImpl.h"
+#include "SocketCore.h"
+#include "util.h"
+
+namespace aria2 {
+
+// Each round, one node sends a burst of find_node sized replies to
+// another over loopback, and the other reads them all.
+static const size_t NUM_ROUNDS = 10000;
+static const size_t BURST = 32;
+static const size_t MESSAGE_LENGTH = 300;
+
+static void benchmarkDHTConnection()
+{
+  DHTConnectionImpl con1;
+  uint16_t con1port = 0;
+  DHTConnectionImpl con2;
+  uint16_t con2port = 0;
+  if(!con1.bind(con1port) || !con2.bind(con2port)) {
+    benchmark::note("failed to bind");
+    return;
+  }
+  std::pair<std::string, uint16_t> addr;
+  con2.getSocket()->getAddrInfo(addr);
+  std::string host = addr.first == "::" ? "::1" : "127.0.0.1";
+  if(!con1.getSocket()->supportsDatagramBatch()) {
+    benchmark::note("recvmmsg/sendmmsg not available");
+  }
+  const std::string message(MESSAGE_LENGTH, 'a');
+  const unsigned char* data =
+    reinterpret_cast<const unsigned char*>(message.data());
+  unsigned char buf[64*1024];
+  size_t received = 0;
+  {
+    // What DHTConnectionImpl did before: one sendto and one recvfrom
+    // per datagram.
+    size_t calls = 0;
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      for(size_t i = 0; i < BURST; ++i) {
+        con1.sendMessage(data, message.size(), host, con2port);
+      }
+      for(;;) {
+        std::pair<std::string, uint16_t> sender;
+        ++calls;
+        if(con2.getSocket()->readDataFrom(buf, sizeof(buf), sender) == 0) {
+          break;
+        }
+        ++received;
+      }
+    }
+    benchmark::report("sendto/recvfrom", NUM_ROUNDS*BURST,
+                      benchmark::now()-start,
+                      (uint64_t)NUM_ROUNDS*BURST*MESSAGE_LENGTH);
+    benchmark::note("packets="+util::uitos(received)+
+                    " send calls="+util::uitos(NUM_ROUNDS*BURST)+
+                    " receive calls="+util::uitos(calls));
+  }
+  received = 0;
+  {
+    uint64_t sendCalls = con1.getNumSendCall();
+    uint64_t sent = con1.getNumSentPacket();
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      for(size_t i = 0; i < BURST; ++i) {
+        con1.queueMessage(data, message.size(), host, con2port);
+      }
+      con1.flushMessages();
+      std::string remoteHost;
+      uint16_t remotePort;
+      while(con2.receiveMessage(buf, sizeof(buf), remoteHost, remotePort)) {
+        ++received;
+      }
+    }
+    benchmark::report("queueMessage/receiveMessage", NUM_ROUNDS*BURST,
+                      benchmark::now()-start,
+                      (uint64_t)NUM_ROUNDS*BURST*MESSAGE_LENGTH);
+    benchmark::note("packets="+util::uitos(con1.getNumSentPacket()-sent)+
+                    " send calls="+
+                    util::uitos(con1.getNumSendCall()-sendCalls)+
+                    " receive calls="+util::uitos(con2.getNumReceiveCall()));
+  }
+  if(received != NUM_ROUNDS*BURST) {
+    benchmark::note("lost "+util::uitos(NUM_ROUNDS*BURST-received)+
+                    " datagrams");
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkDHTConnection);
+
+} // namespace aria2
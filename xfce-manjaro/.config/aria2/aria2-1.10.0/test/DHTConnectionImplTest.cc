@@ -10,6 +10,7 @@ class DHTConnectionImplTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DHTConnectionImplTest);
   CPPUNIT_TEST(testWriteAndReadData);
+  CPPUNIT_TEST(testQueueAndFlushMessages);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp() {}
@@ -17,6 +18,8 @@ public:
   void tearDown() {}
 
   void testWriteAndReadData();
+
+  void testQueueAndFlushMessages();
 };
 
 
@@ -53,4 +56,67 @@ void DHTConnectionImplTest::testWriteAndReadData()
   }
 }
 
+void DHTConnectionImplTest::testQueueAndFlushMessages()
+{
+  try {
+    DHTConnectionImpl con1;
+    uint16_t con1port = 0;
+    CPPUNIT_ASSERT(con1.bind(con1port));
+
+    DHTConnectionImpl con2;
+    uint16_t con2port = 0;
+    CPPUNIT_ASSERT(con2.bind(con2port));
+    std::pair<std::string, uint16_t> addr;
+    con2.getSocket()->getAddrInfo(addr);
+    std::string host = addr.first == "::" ? "::1" : "127.0.0.1";
+
+    const std::string messages[] = { "alpha", "bravo", "charlie" };
+    for(size_t i = 0; i < 3; ++i) {
+      CPPUNIT_ASSERT_EQUAL
+        ((ssize_t)messages[i].size(),
+         con1.queueMessage(reinterpret_cast<const unsigned char*>
+                           (messages[i].c_str()), messages[i].size(),
+                           host, con2port));
+    }
+    bool batch = con1.getSocket()->supportsDatagramBatch();
+    if(batch) {
+      CPPUNIT_ASSERT_EQUAL((uint64_t)0, con1.getNumSendCall());
+    }
+    con1.flushMessages();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)3, con1.getNumSentPacket());
+    if(batch) {
+      CPPUNIT_ASSERT_EQUAL((uint64_t)1, con1.getNumSendCall());
+    }
+
+    while(!con2.getSocket()->isReadable(0));
+    unsigned char readbuffer[100];
+    std::string remoteHost;
+    uint16_t remotePort;
+    for(size_t i = 0; i < 3; ++i) {
+      ssize_t rlength = 0;
+      // Without batch support, datagrams are read one by one and the
+      // later ones may not have arrived yet.
+      while(rlength == 0) {
+        rlength = con2.receiveMessage(readbuffer, sizeof(readbuffer),
+                                      remoteHost, remotePort);
+      }
+      CPPUNIT_ASSERT_EQUAL(messages[i],
+                           std::string(&readbuffer[0], &readbuffer[rlength]));
+      CPPUNIT_ASSERT_EQUAL(con1port, remotePort);
+    }
+    CPPUNIT_ASSERT_EQUAL((uint64_t)3, con2.getNumReceivedPacket());
+    if(batch) {
+      CPPUNIT_ASSERT_EQUAL((uint64_t)1, con2.getNumReceiveCall());
+      // The socket was drained by the first call, so no system call is
+      // made until the next round.
+      CPPUNIT_ASSERT_EQUAL((ssize_t)0,
+                           con2.receiveMessage(readbuffer, sizeof(readbuffer),
+                                               remoteHost, remotePort));
+      CPPUNIT_ASSERT_EQUAL((uint64_t)1, con2.getNumReceiveCall());
+    }
+  } catch(Exception& e) {
+    CPPUNIT_FAIL(e.stackTrace());
+  }
+}
+
 } // namespace aria2
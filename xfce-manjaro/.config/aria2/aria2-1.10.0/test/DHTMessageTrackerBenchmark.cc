@@ -0,0 +1,92 @@
+#include "Benchmark.h"
+
+#include <vector>
+
+#include "DHTMessageTracker.h"
+#include "DHTMessageCallback.h"
+#include "DHTConstants.h"
+#include "DHTNode.h"
+#include "DHTRoutingTable.h"
+#include "MockDHTMessage.h"
+#include "MockDHTMessageFactory.h"
+#include "util.h"
+
+namespace aria2 {
+
+// A node running many lookups at once keeps thousands of queries in
+// flight. Every event loop iteration sweeps the tracker for timeouts,
+// and every reply is matched against the outstanding queries.
+static const size_t NUM_ROUNDS = 20000;
+
+namespace {
+// Returns the same reply for every message, so that the benchmark
+// measures the tracker rather than creating messages.
+class ReplyFactory:public MockDHTMessageFactory {
+private:
+  SharedHandle<DHTResponseMessage> reply_;
+public:
+  ReplyFactory(const SharedHandle<DHTResponseMessage>& reply):reply_(reply) {}
+
+  virtual SharedHandle<DHTResponseMessage>
+  createResponseMessage(const std::string& messageType,
+                        const Dict* dict,
+                        const std::string& ipaddr, uint16_t port)
+  {
+    return reply_;
+  }
+};
+} // namespace
+
+static void benchmarkInFlight(size_t numInFlight)
+{
+  SharedHandle<DHTNode> localNode(new DHTNode());
+  SharedHandle<DHTNode> remoteNode(new DHTNode());
+  SharedHandle<DHTResponseMessage> reply
+    (new MockDHTResponseMessage(localNode, remoteNode, "ab"));
+  DHTMessageTracker tracker;
+  tracker.setRoutingTable
+    (SharedHandle<DHTRoutingTable>(new DHTRoutingTable(localNode)));
+  tracker.setMessageFactory
+    (SharedHandle<DHTMessageFactory>(new ReplyFactory(reply)));
+  std::vector<SharedHandle<DHTMessage> > messages;
+  for(size_t i = 0; i < numInFlight+NUM_ROUNDS; ++i) {
+    SharedHandle<DHTNode> node(new DHTNode());
+    node->setIPAddress("10.0."+util::uitos(i/256%256)+"."+
+                       util::uitos(i%256));
+    node->setPort(6881+i%1000);
+    messages.push_back
+      (SharedHandle<DHTMessage>(new MockDHTMessage(localNode, node)));
+  }
+  for(size_t i = 0; i < numInFlight; ++i) {
+    tracker.addMessage(messages[i], DHT_MESSAGE_TIMEOUT);
+  }
+  size_t sink = 0;
+  double start = benchmark::now();
+  for(size_t i = 0; i < NUM_ROUNDS; ++i) {
+    // Replies arrive roughly in the order the queries were sent.
+    const SharedHandle<DHTMessage>& m = messages[i];
+    Dict dict;
+    dict.put(DHTMessage::T, m->getTransactionID());
+    sink += !tracker.messageArrived(&dict, m->getRemoteNode()->getIPAddress(),
+                                    m->getRemoteNode()->getPort()).
+      first.isNull();
+    tracker.addMessage(messages[numInFlight+i], DHT_MESSAGE_TIMEOUT);
+    tracker.handleTimeout();
+  }
+  benchmark::report("in flight="+util::uitos(numInFlight)+
+                    " reply+send+sweep", NUM_ROUNDS, benchmark::now()-start);
+  if(sink != NUM_ROUNDS || tracker.countEntry() != numInFlight) {
+    benchmark::note("unexpected result");
+  }
+}
+
+static void benchmarkDHTMessageTracker()
+{
+  benchmarkInFlight(100);
+  benchmarkInFlight(1000);
+  benchmarkInFlight(10000);
+}
+
+BENCHMARK_REGISTRATION(benchmarkDHTMessageTracker);
+
+} // namespace aria2
@@ -17,6 +17,7 @@ class DHTMessageTrackerTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DHTMessageTrackerTest);
   CPPUNIT_TEST(testMessageArrived);
+  CPPUNIT_TEST(testMessageArrived_sameTransactionID);
   CPPUNIT_TEST(testHandleTimeout);
   CPPUNIT_TEST_SUITE_END();
 public:
@@ -26,6 +27,8 @@ public:
 
   void testMessageArrived();
 
+  void testMessageArrived_sameTransactionID();
+
   void testHandleTimeout();
 };
 
@@ -98,8 +101,95 @@ void DHTMessageTrackerTest::testMessageArrived()
   }
 }
 
+void DHTMessageTrackerTest::testMessageArrived_sameTransactionID()
+{
+  SharedHandle<DHTNode> localNode(new DHTNode());
+  SharedHandle<DHTRoutingTable> routingTable(new DHTRoutingTable(localNode));
+  SharedHandle<MockDHTMessageFactory> factory(new MockDHTMessageFactory());
+  factory->setLocalNode(localNode);
+
+  SharedHandle<MockDHTMessage> m1(new MockDHTMessage(localNode,
+                                                     SharedHandle<DHTNode>(new DHTNode()), "mock", "ab"));
+  SharedHandle<MockDHTMessage> m2(new MockDHTMessage(localNode,
+                                                     SharedHandle<DHTNode>(new DHTNode()), "mock", "ab"));
+  m1->getRemoteNode()->setIPAddress("192.168.0.1");
+  m1->getRemoteNode()->setPort(6881);
+  m2->getRemoteNode()->setIPAddress("192.168.0.2");
+  m2->getRemoteNode()->setPort(6882);
+
+  DHTMessageTracker tracker;
+  tracker.setRoutingTable(routingTable);
+  tracker.setMessageFactory(factory);
+  tracker.addMessage(m1, DHT_MESSAGE_TIMEOUT);
+  tracker.addMessage(m2, DHT_MESSAGE_TIMEOUT);
+
+  Dict resDict;
+  resDict.put("t", "ab");
+  CPPUNIT_ASSERT(tracker.messageArrived(&resDict, "192.168.0.3", 6882).
+                 first.isNull());
+  CPPUNIT_ASSERT(!tracker.messageArrived(&resDict, "::ffff:192.168.0.2", 6882).
+                 first.isNull());
+  CPPUNIT_ASSERT(tracker.getEntryFor(m2).isNull());
+  CPPUNIT_ASSERT(!tracker.getEntryFor(m1).isNull());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, tracker.countEntry());
+  CPPUNIT_ASSERT(!tracker.messageArrived(&resDict, "192.168.0.1", 6881).
+                 first.isNull());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, tracker.countEntry());
+}
+
+namespace {
+class TimeoutCallback:public MockDHTMessageCallback {
+public:
+  std::vector<SharedHandle<DHTNode> > nodes;
+
+  virtual void onTimeout(const SharedHandle<DHTNode>& remoteNode)
+  {
+    nodes.push_back(remoteNode);
+  }
+};
+} // namespace
+
 void DHTMessageTrackerTest::testHandleTimeout()
 {
+  SharedHandle<DHTNode> localNode(new DHTNode());
+  SharedHandle<DHTRoutingTable> routingTable(new DHTRoutingTable(localNode));
+  SharedHandle<MockDHTMessageFactory> factory(new MockDHTMessageFactory());
+  factory->setLocalNode(localNode);
+
+  SharedHandle<MockDHTMessage> m1(new MockDHTMessage(localNode,
+                                                     SharedHandle<DHTNode>(new DHTNode())));
+  SharedHandle<MockDHTMessage> m2(new MockDHTMessage(localNode,
+                                                     SharedHandle<DHTNode>(new DHTNode())));
+  SharedHandle<MockDHTMessage> m3(new MockDHTMessage(localNode,
+                                                     SharedHandle<DHTNode>(new DHTNode())));
+  m1->getRemoteNode()->setIPAddress("192.168.0.1");
+  m1->getRemoteNode()->setPort(6881);
+  m2->getRemoteNode()->setIPAddress("192.168.0.2");
+  m2->getRemoteNode()->setPort(6882);
+  m3->getRemoteNode()->setIPAddress("192.168.0.3");
+  m3->getRemoteNode()->setPort(6883);
+
+  SharedHandle<TimeoutCallback> callback(new TimeoutCallback());
+  DHTMessageTracker tracker;
+  tracker.setRoutingTable(routingTable);
+  tracker.setMessageFactory(factory);
+  tracker.addMessage(m1, 0, callback);
+  tracker.addMessage(m2, DHT_MESSAGE_TIMEOUT, callback);
+  tracker.addMessage(m3, 0, callback);
+
+  tracker.handleTimeout();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, tracker.countEntry());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, tracker.getNumTimeout());
+  CPPUNIT_ASSERT(!tracker.getEntryFor(m2).isNull());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, callback->nodes.size());
+  CPPUNIT_ASSERT(callback->nodes[0] == m1->getRemoteNode() ||
+                 callback->nodes[0] == m3->getRemoteNode());
+  CPPUNIT_ASSERT(callback->nodes[1] == m1->getRemoteNode() ||
+                 callback->nodes[1] == m3->getRemoteNode());
+
+  tracker.handleTimeout();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, tracker.countEntry());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, tracker.getNumTimeout());
 }
 
 } // namespace aria2
@@ -15,12 +15,14 @@ class DHTPeerAnnounceEntryTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DHTPeerAnnounceEntryTest);
   CPPUNIT_TEST(testRemoveStalePeerAddrEntry);
+  CPPUNIT_TEST(testRemoveOldestPeerAddrEntry);
   CPPUNIT_TEST(testEmpty);
   CPPUNIT_TEST(testAddPeerAddrEntry);
   CPPUNIT_TEST(testGetPeers);
   CPPUNIT_TEST_SUITE_END();
 public:
   void testRemoveStalePeerAddrEntry();
+  void testRemoveOldestPeerAddrEntry();
   void testEmpty();
   void testAddPeerAddrEntry();
   void testGetPeers();
@@ -40,7 +42,7 @@ void DHTPeerAnnounceEntryTest::testRemoveStalePeerAddrEntry()
   entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.3", 6883));
   entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.4", 6884, Timer(0)));
 
-  entry.removeStalePeerAddrEntry(10);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, entry.removeStalePeerAddrEntry(10));
 
   CPPUNIT_ASSERT_EQUAL((size_t)2, entry.countPeerAddrEntry());
 
@@ -50,6 +52,24 @@ void DHTPeerAnnounceEntryTest::testRemoveStalePeerAddrEntry()
   CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), peerAddrEntries[1].getIPAddress());
 }
 
+void DHTPeerAnnounceEntryTest::testRemoveOldestPeerAddrEntry()
+{
+  unsigned char infohash[DHT_ID_LENGTH];
+  memset(infohash, 0xff, DHT_ID_LENGTH);
+  DHTPeerAnnounceEntry entry(infohash);
+
+  entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.1", 6881, Timer(2)));
+  entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.2", 6882, Timer(1)));
+  entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.3", 6883, Timer(3)));
+
+  entry.removeOldestPeerAddrEntry();
+
+  const std::vector<PeerAddrEntry>& peerAddrEntries =
+    entry.getPeerAddrEntries();
+  CPPUNIT_ASSERT_EQUAL((size_t)2, peerAddrEntries.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), peerAddrEntries[0].getIPAddress());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), peerAddrEntries[1].getIPAddress());
+}
 
 void DHTPeerAnnounceEntryTest::testEmpty()
 {
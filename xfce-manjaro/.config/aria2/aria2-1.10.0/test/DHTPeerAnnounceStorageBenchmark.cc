@@ -0,0 +1,74 @@
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+
+#include "DHTPeerAnnounceStorage.h"
+#include "DHTConstants.h"
+#include "Peer.h"
+#include "util.h"
+
+namespace aria2 {
+
+// A well connected node receives announce_peer and get_peers messages
+// for many different torrents. Popular torrents are announced by many
+// peers.
+static const size_t NUM_INFO_HASHES = 20000;
+static const size_t NUM_ANNOUNCES = 200000;
+static const size_t NUM_LOOKUPS = 200000;
+
+static void benchmarkDHTPeerAnnounceStorage()
+{
+  srand(0);
+  std::vector<std::string> infoHashes;
+  for(size_t i = 0; i < NUM_INFO_HASHES; ++i) {
+    unsigned char infoHash[DHT_ID_LENGTH];
+    for(size_t j = 0; j < DHT_ID_LENGTH; ++j) {
+      infoHash[j] = rand();
+    }
+    infoHashes.push_back(std::string(&infoHash[0], &infoHash[DHT_ID_LENGTH]));
+  }
+  std::vector<std::string> addrs;
+  for(size_t i = 0; i < 65536; ++i) {
+    addrs.push_back("10.0."+util::uitos(i/256)+"."+util::uitos(i%256));
+  }
+  // Half of the announces go to 1% of the torrents.
+  std::vector<size_t> targets;
+  for(size_t i = 0; i < NUM_ANNOUNCES; ++i) {
+    if(i%2 == 0) {
+      targets.push_back(rand()%(NUM_INFO_HASHES/100));
+    } else {
+      targets.push_back(rand()%NUM_INFO_HASHES);
+    }
+  }
+  DHTPeerAnnounceStorage storage;
+  double start = benchmark::now();
+  for(size_t i = 0; i < NUM_ANNOUNCES; ++i) {
+    storage.addPeerAnnounce
+      (reinterpret_cast<const unsigned char*>(infoHashes[targets[i]].data()),
+       addrs[rand()%addrs.size()], 6881);
+  }
+  benchmark::report("announce_peer", NUM_ANNOUNCES, benchmark::now()-start);
+  size_t numPeers = 0;
+  start = benchmark::now();
+  for(size_t i = 0; i < NUM_LOOKUPS; ++i) {
+    std::vector<SharedHandle<Peer> > peers;
+    storage.getPeers
+      (peers,
+       reinterpret_cast<const unsigned char*>(infoHashes[targets[i%NUM_ANNOUNCES]].data()));
+    numPeers += peers.size();
+  }
+  benchmark::report("get_peers", NUM_LOOKUPS, benchmark::now()-start);
+  benchmark::note("peers returned="+util::uitos(numPeers));
+  start = benchmark::now();
+  for(size_t i = 0; i < 100; ++i) {
+    storage.handleTimeout();
+  }
+  benchmark::report("handleTimeout", 100, benchmark::now()-start);
+}
+
+BENCHMARK_REGISTRATION(benchmarkDHTPeerAnnounceStorage);
+
+} // namespace aria2
@@ -11,6 +11,7 @@
 #include "Peer.h"
 #include "FileEntry.h"
 #include "bittorrent_helper.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -18,9 +19,27 @@ class DHTPeerAnnounceStorageTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DHTPeerAnnounceStorageTest);
   CPPUNIT_TEST(testAddAnnounce);
+  CPPUNIT_TEST(testAddAnnounce_maxPeerAddrEntryPerInfoHash);
+  CPPUNIT_TEST(testAddAnnounce_maxPeerAddrEntry);
+  CPPUNIT_TEST(testHandleTimeout);
   CPPUNIT_TEST_SUITE_END();
+private:
+  Timer savedWallclock_;
 public:
+  void setUp()
+  {
+    savedWallclock_ = global::wallclock;
+  }
+
+  void tearDown()
+  {
+    global::wallclock = savedWallclock_;
+  }
+
   void testAddAnnounce();
+  void testAddAnnounce_maxPeerAddrEntryPerInfoHash();
+  void testAddAnnounce_maxPeerAddrEntry();
+  void testHandleTimeout();
 };
 
 
@@ -45,6 +64,98 @@ void DHTPeerAnnounceStorageTest::testAddAnnounce()
   CPPUNIT_ASSERT_EQUAL((size_t)2, peers.size());
   CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), peers[0]->getIPAddress());
   CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.4"), peers[1]->getIPAddress());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, storage.countPeerAnnounceEntry());
+  CPPUNIT_ASSERT_EQUAL((size_t)4, storage.countPeerAddrEntry());
+
+  // Announcing the same peer again does not add a new one.
+  storage.addPeerAnnounce(infohash2, "192.168.0.3", 6883);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, storage.countPeerAddrEntry());
+  CPPUNIT_ASSERT(storage.contains(infohash1));
+  CPPUNIT_ASSERT(storage.contains(infohash2));
+}
+
+void DHTPeerAnnounceStorageTest::testAddAnnounce_maxPeerAddrEntryPerInfoHash()
+{
+  unsigned char infohash[DHT_ID_LENGTH];
+  memset(infohash, 0xff, DHT_ID_LENGTH);
+  DHTPeerAnnounceStorage storage;
+  storage.setMaxPeerAddrEntryPerInfoHash(2);
+
+  storage.addPeerAnnounce(infohash, "192.168.0.1", 6881);
+  storage.addPeerAnnounce(infohash, "192.168.0.2", 6882);
+  global::wallclock.advance(1);
+  // 192.168.0.1 becomes the most recently announced one.
+  storage.addPeerAnnounce(infohash, "192.168.0.1", 6881);
+  storage.addPeerAnnounce(infohash, "192.168.0.3", 6883);
+
+  std::vector<SharedHandle<Peer> > peers;
+  storage.getPeers(peers, infohash);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, peers.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), peers[0]->getIPAddress());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), peers[1]->getIPAddress());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, storage.countPeerAddrEntry());
+}
+
+void DHTPeerAnnounceStorageTest::testAddAnnounce_maxPeerAddrEntry()
+{
+  unsigned char infohash1[DHT_ID_LENGTH];
+  memset(infohash1, 0xff, DHT_ID_LENGTH);
+  unsigned char infohash2[DHT_ID_LENGTH];
+  memset(infohash2, 0xf0, DHT_ID_LENGTH);
+  unsigned char infohash3[DHT_ID_LENGTH];
+  memset(infohash3, 0x0f, DHT_ID_LENGTH);
+  DHTPeerAnnounceStorage storage;
+  storage.setMaxPeerAddrEntry(3);
+
+  storage.addPeerAnnounce(infohash1, "192.168.0.1", 6881);
+  storage.addPeerAnnounce(infohash2, "192.168.0.2", 6882);
+  storage.addPeerAnnounce(infohash2, "192.168.0.3", 6883);
+  // infohash2 is announced more recently than infohash1, so the peer
+  // of infohash1 is evicted and infohash1 is dropped.
+  storage.addPeerAnnounce(infohash3, "192.168.0.4", 6884);
+  CPPUNIT_ASSERT(!storage.contains(infohash1));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, storage.countPeerAnnounceEntry());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, storage.countPeerAddrEntry());
+
+  storage.addPeerAnnounce(infohash3, "192.168.0.5", 6885);
+  CPPUNIT_ASSERT(storage.contains(infohash2));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, storage.countPeerAddrEntry());
+
+  std::vector<SharedHandle<Peer> > peers;
+  storage.getPeers(peers, infohash2);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, peers.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), peers[0]->getIPAddress());
+}
+
+void DHTPeerAnnounceStorageTest::testHandleTimeout()
+{
+  unsigned char infohash1[DHT_ID_LENGTH];
+  memset(infohash1, 0xff, DHT_ID_LENGTH);
+  unsigned char infohash2[DHT_ID_LENGTH];
+  memset(infohash2, 0xf0, DHT_ID_LENGTH);
+  DHTPeerAnnounceStorage storage;
+
+  storage.addPeerAnnounce(infohash1, "192.168.0.1", 6881);
+  storage.addPeerAnnounce(infohash2, "192.168.0.2", 6882);
+  storage.handleTimeout();
+  CPPUNIT_ASSERT_EQUAL((size_t)2, storage.countPeerAnnounceEntry());
+
+  global::wallclock.advance(DHT_PEER_ANNOUNCE_PURGE_INTERVAL);
+  storage.addPeerAnnounce(infohash2, "192.168.0.3", 6883);
+  // 192.168.0.2 is removed when infohash2 is announced.
+  CPPUNIT_ASSERT_EQUAL((size_t)2, storage.countPeerAddrEntry());
+
+  storage.handleTimeout();
+  CPPUNIT_ASSERT(!storage.contains(infohash1));
+  CPPUNIT_ASSERT(storage.contains(infohash2));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, storage.countPeerAddrEntry());
+
+  global::wallclock.advance(DHT_PEER_ANNOUNCE_PURGE_INTERVAL);
+  std::vector<SharedHandle<Peer> > peers;
+  storage.getPeers(peers, infohash2);
+  CPPUNIT_ASSERT(peers.empty());
+  CPPUNIT_ASSERT(!storage.contains(infohash2));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, storage.countPeerAddrEntry());
 }
 
 } // namespace aria2
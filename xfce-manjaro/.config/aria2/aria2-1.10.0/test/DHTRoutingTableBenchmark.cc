@@ -0,0 +1,114 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <vector>
+
+#include "DHTRoutingTable.h"
+#include "DHTBucket.h"
+#include "DHTNode.h"
+#include "util.h"
+
+namespace aria2 {
+
+// A long-running node: the bucket of the local node has been split
+// down to a 24 bit shared prefix. Incoming queries look up the sender,
+// and find_node and get_peers replies look up the closest nodes to a
+// random target.
+static const size_t PREFIX_DEPTH = 24;
+static const size_t NUM_QUERIES = 200000;
+static const size_t NUM_TARGETS = 1000;
+
+static void createID(unsigned char* id, const unsigned char* localID,
+                     size_t prefix)
+{
+  util::generateRandomKey(id);
+  memcpy(id, localID, prefix/8);
+  unsigned char bit = 0x80 >> (prefix%8);
+  unsigned char high = ~(bit|(bit-1));
+  id[prefix/8] = (localID[prefix/8]&high)|(~localID[prefix/8]&bit)|
+    (id[prefix/8]&(bit-1));
+}
+
+static void benchmarkDHTRoutingTable()
+{
+  unsigned char localID[DHT_ID_LENGTH];
+  util::generateRandomKey(localID);
+  SharedHandle<DHTNode> localNode(new DHTNode(localID));
+  DHTRoutingTable table(localNode);
+  std::vector<SharedHandle<DHTNode> > nodes;
+  unsigned char id[DHT_ID_LENGTH];
+  for(size_t prefix = 0; prefix < PREFIX_DEPTH; ++prefix) {
+    for(size_t i = 0; i < DHTBucket::K; ++i) {
+      createID(id, localID, prefix);
+      SharedHandle<DHTNode> node(new DHTNode(id));
+      node->setIPAddress("192.168.0."+util::uitos(nodes.size()%256));
+      node->setPort(6881);
+      if(table.addNode(node)) {
+        nodes.push_back(node);
+      }
+    }
+  }
+  benchmark::note("buckets="+util::uitos(table.countBucket())+
+                  " nodes="+util::uitos(nodes.size()));
+  // Senders of queries are mostly unknown nodes, which are tried and
+  // rejected because their bucket is full.
+  std::vector<SharedHandle<DHTNode> > senders;
+  for(size_t i = 0; i < 1000; ++i) {
+    util::generateRandomKey(id);
+    senders.push_back(SharedHandle<DHTNode>(new DHTNode(id)));
+  }
+  size_t sink = 0;
+  {
+    double start = benchmark::now();
+    for(size_t i = 0; i < NUM_QUERIES; ++i) {
+      const SharedHandle<DHTNode>& node = nodes[i%nodes.size()];
+      sink += !table.getNode(node->getID(), node->getIPAddress(),
+                             node->getPort()).isNull();
+      const SharedHandle<DHTNode>& sender = senders[i%senders.size()];
+      sink += table.addNode(sender);
+    }
+    benchmark::report("getNode+addNode", NUM_QUERIES, benchmark::now()-start);
+  }
+  // Targets are generated beforehand because util::generateRandomKey()
+  // is far slower than the lookup.
+  std::vector<unsigned char> targets(NUM_TARGETS*DHT_ID_LENGTH);
+  for(size_t i = 0; i < NUM_TARGETS; ++i) {
+    util::generateRandomKey(&targets[i*DHT_ID_LENGTH]);
+  }
+  {
+    std::vector<SharedHandle<DHTNode> > closest;
+    double start = benchmark::now();
+    for(size_t i = 0; i < NUM_QUERIES; ++i) {
+      closest.clear();
+      table.getClosestKNodes(closest,
+                             &targets[i%NUM_TARGETS*DHT_ID_LENGTH]);
+      sink += closest.size();
+    }
+    benchmark::report("getClosestKNodes random target", NUM_QUERIES,
+                      benchmark::now()-start);
+  }
+  {
+    // Lookups for targets near the local node, as in bucket refresh
+    // and announces for popular infohashes cached nearby.
+    for(size_t i = 0; i < NUM_TARGETS; ++i) {
+      createID(&targets[i*DHT_ID_LENGTH], localID, PREFIX_DEPTH-1-i%8);
+    }
+    std::vector<SharedHandle<DHTNode> > closest;
+    double start = benchmark::now();
+    for(size_t i = 0; i < NUM_QUERIES; ++i) {
+      closest.clear();
+      table.getClosestKNodes(closest,
+                             &targets[i%NUM_TARGETS*DHT_ID_LENGTH]);
+      sink += closest.size();
+    }
+    benchmark::report("getClosestKNodes near target", NUM_QUERIES,
+                      benchmark::now()-start);
+  }
+  if(sink == 0) {
+    benchmark::note("unexpected result");
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkDHTRoutingTable);
+
+} // namespace aria2
@@ -19,6 +19,8 @@ class DHTRoutingTableTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testAddNode);
   CPPUNIT_TEST(testAddNode_localNode);
   CPPUNIT_TEST(testGetClosestKNodes);
+  CPPUNIT_TEST(testGetBucketFor);
+  CPPUNIT_TEST(testGetClosestKNodes_order);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp() {}
@@ -28,6 +30,8 @@ public:
   void testAddNode();
   void testAddNode_localNode();
   void testGetClosestKNodes();
+  void testGetBucketFor();
+  void testGetClosestKNodes_order();
 };
 
 
@@ -108,4 +112,104 @@ void DHTRoutingTableTest::testGetClosestKNodes()
   }
 }
 
+// Returns the number of leading bits shared by id1 and id2.
+static size_t commonPrefix(const unsigned char* id1, const unsigned char* id2)
+{
+  size_t prefix = 0;
+  for(; prefix < DHT_ID_LENGTH*8; ++prefix) {
+    unsigned char mask = 0x80 >> (prefix%8);
+    if((id1[prefix/8]&mask) != (id2[prefix/8]&mask)) {
+      break;
+    }
+  }
+  return prefix;
+}
+
+// Adds num nodes for each length of the prefix shared with the local
+// node up to 20 bits, so that the bucket of the local node is split
+// many times.
+static void fillTable(DHTRoutingTable& table, const unsigned char* localID,
+                      size_t num)
+{
+  unsigned char id[DHT_ID_LENGTH];
+  for(size_t prefix = 0; prefix < 20; ++prefix) {
+    for(size_t i = 0; i < num; ++i) {
+      util::generateRandomKey(id);
+      memcpy(id, localID, prefix/8);
+      // Copy the rest of the prefix, flip the next bit and keep the
+      // bits after it random.
+      unsigned char bit = 0x80 >> (prefix%8);
+      unsigned char high = ~(bit|(bit-1));
+      id[prefix/8] = (localID[prefix/8]&high)|(~localID[prefix/8]&bit)|
+        (id[prefix/8]&(bit-1));
+      table.addNode(SharedHandle<DHTNode>(new DHTNode(id)));
+    }
+  }
+}
+
+void DHTRoutingTableTest::testGetBucketFor()
+{
+  unsigned char localID[DHT_ID_LENGTH];
+  memset(localID, 0xaa, DHT_ID_LENGTH);
+  SharedHandle<DHTNode> localNode(new DHTNode(localID));
+  DHTRoutingTable table(localNode);
+  fillTable(table, localID, DHTBucket::K);
+  CPPUNIT_ASSERT(table.countBucket() > 10);
+
+  std::vector<SharedHandle<DHTBucket> > buckets;
+  table.getBuckets(buckets);
+  CPPUNIT_ASSERT_EQUAL(table.countBucket(), buckets.size());
+  CPPUNIT_ASSERT(buckets.back()->isInRange(localID));
+  size_t numNodes = 0;
+  for(size_t i = 0; i < buckets.size(); ++i) {
+    const std::deque<SharedHandle<DHTNode> >& nodes = buckets[i]->getNodes();
+    numNodes += nodes.size();
+    for(size_t j = 0; j < nodes.size(); ++j) {
+      CPPUNIT_ASSERT(table.getBucketFor(nodes[j]).get() == buckets[i].get());
+    }
+  }
+  CPPUNIT_ASSERT(numNodes > 0);
+
+  unsigned char id[DHT_ID_LENGTH];
+  for(size_t i = 0; i < 1000; ++i) {
+    util::generateRandomKey(id);
+    if(i%2) {
+      memcpy(id, localID, i%DHT_ID_LENGTH);
+    }
+    SharedHandle<DHTBucket> bucket = table.getBucketFor(id);
+    CPPUNIT_ASSERT(bucket->isInRange(id));
+  }
+  CPPUNIT_ASSERT(table.getBucketFor(localID).get() == buckets.back().get());
+}
+
+void DHTRoutingTableTest::testGetClosestKNodes_order()
+{
+  unsigned char localID[DHT_ID_LENGTH];
+  memset(localID, 0xaa, DHT_ID_LENGTH);
+  SharedHandle<DHTNode> localNode(new DHTNode(localID));
+  DHTRoutingTable table(localNode);
+  // Fewer nodes than K in most buckets, so that the result spans
+  // several buckets.
+  fillTable(table, localID, 3);
+
+  for(size_t keyPrefix = 0; keyPrefix < 16; ++keyPrefix) {
+    unsigned char key[DHT_ID_LENGTH];
+    memcpy(key, localID, DHT_ID_LENGTH);
+    key[keyPrefix/8] ^= 0x80 >> (keyPrefix%8);
+    std::vector<SharedHandle<DHTNode> > nodes;
+    table.getClosestKNodes(nodes, key);
+    CPPUNIT_ASSERT_EQUAL((size_t)8, nodes.size());
+    // Nodes in the bucket of key come first, then the nodes as close
+    // to key as the local node, then the farther ones, the farthest
+    // last.
+    CPPUNIT_ASSERT(commonPrefix(nodes[0]->getID(), key) > keyPrefix);
+    size_t last = DHT_ID_LENGTH*8;
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      size_t prefix = commonPrefix(nodes[i]->getID(), key);
+      CPPUNIT_ASSERT(std::min(prefix, keyPrefix) <= last);
+      last = std::min(prefix, keyPrefix);
+    }
+  }
+}
+
 } // namespace aria2
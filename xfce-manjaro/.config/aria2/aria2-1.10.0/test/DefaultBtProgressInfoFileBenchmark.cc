@@ -0,0 +1,70 @@
+#include "Benchmark.h"
+
+#include <string>
+#include <vector>
+
+#include "DefaultBtProgressInfoFile.h"
+#include "DownloadContext.h"
+#include "MockPieceStorage.h"
+#include "BitfieldMan.h"
+#include "Piece.h"
+#include "Option.h"
+#include "File.h"
+#include "util.h"
+
+namespace aria2 {
+
+// A 64GiB download with 16KiB pieces has a 512KiB bitfield. Between
+// saves, a piece is completed and a block of an in-flight piece is
+// downloaded.
+static const size_t PIECE_LENGTH = 16*1024;
+static const uint64_t TOTAL_LENGTH = 64LL*1024*1024*1024;
+static const size_t NUM_IN_FLIGHT_PIECE = 64;
+static const size_t NUM_SAVES = 200;
+
+static const std::string BASE_PATH = "/tmp/aria2_DefaultBtProgressInfoFileBenchmark";
+
+static void benchmarkSave(bool inPlace)
+{
+  Option option;
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(PIECE_LENGTH, TOTAL_LENGTH, BASE_PATH));
+  BitfieldMan bitfield(PIECE_LENGTH, TOTAL_LENGTH);
+  SharedHandle<MockPieceStorage> pieceStorage(new MockPieceStorage());
+  pieceStorage->setBitfield(&bitfield);
+  std::vector<SharedHandle<Piece> > pieces;
+  for(size_t i = 0; i < NUM_IN_FLIGHT_PIECE; ++i) {
+    pieces.push_back(SharedHandle<Piece>(new Piece(i*1000, PIECE_LENGTH)));
+  }
+  pieceStorage->addInFlightPiece(pieces);
+  SharedHandle<DefaultBtProgressInfoFile> infoFile
+    (new DefaultBtProgressInfoFile(dctx, pieceStorage, &option));
+  infoFile->save();
+  double elapsed = 0;
+  for(size_t i = 0; i < NUM_SAVES; ++i) {
+    bitfield.setBit(i*4999%bitfield.countBlock());
+    pieces[i%NUM_IN_FLIGHT_PIECE]->completeBlock(0);
+    if(!inPlace) {
+      // A new object has no map, so the whole file is written.
+      infoFile.reset
+        (new DefaultBtProgressInfoFile(dctx, pieceStorage, &option));
+    }
+    double start = benchmark::now();
+    infoFile->save();
+    elapsed += benchmark::now()-start;
+  }
+  benchmark::report(inPlace ? "in place" : "whole file", NUM_SAVES, elapsed);
+  benchmark::note("control file size="+
+                  util::uitos(File(infoFile->getFilename()).size()));
+  infoFile->removeFile();
+}
+
+static void benchmarkDefaultBtProgressInfoFile()
+{
+  benchmarkSave(false);
+  benchmarkSave(true);
+}
+
+BENCHMARK_REGISTRATION(benchmarkDefaultBtProgressInfoFile);
+
+} // namespace aria2
@@ -13,6 +13,8 @@
 #include "Piece.h"
 #include "FileEntry.h"
 #include "array_fun.h"
+#include "a2io.h"
+#include "File.h"
 #ifdef ENABLE_BITTORRENT
 # include "MockPeerStorage.h"
 # include "BtRuntime.h"
@@ -32,6 +34,9 @@ class DefaultBtProgressInfoFileTest:public CppUnit::TestFixture {
 #endif // !WORDS_BIGENDIAN
 #endif // ENABLE_BITTORRENT
   CPPUNIT_TEST(testSave_nonBt);
+  CPPUNIT_TEST(testSave_inPlace);
+  CPPUNIT_TEST(testSave_growInFlightPieces);
+  CPPUNIT_TEST(testSave_removed);
   CPPUNIT_TEST(testLoad_nonBt);
 #ifndef WORDS_BIGENDIAN
   CPPUNIT_TEST(testLoad_nonBt_compat);
@@ -92,6 +97,9 @@ public:
 #endif // !WORDS_BIGENDIAN
 #endif // ENABLE_BITTORRENT
   void testSave_nonBt();
+  void testSave_inPlace();
+  void testSave_growInFlightPieces();
+  void testSave_removed();
   void testLoad_nonBt();
 #ifndef WORDS_BIGENDIAN
   void testLoad_nonBt_compat();
@@ -237,11 +245,9 @@ void DefaultBtProgressInfoFileTest::testSave()
   // read and validate
   std::ifstream in(infoFile.getFilename().c_str(), std::ios::binary);
 
-  //in.exceptions(ios::failbit);
-
   unsigned char version[2];
   in.read((char*)version, sizeof(version));
-  CPPUNIT_ASSERT_EQUAL(std::string("0001"),
+  CPPUNIT_ASSERT_EQUAL(std::string("0002"),
                        util::toHex(version, sizeof(version)));
 
   unsigned char extension[4];
@@ -269,26 +275,40 @@ void DefaultBtProgressInfoFileTest::testSave()
   totalLength = ntoh64(totalLength);
   CPPUNIT_ASSERT_EQUAL((uint64_t)81920/* 80*1024 */, totalLength);
 
-  uint64_t uploadLength;
-  in.read((char*)&uploadLength, sizeof(uploadLength));
-  uploadLength = ntoh64(uploadLength);
-  CPPUNIT_ASSERT_EQUAL((uint64_t)1024, uploadLength);
-
   uint32_t bitfieldLength;
   in.read((char*)&bitfieldLength, sizeof(bitfieldLength));
   bitfieldLength = ntohl(bitfieldLength);
   CPPUNIT_ASSERT_EQUAL((uint32_t)10, bitfieldLength);
 
+  uint32_t maxInFlightPiece;
+  in.read((char*)&maxInFlightPiece, sizeof(maxInFlightPiece));
+  maxInFlightPiece = ntohl(maxInFlightPiece);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)16, maxInFlightPiece);
+
+  uint32_t pieceBitfieldLength;
+  in.read((char*)&pieceBitfieldLength, sizeof(pieceBitfieldLength));
+  pieceBitfieldLength = ntohl(pieceBitfieldLength);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)1, pieceBitfieldLength);
+
+  // the first snapshot
+  unsigned char checksum[20];
+  in.read((char*)checksum, sizeof(checksum));
+
+  uint64_t generation;
+  in.read((char*)&generation, sizeof(generation));
+  generation = ntoh64(generation);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, generation);
+
+  uint64_t uploadLength;
+  in.read((char*)&uploadLength, sizeof(uploadLength));
+  uploadLength = ntoh64(uploadLength);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1024, uploadLength);
+
   unsigned char bitfieldRead[10];
   in.read((char*)bitfieldRead, sizeof(bitfieldRead));
   CPPUNIT_ASSERT_EQUAL(std::string("fffffffffffffffffffe"),
                        util::toHex(bitfieldRead, sizeof(bitfieldRead)));
 
-  uint32_t numInFlightPiece;
-  in.read((char*)&numInFlightPiece, sizeof(numInFlightPiece));
-  numInFlightPiece = ntohl(numInFlightPiece);
-  CPPUNIT_ASSERT_EQUAL((uint32_t)2, numInFlightPiece);
-
   // piece index 1
   uint32_t index1;
   in.read((char*)&index1, sizeof(index1));
@@ -300,11 +320,6 @@ void DefaultBtProgressInfoFileTest::testSave()
   pieceLength1 = ntohl(pieceLength1);
   CPPUNIT_ASSERT_EQUAL((uint32_t)1024, pieceLength1);
 
-  uint32_t pieceBitfieldLength1;
-  in.read((char*)&pieceBitfieldLength1, sizeof(pieceBitfieldLength1));
-  pieceBitfieldLength1 = ntohl(pieceBitfieldLength1);
-  CPPUNIT_ASSERT_EQUAL((uint32_t)1, pieceBitfieldLength1);
-
   unsigned char pieceBitfield1[1];
   in.read((char*)pieceBitfield1, sizeof(pieceBitfield1));
   CPPUNIT_ASSERT_EQUAL(std::string("00"),
@@ -320,6 +335,25 @@ void DefaultBtProgressInfoFileTest::testSave()
   in.read((char*)&pieceLength2, sizeof(pieceLength2));
   pieceLength2 = ntohl(pieceLength2);
   CPPUNIT_ASSERT_EQUAL((uint32_t)512, pieceLength2);
+
+  in.ignore(1);
+  // the rest of the records are unused
+  uint32_t index3;
+  in.read((char*)&index3, sizeof(index3));
+  CPPUNIT_ASSERT_EQUAL((uint32_t)0xffffffff, index3);
+
+  // the file is loaded back
+  initializeMembers(1024, 81920);
+  dctx_->setBasePath("save-temp");
+  DefaultBtProgressInfoFile loadFile(dctx_, pieceStorage_, option_.get());
+  loadFile.setBtRuntime(btRuntime_);
+  loadFile.setPeerStorage(peerStorage_);
+  loadFile.load();
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1024, btRuntime_->getUploadLengthAtStartup());
+  CPPUNIT_ASSERT_EQUAL(std::string("fffffffffffffffffffe"),
+                       util::toHex(bitfield_->getBitfield(),
+                                   bitfield_->getBitfieldLength()));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pieceStorage_->countInFlightPiece());
 }
 
 #endif // ENABLE_BITTORRENT
@@ -470,11 +504,9 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
   // read and validate
   std::ifstream in(infoFile.getFilename().c_str(), std::ios::binary);
 
-  //in.exceptions(ios::failbit);
-
   unsigned char version[2];
   in.read((char*)version, sizeof(version));
-  CPPUNIT_ASSERT_EQUAL(std::string("0001"),
+  CPPUNIT_ASSERT_EQUAL(std::string("0002"),
                        util::toHex(version, sizeof(version)));
 
   unsigned char extension[4];
@@ -497,26 +529,40 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
   totalLength = ntoh64(totalLength);
   CPPUNIT_ASSERT_EQUAL((uint64_t)81920/* 80*1024 */, totalLength);
 
-  uint64_t uploadLength;
-  in.read((char*)&uploadLength, sizeof(uploadLength));
-  uploadLength = ntoh64(uploadLength);
-  CPPUNIT_ASSERT_EQUAL((uint64_t)0, uploadLength);
-
   uint32_t bitfieldLength;
   in.read((char*)&bitfieldLength, sizeof(bitfieldLength));
   bitfieldLength = ntohl(bitfieldLength);
   CPPUNIT_ASSERT_EQUAL((uint32_t)10, bitfieldLength);
 
+  uint32_t maxInFlightPiece;
+  in.read((char*)&maxInFlightPiece, sizeof(maxInFlightPiece));
+  maxInFlightPiece = ntohl(maxInFlightPiece);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)16, maxInFlightPiece);
+
+  uint32_t pieceBitfieldLength;
+  in.read((char*)&pieceBitfieldLength, sizeof(pieceBitfieldLength));
+  pieceBitfieldLength = ntohl(pieceBitfieldLength);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)1, pieceBitfieldLength);
+
+  // the first snapshot
+  unsigned char checksum[20];
+  in.read((char*)checksum, sizeof(checksum));
+
+  uint64_t generation;
+  in.read((char*)&generation, sizeof(generation));
+  generation = ntoh64(generation);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, generation);
+
+  uint64_t uploadLength;
+  in.read((char*)&uploadLength, sizeof(uploadLength));
+  uploadLength = ntoh64(uploadLength);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, uploadLength);
+
   unsigned char bitfieldRead[10];
   in.read((char*)bitfieldRead, sizeof(bitfieldRead));
   CPPUNIT_ASSERT_EQUAL(std::string("fffffffffffffffffffe"),
                        util::toHex(bitfieldRead, sizeof(bitfieldRead)));
 
-  uint32_t numInFlightPiece;
-  in.read((char*)&numInFlightPiece, sizeof(numInFlightPiece));
-  numInFlightPiece = ntohl(numInFlightPiece);
-  CPPUNIT_ASSERT_EQUAL((uint32_t)2, numInFlightPiece);
-
   // piece index 1
   uint32_t index1;
   in.read((char*)&index1, sizeof(index1));
@@ -528,11 +574,6 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
   pieceLength1 = ntohl(pieceLength1);
   CPPUNIT_ASSERT_EQUAL((uint32_t)1024, pieceLength1);
 
-  uint32_t pieceBitfieldLength1;
-  in.read((char*)&pieceBitfieldLength1, sizeof(pieceBitfieldLength1));
-  pieceBitfieldLength1 = ntohl(pieceBitfieldLength1);
-  CPPUNIT_ASSERT_EQUAL((uint32_t)1, pieceBitfieldLength1);
-
   unsigned char pieceBitfield1[1];
   in.read((char*)pieceBitfield1, sizeof(pieceBitfield1));
   CPPUNIT_ASSERT_EQUAL(std::string("00"),
@@ -548,7 +589,113 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
   in.read((char*)&pieceLength2, sizeof(pieceLength2));
   pieceLength2 = ntohl(pieceLength2);
   CPPUNIT_ASSERT_EQUAL((uint32_t)512, pieceLength2);
+}
 
+void DefaultBtProgressInfoFileTest::testSave_inPlace()
+{
+  initializeMembers(1024, 81920);
+
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(1024, 81920, "save-inplace-temp"));
+
+  bitfield_->setAllBit();
+  bitfield_->unsetBit(79);
+  SharedHandle<Piece> p1(new Piece(1, 1024));
+  std::vector<SharedHandle<Piece> > inFlightPieces;
+  inFlightPieces.push_back(p1);
+  pieceStorage_->addInFlightPiece(inFlightPieces);
+
+  DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+  infoFile.save();
+  a2_struct_stat st1;
+  CPPUNIT_ASSERT_EQUAL(0, a2stat(infoFile.getFilename().c_str(), &st1));
+
+  // The new progress is written into the same file.
+  bitfield_->unsetBit(5);
+  p1->completeBlock(0);
+  inFlightPieces.clear();
+  inFlightPieces.push_back(SharedHandle<Piece>(new Piece(2, 1024)));
+  pieceStorage_->addInFlightPiece(inFlightPieces);
+  infoFile.save();
+  a2_struct_stat st2;
+  CPPUNIT_ASSERT_EQUAL(0, a2stat(infoFile.getFilename().c_str(), &st2));
+#ifdef HAVE_MMAP
+  CPPUNIT_ASSERT(st1.st_ino == st2.st_ino);
+#endif // HAVE_MMAP
+
+  initializeMembers(1024, 81920);
+  DefaultBtProgressInfoFile loadFile(dctx, pieceStorage_, option_.get());
+  loadFile.load();
+  CPPUNIT_ASSERT_EQUAL(std::string("fbfffffffffffffffffe"),
+                       util::toHex(bitfield_->getBitfield(),
+                                   bitfield_->getBitfieldLength()));
+  std::vector<SharedHandle<Piece> > loadedPieces;
+  pieceStorage_->getInFlightPieces(loadedPieces);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, loadedPieces.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, loadedPieces[0]->getIndex());
+  CPPUNIT_ASSERT(loadedPieces[0]->hasBlock(0));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, loadedPieces[1]->getIndex());
+
+  // Corrupt the latest snapshot. The previous one is loaded.
+  {
+    std::fstream f(infoFile.getFilename().c_str(),
+                   std::ios::in|std::ios::out|std::ios::binary);
+    // header(34)+checksum+generation+uploadLength
+    f.seekp(34+20+8+8);
+    f.put(0);
+  }
+  initializeMembers(1024, 81920);
+  DefaultBtProgressInfoFile loadFile2(dctx, pieceStorage_, option_.get());
+  loadFile2.load();
+  CPPUNIT_ASSERT_EQUAL(std::string("fffffffffffffffffffe"),
+                       util::toHex(bitfield_->getBitfield(),
+                                   bitfield_->getBitfieldLength()));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pieceStorage_->countInFlightPiece());
+}
+
+void DefaultBtProgressInfoFileTest::testSave_growInFlightPieces()
+{
+  initializeMembers(1024, 81920);
+
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(1024, 81920, "save-grow-temp"));
+
+  DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+  infoFile.save();
+  // More pieces than the records the file was made with.
+  std::vector<SharedHandle<Piece> > inFlightPieces;
+  for(size_t i = 0; i < 20; ++i) {
+    inFlightPieces.push_back(SharedHandle<Piece>(new Piece(i, 1024)));
+  }
+  pieceStorage_->addInFlightPiece(inFlightPieces);
+  infoFile.save();
+
+  initializeMembers(1024, 81920);
+  DefaultBtProgressInfoFile loadFile(dctx, pieceStorage_, option_.get());
+  loadFile.load();
+  CPPUNIT_ASSERT_EQUAL((size_t)20, pieceStorage_->countInFlightPiece());
+}
+
+void DefaultBtProgressInfoFileTest::testSave_removed()
+{
+  initializeMembers(1024, 81920);
+
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(1024, 81920, "save-removed-temp"));
+
+  DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+  infoFile.save();
+  File f(infoFile.getFilename());
+  CPPUNIT_ASSERT(f.remove());
+  // The file is written again in whole.
+  bitfield_->setAllBit();
+  infoFile.save();
+  CPPUNIT_ASSERT(f.isFile());
+
+  initializeMembers(1024, 81920);
+  DefaultBtProgressInfoFile loadFile(dctx, pieceStorage_, option_.get());
+  loadFile.load();
+  CPPUNIT_ASSERT(bitfield_->isAllBitSet());
 }
 
 void DefaultBtProgressInfoFileTest::testUpdateFilename()
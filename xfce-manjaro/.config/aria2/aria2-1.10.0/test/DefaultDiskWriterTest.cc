@@ -1,12 +1,20 @@
 #include "DefaultDiskWriter.h"
+
+#include <string>
+
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "File.h"
+
 namespace aria2 {
 
 class DefaultDiskWriterTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DefaultDiskWriterTest);
   CPPUNIT_TEST(testSize);
+  CPPUNIT_TEST(testWriteData);
+  CPPUNIT_TEST(testWriteDataVec);
+  CPPUNIT_TEST(testReadDataVec);
   CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -15,6 +23,9 @@ public:
   }
 
   void testSize();
+  void testWriteData();
+  void testWriteDataVec();
+  void testReadDataVec();
 };
 
 
@@ -27,4 +38,64 @@ void DefaultDiskWriterTest::testSize()
   CPPUNIT_ASSERT_EQUAL((uint64_t)4096ULL, dw.size());
 }
 
+void DefaultDiskWriterTest::testWriteData()
+{
+  std::string filename = "/tmp/aria2_DefaultDiskWriterTest_testWriteData";
+  File(filename).remove();
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("56789"), 5, 5);
+  dw.writeData(reinterpret_cast<const unsigned char*>("01234"), 5, 0);
+  unsigned char buf[16];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)10, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789"),
+                       std::string(&buf[0], &buf[10]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)3, dw.readData(buf, 3, 7));
+  CPPUNIT_ASSERT_EQUAL(std::string("789"), std::string(&buf[0], &buf[3]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, dw.readData(buf, sizeof(buf), 10));
+}
+
+void DefaultDiskWriterTest::testWriteDataVec()
+{
+  std::string filename = "/tmp/aria2_DefaultDiskWriterTest_testWriteDataVec";
+  File(filename).remove();
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  std::string msg1 = "0123";
+  std::string msg2 = "";
+  std::string msg3 = "456789";
+  struct iovec iov[3];
+  iov[0].iov_base = const_cast<char*>(msg1.data());
+  iov[0].iov_len = msg1.size();
+  iov[1].iov_base = const_cast<char*>(msg2.data());
+  iov[1].iov_len = msg2.size();
+  iov[2].iov_base = const_cast<char*>(msg3.data());
+  iov[2].iov_len = msg3.size();
+  dw.writeDataVec(iov, 3, 2);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)12ULL, dw.size());
+  unsigned char buf[10];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)10, dw.readData(buf, sizeof(buf), 2));
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789"),
+                       std::string(&buf[0], &buf[sizeof(buf)]));
+}
+
+void DefaultDiskWriterTest::testReadDataVec()
+{
+  DefaultDiskWriter dw("file1r.txt");
+  dw.openExistingFile();
+  char buf1[4];
+  char buf2[20];
+  struct iovec iov[2];
+  iov[0].iov_base = buf1;
+  iov[0].iov_len = sizeof(buf1);
+  iov[1].iov_base = buf2;
+  iov[1].iov_len = sizeof(buf2);
+  // file1r.txt contains "1234567890ABCDE". The second buffer is
+  // filled partially.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)13, dw.readDataVec(iov, 2, 2));
+  CPPUNIT_ASSERT_EQUAL(std::string("3456"), std::string(&buf1[0], &buf1[4]));
+  CPPUNIT_ASSERT_EQUAL(std::string("7890ABCDE"),
+                       std::string(&buf2[0], &buf2[9]));
+}
+
 } // namespace aria2
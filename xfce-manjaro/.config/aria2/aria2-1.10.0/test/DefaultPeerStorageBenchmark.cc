@@ -0,0 +1,143 @@
+#include "Benchmark.h"
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include "DefaultPeerStorage.h"
+#include "Peer.h"
+#include "BtRuntime.h"
+#include "util.h"
+
+namespace aria2 {
+
+// A swarm large enough that trackers, PEX and DHT keep feeding the
+// same peers again and again.
+static const size_t NUM_PEERS = 50000;
+
+static std::vector<SharedHandle<Peer> > createPeers()
+{
+  std::vector<SharedHandle<Peer> > peers;
+  for(size_t i = 0; i < NUM_PEERS; ++i) {
+    std::string ipaddr = "10."+util::uitos((i >> 16)&0xff)+"."+
+      util::uitos((i >> 8)&0xff)+"."+util::uitos(i&0xff);
+    peers.push_back(SharedHandle<Peer>(new Peer(ipaddr, 6881+i%16)));
+  }
+  return peers;
+}
+
+// The algorithm DefaultPeerStorage used before the index: scan the
+// whole list to find a peer.
+class LinearPeerStorage {
+private:
+  std::deque<SharedHandle<Peer> > peers_;
+
+  class FindPeer {
+  private:
+    std::string ipaddr_;
+    uint16_t port_;
+  public:
+    FindPeer(const std::string& ipaddr, uint16_t port):
+      ipaddr_(ipaddr), port_(port) {}
+
+    bool operator()(const SharedHandle<Peer>& peer) const
+    {
+      return ipaddr_ == peer->getIPAddress() && port_ == peer->getPort();
+    }
+  };
+public:
+  bool addPeer(const SharedHandle<Peer>& peer)
+  {
+    if(!getPeer(peer->getIPAddress(), peer->getPort()).isNull()) {
+      return false;
+    }
+    peers_.push_front(peer);
+    return true;
+  }
+
+  SharedHandle<Peer> getPeer(const std::string& ipaddr, uint16_t port) const
+  {
+    std::deque<SharedHandle<Peer> >::const_iterator i =
+      std::find_if(peers_.begin(), peers_.end(), FindPeer(ipaddr, port));
+    if(i == peers_.end()) {
+      return SharedHandle<Peer>();
+    } else {
+      return *i;
+    }
+  }
+};
+
+template<typename PeerStorage>
+static size_t run
+(PeerStorage& ps, const std::vector<SharedHandle<Peer> >& peers,
+ const std::string& label)
+{
+  size_t sink = 0;
+  double start = benchmark::now();
+  for(size_t i = 0; i < peers.size(); ++i) {
+    sink += ps.addPeer(peers[i]);
+  }
+  benchmark::report(label+" addPeer", peers.size(), benchmark::now()-start);
+  start = benchmark::now();
+  // Duplicates are rejected.
+  for(size_t i = 0; i < peers.size(); ++i) {
+    sink += ps.addPeer(peers[i]);
+  }
+  benchmark::report(label+" addPeer duplicate", peers.size(),
+                    benchmark::now()-start);
+  start = benchmark::now();
+  for(size_t i = 0; i < peers.size(); ++i) {
+    sink += !ps.getPeer(peers[i]->getIPAddress(),
+                        peers[i]->getPort()).isNull();
+  }
+  benchmark::report(label+" getPeer", peers.size(), benchmark::now()-start);
+  return sink;
+}
+
+static void benchmarkDefaultPeerStorage()
+{
+  std::vector<SharedHandle<Peer> > peers = createPeers();
+  benchmark::note("peers="+util::uitos(NUM_PEERS));
+  size_t check1, check2;
+  {
+    LinearPeerStorage ps;
+    check1 = run(ps, peers, "linear scan");
+  }
+  {
+    DefaultPeerStorage ps;
+    SharedHandle<BtRuntime> btRuntime(new BtRuntime());
+    btRuntime->setMaxPeers(NUM_PEERS);
+    ps.setBtRuntime(btRuntime);
+    check2 = run(ps, peers, "DefaultPeerStorage");
+    // Peers are returned from the middle of the list as connections
+    // are closed.
+    double start = benchmark::now();
+    for(size_t i = 0; i < peers.size(); ++i) {
+      ps.returnPeer(peers[(i*7919)%peers.size()]);
+    }
+    benchmark::report("DefaultPeerStorage returnPeer", peers.size(),
+                      benchmark::now()-start);
+    if(ps.countPeer() != 0) {
+      benchmark::note("unexpected result");
+    }
+  }
+  {
+    // The peer list is full, so that every addPeer() evicts the
+    // oldest unused peer.
+    DefaultPeerStorage ps;
+    double start = benchmark::now();
+    for(size_t i = 0; i < peers.size(); ++i) {
+      ps.addPeer(peers[i]);
+    }
+    benchmark::report("DefaultPeerStorage addPeer with eviction (list="+
+                      util::uitos(ps.countPeer())+")",
+                      peers.size(), benchmark::now()-start);
+  }
+  if(check1 != check2) {
+    benchmark::note("unexpected result");
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkDefaultPeerStorage);
+
+} // namespace aria2
@@ -18,11 +18,13 @@ class DefaultPeerStorageTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testCountPeer);
   CPPUNIT_TEST(testDeleteUnusedPeer);
   CPPUNIT_TEST(testAddPeer);
+  CPPUNIT_TEST(testGetPeer);
   CPPUNIT_TEST(testGetUnusedPeer);
   CPPUNIT_TEST(testIsPeerAvailable);
   CPPUNIT_TEST(testActivatePeer);
   CPPUNIT_TEST(testCalculateStat);
   CPPUNIT_TEST(testReturnPeer);
+  CPPUNIT_TEST(testUpdatePeerPort);
   CPPUNIT_TEST(testOnErasingPeer);
   CPPUNIT_TEST_SUITE_END();
 private:
@@ -41,11 +43,13 @@ public:
   void testCountPeer();
   void testDeleteUnusedPeer();
   void testAddPeer();
+  void testGetPeer();
   void testGetUnusedPeer();
   void testIsPeerAvailable();
   void testActivatePeer();
   void testCalculateStat();
   void testReturnPeer();
+  void testUpdatePeerPort();
   void testOnErasingPeer();
 };
 
@@ -229,6 +233,84 @@ void DefaultPeerStorageTest::testReturnPeer()
   ps.returnPeer(peer1); // peer1 is removed from the container
   CPPUNIT_ASSERT_EQUAL((size_t)1, ps.getPeers().size());
   CPPUNIT_ASSERT(std::find(ps.getPeers().begin(), ps.getPeers().end(), peer1) == ps.getPeers().end());
+
+  // Returned peer can be added again.
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.2", 6889).isNull());
+  CPPUNIT_ASSERT(ps.addPeer(peer2));
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.2", 6889) == peer2);
+}
+
+void DefaultPeerStorageTest::testUpdatePeerPort()
+{
+  DefaultPeerStorage ps;
+  // Incoming peer is added with the port the connection came from,
+  // like PeerReceiveHandshakeCommand does.
+  SharedHandle<Peer> peer1(new Peer("192.168.0.1", 40000, true));
+  peer1->usedBy(1);
+  CPPUNIT_ASSERT(ps.addPeer(peer1));
+
+  // Then the extension handshake tells its listening port.
+  ps.updatePeerPort(peer1, 6881);
+  CPPUNIT_ASSERT_EQUAL((uint16_t)6881, peer1->getPort());
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.1", 40000).isNull());
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.1", 6881) == peer1);
+  CPPUNIT_ASSERT(!ps.addPeer
+                 (SharedHandle<Peer>(new Peer("192.168.0.1", 6881))));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, ps.countPeer());
+
+  ps.returnPeer(peer1);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, ps.countPeer());
+  CPPUNIT_ASSERT(ps.getPeers().empty());
+
+  // The same peer was already known from tracker. The unused one is
+  // replaced with the connected one.
+  SharedHandle<Peer> peer2(new Peer("192.168.0.2", 6881));
+  SharedHandle<Peer> peer3(new Peer("192.168.0.2", 40001, true));
+  peer3->usedBy(2);
+  CPPUNIT_ASSERT(ps.addPeer(peer2));
+  CPPUNIT_ASSERT(ps.addPeer(peer3));
+  ps.updatePeerPort(peer3, 6881);
+  CPPUNIT_ASSERT_EQUAL((uint16_t)6881, peer3->getPort());
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.2", 6881) == peer3);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, ps.countPeer());
+  CPPUNIT_ASSERT(ps.getPeers().front() == peer3);
+
+  // Connected to the same peer twice. Both are kept.
+  SharedHandle<Peer> peer4(new Peer("192.168.0.2", 40002, true));
+  peer4->usedBy(3);
+  CPPUNIT_ASSERT(ps.addPeer(peer4));
+  ps.updatePeerPort(peer4, 6881);
+  CPPUNIT_ASSERT_EQUAL((uint16_t)40002, peer4->getPort());
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.2", 40002) == peer4);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, ps.countPeer());
+
+  // Peer which is not in PeerStorage.
+  SharedHandle<Peer> peer5(new Peer("192.168.0.3", 40003, true));
+  ps.updatePeerPort(peer5, 6881);
+  CPPUNIT_ASSERT_EQUAL((uint16_t)6881, peer5->getPort());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, ps.countPeer());
+}
+
+void DefaultPeerStorageTest::testGetPeer()
+{
+  DefaultPeerStorage ps;
+  SharedHandle<Peer> peer1(new Peer("192.168.0.1", 6889));
+  SharedHandle<Peer> peer2(new Peer("192.168.0.1", 6890));
+  SharedHandle<Peer> peer3(new Peer("2001:db8::1", 6889));
+  SharedHandle<Peer> peer4(new Peer("localhost", 6889));
+  CPPUNIT_ASSERT(ps.addPeer(peer1));
+  CPPUNIT_ASSERT(ps.addPeer(peer2));
+  CPPUNIT_ASSERT(ps.addPeer(peer3));
+  CPPUNIT_ASSERT(ps.addPeer(peer4));
+  CPPUNIT_ASSERT(!ps.addPeer
+                 (SharedHandle<Peer>(new Peer("2001:db8::1", 6889))));
+
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.1", 6889) == peer1);
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.1", 6890) == peer2);
+  CPPUNIT_ASSERT(ps.getPeer("2001:db8::1", 6889) == peer3);
+  CPPUNIT_ASSERT(ps.getPeer("localhost", 6889) == peer4);
+  CPPUNIT_ASSERT(ps.getPeer("192.168.0.2", 6889).isNull());
+  CPPUNIT_ASSERT(ps.getPeer("2001:db8::1", 6890).isNull());
 }
 
 void DefaultPeerStorageTest::testOnErasingPeer()
@@ -0,0 +1,128 @@
+#include "DiskCacheEntry.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "FileEntry.h"
+
+namespace aria2 {
+
+class DiskCacheEntryTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DiskCacheEntryTest);
+  CPPUNIT_TEST(testCacheData_append);
+  CPPUNIT_TEST(testCacheData_overlap);
+  CPPUNIT_TEST(testCacheData_gap);
+  CPPUNIT_TEST(testReadData);
+  CPPUNIT_TEST(testCovers);
+  CPPUNIT_TEST(testFlush);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  SharedHandle<ByteArrayDiskWriter> writer_;
+  SharedHandle<DirectDiskAdaptor> adaptor_;
+  SharedHandle<DiskCacheEntry> entry_;
+public:
+  void setUp()
+  {
+    writer_.reset(new ByteArrayDiskWriter());
+    writer_->setString(std::string(32, '.'));
+    std::vector<SharedHandle<FileEntry> > fileEntries;
+    fileEntries.push_back(SharedHandle<FileEntry>(new FileEntry("file", 32, 0)));
+    adaptor_.reset(new DirectDiskAdaptor());
+    adaptor_->setDiskWriter(writer_);
+    adaptor_->setTotalLength(32);
+    adaptor_->setFileEntries(fileEntries.begin(), fileEntries.end());
+    entry_.reset(new DiskCacheEntry(adaptor_.get(), 0));
+  }
+
+  void cache(const std::string& data, off_t offset)
+  {
+    entry_->cacheData(reinterpret_cast<const unsigned char*>(data.data()),
+                      data.size(), offset);
+  }
+
+  void testCacheData_append();
+  void testCacheData_overlap();
+  void testCacheData_gap();
+  void testReadData();
+  void testCovers();
+  void testFlush();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DiskCacheEntryTest);
+
+void DiskCacheEntryTest::testCacheData_append()
+{
+  cache("0123", 4);
+  cache("4567", 8);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, entry_->countCell());
+  CPPUNIT_ASSERT_EQUAL((size_t)8, entry_->getSize());
+  // Prepending is also coalesced.
+  cache("ab", 2);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, entry_->countCell());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, entry_->getSize());
+}
+
+void DiskCacheEntryTest::testCacheData_overlap()
+{
+  cache("0123", 4);
+  cache("89", 12);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, entry_->countCell());
+  cache("abcdefgh", 6);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, entry_->countCell());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, entry_->getSize());
+  unsigned char buf[10];
+  CPPUNIT_ASSERT_EQUAL((size_t)10, entry_->readData(buf, sizeof(buf), 4));
+  CPPUNIT_ASSERT_EQUAL(std::string("01abcdefgh"),
+                       std::string(&buf[0], &buf[sizeof(buf)]));
+  // Overwrite inside one cell.
+  cache("XY", 5);
+  CPPUNIT_ASSERT_EQUAL((size_t)10, entry_->getSize());
+  entry_->readData(buf, 4, 4);
+  CPPUNIT_ASSERT_EQUAL(std::string("0XYb"), std::string(&buf[0], &buf[4]));
+}
+
+void DiskCacheEntryTest::testCacheData_gap()
+{
+  cache("0123", 4);
+  cache("4567", 9);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, entry_->countCell());
+  CPPUNIT_ASSERT_EQUAL((size_t)8, entry_->getSize());
+}
+
+void DiskCacheEntryTest::testReadData()
+{
+  cache("0123", 4);
+  cache("4567", 10);
+  std::string buf(16, '.');
+  unsigned char* data =
+    reinterpret_cast<unsigned char*>(const_cast<char*>(buf.data()));
+  CPPUNIT_ASSERT_EQUAL((size_t)13, entry_->readData(data, 16, 1));
+  CPPUNIT_ASSERT_EQUAL(std::string("...0123..4567..."), buf);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, entry_->readData(data, 4, 0));
+}
+
+void DiskCacheEntryTest::testCovers()
+{
+  cache("0123", 4);
+  CPPUNIT_ASSERT(entry_->covers(4, 4));
+  CPPUNIT_ASSERT(entry_->covers(5, 2));
+  CPPUNIT_ASSERT(!entry_->covers(3, 2));
+  CPPUNIT_ASSERT(!entry_->covers(6, 4));
+  CPPUNIT_ASSERT(!entry_->covers(0, 1));
+}
+
+void DiskCacheEntryTest::testFlush()
+{
+  cache("0123", 4);
+  cache("4567", 10);
+  entry_->flush();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, entry_->getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, entry_->countCell());
+  CPPUNIT_ASSERT_EQUAL(std::string("....0123..4567")+std::string(18, '.'),
+                       writer_->getString());
+}
+
+} // namespace aria2
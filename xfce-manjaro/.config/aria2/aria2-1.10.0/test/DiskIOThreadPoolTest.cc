@@ -0,0 +1,126 @@
+#include "DiskIOThreadPool.h"
+
+#include <sys/select.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DiskIOJob.h"
+#include "DlAbortEx.h"
+
+namespace aria2 {
+
+class DiskIOThreadPoolTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DiskIOThreadPoolTest);
+  CPPUNIT_TEST(testPost);
+  CPPUNIT_TEST(testPost_exception);
+  CPPUNIT_TEST(testCreateDiskIOJob);
+  CPPUNIT_TEST(testGetDefaultNumThread);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testPost();
+  void testPost_exception();
+  void testCreateDiskIOJob();
+  void testGetDefaultNumThread();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DiskIOThreadPoolTest);
+
+namespace {
+class CountJob:public DiskIOJob {
+private:
+  int* count_;
+public:
+  CountJob(int* count):count_(count) {}
+
+  virtual void execute()
+  {
+    ++*count_;
+  }
+};
+
+class ThrowJob:public DiskIOJob {
+public:
+  virtual void execute()
+  {
+    throw DL_ABORT_EX("disk error");
+  }
+};
+
+class Counter {
+public:
+  int count;
+
+  Counter():count(0) {}
+
+  void increment()
+  {
+    ++count;
+  }
+};
+
+// Waits until all jobs posted to pool are completed.
+void waitCompletions(DiskIOThreadPool& pool)
+{
+  while(pool.countPendingJob()) {
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    FD_SET(pool.getFd(), &rfds);
+    struct timeval tv;
+    tv.tv_sec = 5;
+    tv.tv_usec = 0;
+    CPPUNIT_ASSERT(select(pool.getFd()+1, &rfds, 0, 0, &tv) > 0);
+    pool.processCompletions();
+  }
+}
+} // namespace
+
+void DiskIOThreadPoolTest::testPost()
+{
+  DiskIOThreadPool pool(2);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.getNumThread());
+  int counts[10] = { 0 };
+  std::vector<SharedHandle<DiskIOJob> > jobs;
+  for(size_t i = 0; i < 10; ++i) {
+    SharedHandle<DiskIOJob> job(new CountJob(&counts[i]));
+    jobs.push_back(job);
+    pool.post(job);
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)10, pool.countPendingJob());
+  waitCompletions(pool);
+  for(size_t i = 0; i < 10; ++i) {
+    CPPUNIT_ASSERT(jobs[i]->completed());
+    CPPUNIT_ASSERT(jobs[i]->getException().isNull());
+    CPPUNIT_ASSERT_EQUAL(1, counts[i]);
+  }
+}
+
+void DiskIOThreadPoolTest::testPost_exception()
+{
+  DiskIOThreadPool pool(1);
+  SharedHandle<DiskIOJob> job(new ThrowJob());
+  pool.post(job);
+  waitCompletions(pool);
+  CPPUNIT_ASSERT(job->completed());
+  CPPUNIT_ASSERT(!job->getException().isNull());
+}
+
+void DiskIOThreadPoolTest::testCreateDiskIOJob()
+{
+  SharedHandle<Counter> counter(new Counter());
+  SharedHandle<DiskIOJob> job = createDiskIOJob(counter, &Counter::increment);
+  DiskIOThreadPool pool(1);
+  pool.post(job);
+  waitCompletions(pool);
+  CPPUNIT_ASSERT_EQUAL(1, counter->count);
+}
+
+void DiskIOThreadPoolTest::testGetDefaultNumThread()
+{
+  size_t n = DiskIOThreadPool::getDefaultNumThread();
+  CPPUNIT_ASSERT(n >= 1);
+  CPPUNIT_ASSERT(n <= DiskIOThreadPool::MAX_DEFAULT_THREAD);
+}
+
+} // namespace aria2
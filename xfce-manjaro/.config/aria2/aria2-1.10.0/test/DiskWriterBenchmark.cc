@@ -0,0 +1,243 @@
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include "DefaultDiskWriter.h"
+#include "File.h"
+#include "a2io.h"
+#include "util.h"
+
+namespace aria2 {
+
+// Blocks are written in the order BitTorrent downloads them: pieces
+// arrive in random order and each piece consists of 16KiB blocks.
+static const size_t BLOCK_LENGTH = 16*1024;
+static const size_t BLOCKS_PER_PIECE = 16;
+static const size_t NUM_PIECES = 128;
+static const size_t NUM_BLOCKS = NUM_PIECES*BLOCKS_PER_PIECE;
+static const uint64_t TOTAL_LENGTH = (uint64_t)NUM_BLOCKS*BLOCK_LENGTH;
+
+static const std::string FILENAME = "/tmp/aria2_DiskWriterBenchmark";
+
+// Reads the number of read and write system calls issued by this
+// process from /proc/self/io. Returns false if it is not available.
+static bool getSyscallCount(uint64_t& syscr, uint64_t& syscw)
+{
+  std::ifstream in("/proc/self/io");
+  if(!in) {
+    return false;
+  }
+  bool r = false, w = false;
+  std::string name;
+  uint64_t value;
+  while(in >> name >> value) {
+    if(name == "syscr:") {
+      syscr = value;
+      r = true;
+    } else if(name == "syscw:") {
+      syscw = value;
+      w = true;
+    }
+  }
+  return r && w;
+}
+
+class SyscallCounter {
+private:
+  bool available_;
+  uint64_t syscr_;
+  uint64_t syscw_;
+  // The number of read system calls needed to read /proc/self/io.
+  uint64_t overhead_;
+public:
+  SyscallCounter():available_(false), syscr_(0), syscw_(0), overhead_(0)
+  {
+    uint64_t syscr, syscw;
+    if(getSyscallCount(syscr, syscw) && getSyscallCount(syscr_, syscw_)) {
+      available_ = true;
+      overhead_ = syscr_-syscr;
+    }
+  }
+
+  // Prints the number of system calls issued since construction.
+  // lseekCount is added because /proc/self/io does not count lseek(2).
+  void print(uint64_t lseekCount) const
+  {
+    uint64_t syscr, syscw;
+    if(!available_ || !getSyscallCount(syscr, syscw)) {
+      benchmark::note("syscalls: n/a");
+      return;
+    }
+    uint64_t reads = syscr-syscr_-overhead_;
+    uint64_t writes = syscw-syscw_;
+    benchmark::note
+      ("syscalls: read="+util::uitos(reads)+
+       " write="+util::uitos(writes)+
+       " lseek="+util::uitos(lseekCount)+
+       " total="+util::uitos(reads+writes+lseekCount));
+  }
+};
+
+static std::vector<size_t> createPieceOrder()
+{
+  std::vector<size_t> order;
+  for(size_t i = 0; i < NUM_PIECES; ++i) {
+    order.push_back(i);
+  }
+  srand(0);
+  std::random_shuffle(order.begin(), order.end());
+  return order;
+}
+
+static off_t blockOffset(size_t piece, size_t block)
+{
+  return ((off_t)piece*BLOCKS_PER_PIECE+block)*BLOCK_LENGTH;
+}
+
+// The path AbstractDiskWriter used before positional I/O: lseek(2)
+// followed by write(2) for every block.
+static void writeSeekWrite(const std::vector<size_t>& order,
+                           const unsigned char* data)
+{
+  int fd = open(FILENAME.c_str(), O_CREAT|O_RDWR|O_TRUNC|O_BINARY, OPEN_MODE);
+  if(fd < 0) {
+    perror("open");
+    exit(EXIT_FAILURE);
+  }
+  SyscallCounter counter;
+  double start = benchmark::now();
+  for(size_t i = 0; i < NUM_PIECES; ++i) {
+    for(size_t j = 0; j < BLOCKS_PER_PIECE; ++j) {
+      if(a2lseek(fd, blockOffset(order[i], j), SEEK_SET) == (off_t)-1 ||
+         write(fd, data, BLOCK_LENGTH) != (ssize_t)BLOCK_LENGTH) {
+        perror("write");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+  benchmark::report("lseek+write", NUM_BLOCKS, benchmark::now()-start,
+                    TOTAL_LENGTH);
+  counter.print(NUM_BLOCKS);
+  close(fd);
+}
+
+static void writeData(const std::vector<size_t>& order,
+                      const unsigned char* data)
+{
+  DefaultDiskWriter dw(FILENAME);
+  dw.initAndOpenFile();
+  SyscallCounter counter;
+  double start = benchmark::now();
+  for(size_t i = 0; i < NUM_PIECES; ++i) {
+    for(size_t j = 0; j < BLOCKS_PER_PIECE; ++j) {
+      dw.writeData(data, BLOCK_LENGTH, blockOffset(order[i], j));
+    }
+  }
+  benchmark::report("DefaultDiskWriter::writeData", NUM_BLOCKS,
+                    benchmark::now()-start, TOTAL_LENGTH);
+  counter.print(0);
+}
+
+static void writeDataVec(const std::vector<size_t>& order,
+                         const unsigned char* data)
+{
+  DefaultDiskWriter dw(FILENAME);
+  dw.initAndOpenFile();
+  std::vector<struct iovec> iov(BLOCKS_PER_PIECE);
+  for(size_t j = 0; j < BLOCKS_PER_PIECE; ++j) {
+    iov[j].iov_base = const_cast<unsigned char*>(data);
+    iov[j].iov_len = BLOCK_LENGTH;
+  }
+  SyscallCounter counter;
+  double start = benchmark::now();
+  for(size_t i = 0; i < NUM_PIECES; ++i) {
+    dw.writeDataVec(&iov[0], iov.size(), blockOffset(order[i], 0));
+  }
+  benchmark::report("DefaultDiskWriter::writeDataVec (1 call/piece)",
+                    NUM_PIECES, benchmark::now()-start, TOTAL_LENGTH);
+  counter.print(0);
+}
+
+static void readSeekRead(const std::vector<size_t>& order,
+                         unsigned char* data)
+{
+  int fd = open(FILENAME.c_str(), O_RDONLY|O_BINARY);
+  if(fd < 0) {
+    perror("open");
+    exit(EXIT_FAILURE);
+  }
+  SyscallCounter counter;
+  double start = benchmark::now();
+  for(size_t i = 0; i < NUM_PIECES; ++i) {
+    for(size_t j = 0; j < BLOCKS_PER_PIECE; ++j) {
+      if(a2lseek(fd, blockOffset(order[i], j), SEEK_SET) == (off_t)-1 ||
+         read(fd, data, BLOCK_LENGTH) != (ssize_t)BLOCK_LENGTH) {
+        perror("read");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+  benchmark::report("lseek+read", NUM_BLOCKS, benchmark::now()-start,
+                    TOTAL_LENGTH);
+  counter.print(NUM_BLOCKS);
+  close(fd);
+}
+
+static void readData(const std::vector<size_t>& order, unsigned char* data)
+{
+  DefaultDiskWriter dw(FILENAME);
+  dw.openExistingFile();
+  SyscallCounter counter;
+  double start = benchmark::now();
+  for(size_t i = 0; i < NUM_PIECES; ++i) {
+    for(size_t j = 0; j < BLOCKS_PER_PIECE; ++j) {
+      dw.readData(data, BLOCK_LENGTH, blockOffset(order[i], j));
+    }
+  }
+  benchmark::report("DefaultDiskWriter::readData", NUM_BLOCKS,
+                    benchmark::now()-start, TOTAL_LENGTH);
+  counter.print(0);
+}
+
+static void readDataVec(const std::vector<size_t>& order,
+                        unsigned char* data)
+{
+  DefaultDiskWriter dw(FILENAME);
+  dw.openExistingFile();
+  std::vector<struct iovec> iov(BLOCKS_PER_PIECE);
+  for(size_t j = 0; j < BLOCKS_PER_PIECE; ++j) {
+    iov[j].iov_base = data;
+    iov[j].iov_len = BLOCK_LENGTH;
+  }
+  SyscallCounter counter;
+  double start = benchmark::now();
+  for(size_t i = 0; i < NUM_PIECES; ++i) {
+    dw.readDataVec(&iov[0], iov.size(), blockOffset(order[i], 0));
+  }
+  benchmark::report("DefaultDiskWriter::readDataVec (1 call/piece)",
+                    NUM_PIECES, benchmark::now()-start, TOTAL_LENGTH);
+  counter.print(0);
+}
+
+static void benchmarkDiskWriter()
+{
+  std::vector<size_t> order = createPieceOrder();
+  std::vector<unsigned char> data(BLOCK_LENGTH, 'a');
+  writeSeekWrite(order, &data[0]);
+  writeData(order, &data[0]);
+  writeDataVec(order, &data[0]);
+  readSeekRead(order, &data[0]);
+  readData(order, &data[0]);
+  readDataVec(order, &data[0]);
+  File(FILENAME).remove();
+}
+
+BENCHMARK_REGISTRATION(benchmarkDiskWriter);
+
+} // namespace aria2
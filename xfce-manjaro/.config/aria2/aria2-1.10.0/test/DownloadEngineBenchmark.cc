@@ -0,0 +1,165 @@
+#include "Benchmark.h"
+
+#include <vector>
+
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+#include "DownloadContext.h"
+#include "FileAllocationEntry.h"
+#include "CheckIntegrityEntry.h"
+#include "TimeBasedCommand.h"
+#include "Option.h"
+#include "prefs.h"
+#include "util.h"
+#ifdef HAVE_EPOLL
+# include "EpollEventPoll.h"
+# include "PeerReceiveHandshakeCommand.h"
+# include "PeerConnection.h"
+# include "Peer.h"
+# include "SocketCore.h"
+#endif // HAVE_EPOLL
+
+namespace aria2 {
+
+// Many commands which have nothing to do for a long time, like idle
+// peer connections and periodic tasks, while one command keeps the
+// engine busy.
+static const size_t NUM_ITERATIONS = 20000;
+static const size_t NUM_REFRESHES = 1000;
+
+namespace {
+
+class IdleCommand:public TimeBasedCommand {
+public:
+  IdleCommand(cuid_t cuid, DownloadEngine* e):
+    TimeBasedCommand(cuid, e, 3600) {}
+
+  virtual void preProcess()
+  {
+    if(getDownloadEngine()->isHaltRequested()) {
+      enableExit();
+    }
+  }
+
+  virtual void process() {}
+};
+
+class BusyCommand:public Command {
+private:
+  DownloadEngine* e_;
+  size_t count_;
+  size_t numIteration_;
+  // If true, every iteration is a refresh, as if a second passed
+  // between them.
+  bool refresh_;
+public:
+  BusyCommand(cuid_t cuid, DownloadEngine* e,
+              size_t numIteration = NUM_ITERATIONS, bool refresh = false):
+    Command(cuid), e_(e), count_(0), numIteration_(numIteration),
+    refresh_(refresh)
+  {
+    setStatusRealtime();
+  }
+
+  virtual bool execute()
+  {
+    if(++count_ == numIteration_) {
+      e_->requestHalt();
+      e_->setNoWait(true);
+      e_->setRefreshInterval(0);
+      return true;
+    }
+    e_->setNoWait(true);
+    if(refresh_) {
+      e_->setRefreshInterval(0);
+    }
+    setStatusRealtime();
+    e_->addCommand(this);
+    return false;
+  }
+};
+
+} // namespace
+
+static SharedHandle<RequestGroupMan> createRequestGroupMan(Option* option)
+{
+  // A waiting download, so that the engine does not finish.
+  SharedHandle<RequestGroup> group
+    (new RequestGroup(SharedHandle<Option>(new Option())));
+  group->setDownloadContext
+    (SharedHandle<DownloadContext>(new DownloadContext(1024, 0, "file")));
+  std::vector<SharedHandle<RequestGroup> > groups;
+  SharedHandle<RequestGroupMan> rgman
+    (new RequestGroupMan(groups, 1, option));
+  rgman->addReservedGroup(group);
+  return rgman;
+}
+
+static void benchmarkDownloadEngine()
+{
+  Option option;
+  const size_t idles[] = { 0, 1000, 10000, 100000 };
+  for(size_t i = 0; i < sizeof(idles)/sizeof(idles[0]); ++i) {
+    DownloadEngine e(SharedHandle<EventPoll>(new SelectEventPoll()));
+    e.setOption(&option);
+    e.setRequestGroupMan(createRequestGroupMan(&option));
+    for(size_t j = 0; j < idles[i]; ++j) {
+      e.addCommand(new IdleCommand(j+1, &e));
+    }
+    e.addCommand(new BusyCommand(0, &e));
+    double start = benchmark::now();
+    e.run();
+    benchmark::report("run: "+util::uitos(idles[i])+" idle commands",
+                      NUM_ITERATIONS, benchmark::now()-start);
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkDownloadEngine);
+
+#ifdef HAVE_EPOLL
+
+// Connected peers which have not sent their handshake yet. Every
+// iteration is a refresh, so commands which wake up on refresh are
+// executed in each of them.
+static void benchmarkIdlePeerConnection()
+{
+  Option option;
+  option.put(PREF_BT_TIMEOUT, "180");
+  const size_t idles[] = { 0, 1000, 5000 };
+  for(size_t i = 0; i < sizeof(idles)/sizeof(idles[0]); ++i) {
+    DownloadEngine e(SharedHandle<EventPoll>(new EpollEventPoll()));
+    e.setOption(&option);
+    e.setRequestGroupMan(createRequestGroupMan(&option));
+    SocketCore server;
+    server.bind(0);
+    server.beginListen();
+    std::pair<std::string, uint16_t> addr;
+    server.getAddrInfo(addr);
+    std::vector<SharedHandle<SocketCore> > clients;
+    for(size_t j = 0; j < idles[i]; ++j) {
+      SharedHandle<SocketCore> client(new SocketCore());
+      client->establishConnection("127.0.0.1", addr.second);
+      clients.push_back(client);
+      SharedHandle<SocketCore> s(server.acceptConnection());
+      s->setNonBlockingMode();
+      std::pair<std::string, uint16_t> peerAddr;
+      s->getPeerInfo(peerAddr);
+      SharedHandle<Peer> peer(new Peer(peerAddr.first, peerAddr.second, true));
+      e.addCommand(new PeerReceiveHandshakeCommand
+                   (j+1, peer, &e, s, SharedHandle<PeerConnection>()));
+    }
+    e.addCommand(new BusyCommand(0, &e, NUM_REFRESHES, true));
+    double start = benchmark::now();
+    e.run();
+    benchmark::report("run: "+util::uitos(idles[i])+" idle peers",
+                      NUM_REFRESHES, benchmark::now()-start);
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkIdlePeerConnection);
+
+#endif // HAVE_EPOLL
+
+} // namespace aria2
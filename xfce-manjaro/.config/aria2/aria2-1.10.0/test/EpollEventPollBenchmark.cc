@@ -0,0 +1,148 @@
+#include "Benchmark.h"
+
+#ifdef HAVE_EPOLL
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "EpollEventPoll.h"
+#include "Command.h"
+#include "util.h"
+
+namespace aria2 {
+
+// 10000 idle connections, each watched for reading by its own
+// Command. In each loop iteration, every Command changes its events
+// the way PeerInteractionCommand and DownloadCommand do, then the
+// engine polls.
+static const size_t NUM_SOCKETS = 10000;
+static const size_t NUM_ROUNDS = 100;
+
+namespace {
+
+class IdleCommand:public Command {
+public:
+  IdleCommand(cuid_t cuid):Command(cuid) {}
+
+  virtual bool execute()
+  {
+    return true;
+  }
+};
+
+} // namespace
+
+static bool raiseFileLimit(size_t num)
+{
+  struct rlimit rlim;
+  if(getrlimit(RLIMIT_NOFILE, &rlim) == -1) {
+    return false;
+  }
+  if(rlim.rlim_cur >= num) {
+    return true;
+  }
+  if(rlim.rlim_max != RLIM_INFINITY && rlim.rlim_max < num) {
+    return false;
+  }
+  rlim.rlim_cur = num;
+  return setrlimit(RLIMIT_NOFILE, &rlim) == 0;
+}
+
+static void benchmarkEpollEventPoll()
+{
+  if(!raiseFileLimit(NUM_SOCKETS+64)) {
+    benchmark::note("cannot open "+util::uitos(NUM_SOCKETS)+" sockets");
+    return;
+  }
+  std::vector<int> fds;
+  for(size_t i = 0; i < NUM_SOCKETS/2; ++i) {
+    int sv[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+      break;
+    }
+    fds.push_back(sv[0]);
+    fds.push_back(sv[1]);
+  }
+  std::vector<IdleCommand*> commands;
+  for(size_t i = 0; i < fds.size(); ++i) {
+    commands.push_back(new IdleCommand(i));
+  }
+  EpollEventPoll poll;
+  struct timeval tv = { 0, 0 };
+  for(size_t i = 0; i < fds.size(); ++i) {
+    poll.addEvents(fds[i], commands[i], EventPoll::EVENT_READ);
+  }
+  poll.poll(tv);
+  benchmark::note("sockets="+util::uitos(fds.size()));
+  {
+    // Data is queued and sent out in the same iteration.
+    uint64_t ctl = poll.getNumCtl();
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      for(size_t i = 0; i < fds.size(); ++i) {
+        poll.addEvents(fds[i], commands[i], EventPoll::EVENT_WRITE);
+        poll.deleteEvents(fds[i], commands[i], EventPoll::EVENT_WRITE);
+      }
+      poll.poll(tv);
+    }
+    benchmark::report("write check toggled in iteration", NUM_ROUNDS,
+                      benchmark::now()-start);
+    benchmark::note("epoll_ctl per iteration: "+
+                    util::uitos((poll.getNumCtl()-ctl)/NUM_ROUNDS));
+  }
+  {
+    // Speed limit exceeded: reading is disabled and enabled again.
+    uint64_t ctl = poll.getNumCtl();
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      for(size_t i = 0; i < fds.size(); ++i) {
+        poll.deleteEvents(fds[i], commands[i], EventPoll::EVENT_READ);
+        poll.addEvents(fds[i], commands[i], EventPoll::EVENT_READ);
+      }
+      poll.poll(tv);
+    }
+    benchmark::report("read check toggled in iteration", NUM_ROUNDS,
+                      benchmark::now()-start);
+    benchmark::note("epoll_ctl per iteration: "+
+                    util::uitos((poll.getNumCtl()-ctl)/NUM_ROUNDS));
+  }
+  {
+    // A tenth of connections start and stop uploading in turn.
+    uint64_t ctl = poll.getNumCtl();
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      for(size_t i = r%10; i < fds.size(); i += 10) {
+        if(r%20 < 10) {
+          poll.addEvents(fds[i], commands[i], EventPoll::EVENT_WRITE);
+        } else {
+          poll.deleteEvents(fds[i], commands[i], EventPoll::EVENT_WRITE);
+        }
+      }
+      poll.poll(tv);
+    }
+    benchmark::report("write check changed across iterations", NUM_ROUNDS,
+                      benchmark::now()-start);
+    benchmark::note("epoll_ctl per iteration: "+
+                    util::uitos((poll.getNumCtl()-ctl)/NUM_ROUNDS));
+  }
+  for(size_t i = 0; i < fds.size(); ++i) {
+    poll.deleteEvents(fds[i], commands[i],
+                      static_cast<EventPoll::EventType>
+                      (EventPoll::EVENT_READ|EventPoll::EVENT_WRITE));
+  }
+  poll.poll(tv);
+  for(size_t i = 0; i < fds.size(); ++i) {
+    close(fds[i]);
+    delete commands[i];
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkEpollEventPoll);
+
+} // namespace aria2
+
+#endif // HAVE_EPOLL
@@ -0,0 +1,163 @@
+#include "EpollEventPoll.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Command.h"
+
+namespace aria2 {
+
+class EpollEventPollTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(EpollEventPollTest);
+  CPPUNIT_TEST(testPoll);
+  CPPUNIT_TEST(testToggleEvents);
+  CPPUNIT_TEST(testDeleteEvents);
+  CPPUNIT_TEST(testReuseDescriptor);
+  CPPUNIT_TEST(testAddEvents_fail);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  int fds_[2];
+
+  static struct timeval noWait()
+  {
+    struct timeval tv = { 0, 0 };
+    return tv;
+  }
+public:
+  class MockCommand:public Command {
+  public:
+    MockCommand(cuid_t cuid):Command(cuid) {}
+
+    virtual bool execute()
+    {
+      return true;
+    }
+  };
+
+  void setUp()
+  {
+    CPPUNIT_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds_));
+  }
+
+  void tearDown()
+  {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  void testPoll();
+  void testToggleEvents();
+  void testDeleteEvents();
+  void testReuseDescriptor();
+  void testAddEvents_fail();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EpollEventPollTest);
+
+void EpollEventPollTest::testPoll()
+{
+  EpollEventPoll poll;
+  CPPUNIT_ASSERT(poll.good());
+  MockCommand command(1);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  // Registration is deferred until poll().
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, poll.getNumCtl());
+  poll.poll(noWait());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, poll.getNumCtl());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, write(fds_[1], "a", 1));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, poll.getNumCtl());
+}
+
+void EpollEventPollTest::testToggleEvents()
+{
+  EpollEventPoll poll;
+  MockCommand command(1);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, poll.getNumCtl());
+  // Enabling and disabling an event in the same iteration costs
+  // nothing.
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_WRITE);
+  poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_WRITE);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, poll.getNumCtl());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+  // Several changes are sent at once.
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_WRITE);
+  poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, poll.getNumCtl());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+}
+
+void EpollEventPollTest::testDeleteEvents()
+{
+  EpollEventPoll poll;
+  MockCommand command(1);
+  CPPUNIT_ASSERT
+    (!poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ));
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  CPPUNIT_ASSERT(poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ));
+  poll.poll(noWait());
+  // Never registered in epoll.
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, poll.getNumCtl());
+  CPPUNIT_ASSERT
+    (!poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ));
+
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, poll.getNumCtl());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, write(fds_[1], "a", 1));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+}
+
+void EpollEventPollTest::testReuseDescriptor()
+{
+  EpollEventPoll poll;
+  MockCommand command(1);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  // The command switches to a new socket which gets the descriptor of
+  // the closed one.
+  int fd = fds_[0];
+  close(fds_[0]);
+  close(fds_[1]);
+  CPPUNIT_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds_));
+  if(fds_[0] != fd) {
+    std::swap(fds_[0], fds_[1]);
+  }
+  CPPUNIT_ASSERT_EQUAL(fd, fds_[0]);
+  poll.deleteEvents(fd, &command, EventPoll::EVENT_READ);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, write(fds_[1], "a", 1));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+}
+
+void EpollEventPollTest::testAddEvents_fail()
+{
+  EpollEventPoll poll;
+  MockCommand command(1);
+  // epoll_ctl fails with EBADF for the closed descriptor.
+  int fd = dup(fds_[0]);
+  close(fd);
+  poll.addEvents(fd, &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+}
+
+} // namespace aria2
@@ -11,6 +11,7 @@
 #include "bittorrent_helper.h"
 #include "Option.h"
 #include "RequestGroup.h"
+#include "MockPeerStorage.h"
 
 namespace aria2 {
 
@@ -110,6 +111,7 @@ void HandshakeExtensionMessageTest::testDoReceivedAction()
   msg.setExtension("ut_metadata", 3);
   msg.setMetadataSize(1024);
   msg.setPeer(peer);
+  msg.setPeerStorage(SharedHandle<PeerStorage>(new MockPeerStorage()));
   msg.setDownloadContext(dctx);
 
   msg.doReceivedAction();
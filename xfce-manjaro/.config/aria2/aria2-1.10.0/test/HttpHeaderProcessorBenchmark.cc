@@ -0,0 +1,66 @@
+#include "Benchmark.h"
+
+#include <string>
+
+#include "HttpHeaderProcessor.h"
+#include "HttpHeader.h"
+#include "util.h"
+
+namespace aria2 {
+
+// A response header as a typical server sends it, received in chunks
+// of various sizes. Small chunks are what a slow link or a header
+// split across TLS records produces.
+static const size_t NUM_ROUNDS = 20000;
+static const size_t NUM_EXTRA_FIELDS = 40;
+
+static std::string createResponseHeader()
+{
+  std::string hd =
+    "HTTP/1.1 200 OK\r\n"
+    "Date: Mon, 25 Jan 2010 07:43:13 GMT\r\n"
+    "Server: Apache/2.2.14 (Unix)\r\n"
+    "Last-Modified: Sun, 24 Jan 2010 10:10:10 GMT\r\n"
+    "ETag: \"1a2b3c-400000-47ddf6f6e6e80\"\r\n"
+    "Accept-Ranges: bytes\r\n"
+    "Content-Length: 4194304\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "Connection: Keep-Alive\r\n";
+  for(size_t i = 0; i < NUM_EXTRA_FIELDS; ++i) {
+    hd += "X-Cache-Info-"+util::uitos(i)+": miss from proxy"+
+      util::uitos(i)+".example.org\r\n";
+  }
+  hd += "\r\n";
+  return hd;
+}
+
+static void benchmarkHttpHeaderProcessor()
+{
+  const std::string hd = createResponseHeader();
+  benchmark::note("header length="+util::uitos(hd.size()));
+  const size_t chunkSizes[] = { 16, 64, 512, 4096 };
+  for(size_t c = 0; c < sizeof(chunkSizes)/sizeof(chunkSizes[0]); ++c) {
+    const size_t chunkSize = chunkSizes[c];
+    uint64_t sink = 0;
+    HttpHeaderProcessor proc;
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      proc.clear();
+      for(size_t i = 0; i < hd.size() && !proc.eoh(); i += chunkSize) {
+        proc.update(hd.substr(i, chunkSize));
+      }
+      SharedHandle<HttpHeader> header = proc.getHttpResponseHeader();
+      sink += header->getFirstAsULLInt(HttpHeader::CONTENT_LENGTH);
+      sink += header->getFirst(HttpHeader::CONNECTION).size();
+    }
+    benchmark::report("chunk="+util::uitos(chunkSize), NUM_ROUNDS,
+                      benchmark::now()-start, (uint64_t)hd.size()*NUM_ROUNDS);
+    if(sink != (4194304ULL+10)*NUM_ROUNDS) {
+      benchmark::note("unexpected result");
+    }
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkHttpHeaderProcessor);
+
+} // namespace aria2
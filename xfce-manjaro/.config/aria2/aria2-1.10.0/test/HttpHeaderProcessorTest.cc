@@ -12,6 +12,7 @@ class HttpHeaderProcessorTest:public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(HttpHeaderProcessorTest);
   CPPUNIT_TEST(testUpdate1);
   CPPUNIT_TEST(testUpdate2);
+  CPPUNIT_TEST(testUpdate_byteByByte);
   CPPUNIT_TEST(testGetPutBackDataLength);
   CPPUNIT_TEST(testGetPutBackDataLength_nullChar);
   CPPUNIT_TEST(testGetHttpResponseHeader);
@@ -26,6 +27,7 @@ class HttpHeaderProcessorTest:public CppUnit::TestFixture {
 public:
   void testUpdate1();
   void testUpdate2();
+  void testUpdate_byteByByte();
   void testGetPutBackDataLength();
   void testGetPutBackDataLength_nullChar();
   void testGetHttpResponseHeader();
@@ -60,6 +62,40 @@ void HttpHeaderProcessorTest::testUpdate2()
   CPPUNIT_ASSERT(proc.eoh());
 }
 
+void HttpHeaderProcessorTest::testUpdate_byteByByte()
+{
+  // The end of header may be split across updates, and a line may end
+  // with LF only.
+  std::string hd = "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 100\n"
+    "Location: http://host/\r\n"
+    "\r\nputbackme";
+  const size_t headerLength = hd.size()-9;
+  HttpHeaderProcessor proc;
+  for(size_t i = 0; i < headerLength; ++i) {
+    CPPUNIT_ASSERT(!proc.eoh());
+    proc.update(hd.substr(i, 1));
+  }
+  CPPUNIT_ASSERT(proc.eoh());
+  proc.update(hd.substr(headerLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)9, proc.getPutBackDataLength());
+  CPPUNIT_ASSERT_EQUAL(hd.substr(0, hd.size()-13), proc.getHeaderString());
+  SharedHandle<HttpHeader> header = proc.getHttpResponseHeader();
+  CPPUNIT_ASSERT_EQUAL((uint64_t)100ULL,
+                       header->getFirstAsULLInt(HttpHeader::HD_CONTENT_LENGTH));
+  CPPUNIT_ASSERT_EQUAL(std::string("http://host/"),
+                       header->getFirst(HttpHeader::HD_LOCATION));
+  CPPUNIT_ASSERT(!header->defined("putbackme"));
+
+  proc.clear();
+  CPPUNIT_ASSERT(!proc.eoh());
+  proc.update("HTTP/1.1 200 OK\n\r");
+  CPPUNIT_ASSERT(!proc.eoh());
+  proc.update("\nputbackme");
+  CPPUNIT_ASSERT(proc.eoh());
+  CPPUNIT_ASSERT_EQUAL((size_t)9, proc.getPutBackDataLength());
+}
+
 void HttpHeaderProcessorTest::testGetPutBackDataLength()
 {
   HttpHeaderProcessor proc;
@@ -10,12 +10,16 @@ class HttpHeaderTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testGetRange);
   CPPUNIT_TEST(testGet);
   CPPUNIT_TEST(testClearField);
+  CPPUNIT_TEST(testFieldId);
+  CPPUNIT_TEST(testPutField);
   CPPUNIT_TEST_SUITE_END();
   
 public:
   void testGetRange();
   void testGet();
   void testClearField();
+  void testFieldId();
+  void testPutField();
 };
 
 
@@ -66,14 +70,60 @@ void HttpHeaderTest::testClearField()
   h.setResponseStatus(HttpHeader::S200);
   h.setVersion(HttpHeader::HTTP_1_1);
   h.put("Foo", "Bar");
+  h.put("Location", "http://host/");
   
   CPPUNIT_ASSERT_EQUAL(std::string("Bar"), h.getFirst("Foo"));
 
   h.clearField();
 
   CPPUNIT_ASSERT_EQUAL(std::string(""), h.getFirst("Foo"));
+  CPPUNIT_ASSERT(!h.defined(HttpHeader::HD_LOCATION));
   CPPUNIT_ASSERT_EQUAL(HttpHeader::S200, h.getResponseStatus());
   CPPUNIT_ASSERT_EQUAL(HttpHeader::HTTP_1_1, h.getVersion());
 }
 
+void HttpHeaderTest::testFieldId()
+{
+  std::string name = "Content-LENGTH";
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::HD_CONTENT_LENGTH,
+                       HttpHeader::getFieldId(name.data(),
+                                              name.data()+name.size()));
+  name = "Content-Lengt";
+  CPPUNIT_ASSERT_EQUAL(-1, HttpHeader::getFieldId(name.data(),
+                                                  name.data()+name.size()));
+
+  HttpHeader h;
+  h.put("content-length", "100");
+  h.put("Set-Cookie", "a=b");
+  h.put("SET-COOKIE", "c=d");
+  CPPUNIT_ASSERT(h.defined(HttpHeader::HD_CONTENT_LENGTH));
+  CPPUNIT_ASSERT(h.defined(HttpHeader::CONTENT_LENGTH));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)100ULL,
+                       h.getFirstAsULLInt(HttpHeader::HD_CONTENT_LENGTH));
+  CPPUNIT_ASSERT_EQUAL(std::string("100"), h.getFirst("Content-Length"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, h.get(HttpHeader::HD_SET_COOKIE).size());
+  CPPUNIT_ASSERT_EQUAL(std::string("c=d"), h.get("set-cookie")[1]);
+  CPPUNIT_ASSERT(!h.defined(HttpHeader::HD_LOCATION));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), h.getFirst(HttpHeader::HD_LOCATION));
+}
+
+void HttpHeaderTest::testPutField()
+{
+  HttpHeader h;
+  std::string line = " Foo-Bar :  baz qux \r";
+  h.putField(line.data(), line.data()+line.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("baz qux"), h.getFirst("foo-bar"));
+  line = "Connection:close";
+  h.putField(line.data(), line.data()+line.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("close"),
+                       h.getFirst(HttpHeader::HD_CONNECTION));
+  line = "NoValue";
+  h.putField(line.data(), line.data()+line.size());
+  CPPUNIT_ASSERT(h.defined("novalue"));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), h.getFirst("novalue"));
+  line = " \r";
+  h.putField(line.data(), line.data()+line.size());
+  CPPUNIT_ASSERT(!h.defined(""));
+}
+
 } // namespace aria2
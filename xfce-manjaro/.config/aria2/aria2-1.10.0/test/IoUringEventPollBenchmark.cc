@@ -0,0 +1,167 @@
+#include "Benchmark.h"
+
+#ifdef HAVE_IO_URING
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <vector>
+#include <string>
+
+#include "IoUringEventPoll.h"
+#ifdef HAVE_EPOLL
+# include "EpollEventPoll.h"
+#endif // HAVE_EPOLL
+#include "Command.h"
+#include "util.h"
+
+namespace aria2 {
+
+// 10000 connections, each watched for reading by its own Command. In
+// each loop iteration, a tenth of them start or stop uploading and a
+// hundredth of them receive data, which is read by their Command.
+static const size_t NUM_SOCKETS = 10000;
+static const size_t NUM_ROUNDS = 100;
+
+namespace {
+
+class ReadCommand:public Command {
+private:
+  int fd_;
+public:
+  ReadCommand(cuid_t cuid, int fd):Command(cuid), fd_(fd) {}
+
+  virtual bool execute()
+  {
+    // Woken up also by write events, so never block.
+    char buf[16];
+    recv(fd_, buf, sizeof(buf), MSG_DONTWAIT);
+    setStatusInactive();
+    return false;
+  }
+};
+
+} // namespace
+
+static bool raiseFileLimit(size_t num)
+{
+  struct rlimit rlim;
+  if(getrlimit(RLIMIT_NOFILE, &rlim) == -1) {
+    return false;
+  }
+  if(rlim.rlim_cur >= num) {
+    return true;
+  }
+  if(rlim.rlim_max != RLIM_INFINITY && rlim.rlim_max < num) {
+    return false;
+  }
+  rlim.rlim_cur = num;
+  return setrlimit(RLIMIT_NOFILE, &rlim) == 0;
+}
+
+static uint64_t countSystemCalls(const IoUringEventPoll& poll)
+{
+  return poll.getNumEnter();
+}
+
+#ifdef HAVE_EPOLL
+static uint64_t countSystemCalls(const EpollEventPoll& poll)
+{
+  // epoll_ctl calls. epoll_wait is added per iteration by the caller.
+  return poll.getNumCtl();
+}
+#endif // HAVE_EPOLL
+
+template<typename Poll>
+static void runLoop(const std::string& label, Poll& poll,
+                    const std::vector<int>& fds,
+                    const std::vector<ReadCommand*>& commands,
+                    size_t waitsPerIteration)
+{
+  struct timeval tv = { 0, 0 };
+  for(size_t i = 0; i < fds.size(); i += 2) {
+    poll.addEvents(fds[i], commands[i], EventPoll::EVENT_READ);
+  }
+  poll.poll(tv);
+  uint64_t calls = countSystemCalls(poll);
+  size_t woken = 0;
+  double start = benchmark::now();
+  for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+    for(size_t i = (r%10)*2; i < fds.size(); i += 20) {
+      if(r%20 < 10) {
+        poll.addEvents(fds[i], commands[i], EventPoll::EVENT_WRITE);
+      } else {
+        poll.deleteEvents(fds[i], commands[i], EventPoll::EVENT_WRITE);
+      }
+    }
+    for(size_t i = (r%100)*2; i < fds.size(); i += 200) {
+      write(fds[i+1], "a", 1);
+    }
+    poll.poll(tv);
+    for(size_t i = 0; i < fds.size(); i += 2) {
+      if(commands[i]->statusMatch(Command::STATUS_ACTIVE)) {
+        ++woken;
+        commands[i]->execute();
+      }
+    }
+  }
+  benchmark::report(label, NUM_ROUNDS, benchmark::now()-start);
+  benchmark::note(label+" system calls per iteration: "+
+                  util::uitos((countSystemCalls(poll)-calls)/NUM_ROUNDS+
+                              waitsPerIteration)+
+                  ", commands woken per iteration: "+
+                  util::uitos(woken/NUM_ROUNDS));
+  for(size_t i = 0; i < fds.size(); i += 2) {
+    poll.deleteEvents(fds[i], commands[i],
+                      static_cast<EventPoll::EventType>
+                      (EventPoll::EVENT_READ|EventPoll::EVENT_WRITE));
+  }
+  poll.poll(tv);
+}
+
+static void benchmarkIoUringEventPoll()
+{
+  IoUringEventPoll uring;
+  if(!uring.good()) {
+    benchmark::note("io_uring is not available");
+    return;
+  }
+  if(!raiseFileLimit(NUM_SOCKETS+64)) {
+    benchmark::note("cannot open "+util::uitos(NUM_SOCKETS)+" sockets");
+    return;
+  }
+  // fds[2*k] is watched by commands[2*k]; fds[2*k+1] is its peer.
+  std::vector<int> fds;
+  for(size_t i = 0; i < NUM_SOCKETS/2; ++i) {
+    int sv[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+      break;
+    }
+    fds.push_back(sv[0]);
+    fds.push_back(sv[1]);
+  }
+  std::vector<ReadCommand*> commands;
+  for(size_t i = 0; i < fds.size(); ++i) {
+    commands.push_back(new ReadCommand(i, fds[i]));
+  }
+  benchmark::note("sockets="+util::uitos(fds.size()/2));
+#ifdef HAVE_EPOLL
+  {
+    EpollEventPoll epoll;
+    runLoop("epoll", epoll, fds, commands, 1);
+  }
+#endif // HAVE_EPOLL
+  runLoop("io_uring", uring, fds, commands, 0);
+  for(size_t i = 0; i < fds.size(); ++i) {
+    close(fds[i]);
+    delete commands[i];
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkIoUringEventPoll);
+
+} // namespace aria2
+
+#endif // HAVE_IO_URING
@@ -0,0 +1,182 @@
+#include "IoUringEventPoll.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Command.h"
+
+namespace aria2 {
+
+class IoUringEventPollTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(IoUringEventPollTest);
+  CPPUNIT_TEST(testPoll);
+  CPPUNIT_TEST(testPoll_levelTriggered);
+  CPPUNIT_TEST(testToggleEvents);
+  CPPUNIT_TEST(testDeleteEvents);
+  CPPUNIT_TEST(testReuseDescriptor);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  int fds_[2];
+
+  static struct timeval noWait()
+  {
+    struct timeval tv = { 0, 0 };
+    return tv;
+  }
+public:
+  class MockCommand:public Command {
+  public:
+    MockCommand(cuid_t cuid):Command(cuid) {}
+
+    virtual bool execute()
+    {
+      return true;
+    }
+  };
+
+  void setUp()
+  {
+    CPPUNIT_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds_));
+  }
+
+  void tearDown()
+  {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  void testPoll();
+  void testPoll_levelTriggered();
+  void testToggleEvents();
+  void testDeleteEvents();
+  void testReuseDescriptor();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IoUringEventPollTest);
+
+// io_uring may be unavailable in the running kernel even if the
+// header exists. Then the tests pass without checking anything.
+
+void IoUringEventPollTest::testPoll()
+{
+  IoUringEventPoll poll;
+  if(!poll.good()) {
+    return;
+  }
+  MockCommand command(1);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  // The request is submitted by the call which waits for events.
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, poll.getNumEnter());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, write(fds_[1], "a", 1));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, poll.getNumEnter());
+}
+
+void IoUringEventPollTest::testPoll_levelTriggered()
+{
+  IoUringEventPoll poll;
+  if(!poll.good()) {
+    return;
+  }
+  MockCommand command(1);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, write(fds_[1], "a", 1));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+  // The data is not read, so the command is woken up again.
+  command.setStatusInactive();
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+
+  char c;
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, read(fds_[0], &c, 1));
+  command.setStatusInactive();
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+}
+
+void IoUringEventPollTest::testToggleEvents()
+{
+  IoUringEventPoll poll;
+  if(!poll.good()) {
+    return;
+  }
+  MockCommand command(1);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  // Enabling and disabling an event in the same iteration leaves the
+  // request in the ring as it is.
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_WRITE);
+  poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_WRITE);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+  // The request is replaced.
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_WRITE);
+  poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)3, poll.getNumEnter());
+}
+
+void IoUringEventPollTest::testDeleteEvents()
+{
+  IoUringEventPoll poll;
+  if(!poll.good()) {
+    return;
+  }
+  MockCommand command(1);
+  CPPUNIT_ASSERT
+    (!poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ));
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  CPPUNIT_ASSERT(poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT
+    (!poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ));
+
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(poll.deleteEvents(fds_[0], &command, EventPoll::EVENT_READ));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, write(fds_[1], "a", 1));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+}
+
+void IoUringEventPollTest::testReuseDescriptor()
+{
+  IoUringEventPoll poll;
+  if(!poll.good()) {
+    return;
+  }
+  MockCommand command(1);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  // The command switches to a new socket which gets the descriptor of
+  // the closed one.
+  int fd = fds_[0];
+  close(fds_[0]);
+  close(fds_[1]);
+  CPPUNIT_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds_));
+  if(fds_[0] != fd) {
+    std::swap(fds_[0], fds_[1]);
+  }
+  CPPUNIT_ASSERT_EQUAL(fd, fds_[0]);
+  poll.deleteEvents(fd, &command, EventPoll::EVENT_READ);
+  poll.addEvents(fds_[0], &command, EventPoll::EVENT_READ);
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(!command.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, write(fds_[1], "a", 1));
+  poll.poll(noWait());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+}
+
+} // namespace aria2
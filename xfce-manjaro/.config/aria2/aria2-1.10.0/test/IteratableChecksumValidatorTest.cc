@@ -9,6 +9,7 @@
 #include "FileEntry.h"
 #include "PieceSelector.h"
 #include "messageDigest.h"
+#include "DiskIOJob.h"
 
 namespace aria2 {
 
@@ -17,6 +18,9 @@ class IteratableChecksumValidatorTest:public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(IteratableChecksumValidatorTest);
   CPPUNIT_TEST(testValidate);
   CPPUNIT_TEST(testValidate_fail);
+#ifdef ENABLE_DISK_IO_THREAD
+  CPPUNIT_TEST(testValidate_concurrent);
+#endif // ENABLE_DISK_IO_THREAD
   CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -26,6 +30,9 @@ public:
 
   void testValidate();
   void testValidate_fail();
+#ifdef ENABLE_DISK_IO_THREAD
+  void testValidate_concurrent();
+#endif // ENABLE_DISK_IO_THREAD
 };
 
 
@@ -70,4 +77,35 @@ void IteratableChecksumValidatorTest::testValidate_fail() {
   CPPUNIT_ASSERT(!ps->downloadFinished());
 }
 
+#ifdef ENABLE_DISK_IO_THREAD
+void IteratableChecksumValidatorTest::testValidate_concurrent() {
+  Option option;
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(100, 250, "chunkChecksumTestFile250.txt"));
+  dctx->setChecksum("898a81b8e0181280ae2ee1b81e269196d91e869a");
+  dctx->setChecksumHashAlgo(MessageDigestContext::SHA1);
+  SharedHandle<DefaultPieceStorage> ps(new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->openFile();
+
+  IteratableChecksumValidator validator(dctx, ps);
+  validator.init();
+  CPPUNIT_ASSERT(validator.concurrent());
+
+  SharedHandle<DiskIOJob> job = validator.createChunkJob();
+  CPPUNIT_ASSERT(!job.isNull());
+  // The file is hashed in order, one job at a time.
+  CPPUNIT_ASSERT(validator.createChunkJob().isNull());
+  job->run();
+  // Nothing is updated until the job is finished in the main thread.
+  CPPUNIT_ASSERT_EQUAL((off_t)0, validator.getCurrentOffset());
+  CPPUNIT_ASSERT(!ps->downloadFinished());
+  validator.finishChunkJob(job);
+  CPPUNIT_ASSERT_EQUAL((off_t)250, validator.getCurrentOffset());
+  CPPUNIT_ASSERT(validator.finished());
+  CPPUNIT_ASSERT(ps->downloadFinished());
+  CPPUNIT_ASSERT(validator.createChunkJob().isNull());
+}
+#endif // ENABLE_DISK_IO_THREAD
+
 } // namespace aria2
@@ -1,5 +1,7 @@
 #include "IteratableChunkChecksumValidator.h"
 
+#include <fstream>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "DownloadContext.h"
@@ -9,6 +11,10 @@
 #include "FileEntry.h"
 #include "PieceSelector.h"
 #include "messageDigest.h"
+#include "DiskIOJob.h"
+#include "MessageDigestHelper.h"
+#include "sha1.h"
+#include "File.h"
 
 namespace aria2 {
 
@@ -17,6 +23,11 @@ class IteratableChunkChecksumValidatorTest:public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(IteratableChunkChecksumValidatorTest);
   CPPUNIT_TEST(testValidate);
   CPPUNIT_TEST(testValidate_readError);
+  CPPUNIT_TEST(testValidate_lanes);
+  CPPUNIT_TEST(testValidate_hole);
+#ifdef ENABLE_DISK_IO_THREAD
+  CPPUNIT_TEST(testValidate_concurrent);
+#endif // ENABLE_DISK_IO_THREAD
   CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -27,6 +38,11 @@ public:
 
   void testValidate();
   void testValidate_readError();
+  void testValidate_lanes();
+  void testValidate_hole();
+#ifdef ENABLE_DISK_IO_THREAD
+  void testValidate_concurrent();
+#endif // ENABLE_DISK_IO_THREAD
 };
 
 
@@ -103,4 +119,137 @@ void IteratableChunkChecksumValidatorTest::testValidate_readError() {
   CPPUNIT_ASSERT(!ps->hasPiece(4));
 }
 
+void IteratableChunkChecksumValidatorTest::testValidate_lanes() {
+  // 20 pieces, but the file ends in piece 13.
+  const size_t pieceLength = 512;
+  const size_t numPieces = 20;
+  std::string data(13*pieceLength+200, 0);
+  for(size_t i = 0; i < data.size(); ++i) {
+    data[i] = i*7;
+  }
+  std::string path = "aria2_IteratableChunkChecksumValidatorTest_lanes";
+  std::ofstream(path.c_str(), std::ios::binary).write(data.data(), data.size());
+  std::deque<std::string> hashes;
+  for(size_t i = 0; i < numPieces; ++i) {
+    if(i < 13) {
+      hashes.push_back(MessageDigestHelper::digestString
+                       (MessageDigestContext::SHA1,
+                        data.substr(i*pieceLength, pieceLength)));
+    } else {
+      hashes.push_back("ffffffffffffffffffffffffffffffffffffffff");
+    }
+  }
+  hashes[3] = "ffffffffffffffffffffffffffffffffffffffff";
+
+  std::string defaultKernel = sha1::getKernel();
+  std::vector<std::string> kernels = sha1::getAvailableKernels();
+  for(std::vector<std::string>::const_iterator i = kernels.begin(),
+        eoi = kernels.end(); i != eoi; ++i) {
+    sha1::selectKernel(*i);
+    Option option;
+    SharedHandle<DownloadContext> dctx
+      (new DownloadContext(pieceLength, numPieces*pieceLength-100, path));
+    dctx->setPieceHashes(hashes.begin(), hashes.end());
+    dctx->setPieceHashAlgo(MessageDigestContext::SHA1);
+    SharedHandle<DefaultPieceStorage> ps
+      (new DefaultPieceStorage(dctx, &option));
+    ps->initStorage();
+    ps->getDiskAdaptor()->openFile();
+
+    IteratableChunkChecksumValidator validator(dctx, ps);
+    validator.init();
+    while(!validator.finished()) {
+      validator.validateChunk();
+    }
+    for(size_t j = 0; j < numPieces; ++j) {
+      CPPUNIT_ASSERT_EQUAL(j < 13 && j != 3, ps->hasPiece(j));
+    }
+  }
+  sha1::selectKernel(defaultKernel);
+}
+
+void IteratableChunkChecksumValidatorTest::testValidate_hole() {
+  // Pieces #1 and #2 are a hole. Only a piece of zeros can be there.
+  const size_t pieceLength = 4096;
+  std::string data(pieceLength, 'a');
+  std::string zeros(pieceLength, 0);
+  std::string path = "aria2_IteratableChunkChecksumValidatorTest_hole";
+  File(path).remove();
+  {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out.write(data.data(), data.size());
+    out.seekp(3*pieceLength);
+    out.write(data.data(), data.size());
+  }
+  std::deque<std::string> hashes;
+  hashes.push_back(MessageDigestHelper::digestString
+                   (MessageDigestContext::SHA1, data));
+  hashes.push_back(MessageDigestHelper::digestString
+                   (MessageDigestContext::SHA1, zeros));
+  hashes.push_back("ffffffffffffffffffffffffffffffffffffffff");
+  hashes.push_back(hashes[0]);
+
+  Option option;
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(pieceLength, 4*pieceLength, path));
+  dctx->setPieceHashes(hashes.begin(), hashes.end());
+  dctx->setPieceHashAlgo(MessageDigestContext::SHA1);
+  SharedHandle<DefaultPieceStorage> ps(new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->openFile();
+
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.init();
+  while(!validator.finished()) {
+    validator.validateChunk();
+  }
+  CPPUNIT_ASSERT(ps->hasPiece(0));
+  CPPUNIT_ASSERT(ps->hasPiece(1));
+  CPPUNIT_ASSERT(!ps->hasPiece(2));
+  CPPUNIT_ASSERT(ps->hasPiece(3));
+}
+
+#ifdef ENABLE_DISK_IO_THREAD
+void IteratableChunkChecksumValidatorTest::testValidate_concurrent() {
+  Option option;
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(100, 500, "chunkChecksumTestFile250.txt"));
+  std::deque<std::string> hashes(&csArray[0], &csArray[3]);
+  hashes.push_back("ffffffffffffffffffffffffffffffffffffffff");
+  hashes.push_back("ffffffffffffffffffffffffffffffffffffffff");
+  dctx->setPieceHashes(hashes.begin(), hashes.end());
+  dctx->setPieceHashAlgo(MessageDigestContext::SHA1);
+  SharedHandle<DefaultPieceStorage> ps(new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->openFile();
+
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.init();
+  CPPUNIT_ASSERT(validator.concurrent());
+
+  std::vector<SharedHandle<DiskIOJob> > jobs;
+  while(1) {
+    SharedHandle<DiskIOJob> job = validator.createChunkJob();
+    if(job.isNull()) {
+      break;
+    }
+    jobs.push_back(job);
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)5, jobs.size());
+  CPPUNIT_ASSERT(!validator.finished());
+  // Jobs may finish in any order.
+  for(size_t i = jobs.size(); i > 0; --i) {
+    jobs[i-1]->run();
+    validator.finishChunkJob(jobs[i-1]);
+    CPPUNIT_ASSERT_EQUAL(i == 1, validator.finished());
+  }
+  CPPUNIT_ASSERT(ps->hasPiece(0));
+  CPPUNIT_ASSERT(ps->hasPiece(1));
+  // Read errors as in testValidate_readError.
+  CPPUNIT_ASSERT(!ps->hasPiece(2));
+  CPPUNIT_ASSERT(!ps->hasPiece(3));
+  CPPUNIT_ASSERT(!ps->hasPiece(4));
+}
+#endif // ENABLE_DISK_IO_THREAD
+
 } // namespace aria2
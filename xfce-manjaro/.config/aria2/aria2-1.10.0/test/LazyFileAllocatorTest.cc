@@ -0,0 +1,79 @@
+#include "LazyFileAllocator.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DirectDiskAdaptor.h"
+#include "DefaultDiskWriter.h"
+#include "FileEntry.h"
+#include "BitfieldMan.h"
+#include "File.h"
+
+namespace aria2 {
+
+class LazyFileAllocatorTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(LazyFileAllocatorTest);
+  CPPUNIT_TEST(testReserve);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void setUp() {}
+
+  void tearDown() {}
+
+  void testReserve();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LazyFileAllocatorTest);
+
+void LazyFileAllocatorTest::testReserve()
+{
+  // 10 pieces of 1024 bytes in batches of 4 pieces.
+  SharedHandle<FileEntry> entry
+    (new FileEntry("./aria2_LazyFileAllocatorTest_testReserve", 10000, 0));
+  File(entry->getPath()).remove();
+  std::vector<SharedHandle<FileEntry> > fileEntries;
+  fileEntries.push_back(entry);
+  SharedHandle<DirectDiskAdaptor> adaptor(new DirectDiskAdaptor());
+  adaptor->setDiskWriter
+    (SharedHandle<DiskWriter>(new DefaultDiskWriter(entry->getPath())));
+  adaptor->setTotalLength(entry->getLength());
+  adaptor->setFileEntries(fileEntries.begin(), fileEntries.end());
+  adaptor->initAndOpenFile();
+
+  BitfieldMan bitfield(1024, entry->getLength());
+  LazyFileAllocator allocator(adaptor, &bitfield, 4096);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, allocator.getPiecesPerBatch());
+
+  allocator.reserve(5);
+  for(size_t i = 0; i < 10; ++i) {
+    CPPUNIT_ASSERT_EQUAL(4 <= i && i < 8, allocator.isAllocated(i));
+  }
+  // The file system may not support allocation. Then only the
+  // bookkeeping is checked.
+  bool enabled = allocator.isEnabled();
+  if(enabled) {
+    CPPUNIT_ASSERT_EQUAL((uint64_t)8192, File(entry->getPath()).size());
+  }
+
+  // The last batch has a downloaded piece, so it was allocated before
+  // the download was resumed.
+  bitfield.setBit(9);
+  allocator.reserve(8);
+  CPPUNIT_ASSERT(allocator.isAllocated(8));
+  if(enabled) {
+    CPPUNIT_ASSERT_EQUAL((uint64_t)8192, File(entry->getPath()).size());
+  }
+
+  // The last batch is shorter than the others.
+  bitfield.unsetBit(9);
+  LazyFileAllocator allocator2(adaptor, &bitfield, 4096);
+  allocator2.reserve(9);
+  CPPUNIT_ASSERT(allocator2.isAllocated(8));
+  CPPUNIT_ASSERT(!allocator2.isAllocated(7));
+  if(enabled) {
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10000, File(entry->getPath()).size());
+  }
+}
+
+} // namespace aria2
@@ -12,7 +12,7 @@ namespace aria2 {
 class MockPeerStorage : public PeerStorage {
 private:
   TransferStat stat;
-  std::deque<SharedHandle<Peer> > peers;
+  std::list<SharedHandle<Peer> > peers;
   std::vector<SharedHandle<Peer> > activePeers;
   int numChokeExecuted_;
 public:
@@ -28,7 +28,7 @@ public:
     std::copy(peers.begin(), peers.end(), back_inserter(this->peers));
   }
 
-  virtual const std::deque<SharedHandle<Peer> >& getPeers() {
+  virtual const std::list<SharedHandle<Peer> >& getPeers() {
     return peers;
   }
 
@@ -61,6 +61,11 @@ public:
   {
   }
 
+  virtual void updatePeerPort(const SharedHandle<Peer>& peer, uint16_t port)
+  {
+    peer->setPort(port);
+  }
+
   virtual bool chokeRoundIntervalElapsed()
   {
     return false;
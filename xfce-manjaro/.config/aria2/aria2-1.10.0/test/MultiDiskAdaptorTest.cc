@@ -20,6 +20,8 @@ class MultiDiskAdaptorTest:public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(MultiDiskAdaptorTest);
   CPPUNIT_TEST(testWriteData);
   CPPUNIT_TEST(testReadData);
+  CPPUNIT_TEST(testWriteDataVec);
+  CPPUNIT_TEST(testReadDataVec);
   CPPUNIT_TEST(testCutTrailingGarbage);
   CPPUNIT_TEST(testSize);
   CPPUNIT_TEST(testUtime);
@@ -35,6 +37,8 @@ public:
 
   void testWriteData();
   void testReadData();
+  void testWriteDataVec();
+  void testReadDataVec();
   void testCutTrailingGarbage();
   void testSize();
   void testUtime();
@@ -363,6 +367,77 @@ void MultiDiskAdaptorTest::testReadData() {
   CPPUNIT_ASSERT_EQUAL(std::string("1234567890ABCDEFGHIJKLMNO"), std::string((char*)buf));
 }
 
+void MultiDiskAdaptorTest::testWriteDataVec()
+{
+  std::vector<SharedHandle<FileEntry> > fileEntries(createEntries());
+  adaptor->setFileEntries(fileEntries.begin(), fileEntries.end());
+
+  adaptor->openFile();
+  // The buffers span file1, file2 and file4 and the boundaries of the
+  // buffers do not match the ones of the files.
+  std::string msg1 = "1234567890ABC";
+  std::string msg2 = "";
+  std::string msg3 = "DEF12345";
+  std::string msg4 = "6712";
+  struct iovec iov[4];
+  iov[0].iov_base = const_cast<char*>(msg1.data());
+  iov[0].iov_len = msg1.size();
+  iov[1].iov_base = const_cast<char*>(msg2.data());
+  iov[1].iov_len = msg2.size();
+  iov[2].iov_base = const_cast<char*>(msg3.data());
+  iov[2].iov_len = msg3.size();
+  iov[3].iov_base = const_cast<char*>(msg4.data());
+  iov[3].iov_len = msg4.size();
+  adaptor->writeDataVec(iov, 4, 0);
+  adaptor->closeFile();
+
+  char buf[128];
+  readFile("file1.txt", buf, 15);
+  buf[15] = '\0';
+  CPPUNIT_ASSERT_EQUAL(std::string("1234567890ABCDE"), std::string(buf));
+  readFile("file2.txt", buf, 7);
+  buf[7] = '\0';
+  CPPUNIT_ASSERT_EQUAL(std::string("F123456"), std::string(buf));
+  readFile("file4.txt", buf, 2);
+  buf[2] = '\0';
+  CPPUNIT_ASSERT_EQUAL(std::string("71"), std::string(buf));
+  readFile("file6.txt", buf, 1);
+  buf[1] = '\0';
+  CPPUNIT_ASSERT_EQUAL(std::string("2"), std::string(buf));
+}
+
+void MultiDiskAdaptorTest::testReadDataVec()
+{
+  SharedHandle<FileEntry> entry1(new FileEntry("file1r.txt", 15, 0));
+  SharedHandle<FileEntry> entry2(new FileEntry("file2r.txt", 7, 15));
+  SharedHandle<FileEntry> entry3(new FileEntry("file3r.txt", 3, 22));
+  std::vector<SharedHandle<FileEntry> > entries;
+  entries.push_back(entry1);
+  entries.push_back(entry2);
+  entries.push_back(entry3);
+
+  adaptor->setFileEntries(entries.begin(), entries.end());
+
+  adaptor->openFile();
+  char buf1[10];
+  char buf2[3];
+  char buf3[10];
+  struct iovec iov[3];
+  iov[0].iov_base = buf1;
+  iov[0].iov_len = sizeof(buf1);
+  iov[1].iov_base = buf2;
+  iov[1].iov_len = sizeof(buf2);
+  iov[2].iov_base = buf3;
+  iov[2].iov_len = sizeof(buf3);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)23, adaptor->readDataVec(iov, 3, 2));
+  CPPUNIT_ASSERT_EQUAL(std::string("34567890AB"),
+                       std::string(&buf1[0], &buf1[sizeof(buf1)]));
+  CPPUNIT_ASSERT_EQUAL(std::string("CDE"),
+                       std::string(&buf2[0], &buf2[sizeof(buf2)]));
+  CPPUNIT_ASSERT_EQUAL(std::string("FGHIJKLMNO"),
+                       std::string(&buf3[0], &buf3[sizeof(buf3)]));
+}
+
 void MultiDiskAdaptorTest::testCutTrailingGarbage()
 {
   std::string dir = "./";
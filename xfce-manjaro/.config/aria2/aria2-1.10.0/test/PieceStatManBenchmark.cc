@@ -0,0 +1,156 @@
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include "PieceStatMan.h"
+#include "bitfield.h"
+#include "util.h"
+
+namespace aria2 {
+
+// A swarm of a torrent with many pieces. Each peer has a random
+// portion of the pieces. Peers connect and then disconnect one by
+// one.
+static const size_t NUM_PIECES = 100000;
+static const size_t NUM_PEERS = 200;
+
+typedef std::vector<unsigned char> Bitfield;
+
+static std::vector<Bitfield> createSwarm()
+{
+  srand(0);
+  std::vector<Bitfield> peers;
+  for(size_t i = 0; i < NUM_PEERS; ++i) {
+    Bitfield bf((NUM_PIECES+7)/8);
+    // Completion ratio between 0% and 100%.
+    size_t ratio = rand()%101;
+    for(size_t j = 0; j < NUM_PIECES; ++j) {
+      if((size_t)(rand()%100) < ratio) {
+        bf[j/8] |= 128 >> (j%8);
+      }
+    }
+    peers.push_back(bf);
+  }
+  return peers;
+}
+
+// The algorithm PieceStatMan used before the incremental index: count
+// every bit, then sort all pieces by count.
+class SortingPieceStatMan {
+private:
+  std::vector<size_t> counts_;
+  std::vector<size_t> order_;
+  std::vector<size_t> sorted_;
+
+  class Rarer {
+  private:
+    const SortingPieceStatMan* man_;
+  public:
+    Rarer(const SortingPieceStatMan* man):man_(man) {}
+
+    bool operator()(size_t lhs, size_t rhs) const
+    {
+      if(man_->counts_[lhs] == man_->counts_[rhs]) {
+        return man_->order_[lhs] < man_->order_[rhs];
+      } else {
+        return man_->counts_[lhs] < man_->counts_[rhs];
+      }
+    }
+  };
+public:
+  SortingPieceStatMan(size_t pieceNum):
+    counts_(pieceNum), order_(pieceNum), sorted_(pieceNum)
+  {
+    for(size_t i = 0; i < pieceNum; ++i) {
+      order_[i] = sorted_[i] = i;
+    }
+  }
+
+  void addPieceStats(const Bitfield& bf)
+  {
+    for(size_t i = 0; i < counts_.size(); ++i) {
+      if(bitfield::test(bf, counts_.size(), i)) {
+        ++counts_[i];
+      }
+    }
+    std::sort(sorted_.begin(), sorted_.end(), Rarer(this));
+  }
+
+  void subtractPieceStats(const Bitfield& bf)
+  {
+    for(size_t i = 0; i < counts_.size(); ++i) {
+      if(bitfield::test(bf, counts_.size(), i)) {
+        --counts_[i];
+      }
+    }
+    std::sort(sorted_.begin(), sorted_.end(), Rarer(this));
+  }
+
+  size_t getRarestPiece() const
+  {
+    return sorted_[0];
+  }
+};
+
+static uint64_t countSetBits(const std::vector<Bitfield>& peers)
+{
+  uint64_t n = 0;
+  for(std::vector<Bitfield>::const_iterator i = peers.begin(),
+        eoi = peers.end(); i != eoi; ++i) {
+    n += bitfield::countSetBit(&(*i)[0], NUM_PIECES);
+  }
+  return n;
+}
+
+static void benchmarkPieceStatMan()
+{
+  std::vector<Bitfield> peers = createSwarm();
+  benchmark::note("pieces="+util::uitos(NUM_PIECES)+
+                  " peers="+util::uitos(NUM_PEERS)+
+                  " set bits="+util::uitos(countSetBits(peers)));
+  size_t check1, check2;
+  {
+    SortingPieceStatMan man(NUM_PIECES);
+    double start = benchmark::now();
+    for(size_t i = 0; i < NUM_PEERS; ++i) {
+      man.addPieceStats(peers[i]);
+    }
+    check1 = man.getRarestPiece();
+    for(size_t i = 0; i < NUM_PEERS; ++i) {
+      man.subtractPieceStats(peers[i]);
+    }
+    benchmark::report("full sort per peer event", NUM_PEERS*2,
+                      benchmark::now()-start);
+  }
+  {
+    PieceStatMan man(NUM_PIECES, false);
+    double start = benchmark::now();
+    for(size_t i = 0; i < NUM_PEERS; ++i) {
+      man.addPieceStats(&peers[i][0], peers[i].size());
+    }
+    check2 = man.getRarerPieceIndexes()[0];
+    for(size_t i = 0; i < NUM_PEERS; ++i) {
+      man.subtractPieceStats(&peers[i][0], peers[i].size());
+    }
+    benchmark::report("PieceStatMan", NUM_PEERS*2, benchmark::now()-start);
+  }
+  // Ties may be broken differently, but the rarest count must match.
+  {
+    std::vector<size_t> counts(NUM_PIECES);
+    for(size_t i = 0; i < NUM_PEERS; ++i) {
+      for(size_t j = 0; j < NUM_PIECES; ++j) {
+        if(bitfield::test(peers[i], NUM_PIECES, j)) {
+          ++counts[j];
+        }
+      }
+    }
+    benchmark::note("rarest count: full sort="+util::uitos(counts[check1])+
+                    " PieceStatMan="+util::uitos(counts[check2]));
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkPieceStatMan);
+
+} // namespace aria2
@@ -1,7 +1,11 @@
 #include "PieceStatMan.h"
 
+#include <cstdlib>
+
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "bitfield.h"
+
 namespace aria2 {
 
 class PieceStatManTest:public CppUnit::TestFixture {
@@ -11,6 +15,7 @@ class PieceStatManTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testAddPieceStats_bitfield);
   CPPUNIT_TEST(testUpdatePieceStats);
   CPPUNIT_TEST(testSubtractPieceStats);
+  CPPUNIT_TEST(testRandomUpdates);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp() {}
@@ -21,6 +26,7 @@ public:
   void testAddPieceStats_bitfield();
   void testUpdatePieceStats();
   void testSubtractPieceStats();
+  void testRandomUpdates();
 };
 
 
@@ -31,7 +37,7 @@ void PieceStatManTest::testAddPieceStats_index()
   PieceStatMan pieceStatMan(10, false);
   pieceStatMan.addPieceStats(1);
   {
-    size_t indexes[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 1 };
+    size_t indexes[] = { 0, 9, 2, 3, 4, 5, 6, 7, 8, 1 };
     size_t counts[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
     
     const std::vector<size_t>& statsidx(pieceStatMan.getRarerPieceIndexes());
@@ -49,7 +55,7 @@ void PieceStatManTest::testAddPieceStats_index()
   pieceStatMan.addPieceStats(1);
 
   {
-    size_t indexes[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 1 };
+    size_t indexes[] = { 0, 9, 2, 3, 4, 5, 6, 7, 8, 1 };
     size_t counts[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 2 };
 
     const std::vector<size_t>& statsidx(pieceStatMan.getRarerPieceIndexes());
@@ -68,7 +74,7 @@ void PieceStatManTest::testAddPieceStats_index()
   pieceStatMan.addPieceStats(0);
 
   {
-    size_t indexes[] = { 2, 4, 5, 6, 7, 8, 0, 9, 1, 3 };
+    size_t indexes[] = { 6, 7, 2, 8, 4, 5, 0, 9, 3, 1 };
     size_t counts[] = {  0, 0, 0, 0, 0, 0, 1, 1, 2, 2 };
 
     const std::vector<size_t>& statsidx(pieceStatMan.getRarerPieceIndexes());
@@ -89,7 +95,7 @@ void PieceStatManTest::testAddPieceStats_bitfield()
   const unsigned char bitfield[] = { 0xaa, 0x80 };
   pieceStatMan.addPieceStats(bitfield, sizeof(bitfield));
   {
-    size_t indexes[] = { 1, 3, 5, 7, 9, 0, 2, 4, 6, 8 };
+    size_t indexes[] = { 9, 1, 5, 3, 7, 8, 6, 4, 2, 0 };
     size_t counts[] = { 0, 0, 0, 0, 0, 1, 1, 1, 1, 1 };
 
     const std::vector<size_t>& statsidx(pieceStatMan.getRarerPieceIndexes());
@@ -107,7 +113,7 @@ void PieceStatManTest::testAddPieceStats_bitfield()
   pieceStatMan.addPieceStats(bitfield, sizeof(bitfield));
 
   {
-    size_t indexes[] = { 1, 3, 5, 7, 9, 0, 2, 4, 6, 8 };
+    size_t indexes[] = { 9, 1, 5, 3, 7, 8, 6, 4, 2, 0 };
     size_t counts[] = { 0, 0, 0, 0, 0, 2, 2, 2, 2, 2 };
 
     const std::vector<size_t>& statsidx(pieceStatMan.getRarerPieceIndexes());
@@ -142,7 +148,7 @@ void PieceStatManTest::testUpdatePieceStats()
     // ---------------------------------
     // res: 0, 0, 0, 1, 2, 2, 2, 2, 1, 1
 
-    size_t indexes[] = { 0, 1, 2, 3, 8, 9, 4, 5, 6, 7 };
+    size_t indexes[] = { 0, 1, 2, 3, 8, 9, 7, 6, 5, 4 };
     size_t counts[] =  { 0, 0, 0, 1, 1, 1, 2, 2, 2, 2 };
 
     const std::vector<size_t>& statsidx(pieceStatMan.getRarerPieceIndexes());
@@ -175,7 +181,7 @@ void PieceStatManTest::testSubtractPieceStats()
     // ---------------------------------
     // res: 1, 1, 0, 0, 0, 0, 0, 0, 0, 0
 
-    size_t indexes[] = { 2, 3, 4, 5, 6, 7, 8, 9, 0, 1 };
+    size_t indexes[] = { 9, 8, 7, 6, 4, 5, 2, 3, 1, 0 };
     size_t counts[] =  { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1 };
 
     const std::vector<size_t>& statsidx(pieceStatMan.getRarerPieceIndexes());
@@ -191,4 +197,60 @@ void PieceStatManTest::testSubtractPieceStats()
   }
 }
 
+void PieceStatManTest::testRandomUpdates()
+{
+  const size_t numPieces = 100;
+  const size_t numPeers = 20;
+  PieceStatMan pieceStatMan(numPieces, true);
+  std::vector<std::vector<unsigned char> > peers
+    (numPeers, std::vector<unsigned char>((numPieces+7)/8));
+  std::vector<size_t> counts(numPieces);
+  srand(0);
+  for(size_t n = 0; n < 1000; ++n) {
+    std::vector<unsigned char>& bf = peers[rand()%numPeers];
+    switch(rand()%3) {
+    case 0: {
+      std::vector<unsigned char> newBf(bf.size());
+      for(size_t i = 0; i < newBf.size(); ++i) {
+        newBf[i] = rand();
+      }
+      newBf[newBf.size()-1] &= bitfield::lastByteMask(numPieces);
+      pieceStatMan.updatePieceStats(&newBf[0], newBf.size(), &bf[0]);
+      bf.swap(newBf);
+      break;
+    }
+    case 1: {
+      size_t index = rand()%numPieces;
+      if(!bitfield::test(bf, numPieces, index)) {
+        bf[index/8] |= 128 >> (index%8);
+        pieceStatMan.addPieceStats(index);
+      }
+      break;
+    }
+    default:
+      pieceStatMan.subtractPieceStats(&bf[0], bf.size());
+      std::fill(bf.begin(), bf.end(), 0);
+    }
+    std::fill(counts.begin(), counts.end(), 0);
+    for(size_t i = 0; i < numPeers; ++i) {
+      for(size_t j = 0; j < numPieces; ++j) {
+        if(bitfield::test(peers[i], numPieces, j)) {
+          ++counts[j];
+        }
+      }
+    }
+    const std::vector<size_t>& statsidx(pieceStatMan.getRarerPieceIndexes());
+    const std::vector<SharedHandle<PieceStat> >& stats
+      (pieceStatMan.getPieceStats());
+    for(size_t i = 0; i < numPieces; ++i) {
+      CPPUNIT_ASSERT_EQUAL(counts[i], stats[i]->getCount());
+      CPPUNIT_ASSERT_EQUAL(i, stats[statsidx[i]]->getOrder());
+      if(i > 0) {
+        CPPUNIT_ASSERT(stats[statsidx[i-1]]->getCount() <=
+                       stats[statsidx[i]]->getCount());
+      }
+    }
+  }
+}
+
 } // namespace aria2
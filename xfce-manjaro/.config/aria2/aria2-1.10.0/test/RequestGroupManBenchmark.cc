@@ -0,0 +1,133 @@
+#include "Benchmark.h"
+
+#ifdef ENABLE_XML_RPC
+
+#include <cstdlib>
+#include <vector>
+
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+#include "DownloadContext.h"
+#include "DownloadResult.h"
+#include "FileAllocationEntry.h"
+#include "CheckIntegrityEntry.h"
+#include "OptionParser.h"
+#include "OptionHandler.h"
+#include "XmlRpcMethodImpl.h"
+#include "XmlRpcRequest.h"
+#include "XmlRpcResponse.h"
+#include "Option.h"
+#include "prefs.h"
+#include "util.h"
+
+namespace aria2 {
+
+// A session with many queued downloads, which RPC clients poll
+// frequently.
+static const size_t NUM_GROUPS = 100000;
+static const size_t NUM_CALLS = 10000;
+
+static SharedHandle<DownloadEngine> createEngine(Option* option)
+{
+  SharedHandle<DownloadEngine> e
+    (new DownloadEngine(SharedHandle<EventPoll>(new SelectEventPoll())));
+  e->setOption(option);
+  SharedHandle<RequestGroupMan> rgman
+    (new RequestGroupMan(std::vector<SharedHandle<RequestGroup> >(),
+                         1, option));
+  e->setRequestGroupMan(rgman);
+  SharedHandle<Option> groupOption(new Option(*option));
+  std::vector<SharedHandle<RequestGroup> > groups;
+  for(size_t i = 0; i < NUM_GROUPS; ++i) {
+    SharedHandle<RequestGroup> group(new RequestGroup(groupOption));
+    group->setDownloadContext
+      (SharedHandle<DownloadContext>
+       (new DownloadContext(1024*1024, 0, "file"+util::uitos(i))));
+    groups.push_back(group);
+  }
+  rgman->addReservedGroup(groups);
+  // Stopped downloads have GIDs after the waiting ones.
+  for(size_t i = 0; i < NUM_GROUPS; ++i) {
+    SharedHandle<DownloadResult> result(new DownloadResult());
+    result->gid = NUM_GROUPS+i+1;
+    result->result = downloadresultcode::FINISHED;
+    rgman->addDownloadResult(result);
+  }
+  return e;
+}
+
+static size_t call
+(xmlrpc::XmlRpcMethod& m, const std::string& methodName,
+ const SharedHandle<List>& params, DownloadEngine* e)
+{
+  xmlrpc::XmlRpcRequest req(methodName, params);
+  return m.execute(req, e).code == 0;
+}
+
+static SharedHandle<List> createGidParams(gid_t gid)
+{
+  SharedHandle<List> params = List::g();
+  params->append(util::itos(gid));
+  return params;
+}
+
+static void benchmarkRequestGroupMan()
+{
+  RequestGroup::resetGIDCounter();
+  Option option;
+  option.put(PREF_DIR, "/tmp");
+  SharedHandle<DownloadEngine> e = createEngine(&option);
+  benchmark::note("waiting="+util::uitos(NUM_GROUPS)+
+                  " stopped="+util::uitos(NUM_GROUPS));
+  srand(0);
+  size_t ok = 0;
+  {
+    xmlrpc::TellStatusXmlRpcMethod m;
+    double start = benchmark::now();
+    for(size_t i = 0; i < NUM_CALLS; ++i) {
+      ok += call(m, xmlrpc::TellStatusXmlRpcMethod::getMethodName(),
+                 createGidParams(rand()%NUM_GROUPS+1), e.get());
+    }
+    benchmark::report("tellStatus waiting", NUM_CALLS, benchmark::now()-start);
+    start = benchmark::now();
+    for(size_t i = 0; i < NUM_CALLS; ++i) {
+      ok += call(m, xmlrpc::TellStatusXmlRpcMethod::getMethodName(),
+                 createGidParams(NUM_GROUPS+rand()%NUM_GROUPS+1), e.get());
+    }
+    benchmark::report("tellStatus stopped", NUM_CALLS, benchmark::now()-start);
+  }
+  {
+    xmlrpc::ChangePositionXmlRpcMethod m;
+    const size_t n = NUM_CALLS/10;
+    double start = benchmark::now();
+    for(size_t i = 0; i < n; ++i) {
+      SharedHandle<List> params = createGidParams(rand()%NUM_GROUPS+1);
+      params->append(Integer::g(rand()%201-100));
+      params->append("POS_CUR");
+      ok += call(m, xmlrpc::ChangePositionXmlRpcMethod::getMethodName(),
+                 params, e.get());
+    }
+    benchmark::report("changePosition POS_CUR", n, benchmark::now()-start);
+  }
+  {
+    xmlrpc::RemoveXmlRpcMethod m;
+    const size_t n = NUM_CALLS/10;
+    double start = benchmark::now();
+    for(size_t i = 0; i < n; ++i) {
+      ok += call(m, xmlrpc::RemoveXmlRpcMethod::getMethodName(),
+                 createGidParams(i*(NUM_GROUPS/n)+1), e.get());
+    }
+    benchmark::report("remove", n, benchmark::now()-start);
+  }
+  if(ok != NUM_CALLS*2+NUM_CALLS/10*2) {
+    benchmark::note("unexpected result: "+util::uitos(ok));
+  }
+}
+
+BENCHMARK_REGISTRATION(benchmarkRequestGroupMan);
+
+} // namespace aria2
+
+#endif // ENABLE_XML_RPC
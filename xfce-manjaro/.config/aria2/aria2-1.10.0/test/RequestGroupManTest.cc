@@ -26,6 +26,8 @@ class RequestGroupManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testLoadServerStat);
   CPPUNIT_TEST(testSaveServerStat);
   CPPUNIT_TEST(testChangeReservedGroupPosition);
+  CPPUNIT_TEST(testFindGroup);
+  CPPUNIT_TEST(testFindNewlyStoppedGroup);
   CPPUNIT_TEST_SUITE_END();
 private:
   SharedHandle<Option> option_;
@@ -41,6 +43,8 @@ public:
   void testLoadServerStat();
   void testSaveServerStat();
   void testChangeReservedGroupPosition();
+  void testFindGroup();
+  void testFindNewlyStoppedGroup();
 };
 
 
@@ -168,4 +172,78 @@ void RequestGroupManTest::testChangeReservedGroupPosition()
   }
 }
 
+void RequestGroupManTest::testFindGroup()
+{
+  SharedHandle<RequestGroup> gs[] = {
+    SharedHandle<RequestGroup>(new RequestGroup(option_)),
+    SharedHandle<RequestGroup>(new RequestGroup(option_)),
+    SharedHandle<RequestGroup>(new RequestGroup(option_)),
+    SharedHandle<RequestGroup>(new RequestGroup(option_))
+  };
+  RequestGroupMan rm(std::vector<SharedHandle<RequestGroup> >(&gs[0], &gs[1]),
+                     0, option_.get());
+  rm.addReservedGroup(gs[1]);
+  rm.insertReservedGroup(0, gs[2]);
+  rm.addRequestGroup(gs[3]);
+
+  CPPUNIT_ASSERT(rm.findReservedGroup(1).get() == gs[0].get());
+  CPPUNIT_ASSERT(rm.findReservedGroup(2).get() == gs[1].get());
+  CPPUNIT_ASSERT(rm.findReservedGroup(3).get() == gs[2].get());
+  CPPUNIT_ASSERT(rm.findReservedGroup(4).isNull());
+  CPPUNIT_ASSERT(rm.findRequestGroup(4).get() == gs[3].get());
+  CPPUNIT_ASSERT(rm.findRequestGroup(1).isNull());
+
+  CPPUNIT_ASSERT(rm.removeReservedGroup(3));
+  CPPUNIT_ASSERT(!rm.removeReservedGroup(3));
+  CPPUNIT_ASSERT(rm.findReservedGroup(3).isNull());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, rm.getReservedGroups().size());
+  CPPUNIT_ASSERT(rm.getReservedGroups()[0].get() == gs[0].get());
+  CPPUNIT_ASSERT(rm.getReservedGroups()[1].get() == gs[1].get());
+
+  CPPUNIT_ASSERT_EQUAL
+    ((size_t)0, rm.changeReservedGroupPosition(2, 0, RequestGroupMan::POS_SET));
+  CPPUNIT_ASSERT(rm.findReservedGroup(2).get() == gs[1].get());
+
+  SharedHandle<DownloadResult> r1(new DownloadResult());
+  r1->gid = 3;
+  SharedHandle<DownloadResult> r2(new DownloadResult());
+  r2->gid = 3;
+  rm.addDownloadResult(r1);
+  rm.addDownloadResult(r2);
+  // The first one is found if GID is duplicated.
+  CPPUNIT_ASSERT(rm.findDownloadResult(3).get() == r1.get());
+  CPPUNIT_ASSERT(rm.findDownloadResult(1).isNull());
+  rm.purgeDownloadResult();
+  CPPUNIT_ASSERT(rm.findDownloadResult(3).isNull());
+}
+
+void RequestGroupManTest::testFindNewlyStoppedGroup()
+{
+  RequestGroupMan rm(std::vector<SharedHandle<RequestGroup> >(), 2,
+                     option_.get());
+  std::vector<SharedHandle<RequestGroup> > gs;
+  for(int i = 0; i < 2; ++i) {
+    SharedHandle<RequestGroup> rg(new RequestGroup(option_));
+    rg->setDownloadContext
+      (SharedHandle<DownloadContext>(new DownloadContext(1024, 0, "file")));
+    rm.addRequestGroup(rg);
+    gs.push_back(rg);
+  }
+  CPPUNIT_ASSERT(!rm.findNewlyStoppedGroup());
+
+  gs[0]->setHaltRequested(true);
+  CPPUNIT_ASSERT(rm.findNewlyStoppedGroup());
+  // Already reported
+  CPPUNIT_ASSERT(!rm.findNewlyStoppedGroup());
+
+  gs[1]->setHaltRequested(true);
+  CPPUNIT_ASSERT(rm.findNewlyStoppedGroup());
+
+  // Reported again if it stops again after it is resumed.
+  gs[0]->setHaltRequested(false);
+  CPPUNIT_ASSERT(!rm.findNewlyStoppedGroup());
+  gs[0]->setHaltRequested(true);
+  CPPUNIT_ASSERT(rm.findNewlyStoppedGroup());
+}
+
 } // namespace aria2
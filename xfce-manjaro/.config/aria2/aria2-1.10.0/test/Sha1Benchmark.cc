@@ -0,0 +1,77 @@
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <vector>
+#include <string>
+
+#include "sha1.h"
+#include "messageDigest.h"
+#include "util.h"
+
+namespace aria2 {
+
+// Pieces of 256KiB, as a torrent of a few GiB has.
+static const size_t PIECE_LENGTH = 256*1024;
+static const size_t NUM_PIECES = 64;
+static const size_t NUM_ROUNDS = 8;
+
+static void benchmarkSha1()
+{
+  std::vector<unsigned char> data(PIECE_LENGTH*NUM_PIECES);
+  srand(0);
+  for(size_t i = 0; i < data.size(); ++i) {
+    data[i] = rand();
+  }
+  const uint64_t bytes = (uint64_t)data.size()*NUM_ROUNDS;
+  // What piece hashing used before: one piece at a time. It runs on
+  // the SHA extensions if the CPU has them, the library otherwise.
+  {
+    MessageDigestContext ctx;
+    ctx.trySetAlgo(MessageDigestContext::SHA1);
+    ctx.digestInit();
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      for(size_t i = 0; i < NUM_PIECES; ++i) {
+        ctx.digestReset();
+        ctx.digestUpdate(&data[i*PIECE_LENGTH], PIECE_LENGTH);
+        ctx.digestFinal();
+      }
+    }
+    benchmark::report(sha1::hasSingleKernel() ?
+                      "MessageDigestContext (shani)" :
+                      "MessageDigestContext (library)",
+                      NUM_PIECES*NUM_ROUNDS, benchmark::now()-start, bytes);
+  }
+  std::string defaultKernel = sha1::getKernel();
+  std::vector<std::string> kernels = sha1::getAvailableKernels();
+  for(std::vector<std::string>::const_iterator i = kernels.begin(),
+        eoi = kernels.end(); i != eoi; ++i) {
+    sha1::selectKernel(*i);
+    size_t lanes = sha1::getLanes();
+    std::vector<sha1::Context> ctxs(lanes);
+    std::vector<sha1::Context*> ctxptrs(lanes);
+    std::vector<const unsigned char*> ptrs(lanes);
+    double start = benchmark::now();
+    for(size_t r = 0; r < NUM_ROUNDS; ++r) {
+      for(size_t i = 0; i < NUM_PIECES; i += lanes) {
+        for(size_t j = 0; j < lanes; ++j) {
+          sha1::init(ctxs[j]);
+          ctxptrs[j] = &ctxs[j];
+          ptrs[j] = &data[(i+j)*PIECE_LENGTH];
+        }
+        sha1::update(&ctxptrs[0], &ptrs[0], PIECE_LENGTH, lanes);
+        for(size_t j = 0; j < lanes; ++j) {
+          unsigned char md[sha1::DIGEST_LENGTH];
+          sha1::final(ctxs[j], md);
+        }
+      }
+    }
+    benchmark::report(*i+" lanes="+util::uitos(lanes),
+                      NUM_PIECES*NUM_ROUNDS, benchmark::now()-start, bytes);
+  }
+  sha1::selectKernel(defaultKernel);
+}
+
+BENCHMARK_REGISTRATION(benchmarkSha1);
+
+} // namespace aria2
@@ -0,0 +1,107 @@
+#include "SocketBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "BufferPool.h"
+#include "a2io.h"
+#include "util.h"
+
+namespace aria2 {
+
+class SocketBufferTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SocketBufferTest);
+  CPPUNIT_TEST(testSend);
+  CPPUNIT_TEST(testSend_partial);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  SharedHandle<SocketCore> sender_;
+  SharedHandle<SocketCore> receiver_;
+public:
+  void setUp()
+  {
+    SocketCore serverSock;
+    serverSock.bind(0);
+    serverSock.beginListen();
+    std::pair<std::string, uint16_t> addrinfo;
+    serverSock.getAddrInfo(addrinfo);
+    sender_.reset(new SocketCore());
+    sender_->establishConnection("localhost", addrinfo.second);
+    receiver_.reset(serverSock.acceptConnection());
+    receiver_->setBlockingMode();
+    // Wait for the connection to be established.
+    sender_->isWritable(5);
+  }
+
+  std::string receive(size_t len)
+  {
+    std::string res;
+    char buf[4096];
+    while(res.size() < len) {
+      size_t r = std::min(sizeof(buf), len-res.size());
+      receiver_->readData(buf, r);
+      CPPUNIT_ASSERT(r > 0);
+      res.append(&buf[0], &buf[r]);
+    }
+    return res;
+  }
+
+  void testSend();
+  void testSend_partial();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SocketBufferTest);
+
+void SocketBufferTest::testSend()
+{
+  SocketBuffer buf(sender_);
+  std::string expected;
+  // More entries than one writeDataVec() call can take.
+  for(size_t i = 0; i < IOV_MAX+10; ++i) {
+    std::string s = util::uitos(i)+",";
+    expected += s;
+    if(i%2 == 0) {
+      buf.pushStr(s);
+    } else {
+      unsigned char* bytes = new unsigned char[s.size()];
+      memcpy(bytes, s.data(), s.size());
+      buf.pushBytes(bytes, s.size());
+    }
+  }
+  CPPUNIT_ASSERT_EQUAL((ssize_t)expected.size(), buf.send());
+  CPPUNIT_ASSERT(buf.sendBufferIsEmpty());
+  CPPUNIT_ASSERT_EQUAL(expected, receive(expected.size()));
+}
+
+void SocketBufferTest::testSend_partial()
+{
+  SocketBuffer buf(sender_);
+  const SharedHandle<BufferPool>& pool = BufferPool::getInstance();
+  std::string expected;
+  // Queue enough data to fill the socket buffers, so that send()
+  // stops in the middle of an entry.
+  for(size_t i = 0; i < 256; ++i) {
+    unsigned char* bytes = pool->allocate();
+    size_t len = 16*1024+i;
+    for(size_t j = 0; j < len; ++j) {
+      bytes[j] = (i+j)%251;
+    }
+    expected.append(&bytes[0], &bytes[len]);
+    buf.pushPooledBytes(bytes, len);
+    buf.pushStr("|");
+    expected += "|";
+  }
+  std::string received;
+  while(!buf.sendBufferIsEmpty()) {
+    ssize_t slen = buf.send();
+    received += receive(slen);
+  }
+  CPPUNIT_ASSERT(expected == received);
+}
+
+} // namespace aria2
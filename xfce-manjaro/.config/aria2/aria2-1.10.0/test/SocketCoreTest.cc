@@ -1,6 +1,8 @@
 #include "SocketCore.h"
 #include "Exception.h"
 #include <iostream>
+#include <fstream>
+#include <fcntl.h>
 #include <cppunit/extensions/HelperMacros.h>
 
 namespace aria2 {
@@ -10,6 +12,7 @@ class SocketCoreTest:public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(SocketCoreTest);
   CPPUNIT_TEST(testWriteAndReadDatagram);
   CPPUNIT_TEST(testGetSocketError);
+  CPPUNIT_TEST(testSendFile);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp() {}
@@ -18,6 +21,7 @@ public:
 
   void testWriteAndReadDatagram();
   void testGetSocketError();
+  void testSendFile();
 };
 
 
@@ -69,4 +73,37 @@ void SocketCoreTest::testGetSocketError()
   CPPUNIT_ASSERT_EQUAL(std::string(""), s.getSocketError());
 }
 
+void SocketCoreTest::testSendFile()
+{
+  SocketCore serverSock;
+  serverSock.bind(0);
+  serverSock.beginListen();
+  std::pair<std::string, uint16_t> addrinfo;
+  serverSock.getAddrInfo(addrinfo);
+  SocketCore s;
+  s.establishConnection("localhost", addrinfo.second);
+  s.setBlockingMode();
+  SharedHandle<SocketCore> r(serverSock.acceptConnection());
+  r->setBlockingMode();
+  if(!s.supportsSendFile()) {
+    return;
+  }
+  std::string filename = "/tmp/aria2_SocketCoreTest_testSendFile";
+  {
+    std::ofstream out(filename.c_str());
+    out << "0123456789";
+  }
+  int fd = open(filename.c_str(), O_RDONLY);
+  CPPUNIT_ASSERT(fd != -1);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, s.sendFile(fd, 2, 5));
+  // Beyond the end of the file
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, s.sendFile(fd, 10, 5));
+  CPPUNIT_ASSERT(!s.wantWrite());
+  close(fd);
+  char buf[5];
+  size_t len = sizeof(buf);
+  r->readData(buf, len);
+  CPPUNIT_ASSERT_EQUAL(std::string("23456"), std::string(&buf[0], &buf[len]));
+}
+
 } // namespace aria2
@@ -0,0 +1,98 @@
+#include "TokenBucket.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "wallclock.h"
+
+namespace aria2 {
+
+class TokenBucketTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TokenBucketTest);
+  CPPUNIT_TEST(testExceeded);
+  CPPUNIT_TEST(testExceeded_noLimit);
+  CPPUNIT_TEST(testRefill);
+  CPPUNIT_TEST(testSetRate);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  Timer savedWallclock_;
+public:
+  void setUp()
+  {
+    savedWallclock_ = global::wallclock;
+    global::wallclock.reset(1000);
+  }
+
+  void tearDown()
+  {
+    global::wallclock = savedWallclock_;
+  }
+
+  void testExceeded();
+  void testExceeded_noLimit();
+  void testRefill();
+  void testSetRate();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TokenBucketTest);
+
+void TokenBucketTest::testExceeded()
+{
+  TokenBucket bucket(1000);
+  CPPUNIT_ASSERT(!bucket.exceeded());
+  bucket.consume(999);
+  CPPUNIT_ASSERT(!bucket.exceeded());
+  bucket.consume(1);
+  CPPUNIT_ASSERT(bucket.exceeded());
+  bucket.consume(500);
+  CPPUNIT_ASSERT_EQUAL((int64_t)-500, bucket.getTokens());
+}
+
+void TokenBucketTest::testExceeded_noLimit()
+{
+  TokenBucket bucket;
+  bucket.consume(1000000);
+  CPPUNIT_ASSERT(!bucket.exceeded());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, bucket.getTokens());
+}
+
+void TokenBucketTest::testRefill()
+{
+  TokenBucket bucket(1000);
+  bucket.consume(2500);
+  CPPUNIT_ASSERT_EQUAL((int64_t)-1500, bucket.getTokens());
+  global::wallclock.advance(1);
+  CPPUNIT_ASSERT(bucket.exceeded());
+  CPPUNIT_ASSERT_EQUAL((int64_t)-500, bucket.getTokens());
+  global::wallclock.advance(1);
+  CPPUNIT_ASSERT(!bucket.exceeded());
+  CPPUNIT_ASSERT_EQUAL((int64_t)500, bucket.getTokens());
+  // The bucket holds one second worth of tokens at most.
+  global::wallclock.advance(10);
+  CPPUNIT_ASSERT(!bucket.exceeded());
+  CPPUNIT_ASSERT_EQUAL((int64_t)1000, bucket.getTokens());
+  // The clock goes backwards.
+  bucket.consume(1000);
+  global::wallclock.reset(500);
+  CPPUNIT_ASSERT(bucket.exceeded());
+  global::wallclock.advance(1);
+  CPPUNIT_ASSERT(!bucket.exceeded());
+  CPPUNIT_ASSERT_EQUAL((int64_t)1000, bucket.getTokens());
+}
+
+void TokenBucketTest::testSetRate()
+{
+  TokenBucket bucket(1000);
+  bucket.consume(2000);
+  CPPUNIT_ASSERT(bucket.exceeded());
+  bucket.setRate(5000);
+  CPPUNIT_ASSERT_EQUAL(5000U, bucket.getRate());
+  CPPUNIT_ASSERT(!bucket.exceeded());
+  CPPUNIT_ASSERT_EQUAL((int64_t)5000, bucket.getTokens());
+  bucket.setRate(0);
+  bucket.consume(10000);
+  CPPUNIT_ASSERT(!bucket.exceeded());
+}
+
+} // namespace aria2
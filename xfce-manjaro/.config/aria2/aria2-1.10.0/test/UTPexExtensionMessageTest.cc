@@ -139,12 +139,12 @@ void UTPexExtensionMessageTest::testDoReceivedAction()
 
   CPPUNIT_ASSERT_EQUAL((size_t)2, peerStorage_->getPeers().size());
   {
-    SharedHandle<Peer> p = peerStorage_->getPeers()[0];
+    SharedHandle<Peer> p = peerStorage_->getPeers().front();
     CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), p->getIPAddress());
     CPPUNIT_ASSERT_EQUAL((uint16_t)6881, p->getPort());
   }
   {
-    SharedHandle<Peer> p = peerStorage_->getPeers()[1];
+    SharedHandle<Peer> p = peerStorage_->getPeers().back();
     CPPUNIT_ASSERT_EQUAL(std::string("10.1.1.2"), p->getIPAddress());
     CPPUNIT_ASSERT_EQUAL((uint16_t)9999, p->getPort());
   }
@@ -1,5 +1,6 @@
 #include "util.h"
 
+#include <cerrno>
 #include <cstring>
 #include <string>
 #include <iostream>
@@ -65,6 +66,7 @@ class UtilTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testEscapePath);
   CPPUNIT_TEST(testGetCidrPrefix);
   CPPUNIT_TEST(testInSameCidrBlock);
+  CPPUNIT_TEST(testSafeStrerror);
   CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -118,6 +120,7 @@ public:
   void testEscapePath();
   void testGetCidrPrefix();
   void testInSameCidrBlock();
+  void testSafeStrerror();
 };
 
 
@@ -1098,4 +1101,10 @@ void UtilTest::testInSameCidrBlock()
   CPPUNIT_ASSERT(!util::inSameCidrBlock("192.168.128.1", "192.168.0.1", 17));
 }
 
+void UtilTest::testSafeStrerror()
+{
+  CPPUNIT_ASSERT_EQUAL(std::string(strerror(ENOENT)),
+                       util::safeStrerror(ENOENT));
+}
+
 } // namespace aria2
@@ -77,6 +77,7 @@ class XmlRpcMethodTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testChangePosition);
   CPPUNIT_TEST(testChangePosition_fail);
   CPPUNIT_TEST(testGetSessionInfo);
+  CPPUNIT_TEST(testGetGlobalStat);
   CPPUNIT_TEST(testChangeUri);
   CPPUNIT_TEST(testChangeUri_fail);
   CPPUNIT_TEST(testPause);
@@ -140,6 +141,7 @@ public:
   void testChangePosition();
   void testChangePosition_fail();
   void testGetSessionInfo();
+  void testGetGlobalStat();
   void testChangeUri();
   void testChangeUri_fail();
   void testPause();
@@ -987,6 +989,30 @@ void XmlRpcMethodTest::testGetSessionInfo()
                        getString(asDict(res.param), "sessionId"));
 }
 
+void XmlRpcMethodTest::testGetGlobalStat()
+{
+  e_->getRequestGroupMan()->addReservedGroup
+    (SharedHandle<RequestGroup>(new RequestGroup(option_)));
+  e_->getRequestGroupMan()->addReservedGroup
+    (SharedHandle<RequestGroup>(new RequestGroup(option_)));
+  GetGlobalStatXmlRpcMethod m;
+  XmlRpcRequest req(GetGlobalStatXmlRpcMethod::getMethodName(), List::g());
+  XmlRpcResponse res = m.execute(req, e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  const Dict* resParams = asDict(res.param);
+  CPPUNIT_ASSERT_EQUAL(std::string("0"), getString(resParams, "downloadSpeed"));
+  CPPUNIT_ASSERT_EQUAL(std::string("0"), getString(resParams, "uploadSpeed"));
+  CPPUNIT_ASSERT_EQUAL(std::string("0"), getString(resParams, "numActive"));
+  CPPUNIT_ASSERT_EQUAL(std::string("2"), getString(resParams, "numWaiting"));
+  CPPUNIT_ASSERT_EQUAL(std::string("0"), getString(resParams, "numStopped"));
+  CPPUNIT_ASSERT(resParams->containsKey("zeroCopyUploadLength"));
+  CPPUNIT_ASSERT(resParams->containsKey("bufferPoolInUse"));
+  CPPUNIT_ASSERT(resParams->containsKey("bufferPoolHighWater"));
+  CPPUNIT_ASSERT(resParams->containsKey("bufferPoolMiss"));
+  // DHT is not set up.
+  CPPUNIT_ASSERT(!resParams->containsKey("dhtPendingQueries"));
+}
+
 void XmlRpcMethodTest::testPause()
 {
   const std::string URIS[] = {
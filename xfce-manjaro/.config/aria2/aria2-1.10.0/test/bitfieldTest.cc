@@ -1,5 +1,8 @@
 #include "bitfield.h"
 
+#include <cstdlib>
+#include <vector>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 namespace aria2 {
@@ -11,6 +14,8 @@ class bitfieldTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testCountBit32);
   CPPUNIT_TEST(testCountSetBit);
   CPPUNIT_TEST(testLastByteMask);
+  CPPUNIT_TEST(testComputeBits);
+  CPPUNIT_TEST(testKernels);
   CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -19,6 +24,8 @@ public:
   void testCountBit32();
   void testCountSetBit();
   void testLastByteMask();
+  void testComputeBits();
+  void testKernels();
 };
 
 
@@ -66,4 +73,95 @@ void bitfieldTest::testLastByteMask()
                        (unsigned int)bitfield::lastByteMask(16));
 }
 
+void bitfieldTest::testComputeBits()
+{
+  const unsigned char p1[] = { 0xff, 0xf0 };
+  const unsigned char n1[] = { 0x0f, 0x30 };
+  unsigned char dst[2];
+  // nbits = 12, the last 4 bits are ignored.
+  CPPUNIT_ASSERT(bitfield::computeBits(dst, p1, 0, n1, 0, 12));
+  CPPUNIT_ASSERT_EQUAL((unsigned int)0xf0, (unsigned int)dst[0]);
+  CPPUNIT_ASSERT_EQUAL((unsigned int)0xc0, (unsigned int)dst[1]);
+  CPPUNIT_ASSERT_EQUAL((size_t)6, bitfield::countBits(p1, 0, n1, 0, 12));
+  size_t index;
+  CPPUNIT_ASSERT(bitfield::findFirstBit(index, n1, 0, 0, 0, 12));
+  CPPUNIT_ASSERT_EQUAL((size_t)4, index);
+  CPPUNIT_ASSERT(bitfield::findFirstBit(index, 0, 0, n1, 0, 12));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, index);
+  // ~p1 has bits only after nbits.
+  CPPUNIT_ASSERT(!bitfield::findFirstBit(index, 0, 0, p1, 0, 12));
+  CPPUNIT_ASSERT(!bitfield::computeBits(0, p1, 0, p1, 0, 12));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, bitfield::countBits(0, 0, 0, 0, 0));
+}
+
+// Compares every kernel with bit by bit computation on random
+// bitfields of various lengths, including ones longer than the
+// chunk used for missing operands.
+void bitfieldTest::testKernels()
+{
+  std::string defaultKernel = bitfield::getKernel();
+  std::vector<std::string> kernels = bitfield::getAvailableKernels();
+  CPPUNIT_ASSERT_EQUAL(std::string("generic"), kernels[0]);
+  srand(0);
+  const size_t lengths[] = { 0, 1, 7, 8, 9, 63, 64, 65, 127, 255, 256, 257,
+                             1000, 8*4096+3, 8*9000+5 };
+  for(size_t l = 0; l < sizeof(lengths)/sizeof(lengths[0]); ++l) {
+    size_t nbits = lengths[l];
+    size_t len = (nbits+7)/8;
+    std::vector<unsigned char> ops[4];
+    for(size_t k = 0; k < 4; ++k) {
+      ops[k].resize(len+1);
+      for(size_t i = 0; i < len; ++i) {
+        // Make bits sparse, so that findFirstBit() has to skip words.
+        ops[k][i] = (k < 2 ? rand()|rand() : rand()&rand()) & 0xff;
+        if(k == 0 && i < len/2) {
+          ops[k][i] = 0;
+        }
+      }
+    }
+    // Try each combination of missing operands.
+    for(size_t mask = 0; mask < 16; ++mask) {
+      const unsigned char* p[4];
+      for(size_t k = 0; k < 4; ++k) {
+        p[k] = mask&(1 << k) ? 0 : &ops[k][0];
+      }
+      std::vector<unsigned char> expected(len+1);
+      size_t expectedCount = 0;
+      size_t expectedFirst = nbits;
+      for(size_t i = 0; i < nbits; ++i) {
+        bool bit = (!p[0] || bitfield::test(p[0], nbits, i)) &&
+          (!p[1] || bitfield::test(p[1], nbits, i)) &&
+          !(p[2] && bitfield::test(p[2], nbits, i)) &&
+          !(p[3] && bitfield::test(p[3], nbits, i));
+        if(bit) {
+          expected[i/8] |= 128 >> (i%8);
+          ++expectedCount;
+          expectedFirst = std::min(expectedFirst, i);
+        }
+      }
+      for(std::vector<std::string>::const_iterator k = kernels.begin(),
+            eok = kernels.end(); k != eok; ++k) {
+        CPPUNIT_ASSERT(bitfield::selectKernel(*k));
+        std::vector<unsigned char> dst(len+1);
+        CPPUNIT_ASSERT_EQUAL
+          (expectedCount > 0,
+           bitfield::computeBits(&dst[0], p[0], p[1], p[2], p[3], nbits));
+        CPPUNIT_ASSERT(expected == dst);
+        CPPUNIT_ASSERT_EQUAL
+          (expectedCount,
+           bitfield::countBits(p[0], p[1], p[2], p[3], nbits));
+        size_t index;
+        CPPUNIT_ASSERT_EQUAL
+          (expectedCount > 0,
+           bitfield::findFirstBit(index, p[0], p[1], p[2], p[3], nbits));
+        if(expectedCount > 0) {
+          CPPUNIT_ASSERT_EQUAL(expectedFirst, index);
+        }
+      }
+    }
+  }
+  CPPUNIT_ASSERT(!bitfield::selectKernel("unknown"));
+  CPPUNIT_ASSERT(bitfield::selectKernel(defaultKernel));
+}
+
 } // namespace aria2
@@ -0,0 +1,142 @@
+#include "sha1.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "util.h"
+
+namespace aria2 {
+
+class sha1Test:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(sha1Test);
+  CPPUNIT_TEST(testDigest);
+  CPPUNIT_TEST(testUpdate_split);
+  CPPUNIT_TEST(testKernels);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  std::string defaultKernel_;
+
+  static std::string digest(const std::string& data)
+  {
+    sha1::Context ctx;
+    sha1::init(ctx);
+    sha1::update(ctx, data.data(), data.size());
+    unsigned char md[sha1::DIGEST_LENGTH];
+    sha1::final(ctx, md);
+    return util::toHex(md, sizeof(md));
+  }
+public:
+  void setUp()
+  {
+    defaultKernel_ = sha1::getKernel();
+  }
+
+  void tearDown()
+  {
+    sha1::selectKernel(defaultKernel_);
+  }
+
+  void testDigest();
+  void testUpdate_split();
+  void testKernels();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( sha1Test );
+
+void sha1Test::testDigest()
+{
+  std::vector<std::string> kernels = sha1::getAvailableKernels();
+  CPPUNIT_ASSERT_EQUAL(std::string("generic"), kernels[0]);
+  for(std::vector<std::string>::const_iterator i = kernels.begin(),
+        eoi = kernels.end(); i != eoi; ++i) {
+    CPPUNIT_ASSERT(sha1::selectKernel(*i));
+    CPPUNIT_ASSERT_EQUAL
+      (std::string("da39a3ee5e6b4b0d3255bfef95601890afd80709"), digest(""));
+    CPPUNIT_ASSERT_EQUAL
+      (std::string("a9993e364706816aba3e25717850c26c9cd0d89d"),
+       digest("abc"));
+    // 56 bytes: the length does not fit in the first padding block.
+    CPPUNIT_ASSERT_EQUAL
+      (std::string("84983e441c3bd26ebaae4aa1f95129e5e54670f1"),
+       digest("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+    CPPUNIT_ASSERT_EQUAL
+      (std::string("34aa973cd4c4daa4f61eeb2bdbad27316534016f"),
+       digest(std::string(1000000, 'a')));
+  }
+  CPPUNIT_ASSERT(!sha1::selectKernel("unknown"));
+}
+
+void sha1Test::testUpdate_split()
+{
+  std::string data(1000, 'a');
+  for(size_t i = 0; i < data.size(); ++i) {
+    data[i] = i;
+  }
+  std::string expected = digest(data);
+  for(size_t split = 0; split <= 130; ++split) {
+    sha1::Context ctx;
+    sha1::init(ctx);
+    sha1::update(ctx, data.data(), split);
+    sha1::update(ctx, data.data()+split, data.size()-split);
+    unsigned char md[sha1::DIGEST_LENGTH];
+    sha1::final(ctx, md);
+    CPPUNIT_ASSERT_EQUAL(expected, util::toHex(md, sizeof(md)));
+  }
+}
+
+void sha1Test::testKernels()
+{
+  // More messages than any kernel has lanes, so that some of them are
+  // left to the single lane code.
+  const size_t n = 11;
+  srand(0);
+  std::vector<std::string> messages;
+  for(size_t i = 0; i < n; ++i) {
+    std::string m(1000+rand()%200, 0);
+    for(size_t j = 0; j < m.size(); ++j) {
+      m[j] = rand();
+    }
+    messages.push_back(m);
+  }
+  // Each update() gives the same number of bytes to every message.
+  const size_t lengths[] = { 128, 64, 3, 61, 320, 100 };
+  const size_t numLengths = sizeof(lengths)/sizeof(lengths[0]);
+  std::vector<std::string> expected;
+  for(size_t i = 0; i < n; ++i) {
+    size_t total = 0;
+    for(size_t j = 0; j < numLengths; ++j) {
+      total += lengths[j];
+    }
+    expected.push_back(digest(messages[i].substr(0, total)));
+  }
+  std::vector<std::string> kernels = sha1::getAvailableKernels();
+  for(std::vector<std::string>::const_iterator k = kernels.begin(),
+        eok = kernels.end(); k != eok; ++k) {
+    CPPUNIT_ASSERT(sha1::selectKernel(*k));
+    std::vector<sha1::Context> ctxs(n);
+    std::vector<sha1::Context*> ctxptrs(n);
+    std::vector<const unsigned char*> data(n);
+    for(size_t i = 0; i < n; ++i) {
+      sha1::init(ctxs[i]);
+      ctxptrs[i] = &ctxs[i];
+      data[i] = reinterpret_cast<const unsigned char*>(messages[i].data());
+    }
+    for(size_t j = 0; j < numLengths; ++j) {
+      sha1::update(&ctxptrs[0], &data[0], lengths[j], n);
+      for(size_t i = 0; i < n; ++i) {
+        data[i] += lengths[j];
+      }
+    }
+    for(size_t i = 0; i < n; ++i) {
+      unsigned char md[sha1::DIGEST_LENGTH];
+      sha1::final(ctxs[i], md);
+      CPPUNIT_ASSERT_EQUAL(expected[i], util::toHex(md, sizeof(md)));
+    }
+  }
+}
+
+} // namespace aria2